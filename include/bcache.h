@@ -0,0 +1,59 @@
+// include/bcache.h
+#ifndef BCACHE_H
+#define BCACHE_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Block-Cache vor dem SD-Treiber (sd.h). Der Cache verwaltet Zeilen aus
+ * BCACHE_LINE_BLOCKS aufeinanderfolgenden Blöcken, ersetzt nach LRU und
+ * schreibt verzögert zurück (write-back): Änderungen landen erst beim
+ * Verdrängen oder bei bcache_sync() auf der Karte, benachbarte schmutzige
+ * Zeilen dabei in einem Mehrblock-Befehl.
+ *
+ * Wird auf aufeinanderfolgende Zeilen zugegriffen, liest der Cache voraus:
+ * das Fenster verdoppelt sich bis BCACHE_READAHEAD_MAX Zeilen, die per
+ * Scatter-Gather in einem einzigen Befehl direkt in die Zeilen geladen
+ * werden. Ein Zugriff außer der Reihe setzt das Fenster zurück. Lesezugriffe
+ * ab der Größe des Read-ahead-Fensters in einen auf CACHE_LINE
+ * ausgerichteten Puffer gehen direkt per DMA in den Puffer.
+ */
+
+#define BCACHE_BLOCK_SIZE    512
+#define BCACHE_LINE_BLOCKS   8     // 4 KB pro Zeile
+#define BCACHE_LINES         256   // 1 MB Cache
+#define BCACHE_READAHEAD_MAX 16    // Zeilen (64 KB)
+
+typedef struct {
+    unsigned long hits, misses;         // Zeilenzugriffe
+    unsigned long readahead;            // Vorausgelesene Zeilen
+    unsigned long readahead_used;       // ... davon später gebraucht
+    unsigned long writebacks;           // Zurückgeschriebene Zeilen
+    unsigned long write_errors;         // Gescheiterte Schreibbefehle
+    unsigned long reads, writes;        // Lese-/Schreibaufrufe an den Cache
+    unsigned long direct_blocks;        // Große Lesezugriffe am Cache vorbei
+} BcacheStats;
+
+// Reserviert den Cache; setzt eine initialisierte Karte voraus (sd_init)
+void bcache_init();
+
+// Liest bzw. schreibt count Blöcke ab lba; Fehlercodes aus sd.h
+int bcache_read(unsigned long lba, unsigned long count, void* buffer);
+int bcache_write(unsigned long lba, unsigned long count, const void* buffer);
+
+/**
+ * Zeiger auf einen Block im Cache, ohne Kopie. Gültig bis zum nächsten
+ * Aufruf einer bcache-Funktion; NULL bei einem Lesefehler.
+ */
+const void* bcache_block(unsigned long lba);
+
+// Schreibt alle geänderten Zeilen zurück
+int bcache_sync();
+
+// Schreibt zurück und verwirft den Inhalt (z.B. für Messungen mit kaltem Cache)
+int bcache_drop();
+
+const BcacheStats* bcache_stats();
+void bcache_reset_stats();
+
+#endif // BCACHE_H
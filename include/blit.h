@@ -0,0 +1,65 @@
+// include/blit.h
+#ifndef BLIT_H
+#define BLIT_H
+
+/**
+ * Blit-Engine für 32-Bit-Bilder (0xAARRGGBB, wie die Palette in fb.c).
+ * Bilder kommen entweder als Asset aus der Linker-Section .assets (erzeugt
+ * von tools/mkasset aus den Dateien in assets/) oder werden zur Laufzeit mit
+ * blit_create angelegt. Alle Blits werden am Bildschirmrand geclippt.
+ * In den 16- und 8-Bit-Modi werden die Pixel beim Zeichnen gewandelt.
+ */
+
+// Zeichenmodi; ein Asset bringt seinen Standardmodus in 'format' mit
+enum {
+    BLIT_OPAQUE   = 0, // Pixel werden unverändert kopiert
+    BLIT_COLORKEY = 1, // Pixel mit der Farbe 'key' (RGB) bleiben durchsichtig
+    BLIT_ALPHA    = 2  // Alpha-Blending mit dem Alphakanal jedes Pixels
+};
+
+#define ASSET_MAGIC 0x4153424F // "OBSA"
+
+// Liegt so im Asset-Image; der Header ist 64 Byte groß, die Pixel
+// sind damit wie die Section 16-Byte-ausgerichtet.
+typedef struct {
+    unsigned int magic;     // ASSET_MAGIC
+    unsigned int size;      // Gesamtgröße inkl. Header, Vielfaches von 16
+    unsigned int width;
+    unsigned int height;
+    unsigned int format;    // BLIT_...
+    unsigned int key;       // Farbschlüssel für BLIT_COLORKEY (0xRRGGBB)
+    char name[40];
+    unsigned int pixels[];  // width * height Pixel, zeilenweise
+} Image;
+
+// Sucht ein eingebettetes Asset über seinen Namen (Dateiname ohne Endung)
+const Image* blit_find(const char* name);
+
+// Legt ein leeres (schwarzes, transparentes) Bild auf dem Heap an
+Image* blit_create(unsigned int width, unsigned int height, unsigned int format);
+
+// Zeichnet das Bild mit seinem Standardmodus bzw. einem expliziten Modus
+void blit(const Image* img, int x, int y);
+void blit_mode(const Image* img, int x, int y, int mode);
+
+// Zeichnet den Ausschnitt (sx, sy, w, h) des Bildes an (x, y)
+void blit_rect(const Image* img, int sx, int sy, int w, int h, int x, int y, int mode);
+
+// Skaliert das Bild auf w x h Pixel (Nearest Neighbour)
+void blit_scaled(const Image* img, int x, int y, int w, int h, int mode);
+
+/**
+ * Zeichnet ein Bild im Asset-Format, das stückweise aus einer Datei kommt:
+ * read liest wie fat_read bis zu n Bytes und liefert die Anzahl (0 am Ende,
+ * < 0 bei Fehlern). Es werden immer nur einige Zeilen gepuffert, das Bild
+ * muss also nicht in den Speicher passen. Liefert 0 oder -1 bei einem
+ * ungültigen Bild bzw. Lesefehler.
+ */
+typedef long (*blit_read_t)(void* ctx, void* buffer, unsigned long n);
+int blit_stream(blit_read_t read, void* ctx, int x, int y);
+
+// Schleife über alle Assets: for (a = blit_first(); a; a = blit_next(a))
+const Image* blit_first();
+const Image* blit_next(const Image* img);
+
+#endif // BLIT_H
@@ -0,0 +1,46 @@
+// include/clock.h
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Takte über die Mailbox-Clock-Tags der Firmware. clock_init() setzt den
+ * ARM-Takt auf sein Maximum und gleicht den Mini-UART an den tatsächlichen
+ * Kerntakt an. Jede Änderung des Kerntakts (CLOCK_CORE) wird an die davon
+ * abhängigen Teiler weitergegeben.
+ */
+
+// Takt-IDs der Firmware
+enum {
+    CLOCK_EMMC  = 1,
+    CLOCK_UART  = 2,  // PL011, nicht der Mini-UART
+    CLOCK_ARM   = 3,
+    CLOCK_CORE  = 4,  // VPU; davon leitet sich der Mini-UART ab
+    CLOCK_EMMC2 = 12  // SD-Karte beim Pi 4
+};
+
+void clock_init();
+
+// Frequenzen in Hz, 0 bei Fehler
+unsigned int clock_rate(unsigned int id);       // Eingestellter Wert
+unsigned int clock_measured(unsigned int id);   // Von der Firmware gemessen
+unsigned int clock_min(unsigned int id);
+unsigned int clock_max(unsigned int id);
+
+// Setzt einen Takt; liefert die tatsächlich eingestellte Frequenz
+unsigned int clock_set_rate(unsigned int id, unsigned int hz);
+
+/**
+ * Governor: die Hauptschleife meldet mit clock_governor_update(), ob der
+ * letzte Durchlauf Arbeit hatte. Alle CLOCK_GOV_PERIOD_MS wird aus dem
+ * Anteil der Arbeit der ARM-Takt gewählt: ab CLOCK_GOV_UP_PERCENT das
+ * Maximum, sonst proportional zur Last, aber nie unter dem Minimum.
+ */
+#define CLOCK_GOV_PERIOD_MS  100
+#define CLOCK_GOV_UP_PERCENT 80
+
+void clock_governor_enable(bool on);
+void clock_governor_update(bool busy);
+
+#endif // CLOCK_H
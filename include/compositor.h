@@ -0,0 +1,45 @@
+// include/compositor.h
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include "string_utils.h" // Für bool
+#include "blit.h"
+
+/**
+ * Kachel-Compositor: Zeichenbefehle werden zunächst in einer Display-Liste
+ * gesammelt und erst mit comp_render() gerastert. Der Bildschirm ist in
+ * COMP_TILE x COMP_TILE große Kacheln geteilt; Kachel i gehört Core
+ * i % cores. Jeder Core zeichnet die Liste in Reihenfolge, begrenzt auf
+ * seine Kacheln. Da eine Kachelbreite ein Vielfaches der Cache-Zeile ist,
+ * schreiben nie zwei Cores in dieselbe Zeile, und das Ergebnis ist für jede
+ * Core-Anzahl Pixel für Pixel gleich.
+ *
+ * Texte und Punktlisten werden kopiert; Bilder müssen bis comp_render()
+ * gültig bleiben. Die comp_...-Funktionen liefern false, wenn die Liste
+ * voll ist.
+ */
+
+#define COMP_TILE      64
+#define COMP_MAX_CMDS  1024
+#define COMP_ARENA     (32 * 1024) // Für Texte und Punktlisten
+
+// Leert die Display-Liste
+void comp_begin();
+
+// Entsprechen den draw...-Funktionen aus fb.h bzw. blit_mode()
+bool comp_clear(unsigned char attr);
+bool comp_rect(int x1, int y1, int x2, int y2, unsigned char attr, int fill);
+bool comp_line(int x1, int y1, int x2, int y2, unsigned char attr);
+bool comp_circle(int x0, int y0, int radius, unsigned char attr, int fill);
+bool comp_triangle(int x1, int y1, int x2, int y2, int x3, int y3, unsigned char attr, int fill);
+bool comp_polygon(const int* points, int count, unsigned char attr, int fill);
+bool comp_text(int x, int y, const char* s, unsigned char attr);
+bool comp_blit(const Image* img, int x, int y, int mode);
+
+// Rastert die Liste mit den ersten 'cores' Cores (siehe smp_run), danach fb_flush()
+void comp_render(unsigned int cores);
+
+// Anzahl der Befehle in der Liste
+unsigned int comp_count();
+
+#endif // COMPOSITOR_H
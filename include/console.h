@@ -2,20 +2,39 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
-
+#include "string_utils.h" // Für bool
 
 // Initialisiert UART und Framebuffer für die Konsole
 void console_init();
 
+// Unterdrückt alle Ausgaben (z.B. im Batch-Modus der Shell)
+void console_set_mute(bool mute);
+
 // Schreibt ein einzelnes Zeichen auf die Konsole (UART und Framebuffer)
 void console_putc(char c);
 
 // Schreibt einen String auf die Konsole (UART und Framebuffer)
 void console_puts(const char* s);
 
+/**
+ * Gibt n Bytes nur auf dem Framebuffer aus, ohne Echo auf dem UART und ohne
+ * fb_flush. Wie alle Ausgaben laufen sie durch den VT100/ANSI-Interpreter:
+ * Cursor (CUU/CUD/CUF/CUB/CUP/HVP/CHA/VPA, ESC 7/8), Löschen (ED/EL/ECH),
+ * Einfügen/Entfernen (IL/DL/ICH/DCH), Scroll-Bereich (DECSTBM, SU/SD,
+ * IND/RI), Farben (SGR 0/1/7/22/27, 30-37, 40-47, 90-97, 100-107) und
+ * die Cursorabfrage ESC[6n.
+ */
+void console_render(const char* s, unsigned long n);
+
+// Schreibt n Zeichen auf die Konsole, z.B. Dateiinhalte ohne Null-Terminator
+void console_write(const char* s, unsigned long n);
+
 // Schreibt eine vorzeichenbehaftete Ganzzahl auf die Konsole
 void console_putint(int i);
 
+// Schreibt eine vorzeichenbehaftete 64-Bit-Ganzzahl auf die Konsole
+void console_putlong(long l);
+
 // Schreibt eine vorzeichenlose Ganzzahl im Hexadezimalformat auf die Konsole
 void console_puthex(unsigned int val);
 
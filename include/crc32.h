@@ -0,0 +1,13 @@
+// include/crc32.h
+#ifndef CRC32_H
+#define CRC32_H
+
+/**
+ * CRC-32 (IEEE 802.3, wie zlib/PNG/Ethernet).
+ * Aufruf wie bei zlib: mit crc = 0 beginnen und das Ergebnis für weitere
+ * Daten wieder hineingeben. Die Datei hat keine Kernel-Abhängigkeiten und
+ * wird auch für die Host-Werkzeuge in tools/ mitübersetzt.
+ */
+unsigned int crc32_update(unsigned int crc, const void* data, unsigned long len);
+
+#endif // CRC32_H
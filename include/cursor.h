@@ -0,0 +1,55 @@
+// include/cursor.h
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Cursor über dem Framebuffer. Wenn die Firmware die Tags "set cursor info"
+ * und "set cursor state" kennt, legt der VideoCore das Sprite als eigene
+ * Ebene über das Bild: Bewegen kostet einen Mailbox-Aufruf und keinen
+ * einzigen Schreibzugriff auf den Framebuffer.
+ *
+ * Sonst (oder mit "cursor sw") wird das Sprite in den Framebuffer geblittet
+ * und die Pixel darunter gesichert. Zeichnet jemand über fb.h oder blit.h an
+ * der Cursorstelle, entfernt sich der Cursor vorher selbst (fb_set_draw_hook)
+ * und erscheint mit dem nächsten cursor_move bzw. cursor_redraw wieder; die
+ * Konsole ruft cursor_erase und cursor_redraw selbst auf. Wer direkt in
+ * fb_buffer() schreibt, meldet das vorher mit fb_begin_draw. Beim
+ * Hardware-Cursor tun cursor_erase und cursor_redraw nichts.
+ */
+
+// Wer den Cursor führt: die Textkonsole (Unterstrich an der Schreibposition)
+// oder ein Zeigegerät (Pfeil)
+enum {
+    CURSOR_CONSOLE,
+    CURSOR_POINTER
+};
+
+// Nach fb_init aufrufen; versucht zuerst den Hardware-Cursor
+void cursor_init();
+
+// Position des Hotspots in Framebuffer-Pixeln
+void cursor_move(int x, int y);
+void cursor_show(bool visible);
+
+void cursor_set_owner(int owner);
+int cursor_owner();
+
+// Nur Software-Cursor: Pixel unter dem Sprite wiederherstellen bzw. das
+// Sprite an der alten Stelle neu zeichnen
+void cursor_erase();
+void cursor_redraw();
+
+bool cursor_is_hardware();
+
+typedef struct {
+    unsigned long moves;          // Aufrufe von cursor_move
+    unsigned long firmware_calls; // Mailbox-Aufrufe
+    unsigned long redraws;        // Software: Sprite gezeichnet
+    unsigned long overdrawn;      // Software: vor fremdem Zeichnen entfernt
+} CursorStats;
+
+const CursorStats* cursor_stats();
+
+#endif // CURSOR_H
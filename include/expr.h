@@ -0,0 +1,59 @@
+// include/expr.h
+#ifndef EXPR_H
+#define EXPR_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Ausdrucksauswertung für die Shell.
+ *
+ * Ein Ausdruck wird einmal von einem Pratt-Parser in kompakten Bytecode
+ * übersetzt, den eine kleine Register-VM ausführt. Variablen werden schon beim
+ * Übersetzen in Slots des Variablenspeichers (vars.h) aufgelöst.
+ *
+ * Operatoren (nach Priorität, stärkste zuletzt):
+ *   |   ^   &   == !=   < <= > >=   << >>   + -   * / %   unär - ~ !
+ * Zahlen dezimal oder hexadezimal (0x...), Klammern erlaubt. Vergleiche
+ * liefern 0 oder 1. Gerechnet wird mit 64-Bit-Ganzzahlen.
+ */
+
+enum {
+    EXPR_OK = 0,
+    EXPR_ERR_SYNTAX,
+    EXPR_ERR_UNKNOWN_VAR,
+    EXPR_ERR_TOO_COMPLEX,
+    EXPR_ERR_DIV_ZERO
+};
+
+#define EXPR_MAX_CODE   48  // Befehle pro Ausdruck
+#define EXPR_MAX_CONSTS 16  // Konstanten pro Ausdruck
+#define EXPR_MAX_REGS   16  // Register der VM
+#define EXPR_MAX_DEPTH  32  // Schachtelungstiefe von Klammern und unären Operatoren
+
+typedef struct {
+    unsigned char op;
+    unsigned char dst;
+    unsigned char a;
+    unsigned char b;
+} ExprInsn;
+
+typedef struct {
+    ExprInsn code[EXPR_MAX_CODE];
+    long consts[EXPR_MAX_CONSTS];
+    unsigned char code_len;
+    unsigned char const_count;
+} ExprProgram;
+
+// Übersetzt einen Ausdruck. Liefert EXPR_OK oder einen Fehlercode.
+int expr_compile(const char* src, ExprProgram* prog);
+
+// Führt ein übersetztes Programm aus
+int expr_run(const ExprProgram* prog, long* result);
+
+// Übersetzen (oder aus dem LRU-Cache holen) und ausführen
+int expr_eval(const char* src, long* result);
+
+// Lesbarer Text zu einem Fehlercode
+const char* expr_error_string(int err);
+
+#endif // EXPR_H
@@ -0,0 +1,111 @@
+// include/fat.h
+#ifndef FAT_H
+#define FAT_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * FAT32 auf der SD-Karte (die Boot-Partition mit kernel8.img), nur lesend.
+ * Alle Zugriffe gehen über den Block-Cache (bcache.h).
+ *
+ * Beschleunigt wird an drei Stellen:
+ *   - Clusterketten werden beim ersten Öffnen einmal abgelaufen und zu
+ *     Extents (Startcluster, Länge) zusammengefasst; die Extents bleiben in
+ *     einem kleinen LRU-Cache, sodass die FAT nicht erneut gelesen wird.
+ *   - Ein Verzeichniscache bildet Pfade direkt auf ihren Eintrag ab.
+ *   - fat_read liest zusammenhängende Cluster mit einem einzigen
+ *     Mehrblock-Zugriff.
+ *
+ * Dateien werden gestreamt: fat_read und fat_read_line lesen ab der
+ * aktuellen Position, ohne die Datei im Speicher abzulegen. Pfade sind
+ * relativ zur Wurzel der Partition, Groß-/Kleinschreibung egal, lange
+ * Dateinamen (VFAT) werden unterstützt (Zeichen außerhalb ASCII als '?').
+ */
+
+enum {
+    FAT_OK = 0,
+    FAT_ERR_NOT_MOUNTED,
+    FAT_ERR_FORMAT,     // Keine FAT32-Partition
+    FAT_ERR_IO,         // Lesefehler der Karte
+    FAT_ERR_CORRUPT,    // Kaputte Clusterkette
+    FAT_ERR_NOT_FOUND,
+    FAT_ERR_NOT_DIR,
+    FAT_ERR_IS_DIR,
+    FAT_ERR_RANGE       // Position hinter dem Dateiende
+};
+
+#define FAT_NAME_MAX 256
+
+enum {
+    FAT_ATTR_READONLY  = 0x01,
+    FAT_ATTR_HIDDEN    = 0x02,
+    FAT_ATTR_SYSTEM    = 0x04,
+    FAT_ATTR_VOLUME    = 0x08,
+    FAT_ATTR_DIRECTORY = 0x10,
+    FAT_ATTR_ARCHIVE   = 0x20,
+    FAT_ATTR_LFN       = 0x0F
+};
+
+typedef struct {
+    char name[FAT_NAME_MAX];
+    unsigned int cluster;
+    unsigned int size;
+    unsigned char attr;
+} FatDirEntry;
+
+// Geöffnete Datei oder geöffnetes Verzeichnis
+typedef struct {
+    unsigned int cluster;       // Erster Cluster, 0 bei leeren Dateien
+    unsigned long size;         // Verzeichnisse: Länge der Clusterkette
+    unsigned long pos;
+    bool dir;
+    unsigned int walk_index;    // Position in der Kette jenseits der Extents
+    unsigned int walk_cluster;
+} FatFile;
+
+typedef struct {
+    unsigned long chain_hits, chain_misses;     // Extent-Cache
+    unsigned long fat_reads;                    // Gelesene FAT-Einträge
+    unsigned long dir_hits, dir_misses;         // Verzeichniscache
+    unsigned long dir_scans;                    // Gelesene Verzeichniseinträge
+} FatStats;
+
+// Sucht die FAT32-Partition (erste Partition oder Karte ohne Partitionstabelle)
+int fat_mount();
+bool fat_mounted();
+
+int fat_open(const char* path, FatFile* file);
+
+// Liest bis zu n Bytes ab der aktuellen Position; Bytes oder -Fehlercode
+long fat_read(FatFile* file, void* buffer, unsigned long n);
+
+int fat_seek(FatFile* file, unsigned long pos);
+
+// Rückgabe von fat_read_line am Dateiende (Fehler sind -FAT_ERR_*)
+#define FAT_EOF (-100)
+
+/**
+ * Liest eine Zeile ohne '\n' (und ohne '\r'). Liefert die volle Länge der
+ * Zeile, FAT_EOF am Dateiende oder -Fehlercode. Ist die Länge >= size, passte
+ * die Zeile nicht und im Puffer steht nur ihr Anfang.
+ */
+int fat_read_line(FatFile* file, char* buffer, unsigned int size);
+
+/**
+ * Block auf der Karte, in dem das Byte pos der Datei liegt, und wie viele
+ * Blöcke der Datei ab dort am Stück folgen. Damit lässt sich eine Datei
+ * fester Größe an Ort und Stelle beschreiben (bcache_write), ohne FAT oder
+ * Verzeichnis zu ändern.
+ */
+int fat_map(FatFile* file, unsigned long pos, unsigned long* lba, unsigned long* blocks);
+
+// Nächster Eintrag eines Verzeichnisses: 1 = Eintrag, 0 = Ende, < 0 Fehler
+int fat_readdir(FatFile* dir, FatDirEntry* entry);
+
+// Leert Extent- und Verzeichniscache (z.B. für Messungen)
+void fat_drop_caches();
+
+const FatStats* fat_stats();
+const char* fat_error_string(int err);
+
+#endif // FAT_H
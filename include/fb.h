@@ -1,7 +1,120 @@
+#ifndef FB_H
+#define FB_H
+
+#include "string_utils.h" // Für bool
+
+// Rechteck mit inklusiven Grenzen
+typedef struct {
+    int x1, y1, x2, y2;
+} FbRect;
+
+// Größe eines Zeichens der eingebauten Schrift (siehe terminal.h)
+#define FB_FONT_WIDTH  8
+#define FB_FONT_HEIGHT 8
+
 void fb_init();
+unsigned int fb_width();
+unsigned int fb_height();
+unsigned int fb_pitch();        // Bytes pro Zeile
+unsigned char *fb_buffer();     // NULL, wenn fb_init fehlgeschlagen ist
+unsigned int fb_depth();        // Bits pro Pixel
+
+/**
+ * Schaltet auf 32 Bit (0xRRGGBB), 16 Bit (RGB565) oder 8 Bit mit Palette
+ * um. Die 8-Bit-Palette enthält die 16 VGA-Farben, einen 6x6x6-Farbwürfel
+ * ab Index 16 und 24 Graustufen ab Index 232. Der Bildschirminhalt ist
+ * danach undefiniert, die Clip-Rechtecke sind zurückgesetzt.
+ */
+bool fb_set_depth(unsigned int bpp);
+
+// Pixelwert für eine Farbe 0xRRGGBB bzw. eine VGA-Farbe im aktuellen Format
+unsigned int fb_map_rgb(unsigned int rgb);
+unsigned int fb_color(unsigned char attr);
+
+// Umkehrung von fb_map_rgb: Pixelwert aus dem Framebuffer als 0xRRGGBB
+unsigned int fb_pixel_to_rgb(unsigned int pixel);
+
+static inline unsigned int fb_rgb565(unsigned int rgb)
+{
+    return ((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F);
+}
+
+// Nächster Eintrag im Farbwürfel der 8-Bit-Palette; (c*5+128)>>8 rundet auf 0..5
+static inline unsigned int fb_cube_index(unsigned int rgb)
+{
+    unsigned int r = (((rgb >> 16) & 0xFF) * 5 + 128) >> 8;
+    unsigned int g = (((rgb >> 8) & 0xFF) * 5 + 128) >> 8;
+    unsigned int b = ((rgb & 0xFF) * 5 + 128) >> 8;
+    return 16 + r * 36 + g * 6 + b;
+}
+
+/**
+ * Schattenpuffer: Ist er an, zeichnen alle Primitive (und fb_buffer()) in
+ * eine Kopie im cachebaren RAM. Geänderte Bereiche werden als Rechtecke
+ * gesammelt; erst fb_flush() kopiert sie in den Framebuffer der GPU, der
+ * selbst nicht cachebar ist. Ohne Schattenpuffer tut fb_flush nichts.
+ */
+bool fb_set_shadow(bool on);
+
+// Framebuffer der GPU, auch wenn der Schattenpuffer an ist
+unsigned char *fb_front_buffer();
+
+// Kopiert alle geänderten Bereiche; liefert die kopierten Bytes
+unsigned long fb_flush();
+
+// Für Code, der selbst in fb_buffer() schreibt (z.B. Blits)
+void fb_mark_dirty(int x1, int y1, int x2, int y2);
+
+/**
+ * Wird vor jedem Zeichnen mit dem betroffenen Rechteck aufgerufen (nicht
+ * geclippt), solange ein Hook gesetzt ist. Der Software-Cursor entfernt sich
+ * darüber, bevor jemand über ihn zeichnet. Die Zeichenfunktionen aus fb.h und
+ * blit.h tun das selbst, wer direkt in fb_buffer() schreibt, ruft vorher
+ * fb_begin_draw auf.
+ */
+typedef void (*fb_draw_hook_t)(int x1, int y1, int x2, int y2);
+void fb_set_draw_hook(fb_draw_hook_t hook);
+void fb_begin_draw(int x1, int y1, int x2, int y2);
+
+typedef struct {
+    unsigned long flushes;
+    unsigned long drawn, flushed;             // Beim letzten fb_flush
+    unsigned long total_drawn, total_flushed; // Seit dem Einschalten
+} FbStats;
+
+const FbStats *fb_stats();
+
+// Alles Zeichnen wird auf das Clip-Rechteck des aufrufenden Cores begrenzt
+// (Standard: ganzer Bildschirm). Es wird mit dem Bildschirm geschnitten.
+void fb_set_clip(int x1, int y1, int x2, int y2);
+void fb_reset_clip();
+const FbRect *fb_get_clip();
+
 void drawPixel(int x, int y, unsigned char attr);
 void drawChar(unsigned char ch, int x, int y, unsigned char attr);
 void drawString(int x, int y, char *s, unsigned char attr);
 void drawRect(int x1, int y1, int x2, int y2, unsigned char attr, int fill);
 void drawCircle(int x0, int y0, int radius, unsigned char attr, int fill);
+void drawEllipse(int x0, int y0, int rx, int ry, unsigned char attr, int fill);
+
+// Füllt das Rechteck (inklusive Grenzen) ganz mit der Farbe attr & 0x0f
+void fb_fill_rect(int x1, int y1, int x2, int y2, unsigned char attr);
+
+// Verschiebt w x h Pixel ab (x, y) um (dx, dy); Quelle und Ziel dürfen
+// sich überlappen (Scrollen). Das Ziel wird auf das Clip-Rechteck begrenzt.
+void fb_move_rect(int x, int y, int w, int h, int dx, int dy);
+
+// Flächen: Umriss in attr & 0x0f, Füllung (fill != 0) in attr >> 4.
+// Gefüllt werden linke/obere Kanten inklusive, rechte/untere exklusive.
+void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, unsigned char attr, int fill);
+
+// count Punkte als x,y-Paare, höchstens 256; konkav erlaubt (Even-Odd-Regel)
+void drawPolygon(const int *points, int count, unsigned char attr, int fill);
+
+// Linien werden am Bildschirmrand geclippt, Endpunkte sind inklusive
 void drawLine(int x1, int y1, int x2, int y2, unsigned char attr);
+
+// Verbindet count Punkte (x,y-Paare in points) zu count-1 Segmenten
+void drawPolyline(const int *points, int count, unsigned char attr);
+
+#endif // FB_H
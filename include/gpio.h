@@ -1,14 +1,114 @@
 #ifndef GPIO_H
 #define GPIO_H
 
-#define PERIPHERAL_BASE 0xFE000000
-// MMIO (wird von GPIO und UART gebraucht, passt gut hierher)
-void mmio_write(long reg, unsigned int val);
-unsigned int mmio_read(long reg);
-
-// GPIO Funktionen
-void gpio_useAsAlt5(unsigned int pin_number);
-void gpio_initOutputPinWithPullNone(unsigned int pin_number);
-void gpio_setPinOutputBool(unsigned int pin_number, unsigned int onOrOff);
+// MMIO-Zugriffe und Registeradressen (PERIPHERAL_BASE, GPIO-Register, ...)
+#include "mmio.h"
+#include "regs.h"
+
+enum {
+    GPIO_MAX_PIN        = 53,
+    GPIO_FUNCTION_IN    = 0,
+    GPIO_FUNCTION_OUT   = 1,
+    GPIO_FUNCTION_ALT0  = 4,
+    GPIO_FUNCTION_ALT1  = 5,
+    GPIO_FUNCTION_ALT2  = 6,
+    GPIO_FUNCTION_ALT3  = 7,
+    GPIO_FUNCTION_ALT4  = 3,
+    GPIO_FUNCTION_ALT5  = 2
+};
+
+enum {
+    Pull_None = 0,
+    Pull_Down = 2,
+    Pull_Up   = 1
+};
+
+// ##################################
+// ## Einzelne Pins
+// ##################################
+// Alles static inline: Bei konstanter Pin-Nummer faltet der Compiler
+// Registeradresse, Shift und Bereichsprüfung weg.
+
+static inline unsigned int gpio_call(unsigned int pin_number, unsigned int value, long base, unsigned int field_size, unsigned int field_max) {
+    if (pin_number > field_max) return 0;
+    if (value > (1u << field_size) - 1) return 0;
+
+    mmio_field_set(GPIO_PIN_FIELD(base, pin_number, field_size), value);
+    return 1;
+}
+
+// GPSET/GPCLR wirken nur auf die geschriebenen 1-Bits - ein einzelner
+// Schreibzugriff genügt, Lesen-Ändern-Schreiben wäre überflüssig.
+static inline unsigned int gpio_write_bit(unsigned int pin_number, unsigned int value, long base) {
+    if (pin_number > GPIO_MAX_PIN) return 0;
+    if (value > 1) return 0;
+
+    if (value) mmio_write(base + (pin_number / 32) * 4, 1u << (pin_number % 32));
+    return 1;
+}
+
+static inline unsigned int gpio_set     (unsigned int pin_number, unsigned int value) { return gpio_write_bit(pin_number, value, GPSET0); }
+static inline unsigned int gpio_clear   (unsigned int pin_number, unsigned int value) { return gpio_write_bit(pin_number, value, GPCLR0); }
+static inline unsigned int gpio_pull    (unsigned int pin_number, unsigned int value) { return gpio_call(pin_number, value, GPPUPPDN0, 2, GPIO_MAX_PIN); }
+static inline unsigned int gpio_function(unsigned int pin_number, unsigned int value) { return gpio_call(pin_number, value, GPFSEL0, 3, GPIO_MAX_PIN); }
+
+static inline void gpio_useAsAlt5(unsigned int pin_number) {
+    gpio_pull(pin_number, Pull_None);
+    gpio_function(pin_number, GPIO_FUNCTION_ALT5);
+}
+
+static inline void gpio_initOutputPinWithPullNone(unsigned int pin_number) {
+    gpio_pull(pin_number, Pull_None);
+    gpio_function(pin_number, GPIO_FUNCTION_OUT);
+}
+
+static inline void gpio_setPinOutputBool(unsigned int pin_number, unsigned int onOrOff) {
+    if (onOrOff) {
+        gpio_set(pin_number, 1);
+    } else {
+        gpio_clear(pin_number, 1);
+    }
+}
+
+// ##################################
+// ## Mehrere Pins auf einmal
+// ##################################
+// Bank 0 = GPIO 0-31, Bank 1 = GPIO 32-53. Bit n der Maske steht für Pin (32 * bank + n).
+
+static inline void gpio_set_mask(unsigned int bank, unsigned int mask) {
+    if (bank > 1) return;
+    mmio_write(GPSET0 + bank * 4, mask);
+}
+
+static inline void gpio_clear_mask(unsigned int bank, unsigned int mask) {
+    if (bank > 1) return;
+    mmio_write(GPCLR0 + bank * 4, mask);
+}
+
+/**
+ * Setzt die Pins aus 'mask' auf die entsprechenden Bits aus 'value'.
+ * Braucht höchstens zwei Schreibzugriffe (GPSET und GPCLR) und nie einen Lesezugriff.
+ */
+static inline void gpio_write_masked(unsigned int bank, unsigned int mask, unsigned int value) {
+    if (bank > 1) return;
+    unsigned int set = mask & value;
+    unsigned int clear = mask & ~value;
+    if (set) mmio_write(GPSET0 + bank * 4, set);
+    if (clear) mmio_write(GPCLR0 + bank * 4, clear);
+}
+
+static inline unsigned int gpio_read_bank(unsigned int bank) {
+    if (bank > 1) return 0;
+    return mmio_read(GPLEV0 + bank * 4);
+}
+
+// Konfiguriert viele Pins und schreibt dabei jedes GPFSEL-/Pull-Register nur einmal
+typedef struct {
+    unsigned char pin;
+    unsigned char function; // GPIO_FUNCTION_...
+    unsigned char pull;     // Pull_...
+} GpioPinConfig;
+
+void gpio_configure(const GpioPinConfig* pins, unsigned int count);
 
 #endif // GPIO_H
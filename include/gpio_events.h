@@ -0,0 +1,51 @@
+// include/gpio_events.h
+#ifndef GPIO_EVENTS_H
+#define GPIO_EVENTS_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Ereigniserkennung an GPIO-Eingängen (GPREN/GPFEN/GPHEN/GPLEN/GPAREN/GPAFEN).
+ * Die Erkennung läuft in Hardware; die GPIO-Bank-Interrupts holen die
+ * Ereignisse ab, versehen sie mit einem Zeitstempel des Generic Timers und
+ * legen sie in eine lock-freie Queue (ein Produzent: der Interrupt, ein
+ * Konsument: die Hauptschleife).
+ *
+ * Pegel-Ereignisse (HIGH/LOW) sind "one-shot": Nach dem ersten Ereignis wird
+ * die Pegelerkennung für den Pin abgeschaltet, sonst würde der Interrupt bei
+ * anliegendem Pegel ständig neu auslösen. gpio_event_enable schaltet sie
+ * wieder scharf.
+ */
+
+enum {
+    GPIO_EVENT_RISING        = 1 << 0,   // Synchron abgetastete Flanken
+    GPIO_EVENT_FALLING       = 1 << 1,
+    GPIO_EVENT_HIGH          = 1 << 2,   // Pegel
+    GPIO_EVENT_LOW           = 1 << 3,
+    GPIO_EVENT_ASYNC_RISING  = 1 << 4,   // Asynchrone Flanken (auch sehr kurze Pulse)
+    GPIO_EVENT_ASYNC_FALLING = 1 << 5
+};
+
+typedef struct {
+    unsigned long timestamp;    // timer_ticks() beim Abholen im Interrupt
+    unsigned char pin;
+    unsigned char level;        // Pegel des Pins beim Abholen
+} GpioEvent;
+
+// Wird im Interrupt-Kontext aufgerufen - kurz halten!
+typedef void (*gpio_event_callback_t)(const GpioEvent* event);
+
+void gpio_events_init();
+
+// Schaltet die Erkennung 'types' (GPIO_EVENT_...) für einen Pin ein. Callback optional.
+bool gpio_event_enable(unsigned int pin, unsigned int types, gpio_event_callback_t callback);
+void gpio_event_disable(unsigned int pin);
+
+// Holt das älteste Ereignis aus der Queue. 'false', wenn sie leer ist.
+bool gpio_event_pop(GpioEvent* event);
+
+// Leert die Queue (für die Hauptschleife, wenn niemand sonst die Ereignisse braucht).
+// Liefert true, wenn Ereignisse anstanden.
+bool gpio_events_update();
+
+#endif // GPIO_EVENTS_H
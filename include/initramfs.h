@@ -0,0 +1,56 @@
+// include/initramfs.h
+#ifndef INITRAMFS_H
+#define INITRAMFS_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Eingebettetes Dateisystem: tools/mkcpio packt das Verzeichnis rootfs/ in
+ * ein cpio-Archiv (Format "newc"), das in der Linker-Section .initramfs im
+ * Kernel-Image landet. initramfs_init() baut daraus beim Start eine
+ * Hashtabelle der Pfade. Dateien werden nie kopiert: alle Funktionen
+ * liefern Zeiger direkt in das Image, die bis zum Neustart gültig bleiben.
+ *
+ * Pfade sind relativ zur Wurzel von rootfs/, z.B. "etc/motd"; ein
+ * führendes "/" oder "./" wird ignoriert.
+ */
+
+typedef struct {
+    const char* name;   // Pfad ohne führendes "/", nullterminiert
+    const void* data;   // Inhalt (nur bei regulären Dateien)
+    unsigned long size;
+    unsigned int mode;  // Typ und Rechte wie st_mode
+} InitramfsEntry;
+
+#define INITRAMFS_TYPE_MASK 0170000
+#define INITRAMFS_TYPE_DIR  0040000
+#define INITRAMFS_TYPE_FILE 0100000
+
+static inline bool initramfs_is_dir(const InitramfsEntry* e) {
+    return (e->mode & INITRAMFS_TYPE_MASK) == INITRAMFS_TYPE_DIR;
+}
+
+static inline bool initramfs_is_file(const InitramfsEntry* e) {
+    return (e->mode & INITRAMFS_TYPE_MASK) == INITRAMFS_TYPE_FILE;
+}
+
+/**
+ * Liest das Archiv und baut den Index auf. Ein fehlendes oder beschädigtes
+ * Archiv ergibt ein leeres Dateisystem (bis zur fehlerhaften Stelle).
+ */
+void initramfs_init();
+
+// Sucht einen Eintrag (Datei oder Verzeichnis); NULL, wenn es ihn nicht gibt
+const InitramfsEntry* initramfs_find(const char* path);
+
+/**
+ * Liefert den Inhalt einer regulären Datei und schreibt die Länge nach
+ * *size. NULL, wenn es keine Datei dieses Namens gibt.
+ */
+const void* initramfs_data(const char* path, unsigned long* size);
+
+// Einträge in Archivreihenfolge (mkcpio sortiert nach Pfad)
+unsigned int initramfs_count();
+const InitramfsEntry* initramfs_entry(unsigned int index);
+
+#endif // INITRAMFS_H
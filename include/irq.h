@@ -0,0 +1,38 @@
+// include/irq.h
+#ifndef IRQ_H
+#define IRQ_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Interrupts über den GIC-400 des BCM2711.
+ * Die Interrupt-IDs sind GIC-IDs: VideoCore-Peripherie-Interrupt n hat die
+ * ID 96 + n (siehe BCM2711-Datenblatt, Kapitel "ARM GIC").
+ */
+enum {
+    IRQ_GPIO_BANK0 = 96 + 49,   // GPIO 0-27
+    IRQ_GPIO_BANK1 = 96 + 50,   // GPIO 28-45
+    IRQ_GPIO_BANK2 = 96 + 51,   // GPIO 46-57
+    IRQ_MAX        = 256
+};
+
+typedef void (*irq_handler_t)(unsigned int id);
+
+// Initialisiert Distributor und CPU-Interface. Interrupts bleiben maskiert.
+void irq_init();
+
+// Registriert einen Handler und schaltet den Interrupt im GIC frei
+bool irq_register(unsigned int id, irq_handler_t handler);
+
+// Schaltet den Interrupt im GIC ab und entfernt den Handler
+void irq_unregister(unsigned int id);
+
+// IRQs auf diesem Core zulassen bzw. sperren
+void irq_enable();
+void irq_disable();
+
+// Sperrt IRQs und liefert den vorherigen Zustand für irq_restore
+unsigned long irq_save();
+void irq_restore(unsigned long flags);
+
+#endif // IRQ_H
@@ -1,4 +1,5 @@
-extern volatile unsigned int mbox[36];
+// 36 Worte Nachricht, auf ganze Cache-Zeilen aufgerundet (siehe mb.c)
+extern volatile unsigned int mbox[48];
 
 enum {
     MBOX_REQUEST  = 0
@@ -17,8 +18,16 @@ enum {
 };
 
 enum {
+    MBOX_TAG_GETBOARDREV = 0x10002,
+    MBOX_TAG_GETARMMEM  = 0x10005,
+
     MBOX_TAG_SETPOWER   = 0x28001,
+    MBOX_TAG_GETCLKRATE = 0x30002,
+    MBOX_TAG_GETMAXCLK  = 0x30004,
+    MBOX_TAG_GETMINCLK  = 0x30007,
+    MBOX_TAG_GETMEASCLK = 0x30047,
     MBOX_TAG_SETCLKRATE = 0x38002,
+    MBOX_TAG_SETGPIOSTATE = 0x38041, // GPIOs am Expander (ab 128)
 
     MBOX_TAG_SETPHYWH   = 0x48003,
     MBOX_TAG_SETVIRTWH  = 0x48004,
@@ -27,6 +36,10 @@ enum {
     MBOX_TAG_SETPXLORDR = 0x48006,
     MBOX_TAG_GETFB      = 0x40001,
     MBOX_TAG_GETPITCH   = 0x40008,
+    MBOX_TAG_SETPALETTE = 0x4800B,
+
+    MBOX_TAG_SETCURSORINFO  = 0x8010,
+    MBOX_TAG_SETCURSORSTATE = 0x8011,
 
     MBOX_TAG_LAST       = 0
 };
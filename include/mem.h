@@ -0,0 +1,29 @@
+// include/mem.h
+#ifndef MEM_H
+#define MEM_H
+
+/**
+ * Einfacher Bump-Allocator für den Kernel-Heap (Speicher hinter _end).
+ * Es gibt bewusst kein free(): Datenstrukturen, die wachsen, verdoppeln ihre
+ * Kapazität, sodass der "verlorene" alte Speicher höchstens so groß ist wie
+ * der aktuell genutzte.
+ */
+void mem_init();
+
+// Liefert 16-Byte-ausgerichteten Speicher oder NULL, wenn der Heap voll ist
+void* mem_alloc(unsigned long size);
+
+// Wie mem_alloc, aber mit frei wählbarer Ausrichtung (Zweierpotenz)
+void* mem_alloc_aligned(unsigned long size, unsigned long align);
+
+// Ende des ARM-Speichers unterhalb von 1 GB (danach folgt der GPU-Speicher)
+unsigned long mem_ram_end();
+
+// Installierter RAM insgesamt (laut Revisionscode der Firmware, sonst 1 GB)
+unsigned long mem_ram_total();
+
+// Statistik für Diagnosezwecke
+unsigned long mem_used();
+unsigned long mem_free();
+
+#endif // MEM_H
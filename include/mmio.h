@@ -0,0 +1,90 @@
+// include/mmio.h
+#ifndef MMIO_H
+#define MMIO_H
+
+/**
+ * MMIO-Zugriffe als static inline, damit jeder Registerzugriff ein einzelner
+ * ldr/str ist statt eines Funktionsaufrufs.
+ *
+ * Reihenfolge: Zugriffe auf dasselbe Peripheriegerät kommen in Programm-
+ * reihenfolge an. Zwischen verschiedenen Geräten (und zwischen normalem
+ * Speicher und einem Gerät, z.B. Mailbox-Puffer -> Mailbox) braucht es eine
+ * Barriere. Dafür gibt es die _acquire/_release/_sync-Varianten:
+ *   mmio_read_acquire:  Lesen, danach dmb  (spätere Zugriffe sehen das Ergebnis)
+ *   mmio_write_release: dmb, danach Schreiben (frühere Zugriffe sind sichtbar)
+ *   mmio_write_sync:    dsb, Schreiben, dsb (z.B. bevor ein Gerät per DMA liest)
+ */
+
+#define PERIPHERAL_BASE 0xFE000000
+
+// ##################################
+// ## Barrieren
+// ##################################
+
+static inline void dmb() { asm volatile("dmb sy" ::: "memory"); }
+static inline void dsb() { asm volatile("dsb sy" ::: "memory"); }
+static inline void isb() { asm volatile("isb" ::: "memory"); }
+
+// ##################################
+// ## Registerzugriffe
+// ##################################
+
+static inline unsigned int mmio_read(long reg) {
+    return *(volatile unsigned int *)reg;
+}
+
+static inline void mmio_write(long reg, unsigned int val) {
+    *(volatile unsigned int *)reg = val;
+}
+
+static inline unsigned int mmio_read_acquire(long reg) {
+    unsigned int val = mmio_read(reg);
+    dmb();
+    return val;
+}
+
+static inline void mmio_write_release(long reg, unsigned int val) {
+    dmb();
+    mmio_write(reg, val);
+}
+
+static inline void mmio_write_sync(long reg, unsigned int val) {
+    dsb();
+    mmio_write(reg, val);
+    dsb();
+}
+
+// ##################################
+// ## Registerfelder
+// ##################################
+// Ein Feld ist (Registeradresse, Bitposition, Breite). Bei konstanten
+// Deskriptoren faltet der Compiler Maske und Shift komplett weg.
+
+typedef struct {
+    long reg;
+    unsigned int shift;
+    unsigned int width;
+} RegField;
+
+#define REG_FIELD(reg, shift, width) ((RegField){ (reg), (shift), (width) })
+
+static inline unsigned int mmio_field_mask(RegField f) {
+    return (f.width >= 32 ? 0xFFFFFFFFu : ((1u << f.width) - 1)) << f.shift;
+}
+
+// Feld aus einem bereits gelesenen Registerwert holen
+static inline unsigned int mmio_field_extract(RegField f, unsigned int value) {
+    return (value & mmio_field_mask(f)) >> f.shift;
+}
+
+static inline unsigned int mmio_field_get(RegField f) {
+    return mmio_field_extract(f, mmio_read(f.reg));
+}
+
+// Lesen-Ändern-Schreiben eines Feldes
+static inline void mmio_field_set(RegField f, unsigned int value) {
+    unsigned int mask = mmio_field_mask(f);
+    mmio_write(f.reg, (mmio_read(f.reg) & ~mask) | ((value << f.shift) & mask));
+}
+
+#endif // MMIO_H
@@ -0,0 +1,28 @@
+// include/mmu.h
+#ifndef MMU_H
+#define MMU_H
+
+/**
+ * MMU und Caches. Die ersten 4 GB werden 1:1 in 2-MB-Blöcken abgebildet:
+ *   - ARM-RAM:           Normal, Write-Back (gecacht)
+ *   - VideoCore-Speicher: Normal, nicht gecacht (enthält den Framebuffer),
+ *     ebenso ein 2-MB-Block, den er sich mit dem ARM-RAM teilt
+ *   - Über 1 GB ohne bestückten RAM: nicht abgebildet
+ *   - Peripherie ab 0xFC000000: Device-nGnRnE
+ * Puffer, die die VideoCore liest oder schreibt (Mailbox), müssen mit den
+ * cache_...-Funktionen synchron gehalten werden.
+ */
+
+// Baut die Tabellen auf und schaltet MMU und Caches auf diesem Core ein
+void mmu_init();
+
+// Schaltet die MMU mit den Tabellen aus mmu_init ein (für Cores 1-3)
+void mmu_enable();
+
+// Schreibt geänderte Cache-Zeilen in den Speicher (vor einem Lesen durch die GPU)
+void cache_clean(const volatile void* addr, unsigned long size);
+
+// Schreibt zurück und verwirft die Zeilen (nach einem Schreiben durch die GPU)
+void cache_flush(const volatile void* addr, unsigned long size);
+
+#endif // MMU_H
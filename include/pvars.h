@@ -0,0 +1,71 @@
+// include/pvars.h
+#ifndef PVARS_H
+#define PVARS_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Persistente Shell-Variablen in der Datei vars.log auf der FAT-Partition
+ * der SD-Karte. Die Datei wird einmal auf dem Host in fester Größe angelegt
+ * (z.B. 256 KB Nullen) und danach an Ort und Stelle beschrieben (fat_map);
+ * FAT und Verzeichnis ändern sich nie.
+ *
+ * Die Datei besteht aus zwei Hälften. In die aktive Hälfte werden nur
+ * Records angehängt (Name, Wert, CRC32). Ist sie voll, schreibt die
+ * Kompaktierung den aktuellen Stand in die andere Hälfte und macht sie
+ * erst danach mit einer höheren Generation im Kopfblock gültig. Beim Booten
+ * wird die Hälfte mit der höchsten gültigen Generation bis zum ersten
+ * ungültigen Record gelesen. Die Werte landen direkt in der
+ * Variablentabelle (vars.h), die damit auch der Index ist.
+ *
+ * pvars_set legt den Record nur im RAM ab (Group Commit). Auf die Karte
+ * kommen alle neuen Records mit einem Schreibzugriff, sobald die Shell
+ * PVARS_COMMIT_DELAY_MS lang nichts mehr setzt (pvars_update in der
+ * Hauptschleife), der Puffer voll ist oder pvars_sync aufgerufen wird.
+ * Ein Absturz kostet höchstens die bis dahin ungeschriebenen Records.
+ */
+
+#define PVARS_FILE            "vars.log"
+#define PVARS_NAME_MAX        64    // Längere Namen bleiben flüchtig
+#define PVARS_COMMIT_DELAY_MS 20
+
+enum {
+    PVARS_OK = 0,
+    PVARS_ERR_NOT_MOUNTED,
+    PVARS_ERR_NO_FILE,  // Kein vars.log auf der Karte
+    PVARS_ERR_TOO_SMALL,
+    PVARS_ERR_IO,
+    PVARS_ERR_FULL,     // Der aktuelle Stand passt nicht in eine Hälfte
+    PVARS_ERR_NAME,     // Name zu lang
+    PVARS_ERR_MEMORY    // Heap voll (Variablentabelle)
+};
+
+typedef struct {
+    unsigned long restore_us;       // Dauer von pvars_mount
+    unsigned long restored;         // Dabei übernommene Records
+    unsigned long scanned_blocks;
+    unsigned long appends;          // Records seit dem Booten
+    unsigned long commits;          // Schreibzugriffe (Group Commits)
+    unsigned long committed_blocks;
+    unsigned long compactions;
+    unsigned long errors;           // Fehlgeschlagene Commits in pvars_update
+} PvarsStats;
+
+// Öffnet vars.log und stellt die Variablen wieder her; nach fat_mount
+int pvars_mount();
+bool pvars_mounted();
+
+// vars_set und, sofern vars.log bereit ist, ein Record im Log.
+// Ohne vars.log: PVARS_ERR_NOT_MOUNTED, die Variable ist trotzdem gesetzt.
+int pvars_set(const char* name, long value);
+
+// Schreibt alle ausstehenden Records auf die Karte
+int pvars_sync();
+
+// Für die Hauptschleife: Group Commit nach einer Pause; true, wenn geschrieben wurde
+bool pvars_update();
+
+const PvarsStats* pvars_stats();
+const char* pvars_error_string(int err);
+
+#endif // PVARS_H
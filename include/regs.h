@@ -0,0 +1,155 @@
+// include/regs.h
+#ifndef REGS_H
+#define REGS_H
+
+#include "mmio.h"
+
+/**
+ * Registeradressen und -felder der BCM2711-Peripherie, die der Kernel nutzt.
+ * Quelle: BCM2711 ARM Peripherals.
+ */
+
+// ##################################
+// ## GPIO
+// ##################################
+
+enum {
+    GPIO_BASE   = PERIPHERAL_BASE + 0x200000,
+    GPFSEL0     = GPIO_BASE + 0x00,     // 10 Pins pro Register, 3 Bit pro Pin
+    GPSET0      = GPIO_BASE + 0x1C,
+    GPCLR0      = GPIO_BASE + 0x28,
+    GPLEV0      = GPIO_BASE + 0x34,
+    GPEDS0      = GPIO_BASE + 0x40,     // Event Detect Status (1 schreiben = löschen)
+    GPREN0      = GPIO_BASE + 0x4C,
+    GPFEN0      = GPIO_BASE + 0x58,
+    GPHEN0      = GPIO_BASE + 0x64,
+    GPLEN0      = GPIO_BASE + 0x70,
+    GPAREN0     = GPIO_BASE + 0x7C,
+    GPAFEN0     = GPIO_BASE + 0x88,
+    GPPUPPDN0   = GPIO_BASE + 0xE4      // 16 Pins pro Register, 2 Bit pro Pin
+};
+
+// Feld eines Pins in einem Register mit 'bits' Bit pro Pin
+#define GPIO_PIN_FIELD(base, pin, bits) \
+    REG_FIELD((base) + ((pin) / (32 / (bits))) * 4, ((pin) % (32 / (bits))) * (bits), (bits))
+
+// ##################################
+// ## AUX / Mini-UART
+// ##################################
+
+enum {
+    AUX_BASE        = PERIPHERAL_BASE + 0x215000,
+    AUX_ENABLES     = AUX_BASE + 4,
+    AUX_MU_IO_REG   = AUX_BASE + 64,
+    AUX_MU_IER_REG  = AUX_BASE + 68,
+    AUX_MU_IIR_REG  = AUX_BASE + 72,
+    AUX_MU_LCR_REG  = AUX_BASE + 76,
+    AUX_MU_MCR_REG  = AUX_BASE + 80,
+    AUX_MU_LSR_REG  = AUX_BASE + 84,
+    AUX_MU_CNTL_REG = AUX_BASE + 96,
+    AUX_MU_STAT_REG = AUX_BASE + 100,
+    AUX_MU_BAUD_REG = AUX_BASE + 104
+};
+
+#define AUX_MU_LSR_DATA_READY REG_FIELD(AUX_MU_LSR_REG, 0, 1)
+#define AUX_MU_LSR_RX_OVERRUN REG_FIELD(AUX_MU_LSR_REG, 1, 1)
+#define AUX_MU_LSR_TX_EMPTY   REG_FIELD(AUX_MU_LSR_REG, 5, 1) // Platz in der Sende-FIFO
+#define AUX_MU_LSR_TX_IDLE    REG_FIELD(AUX_MU_LSR_REG, 6, 1) // FIFO und Schieberegister leer
+
+#define AUX_MU_CNTL_RX_ENABLE REG_FIELD(AUX_MU_CNTL_REG, 0, 1)
+#define AUX_MU_CNTL_TX_ENABLE REG_FIELD(AUX_MU_CNTL_REG, 1, 1)
+#define AUX_MU_CNTL_RTS_AUTO  REG_FIELD(AUX_MU_CNTL_REG, 2, 1)
+#define AUX_MU_CNTL_CTS_AUTO  REG_FIELD(AUX_MU_CNTL_REG, 3, 1)
+
+// ##################################
+// ## Mailbox
+// ##################################
+
+enum {
+    VIDEOCORE_MBOX = PERIPHERAL_BASE + 0x0000B880,
+    MBOX_READ      = VIDEOCORE_MBOX + 0x0,
+    MBOX_POLL      = VIDEOCORE_MBOX + 0x10,
+    MBOX_SENDER    = VIDEOCORE_MBOX + 0x14,
+    MBOX_STATUS    = VIDEOCORE_MBOX + 0x18,
+    MBOX_CONFIG    = VIDEOCORE_MBOX + 0x1C,
+    MBOX_WRITE     = VIDEOCORE_MBOX + 0x20
+};
+
+#define MBOX_STATUS_EMPTY REG_FIELD(MBOX_STATUS, 30, 1)
+#define MBOX_STATUS_FULL  REG_FIELD(MBOX_STATUS, 31, 1)
+
+// ##################################
+// ## EMMC2 (SD-Karte, SDHCI-kompatibel)
+// ##################################
+
+enum {
+    EMMC_BASE         = PERIPHERAL_BASE + 0x340000,
+    EMMC_ARG2         = EMMC_BASE + 0x00,
+    EMMC_BLKSIZECNT   = EMMC_BASE + 0x04,   // Blockgröße (Bit 0-9), Anzahl (Bit 16-31)
+    EMMC_ARG1         = EMMC_BASE + 0x08,
+    EMMC_CMDTM        = EMMC_BASE + 0x0C,   // Transfer-Modus und Befehl, startet den Befehl
+    EMMC_RESP0        = EMMC_BASE + 0x10,
+    EMMC_RESP1        = EMMC_BASE + 0x14,
+    EMMC_RESP2        = EMMC_BASE + 0x18,
+    EMMC_RESP3        = EMMC_BASE + 0x1C,
+    EMMC_DATA         = EMMC_BASE + 0x20,
+    EMMC_STATUS       = EMMC_BASE + 0x24,
+    EMMC_CONTROL0     = EMMC_BASE + 0x28,
+    EMMC_CONTROL1     = EMMC_BASE + 0x2C,
+    EMMC_INTERRUPT    = EMMC_BASE + 0x30,   // 1 schreiben = löschen
+    EMMC_IRPT_MASK    = EMMC_BASE + 0x34,   // Welche Ereignisse in INTERRUPT erscheinen
+    EMMC_IRPT_EN      = EMMC_BASE + 0x38,   // Welche davon einen Interrupt auslösen
+    EMMC_CONTROL2     = EMMC_BASE + 0x3C,
+    EMMC_CAPABILITIES = EMMC_BASE + 0x40,
+    EMMC_ADMA_ERR     = EMMC_BASE + 0x54,
+    EMMC_ADMA_ADDR    = EMMC_BASE + 0x58,
+    EMMC_SLOTISR_VER  = EMMC_BASE + 0xFC
+};
+
+#define EMMC_STATUS_CMD_INHIBIT  REG_FIELD(EMMC_STATUS, 0, 1)
+#define EMMC_STATUS_DAT_INHIBIT  REG_FIELD(EMMC_STATUS, 1, 1)
+
+#define EMMC_CONTROL0_BUS_4BIT   REG_FIELD(EMMC_CONTROL0, 1, 1)
+#define EMMC_CONTROL0_HIGH_SPEED REG_FIELD(EMMC_CONTROL0, 2, 1)
+#define EMMC_CONTROL0_DMA_SELECT REG_FIELD(EMMC_CONTROL0, 3, 2)  // 2 = ADMA2, 32 Bit
+#define EMMC_CONTROL0_POWER      REG_FIELD(EMMC_CONTROL0, 8, 4)  // Bit 0: an, Bit 1-3: 7 = 3,3 V
+
+#define EMMC_CONTROL1_CLK_INTLEN REG_FIELD(EMMC_CONTROL1, 0, 1)
+#define EMMC_CONTROL1_CLK_STABLE REG_FIELD(EMMC_CONTROL1, 1, 1)
+#define EMMC_CONTROL1_CLK_EN     REG_FIELD(EMMC_CONTROL1, 2, 1)
+#define EMMC_CONTROL1_CLK_MS2    REG_FIELD(EMMC_CONTROL1, 6, 2)  // Bit 9-8 des Teilers
+#define EMMC_CONTROL1_CLK_FREQ8  REG_FIELD(EMMC_CONTROL1, 8, 8)  // Bit 7-0 des Teilers
+#define EMMC_CONTROL1_TIMEOUT    REG_FIELD(EMMC_CONTROL1, 16, 4)
+#define EMMC_CONTROL1_SRST_HC    REG_FIELD(EMMC_CONTROL1, 24, 1)
+#define EMMC_CONTROL1_SRST_CMD   REG_FIELD(EMMC_CONTROL1, 25, 1)
+#define EMMC_CONTROL1_SRST_DATA  REG_FIELD(EMMC_CONTROL1, 26, 1)
+
+#define EMMC_CAPABILITIES_BASE_MHZ REG_FIELD(EMMC_CAPABILITIES, 8, 8)
+
+// ##################################
+// ## GIC-400
+// ##################################
+
+enum {
+    GIC_BASE        = PERIPHERAL_BASE + 0x1840000,
+    GICD_BASE       = GIC_BASE + 0x1000,
+    GICD_CTLR       = GICD_BASE + 0x000,
+    GICD_TYPER      = GICD_BASE + 0x004,
+    GICD_ISENABLER  = GICD_BASE + 0x100,
+    GICD_ICENABLER  = GICD_BASE + 0x180,
+    GICD_ICPENDR    = GICD_BASE + 0x280,
+    GICD_IPRIORITYR = GICD_BASE + 0x400,
+    GICD_ITARGETSR  = GICD_BASE + 0x800,
+    GICD_ICFGR      = GICD_BASE + 0xC00,
+
+    GICC_BASE       = GIC_BASE + 0x2000,
+    GICC_CTLR       = GICC_BASE + 0x000,
+    GICC_PMR        = GICC_BASE + 0x004,
+    GICC_IAR        = GICC_BASE + 0x00C,
+    GICC_EOIR       = GICC_BASE + 0x010
+};
+
+#define GICD_TYPER_IT_LINES REG_FIELD(GICD_TYPER, 0, 5)
+#define GICC_IAR_ID         REG_FIELD(GICC_IAR, 0, 10)
+
+#endif // REGS_H
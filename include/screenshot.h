@@ -0,0 +1,44 @@
+// include/screenshot.h
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+/**
+ * Bildschirmfotos über den UART ("screenshot"), dekodiert vom Host mit
+ * tools/fbgrab. Die Datei wird auch von tools/fbgrab.c eingebunden.
+ *
+ * Ein Frame beginnt mit einem Header von SHOT_HEADER_SIZE Bytes:
+ *   "OBSS", Version, Flags (SHOT_FLAG_...), Breite und Höhe (je 16 Bit LE),
+ *   16 Startfarben als R, G, B.
+ * Danach folgen Tokens, die die Pixel zeilenweise ohne Zeilengrenzen als
+ * Läufe beschreiben. Jeder Lauf verweist auf eine Farbtabelle mit
+ * SHOT_PALETTE_SIZE Einträgen: 0-15 sind die festen Startfarben, neue
+ * Farben belegen reihum 16-255 (nach 255 wieder 16). Längen werden als
+ * Varint (7 Bit pro Byte, niederwertig zuerst) übertragen.
+ *
+ *   0iii illl              Lauf der Startfarbe i, Länge l + 1 (1-8)
+ *   10ll llll <idx>        Lauf der Farbe idx, Länge l + 1 (1-64)
+ *   SHOT_RUN <idx> <n>     Lauf der Farbe idx, Länge n + 1
+ *   SHOT_NEW r g b <n>     Neue Farbe in die Tabelle, Lauf der Länge n + 1
+ *   SHOT_SKIP <n>          n + 1 Pixel wie im vorigen Frame (nur Delta)
+ *   SHOT_END <crc>         Ende; CRC-32 (LE) über alle Bytes ab "OBSS"
+ *                          bis einschließlich SHOT_END
+ */
+
+#define SHOT_MAGIC        "OBSS"
+#define SHOT_VERSION      1
+#define SHOT_HEADER_SIZE  (4 + 2 + 4 + 16 * 3)
+#define SHOT_PALETTE_SIZE 256
+#define SHOT_FIXED_COLORS 16
+
+enum {
+    SHOT_FLAG_DELTA = 1 // SKIP bezieht sich auf den vorigen Frame
+};
+
+enum {
+    SHOT_RUN  = 0xC0,
+    SHOT_NEW  = 0xC1,
+    SHOT_SKIP = 0xC2,
+    SHOT_END  = 0xC3
+};
+
+#endif // SCREENSHOT_H
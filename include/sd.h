@@ -0,0 +1,79 @@
+// include/sd.h
+#ifndef SD_H
+#define SD_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Treiber für die SD-Karte am EMMC2-Controller des Pi 4 (SDHCI).
+ *
+ * Daten werden nur per ADMA2 übertragen: eine Deskriptorliste beschreibt
+ * beliebig viele Puffer, die der Controller in einem einzigen Mehrblock-
+ * Befehl (CMD18/CMD25 mit automatischem CMD12) füllt bzw. liest. Die
+ * Puffer müssen auf CACHE_LINE ausgerichtet sein und ganze Cache-Zeilen
+ * belegen, weil sie vor und nach der Übertragung invalidiert werden.
+ *
+ * Der Treiber arbeitet ohne Interrupts (Polling) und ist nur für Core 0
+ * gedacht. Normalerweise geht man über den Block-Cache (bcache.h).
+ */
+
+#define SD_BLOCK_SIZE   512
+#define SD_MAX_SEGMENTS 32   // Puffer pro Befehl
+
+enum {
+    SD_OK = 0,
+    SD_ERR_NO_CARD,     // Keine Karte oder nicht initialisiert
+    SD_ERR_TIMEOUT,
+    SD_ERR_COMMAND,     // Fehler bei Befehl oder Antwort (CRC, Index, ...)
+    SD_ERR_DATA,        // Fehler bei der Datenübertragung oder im ADMA
+    SD_ERR_ALIGN,       // Puffer nicht auf CACHE_LINE ausgerichtet
+    SD_ERR_RANGE        // Block hinter dem Ende der Karte
+};
+
+// Ein Puffer eines Mehrblock-Transfers
+typedef struct {
+    void* data;
+    unsigned int blocks;
+} SdSegment;
+
+typedef struct {
+    bool ready;
+    bool sdhc;          // Blockadressierung (SDHC/SDXC) statt Byteadressen
+    bool high_speed;    // 50 MHz statt 25 MHz
+    unsigned int rca;   // Relative Card Address
+    unsigned int clock; // Tatsächlicher Bustakt in Hz
+    unsigned long blocks;
+    unsigned int cid[4];
+} SdCard;
+
+typedef struct {
+    unsigned long commands;
+    unsigned long read_commands, write_commands;
+    unsigned long read_blocks, write_blocks;
+    unsigned long read_ticks, write_ticks;    // timer_ticks() in Transfers
+    unsigned long errors;
+} SdStats;
+
+/**
+ * Setzt den Controller zurück und initialisiert die Karte (4 Bit,
+ * High Speed, falls möglich). Ohne Karte kehrt die Funktion nach wenigen
+ * Millisekunden mit SD_ERR_NO_CARD oder SD_ERR_TIMEOUT zurück.
+ */
+int sd_init();
+
+const SdCard* sd_card();
+
+// Liest bzw. schreibt ab Block lba zusammenhängend in/aus den Segmenten
+int sd_read(unsigned long lba, const SdSegment* segs, unsigned int count);
+int sd_write(unsigned long lba, const SdSegment* segs, unsigned int count);
+
+// Ein Puffer, beliebig viele Blöcke (wird in Befehle passender Größe geteilt)
+int sd_read_blocks(unsigned long lba, unsigned long blocks, void* buffer);
+int sd_write_blocks(unsigned long lba, unsigned long blocks, const void* buffer);
+
+const SdStats* sd_stats();
+void sd_reset_stats();
+
+const char* sd_error_string(int err);
+
+#endif // SD_H
@@ -2,15 +2,66 @@
 #ifndef SHELL_H
 #define SHELL_H
 
+#include "string_utils.h" // Für bool
+
 /**
- * Initialisiert die Shell. (Gute Praxis für später)
+ * Initialisiert die Shell. Baut dabei die Befehlstabelle aus der
+ * Linker-Section .shell_cmds auf.
  */
 void shell_init();
 
 /**
  * Verarbeitet anstehende Benutzereingaben und führt Befehle aus.
  * Diese Funktion sollte in der Hauptschleife des Kernels aufgerufen werden.
+ * Liefert true, wenn es Eingaben zu verarbeiten gab.
+ */
+bool shell_update();
+
+/**
+ * Zerlegt eine Zeile und führt den Befehl aus. Die Zeile wird dabei verändert.
+ * Liefert SHELL_OK oder den Fehlerwert des Befehls.
+ */
+int shell_execute(char* line);
+
+// ##################################
+// ## Befehlsregistrierung
+// ##################################
+
+enum {
+    SHELL_OK    = 0,
+    SHELL_ERROR = 1
+};
+
+// Eine Zeile (Eingabe, Skript, Batch) hat höchstens 255 Zeichen, also
+// höchstens 128 Wörter: so viele wie "set" mit Name/Wert-Paaren braucht
+#define SHELL_MAX_ARGS 128
+
+typedef int (*shell_handler_t)(int argc, char** argv);
+
+typedef struct {
+    const char* name;
+    shell_handler_t handler;
+    const char* help;     // Argumente und Kurzbeschreibung für 'help'
+} ShellCommand;
+
+/**
+ * Registriert einen Befehl, z.B.:
+ *     static int cmd_version(int argc, char** argv) { ... }
+ *     SHELL_COMMAND(version, cmd_version, "- show the kernel version");
+ *
+ * Der Deskriptor landet in der Section .shell_cmds (siehe link.ld), die
+ * shell_init() beim Start in eine Hashtabelle einsortiert. Befehle können
+ * so in jeder Datei registriert werden, ohne shell.c anzufassen.
+ */
+#define SHELL_COMMAND(name, handler, help)                                  \
+    static const ShellCommand shell_cmd_##name                              \
+    __attribute__((used, section(".shell_cmds"), aligned(8))) =             \
+        { #name, handler, help }
+
+/**
+ * Fügt argv[first..argc-1] mit Leerzeichen getrennt in 'buffer' zusammen,
+ * z.B. für Befehle, die einen ganzen Ausdruck als Argument nehmen.
  */
-void shell_update();
+char* shell_join_args(int argc, char** argv, int first, char* buffer, unsigned int size);
 
 #endif // SHELL_H
@@ -0,0 +1,39 @@
+// include/smp.h
+#ifndef SMP_H
+#define SMP_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Mehrkernbetrieb. Core 0 führt den Kernel aus; die Cores 1-3 warten nach
+ * smp_init() in einer Schleife auf Arbeit. Parallelität ist explizit:
+ * smp_run() verteilt eine Funktion auf die ersten n Cores (inklusive
+ * Core 0) und kehrt erst zurück, wenn alle fertig sind. Interrupts
+ * werden nur auf Core 0 behandelt.
+ */
+
+#define SMP_MAX_CORES  4
+#define SMP_STACK_SIZE (64 * 1024) // Muss zu boot.S passen
+#define CACHE_LINE     64
+
+typedef void (*smp_work_t)(unsigned int core, unsigned int cores, void* arg);
+
+// Weckt die Cores 1-3 über die Spin-Table der Firmware.
+// Setzt eine eingeschaltete MMU voraus (mmu_init).
+void smp_init();
+
+// Anzahl der laufenden Cores (1, wenn die anderen nicht gestartet sind)
+unsigned int smp_cores();
+
+// Führt fn(core, cores, arg) auf den Cores 0..cores-1 aus und wartet.
+// Nur von Core 0 aufrufen; cores wird auf smp_cores() begrenzt.
+void smp_run(smp_work_t fn, void* arg, unsigned int cores);
+
+// Nummer des aktuellen Cores (0-3)
+static inline unsigned int smp_core_id() {
+    unsigned long mpidr;
+    asm volatile("mrs %0, mpidr_el1" : "=r"(mpidr));
+    return mpidr & 3;
+}
+
+#endif // SMP_H
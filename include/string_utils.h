@@ -16,9 +16,23 @@ typedef int bool;
 // Öffentliche Funktionsprototypen
 int simple_atoi(const char *str);
 char* simple_itoa(int value, char *buffer);
+long simple_atol(const char *str);
+char* simple_ltoa(long value, char *buffer); // buffer: mindestens 21 Bytes
 int strcmp_simple(const char *s1, const char *s2);
 int strncmp_simple(const char *s1, const char *s2, unsigned int n);
 void strncpy_simple(char *dest, const char *src, unsigned int n);
+unsigned int strlen_simple(const char *s);
+
+// FNV-1a Hash über einen null-terminierten String (für Hashtabellen)
+unsigned int hash_string(const char *s);
+unsigned int hash_string_n(const char *s, unsigned int len);
+
+// Speicherfunktionen. Die Namen sind Pflicht: GCC erzeugt selbst im
+// -ffreestanding-Modus Aufrufe von memcpy/memset (z.B. für Struct-Kopien).
+void* memcpy(void *dest, const void *src, unsigned long n);
+void* memmove(void *dest, const void *src, unsigned long n);
+void* memset(void *dest, int c, unsigned long n);
+int memcmp(const void *s1, const void *s2, unsigned long n);
 
 
 // Konvertiert eine vorzeichenlose Ganzzahl in einen Hexadezimal-String
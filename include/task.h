@@ -0,0 +1,60 @@
+// include/task.h
+#ifndef TASK_H
+#define TASK_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Aufgaben mit Work-Stealing auf allen Cores. task_run startet über
+ * smp_run eine Sitzung: Core 0 führt die Wurzelaufgabe aus, die übrigen
+ * Cores holen sich Arbeit, bis sie fertig ist.
+ *
+ * Jeder Core hat eine eigene Deque (Chase-Lev). Neue Aufgaben kommen unten
+ * in die Deque des erzeugenden Cores, der sie von dort auch wieder nimmt
+ * (zuletzt erzeugte zuerst); untätige Cores stehlen oben die ältesten.
+ * Es gibt keine globale Sperre. Ohne Arbeit schlafen die Cores in wfe,
+ * jede neue Aufgabe weckt sie mit sev.
+ *
+ * Eine Aufgabe muss alle Gruppen, in die sie Aufgaben erzeugt hat, mit
+ * task_wait abwarten, bevor sie zurückkehrt. task_wait arbeitet währenddessen
+ * selbst Aufgaben ab. Außerhalb einer Sitzung laufen task_spawn und
+ * task_run sofort auf dem aufrufenden Core.
+ */
+
+typedef void (*task_fn_t)(void* arg);
+typedef void (*task_range_fn_t)(unsigned long begin, unsigned long end, void* arg);
+
+// Zähler der noch offenen Aufgaben einer Gruppe
+typedef struct {
+    unsigned long pending;
+} TaskGroup;
+
+#define TASK_GROUP_INIT { 0 }
+
+// Führt fn(arg) mit cores Cores aus (begrenzt auf smp_cores()). Nur Core 0.
+void task_run(task_fn_t fn, void* arg, unsigned int cores);
+
+void task_spawn(TaskGroup* group, task_fn_t fn, void* arg);
+void task_wait(TaskGroup* group);
+
+/**
+ * Ruft fn für Teilbereiche von [begin, end) auf, die höchstens grain
+ * Elemente groß sind. Der Bereich wird rekursiv halbiert, die oberen
+ * Hälften können gestohlen werden. Außerhalb einer Sitzung startet
+ * parallel_for eine mit allen Cores.
+ */
+void parallel_for(unsigned long begin, unsigned long end, unsigned long grain,
+                  task_range_fn_t fn, void* arg);
+
+typedef struct {
+    unsigned long executed;     // Ausgeführte Aufgaben
+    unsigned long stolen;       // Davon bei anderen Cores gestohlen
+    unsigned long steal_failed; // Leere Deques oder verlorene Wettläufe
+    unsigned long overflows;    // Deque voll, sofort ausgeführt
+    unsigned long sleeps;       // wfe ohne Arbeit
+} TaskStats;
+
+const TaskStats* task_stats(unsigned int core);
+void task_reset_stats();
+
+#endif // TASK_H
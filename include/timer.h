@@ -0,0 +1,27 @@
+// include/timer.h
+#ifndef TIMER_H
+#define TIMER_H
+
+/**
+ * Zugriff auf den ARM Generic Timer (Systemzähler).
+ * Der Zähler läuft ab dem Einschalten mit fester Frequenz (54 MHz auf dem Pi 4)
+ * und ist unabhängig vom CPU-Takt - ideal für Zeitstempel und Benchmarks.
+ */
+
+// Aktueller Zählerstand
+unsigned long timer_ticks();
+
+// Zählerfrequenz in Hz
+unsigned long timer_freq();
+
+// Rechnet eine Tick-Differenz in Mikrosekunden um
+unsigned long timer_ticks_to_us(unsigned long ticks);
+
+// CPU-Taktzyklen aus dem PMU-Zykluszähler (PMCCNTR_EL0). Der Zähler wird
+// beim ersten Aufruf eingeschaltet. Für Messungen im Bereich weniger Takte.
+unsigned long timer_cycles();
+
+// Aktives Warten
+void timer_delay_us(unsigned long us);
+
+#endif // TIMER_H
@@ -8,5 +8,19 @@ void uart_init();
 void uart_writeText(const char *buffer);
 void uart_writeByteBlocking(unsigned char ch); // Nützliche Hilfsfunktion
 bool uart_read_byte(unsigned char* byte);
+void uart_flush(); // Wartet, bis die Sende-Queue leer ist
+void uart_drain(); // Wartet, bis auch das letzte Bit gesendet ist
+void uart_set_clock(unsigned int hz); // Neuer Kerntakt, Baudrate bleibt gleich
+
+enum {
+    UART_FLOW_NONE = 0,
+    UART_FLOW_XONXOFF,
+    UART_FLOW_RTSCTS
+};
+
+void uart_set_flow_control(int mode);
+void uart_pause_input();  // XOFF, solange die Software nicht pollt
+void uart_resume_input(); // XON, wenn der Empfangspuffer es zulässt
+unsigned int uart_rx_overruns(); // Seit dem Start verlorene Empfangsbytes
 
 #endif // UART_H
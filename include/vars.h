@@ -0,0 +1,40 @@
+// include/vars.h
+#ifndef VARS_H
+#define VARS_H
+
+#include "string_utils.h" // Für bool
+
+/**
+ * Variablenspeicher der Shell.
+ *
+ * Offene Adressierung (lineares Sondieren) über einem Index, der auf dichte
+ * Arrays mit Namen, Hashes und Werten zeigt. Namen werden einmalig in einer
+ * Arena abgelegt ("interned"). Jede Variable bekommt einen festen Slot, der
+ * sich auch beim Wachsen der Tabelle nicht mehr ändert.
+ */
+
+// Wert einer Variablen an einem Slot (siehe vars_slot)
+extern long* vars_values;
+
+// Legt die Variable an bzw. überschreibt sie. 'false', wenn der Heap voll ist.
+bool vars_set(const char* name, long value);
+
+// Liest eine Variable. 'false', wenn es sie nicht gibt.
+bool vars_get(const char* name, long* value);
+
+// Liefert den Slot einer Variablen oder -1, wenn es sie nicht gibt
+int vars_slot(const char* name);
+
+// Wie vars_slot, legt die Variable aber mit Wert 0 an, falls nötig (-1 = Heap voll)
+int vars_intern(const char* name);
+
+// Name der Variablen an einem Slot
+const char* vars_slot_name(int slot);
+
+// Sorgt dafür, dass 'count' weitere Variablen ohne Rehash Platz haben
+bool vars_reserve(unsigned int count);
+
+// Anzahl angelegter Variablen
+unsigned int vars_count();
+
+#endif // VARS_H
@@ -0,0 +1,198 @@
+// loader/loader.c
+// Serieller Chainloader: empfängt einen Kernel über die Mini-UART und
+// startet ihn an 0x80000. Protokoll siehe protocol.h.
+#include "gpio.h"
+#include "regs.h"
+#include "string_utils.h" // Für bool
+#include "crc32.h"
+#include "protocol.h"
+
+// ##################################
+// ## Mini-UART (minimal, ohne Queues)
+// ##################################
+
+enum {
+    AUX_UART_CLOCK  = 500000000
+};
+
+// Platz für den Stack unterhalb des Loaders
+#define LOADER_STACK_RESERVE 0x10000
+
+extern char __loader_start[];
+extern void loader_jump(unsigned long entry, unsigned long dtb);
+
+static unsigned int uart_divisor(unsigned int baud) {
+    return (AUX_UART_CLOCK + 4 * baud) / (8 * baud) - 1;
+}
+
+static unsigned int uart_actual_baud(unsigned int baud) {
+    return AUX_UART_CLOCK / (8 * (uart_divisor(baud) + 1));
+}
+
+static void uart_putc(unsigned char ch) {
+    while (!mmio_field_get(AUX_MU_LSR_TX_EMPTY));
+    mmio_write(AUX_MU_IO_REG, ch);
+}
+
+static void uart_flush() {
+    // Sender leer (FIFO und Schieberegister)
+    while (!mmio_field_get(AUX_MU_LSR_TX_IDLE));
+}
+
+static bool uart_has_byte() {
+    return mmio_field_get(AUX_MU_LSR_DATA_READY);
+}
+
+static unsigned char uart_getc() {
+    while (!uart_has_byte());
+    return (unsigned char)mmio_read(AUX_MU_IO_REG);
+}
+
+static void uart_set_baud(unsigned int baud) {
+    uart_flush();
+    mmio_write(AUX_MU_CNTL_REG, 0);
+    mmio_write(AUX_MU_BAUD_REG, uart_divisor(baud));
+    mmio_write(AUX_MU_CNTL_REG, 3);
+}
+
+static void uart_init() {
+    mmio_write(AUX_ENABLES, 1);
+    mmio_write(AUX_MU_IER_REG, 0);
+    mmio_write(AUX_MU_CNTL_REG, 0);
+    mmio_write(AUX_MU_LCR_REG, 3); // 8 Bit
+    mmio_write(AUX_MU_MCR_REG, 0);
+    mmio_write(AUX_MU_IIR_REG, 0xC6);
+    mmio_write(AUX_MU_BAUD_REG, uart_divisor(LOADER_BOOT_BAUD));
+    gpio_useAsAlt5(14);
+    gpio_useAsAlt5(15);
+    mmio_write(AUX_MU_CNTL_REG, 3);
+}
+
+static void uart_puts(const char* s) {
+    while (*s) uart_putc(*s++);
+}
+
+static void uart_put32(unsigned int v) {
+    for (int i = 0; i < 4; i++) uart_putc((v >> (8 * i)) & 0xFF);
+}
+
+static void uart_put16(unsigned int v) {
+    uart_putc(v & 0xFF);
+    uart_putc((v >> 8) & 0xFF);
+}
+
+// ##################################
+// ## Protokoll
+// ##################################
+
+// Wartet auf den Header und sendet dabei regelmäßig LOADER_HELLO
+static bool receive_header(LoaderHeader* header) {
+    unsigned char* raw = (unsigned char*)header;
+    unsigned int spin = 0;
+
+    // Auf das erste Byte des Magics warten
+    while (1) {
+        if (uart_has_byte()) {
+            raw[0] = uart_getc();
+            if (raw[0] == (LOADER_MAGIC & 0xFF)) break;
+        } else if ((spin++ & 0xFFFFF) == 0) {
+            uart_puts(LOADER_HELLO);
+        }
+    }
+    for (unsigned int i = 1; i < sizeof(LoaderHeader); i++) {
+        raw[i] = uart_getc();
+    }
+    return header->magic == LOADER_MAGIC
+        && crc32_update(0, header, 16) == header->header_crc;
+}
+
+/**
+ * Der Host stellt seine Schnittstelle erst nach dem ACK auf die neue
+ * Baudrate um; ein einzelnes READY direkt nach dem Umschalten kann er
+ * verpassen oder verstümmelt empfangen. Deshalb wird READY wiederholt, bis
+ * das erste Byte des ersten Frames ankommt (es bleibt in der FIFO).
+ */
+static void announce_ready() {
+    unsigned int spin = 0;
+    while (!uart_has_byte()) {
+        if ((spin++ & 0x3FFFF) == 0) uart_putc(LOADER_READY);
+    }
+}
+
+/**
+ * Empfängt alle Frames direkt an die Zieladresse. Die CRC wird Byte für Byte
+ * mitgerechnet, damit die Schleife nie länger als eine Bytezeit hängt - die
+ * Hardware-FIFO der Mini-UART fasst nur 8 Bytes.
+ */
+static bool receive_image(const LoaderHeader* header) {
+    unsigned char* dest = (unsigned char*)LOADER_KERNEL_ADDR;
+    unsigned int frames = (header->size + LOADER_FRAME_SIZE - 1) / LOADER_FRAME_SIZE;
+    unsigned int expected = 0;
+    bool nak_sent = false;
+
+    while (expected < frames) {
+        if (uart_getc() != LOADER_SOF) continue;
+
+        unsigned char hdr[4];
+        for (int i = 0; i < 4; i++) hdr[i] = uart_getc();
+        unsigned int crc = crc32_update(0, hdr, 4);
+        unsigned int seq = hdr[0] | (hdr[1] << 8);
+        unsigned int len = hdr[2] | (hdr[3] << 8);
+
+        // Nur den erwarteten Frame schreiben, alle anderen nur überlesen
+        unsigned int offset = seq * LOADER_FRAME_SIZE;
+        bool in_order = seq == expected && len <= LOADER_FRAME_SIZE
+                        && offset + len <= header->size;
+        if (len > LOADER_FRAME_SIZE) len = 0; // Kaputter Header: nicht weiterlesen
+
+        for (unsigned int i = 0; i < len; i++) {
+            unsigned char b = uart_getc();
+            crc = crc32_update(crc, &b, 1);
+            if (in_order) dest[offset + i] = b;
+        }
+        unsigned int frame_crc = 0;
+        for (int i = 0; i < 4; i++) frame_crc |= (unsigned int)uart_getc() << (8 * i);
+
+        if (in_order && crc == frame_crc) {
+            expected++;
+            nak_sent = false;
+            uart_putc(LOADER_ACK);
+            uart_put16(seq);
+        } else if (!nak_sent) {
+            nak_sent = true;
+            uart_putc(LOADER_NAK);
+            uart_put16(expected);
+        }
+    }
+    return crc32_update(0, dest, header->size) == header->image_crc;
+}
+
+void loader_main(unsigned long dtb) {
+    uart_init();
+    uart_puts("\r\nOhneBS serial loader\r\n");
+
+    while (1) {
+        LoaderHeader header;
+        if (!receive_header(&header)) continue;
+
+        unsigned long max_size = (unsigned long)__loader_start - LOADER_KERNEL_ADDR - LOADER_STACK_RESERVE;
+        unsigned int actual = uart_actual_baud(header.baud);
+        unsigned int error = actual > header.baud ? actual - header.baud : header.baud - actual;
+        if (header.size == 0 || header.size > max_size || error > header.baud / 33) {
+            uart_putc(LOADER_NAK); // Zu groß oder Baudrate nicht auf 3% genau erreichbar
+            continue;
+        }
+        uart_putc(LOADER_ACK);
+        uart_put32(actual);
+
+        uart_set_baud(header.baud);
+        announce_ready();
+
+        bool ok = receive_image(&header);
+        uart_putc(ok ? LOADER_DONE : LOADER_NAK);
+        uart_set_baud(LOADER_BOOT_BAUD);
+        if (ok) {
+            loader_jump(LOADER_KERNEL_ADDR, dtb);
+        }
+    }
+}
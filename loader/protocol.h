@@ -0,0 +1,47 @@
+// loader/protocol.h
+#ifndef LOADER_PROTOCOL_H
+#define LOADER_PROTOCOL_H
+
+/**
+ * Protokoll zwischen dem seriellen Chainloader (loader/loader.c) und dem
+ * Sendeprogramm auf dem Host (tools/chainload.c). Alle Zahlen little-endian.
+ *
+ * 1. Der Loader sendet bei 115200 Baud regelmäßig LOADER_HELLO.
+ * 2. Der Host antwortet mit einem Header (LoaderHeader, 20 Bytes).
+ * 3. Der Loader bestätigt mit LOADER_ACK + tatsächlicher Baudrate (4 Bytes)
+ *    oder lehnt mit LOADER_NAK ab. Danach schalten beide auf die neue
+ *    Baudrate, und der Loader sendet LOADER_READY - wiederholt, bis das
+ *    erste Byte vom Host kommt. Der Host überliest weitere READY-Bytes.
+ * 4. Der Host schickt das Image in Frames:
+ *        LOADER_SOF, seq (2), len (2), payload (len), crc32 (4)
+ *    Die CRC läuft über seq, len und payload. Es dürfen bis zu
+ *    LOADER_WINDOW Frames unbestätigt unterwegs sein (Go-Back-N).
+ * 5. Der Loader antwortet auf jeden korrekten Frame mit LOADER_ACK + seq
+ *    und auf einen fehlerhaften oder unerwarteten einmal mit
+ *    LOADER_NAK + erwartete seq. Der Host sendet ab dort erneut.
+ * 6. Nach dem letzten Frame prüft der Loader die CRC des ganzen Images,
+ *    meldet LOADER_DONE (oder LOADER_NAK) und springt nach 0x80000.
+ */
+
+#define LOADER_HELLO       "OBSL"
+#define LOADER_MAGIC       0x4B53424F   // "OBSK"
+#define LOADER_SOF         0xA5
+#define LOADER_ACK         0x06
+#define LOADER_NAK         0x15
+#define LOADER_READY       'R'
+#define LOADER_DONE        'D'
+
+#define LOADER_FRAME_SIZE  1024
+#define LOADER_WINDOW      8
+#define LOADER_BOOT_BAUD   115200
+#define LOADER_KERNEL_ADDR 0x80000
+
+typedef struct {
+    unsigned int magic;      // LOADER_MAGIC
+    unsigned int size;       // Imagegröße in Bytes
+    unsigned int image_crc;  // CRC-32 des ganzen Images
+    unsigned int baud;       // Gewünschte Baudrate für die Übertragung
+    unsigned int header_crc; // CRC-32 der ersten 16 Bytes
+} LoaderHeader;
+
+#endif // LOADER_PROTOCOL_H
@@ -0,0 +1,14 @@
+# Grafik-Benchmarks nacheinander in allen Farbtiefen
+fbmode 32
+linebench
+fillbench
+blitbench
+fbmode 16
+linebench
+fillbench
+blitbench
+fbmode 8
+linebench
+fillbench
+blitbench
+fbmode 32
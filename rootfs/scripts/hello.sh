@@ -0,0 +1,4 @@
+# Beispiel für "run": Variablen setzen und einen Ausdruck auswerten
+cat etc/motd
+set answer 6 factor 7
+print answer * factor
@@ -0,0 +1,575 @@
+// src/bcache.c
+#include "bcache.h"
+#include "sd.h"
+#include "mem.h"
+#include "smp.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+#define LINE_BYTES  (BCACHE_LINE_BLOCKS * BCACHE_BLOCK_SIZE)
+#define HASH_SIZE   (BCACHE_LINES * 2) // Zweierpotenz
+#define NO_TAG      (~0UL)
+
+// Ab dieser Größe liest bcache_read in ausgerichtete Puffer direkt von der
+// Karte, statt den Cache mit Daten zu füllen, die nur einmal gebraucht werden
+#define DIRECT_MIN  (BCACHE_READAHEAD_MAX * BCACHE_LINE_BLOCKS)
+
+typedef struct BcacheLine {
+    unsigned long tag;                  // lba / BCACHE_LINE_BLOCKS
+    struct BcacheLine* prev;            // LRU-Liste, vorne = zuletzt benutzt
+    struct BcacheLine* next;
+    struct BcacheLine* hash_next;
+    unsigned char* data;
+    unsigned char dirty;                // Ein Bit pro Block
+    bool valid;
+    bool prefetched;                    // Vorausgelesen, noch nicht benutzt
+} BcacheLine;
+
+_Static_assert(BCACHE_LINE_BLOCKS <= 8, "dirty mask holds 8 blocks");
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+static BcacheLine* lines = NULL;
+static BcacheLine* buckets[HASH_SIZE];
+static BcacheLine lru;                  // Anker der LRU-Liste
+static BcacheStats stats;
+
+// Erkennung sequenzieller Zugriffe
+static unsigned long last_tag = NO_TAG;
+static unsigned int readahead_window = 1;
+
+// ##################################
+// ## Listen und Hashtabelle
+// ##################################
+
+static inline unsigned int hash_tag(unsigned long tag) {
+    return (tag * 0x9E3779B1u) & (HASH_SIZE - 1);
+}
+
+static void lru_remove(BcacheLine* line) {
+    line->prev->next = line->next;
+    line->next->prev = line->prev;
+}
+
+static void lru_push_front(BcacheLine* line) {
+    line->next = lru.next;
+    line->prev = &lru;
+    lru.next->prev = line;
+    lru.next = line;
+}
+
+static void lru_push_back(BcacheLine* line) {
+    line->prev = lru.prev;
+    line->next = &lru;
+    lru.prev->next = line;
+    lru.prev = line;
+}
+
+static BcacheLine* hash_find(unsigned long tag) {
+    BcacheLine* line = buckets[hash_tag(tag)];
+    while (line != NULL && line->tag != tag) line = line->hash_next;
+    return line;
+}
+
+static void hash_insert(BcacheLine* line) {
+    BcacheLine** bucket = &buckets[hash_tag(line->tag)];
+    line->hash_next = *bucket;
+    *bucket = line;
+}
+
+static void hash_remove(BcacheLine* line) {
+    BcacheLine** p = &buckets[hash_tag(line->tag)];
+    while (*p != line) p = &(*p)->hash_next;
+    *p = line->hash_next;
+}
+
+// ##################################
+// ## Zurückschreiben
+// ##################################
+
+static inline unsigned int first_bit(unsigned int mask) { return __builtin_ctz(mask); }
+static inline unsigned int last_bit(unsigned int mask) { return 31 - __builtin_clz(mask); }
+
+#define FULL_MASK ((1u << BCACHE_LINE_BLOCKS) - 1)
+#define LAST_BLOCK (1u << (BCACHE_LINE_BLOCKS - 1))
+
+/**
+ * Schreibt die schmutzigen Blöcke der Zeile zurück. Reicht der Bereich bis
+ * ans Zeilenende, werden die folgenden Zeilen gleich mitgenommen, solange
+ * sie am Anfang schmutzig sind - alles in einem Mehrblock-Befehl. Saubere
+ * Blöcke zwischen zwei schmutzigen werden mitgeschrieben.
+ */
+static int writeback(BcacheLine* line) {
+    SdSegment segs[SD_MAX_SEGMENTS];
+    BcacheLine* written[SD_MAX_SEGMENTS];
+    unsigned int start = first_bit(line->dirty);
+    unsigned long lba = line->tag * BCACHE_LINE_BLOCKS + start;
+    unsigned int n = 0;
+
+    unsigned int from = start;
+    while (1) {
+        unsigned int end = last_bit(line->dirty) + 1;
+        segs[n].data = line->data + from * BCACHE_BLOCK_SIZE;
+        segs[n].blocks = end - from;
+        written[n++] = line;
+        if (end != BCACHE_LINE_BLOCKS || n == SD_MAX_SEGMENTS) break;
+
+        line = hash_find(line->tag + 1);
+        if (line == NULL || !(line->dirty & 1)) break;
+        from = 0;
+    }
+
+    int err = sd_write(lba, segs, n);
+    if (err != SD_OK) {
+        stats.write_errors++;
+        return err;
+    }
+    for (unsigned int i = 0; i < n; i++) written[i]->dirty = 0;
+    stats.writebacks += n;
+    return SD_OK;
+}
+
+// Anfang einer Kette schmutziger Zeilen (siehe writeback)?
+static bool run_start(BcacheLine* line) {
+    if (line->tag == 0 || !(line->dirty & 1)) return true;
+    BcacheLine* prev = hash_find(line->tag - 1);
+    return prev == NULL || !(prev->dirty & LAST_BLOCK);
+}
+
+/**
+ * Die am längsten unbenutzte Zeile freimachen. Scheitert ihr Zurückschreiben,
+ * bleibt sie schmutzig (bcache_sync versucht es erneut und meldet den
+ * Fehler) und rückt nach vorne; frei wird dann die älteste saubere Zeile.
+ * NULL erst, wenn keine saubere Zeile mehr übrig ist.
+ */
+static BcacheLine* evict(int* err) {
+    BcacheLine* line = lru.prev;
+    if (line->dirty) {
+        int werr = writeback(line);
+        if (werr != SD_OK) {
+            lru_remove(line);
+            lru_push_front(line);
+            for (line = lru.prev; line != &lru && line->dirty; line = line->prev);
+            if (line == &lru) {
+                *err = werr;
+                return NULL;
+            }
+        }
+    }
+    if (line->valid) hash_remove(line);
+    line->valid = false;
+    line->prefetched = false;
+    lru_remove(line);
+    return line;
+}
+
+// ##################################
+// ## Lesen
+// ##################################
+
+// Blöcke der Zeile, die auf der Karte existieren (die letzte kann kürzer sein)
+static unsigned int line_blocks(unsigned long tag) {
+    unsigned long total = sd_card()->blocks;
+    unsigned long first = tag * BCACHE_LINE_BLOCKS;
+    if (first >= total) return 0;
+    return total - first < BCACHE_LINE_BLOCKS ? total - first : BCACHE_LINE_BLOCKS;
+}
+
+/**
+ * Lädt die Zeile tag und bis zu want - 1 folgende, noch nicht gecachte
+ * Zeilen mit einem Befehl direkt in freigemachte Zeilen.
+ */
+static BcacheLine* fill(unsigned long tag, unsigned int want, int* err) {
+    SdSegment segs[SD_MAX_SEGMENTS];
+    BcacheLine* filled[SD_MAX_SEGMENTS];
+    unsigned int n = 0;
+
+    if (want > SD_MAX_SEGMENTS) want = SD_MAX_SEGMENTS;
+    while (n < want) {
+        unsigned int blocks = line_blocks(tag + n);
+        if (blocks == 0 || (n > 0 && hash_find(tag + n) != NULL)) break;
+
+        BcacheLine* line = evict(err);
+        if (line == NULL) break;
+        lru_push_front(line);
+        line->tag = tag + n;
+        segs[n].data = line->data;
+        segs[n].blocks = blocks;
+        filled[n++] = line;
+        if (blocks < BCACHE_LINE_BLOCKS) break;
+    }
+    if (n == 0) {
+        if (*err == SD_OK) *err = SD_ERR_RANGE;
+        return NULL;
+    }
+
+    *err = sd_read(tag * BCACHE_LINE_BLOCKS, segs, n);
+    if (*err != SD_OK) {
+        for (unsigned int i = 0; i < n; i++) {
+            lru_remove(filled[i]);
+            lru_push_back(filled[i]);
+        }
+        return NULL;
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+        filled[i]->valid = true;
+        filled[i]->prefetched = i > 0;
+        hash_insert(filled[i]);
+    }
+    stats.readahead += n - 1;
+
+    // Die angefragte Zeile zuletzt nach vorne, die vorausgelesenen dahinter
+    lru_remove(filled[0]);
+    lru_push_front(filled[0]);
+    return filled[0];
+}
+
+/**
+ * Liefert die Zeile zu lba. need ist die Zahl der Zeilen, die der Aufruf
+ * noch braucht; bei einem Fehlzugriff wird mindestens so weit gelesen.
+ * Mit overwrite wird eine fehlende Zeile nicht gelesen, weil der Aufrufer
+ * sie komplett überschreibt.
+ */
+static BcacheLine* get_line(unsigned long lba, unsigned int need, bool overwrite, int* err) {
+    unsigned long tag = lba / BCACHE_LINE_BLOCKS;
+    bool sequential = tag == last_tag + 1;
+    if (tag != last_tag) last_tag = tag;
+    *err = SD_OK;
+
+    BcacheLine* line = hash_find(tag);
+    if (line != NULL) {
+        stats.hits++;
+        if (line->prefetched) {
+            stats.readahead_used++;
+            line->prefetched = false;
+        }
+        lru_remove(line);
+        lru_push_front(line);
+        return line;
+    }
+    stats.misses++;
+
+    if (overwrite) {
+        if (line_blocks(tag) == 0) {
+            *err = SD_ERR_RANGE;
+            return NULL;
+        }
+        line = evict(err);
+        if (line == NULL) return NULL;
+        line->tag = tag;
+        line->valid = true;
+        hash_insert(line);
+        lru_push_front(line);
+        return line;
+    }
+
+    if (sequential) {
+        readahead_window *= 2;
+        if (readahead_window > BCACHE_READAHEAD_MAX) readahead_window = BCACHE_READAHEAD_MAX;
+    } else {
+        readahead_window = 1;
+    }
+    unsigned int want = need > readahead_window ? need : readahead_window;
+    return fill(tag, want, err);
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void bcache_init() {
+    if (lines != NULL) return;
+
+    unsigned char* memory = mem_alloc_aligned((unsigned long)BCACHE_LINES * LINE_BYTES, CACHE_LINE);
+    lines = mem_alloc(BCACHE_LINES * sizeof(BcacheLine));
+    if (memory == NULL || lines == NULL) {
+        lines = NULL;
+        return;
+    }
+    lru.next = lru.prev = &lru;
+    for (unsigned int i = 0; i < BCACHE_LINES; i++) {
+        lines[i].data = memory + (unsigned long)i * LINE_BYTES;
+        lines[i].valid = false;
+        lines[i].dirty = 0;
+        lines[i].prefetched = false;
+        lru_push_back(&lines[i]);
+    }
+    memset(buckets, 0, sizeof(buckets));
+}
+
+// Großer Lesezugriff an der Cache vorbei; vorher geänderte Zeilen zurückschreiben
+static int read_direct(unsigned long lba, unsigned long count, void* buffer) {
+    unsigned long last = (lba + count - 1) / BCACHE_LINE_BLOCKS;
+    for (unsigned long tag = lba / BCACHE_LINE_BLOCKS; tag <= last; tag++) {
+        BcacheLine* line = hash_find(tag);
+        if (line != NULL && line->dirty) {
+            int err = writeback(line);
+            if (err != SD_OK) return err;
+        }
+    }
+    stats.direct_blocks += count;
+    return sd_read_blocks(lba, count, buffer);
+}
+
+// Der ganze Bereich muss auf der Karte liegen: sonst würden Blöcke hinter
+// dem Ende gecacht oder als schmutzig markiert
+static bool in_range(unsigned long lba, unsigned long count) {
+    unsigned long total = sd_card()->blocks;
+    return lba <= total && count <= total - lba;
+}
+
+int bcache_read(unsigned long lba, unsigned long count, void* buffer) {
+    if (lines == NULL) return SD_ERR_NO_CARD;
+    if (!in_range(lba, count)) return SD_ERR_RANGE;
+    stats.reads++;
+    if (count >= DIRECT_MIN && ((unsigned long)buffer & (CACHE_LINE - 1)) == 0) {
+        return read_direct(lba, count, buffer);
+    }
+
+    unsigned char* out = buffer;
+    while (count > 0) {
+        unsigned int offset = lba % BCACHE_LINE_BLOCKS;
+        unsigned long n = BCACHE_LINE_BLOCKS - offset;
+        if (n > count) n = count;
+
+        int err;
+        unsigned long need = (offset + count + BCACHE_LINE_BLOCKS - 1) / BCACHE_LINE_BLOCKS;
+        BcacheLine* line = get_line(lba, need > BCACHE_READAHEAD_MAX ? BCACHE_READAHEAD_MAX : need, false, &err);
+        if (line == NULL) return err;
+
+        memcpy(out, line->data + offset * BCACHE_BLOCK_SIZE, n * BCACHE_BLOCK_SIZE);
+        out += n * BCACHE_BLOCK_SIZE;
+        lba += n;
+        count -= n;
+    }
+    return SD_OK;
+}
+
+int bcache_write(unsigned long lba, unsigned long count, const void* buffer) {
+    if (lines == NULL) return SD_ERR_NO_CARD;
+    if (!in_range(lba, count)) return SD_ERR_RANGE;
+    stats.writes++;
+
+    const unsigned char* in = buffer;
+    while (count > 0) {
+        unsigned int offset = lba % BCACHE_LINE_BLOCKS;
+        unsigned long n = BCACHE_LINE_BLOCKS - offset;
+        if (n > count) n = count;
+
+        int err;
+        bool whole = n == BCACHE_LINE_BLOCKS;
+        BcacheLine* line = get_line(lba, 1, whole, &err);
+        if (line == NULL) return err;
+
+        memcpy(line->data + offset * BCACHE_BLOCK_SIZE, in, n * BCACHE_BLOCK_SIZE);
+        line->dirty |= ((1u << n) - 1) << offset;
+        line->prefetched = false;
+        in += n * BCACHE_BLOCK_SIZE;
+        lba += n;
+        count -= n;
+    }
+    return SD_OK;
+}
+
+const void* bcache_block(unsigned long lba) {
+    if (lines == NULL || !in_range(lba, 1)) return NULL;
+    int err;
+    BcacheLine* line = get_line(lba, 1, false, &err);
+    if (line == NULL) return NULL;
+    return line->data + (lba % BCACHE_LINE_BLOCKS) * BCACHE_BLOCK_SIZE;
+}
+
+int bcache_sync() {
+    if (lines == NULL) return SD_OK;
+
+    // Jede Runde schreibt mindestens den Anfang jeder Kette
+    bool dirty = true;
+    while (dirty) {
+        dirty = false;
+        for (unsigned int i = 0; i < BCACHE_LINES; i++) {
+            BcacheLine* line = &lines[i];
+            if (!line->dirty) continue;
+            if (!run_start(line)) {
+                dirty = true;
+                continue;
+            }
+            int err = writeback(line);
+            if (err != SD_OK) return err;
+            if (line->dirty) dirty = true;
+        }
+    }
+    return SD_OK;
+}
+
+int bcache_drop() {
+    int err = bcache_sync();
+    if (err != SD_OK || lines == NULL) return err;
+
+    memset(buckets, 0, sizeof(buckets));
+    for (unsigned int i = 0; i < BCACHE_LINES; i++) {
+        lines[i].valid = false;
+        lines[i].prefetched = false;
+    }
+    last_tag = NO_TAG;
+    readahead_window = 1;
+    return SD_OK;
+}
+
+const BcacheStats* bcache_stats() {
+    return &stats;
+}
+
+void bcache_reset_stats() {
+    memset(&stats, 0, sizeof(stats));
+    sd_reset_stats();
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+// Durchsatz in KB/s aus Bytes und Ticks
+static void print_throughput(unsigned long bytes, unsigned long ticks) {
+    unsigned long us = timer_ticks_to_us(ticks);
+    console_putlong(us ? bytes * 1000000 / 1024 / us : 0);
+    console_puts(" KB/s");
+}
+
+static void print_stats() {
+    const SdStats* sd = sd_stats();
+    unsigned long lookups = stats.hits + stats.misses;
+    unsigned int dirty = 0;
+    for (unsigned int i = 0; i < BCACHE_LINES; i++) dirty += lines[i].dirty != 0;
+
+    console_puts("cache: ");
+    console_putlong(stats.hits);
+    console_puts(" hits, ");
+    console_putlong(stats.misses);
+    console_puts(" misses (");
+    console_putlong(lookups ? stats.hits * 100 / lookups : 0);
+    console_puts("% hits), read-ahead ");
+    console_putlong(stats.readahead_used);
+    console_puts("/");
+    console_putlong(stats.readahead);
+    console_puts(" lines used, ");
+    console_putlong(stats.writebacks);
+    console_puts(" write-backs (");
+    console_putlong(stats.write_errors);
+    console_puts(" failed), ");
+    console_putlong(stats.direct_blocks);
+    console_puts(" blocks direct, ");
+    console_putint(dirty);
+    console_puts(" dirty lines\n");
+
+    console_puts("card:  read ");
+    console_putlong(sd->read_blocks);
+    console_puts(" blocks in ");
+    console_putlong(sd->read_commands);
+    console_puts(" commands, ");
+    print_throughput(sd->read_blocks * SD_BLOCK_SIZE, sd->read_ticks);
+    console_puts("; wrote ");
+    console_putlong(sd->write_blocks);
+    console_puts(" blocks in ");
+    console_putlong(sd->write_commands);
+    console_puts(" commands, ");
+    print_throughput(sd->write_blocks * SD_BLOCK_SIZE, sd->write_ticks);
+    console_puts("; ");
+    console_putlong(sd->errors);
+    console_puts(" errors\n");
+}
+
+// Eine Messung: "name: N KB/s"
+static void bench_line(const char* name, unsigned long bytes, unsigned long ticks, int err) {
+    console_puts(name);
+    if (err != SD_OK) {
+        console_puts("error: ");
+        console_puts(sd_error_string(err));
+    } else {
+        print_throughput(bytes, ticks);
+    }
+    console_puts("\n");
+}
+
+/**
+ * Liest die ersten MB der Karte auf verschiedene Arten: blockweise direkt,
+ * in 64-KB-Befehlen direkt und in 4-KB-Stücken über den Cache, einmal kalt
+ * (mit Read-ahead) und einmal warm. Es wird nur gelesen.
+ */
+static int bench(unsigned long mb) {
+    static unsigned char* buffer = NULL;
+    if (buffer == NULL) buffer = mem_alloc_aligned(64 * 1024, CACHE_LINE);
+    if (buffer == NULL) return SD_ERR_NO_CARD;
+
+    unsigned long blocks = mb * 2048;
+    unsigned long single = blocks < 2048 ? blocks : 2048; // Höchstens 1 MB, sonst dauert es zu lange
+    int err = SD_OK;
+
+    unsigned long start = timer_ticks();
+    for (unsigned long b = 0; b < single && err == SD_OK; b++) err = sd_read_blocks(b, 1, buffer);
+    bench_line("direct, 512 B:     ", single * SD_BLOCK_SIZE, timer_ticks() - start, err);
+
+    start = timer_ticks();
+    for (unsigned long b = 0; b < blocks && err == SD_OK; b += 128) err = sd_read_blocks(b, 128, buffer);
+    bench_line("direct, 64 KB:     ", blocks * SD_BLOCK_SIZE, timer_ticks() - start, err);
+
+    if (err == SD_OK) err = bcache_drop();
+    bcache_reset_stats();
+    start = timer_ticks();
+    for (unsigned long b = 0; b < blocks && err == SD_OK; b += 8) err = bcache_read(b, 8, buffer);
+    bench_line("cache cold, 4 KB:  ", blocks * SD_BLOCK_SIZE, timer_ticks() - start, err);
+
+    // Warm: der zuletzt gelesene Teil, der noch in den Cache passt
+    unsigned long warm = blocks < BCACHE_LINES * BCACHE_LINE_BLOCKS / 2 ? blocks : BCACHE_LINES * BCACHE_LINE_BLOCKS / 2;
+    unsigned long first = blocks - warm;
+    start = timer_ticks();
+    for (int pass = 0; pass < 4 && err == SD_OK; pass++) {
+        for (unsigned long b = first; b < blocks && err == SD_OK; b += 8) err = bcache_read(b, 8, buffer);
+    }
+    bench_line("cache warm, 4 KB:  ", 4 * warm * SD_BLOCK_SIZE, timer_ticks() - start, err);
+    return err;
+}
+
+/**
+ * "bcache": Statistik, "bcache sync|drop|reset",
+ * "bcache bench [MB]": Lesedurchsatz mit und ohne Cache.
+ */
+static int cmd_bcache(int argc, char** argv) {
+    if (lines == NULL) {
+        console_puts("No SD card or block cache\n");
+        return SHELL_ERROR;
+    }
+
+    int err = SD_OK;
+    if (argc == 1) {
+        print_stats();
+        return SHELL_OK;
+    } else if (strcmp_simple(argv[1], "sync") == 0) {
+        err = bcache_sync();
+    } else if (strcmp_simple(argv[1], "drop") == 0) {
+        err = bcache_drop();
+    } else if (strcmp_simple(argv[1], "reset") == 0) {
+        bcache_reset_stats();
+    } else if (strcmp_simple(argv[1], "bench") == 0) {
+        long mb = argc > 2 ? simple_atol(argv[2]) : 8;
+        if (mb <= 0) mb = 8;
+        err = bench(mb);
+        if (err == SD_OK) print_stats();
+    } else {
+        console_puts("Usage: bcache [sync|drop|reset|bench [MB]]\n");
+        return SHELL_ERROR;
+    }
+
+    if (err != SD_OK) {
+        console_puts("Error: ");
+        console_puts(sd_error_string(err));
+        console_puts("\n");
+        return SHELL_ERROR;
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(bcache, cmd_bcache, "[sync|drop|reset|bench [MB]] - block cache statistics and benchmark");
@@ -0,0 +1,438 @@
+// src/bench.c
+// Benchmarks als Shell-Befehle. Alle Zeiten kommen vom Generic Timer.
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+#include "timer.h"
+#include "gpio.h"
+#include "uart.h"
+#include "fb.h"
+#include "blit.h"
+
+// ##################################
+// ## Hilfsfunktionen
+// ##################################
+
+// Gibt "<label><count * 1e6 / us> <unit>/s" aus
+static void print_rate(const char* label, unsigned long count, unsigned long ticks, const char* unit) {
+    unsigned long us = timer_ticks_to_us(ticks);
+    if (us == 0) us = 1;
+    console_puts(label);
+    console_putlong(count * 1000000 / us);
+    console_puts(" ");
+    console_puts(unit);
+    console_puts("/s (");
+    console_putlong(us);
+    console_puts(" us)\n");
+}
+
+// Einfacher xorshift-Zufallsgenerator, reproduzierbar über den Startwert
+static unsigned int bench_rand_state = 2463534242u;
+
+static unsigned int bench_rand() {
+    unsigned int x = bench_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return bench_rand_state = x;
+}
+
+// Zufallszahl in [lo, hi)
+static int bench_rand_range(int lo, int hi) {
+    return lo + (int)(bench_rand() % (unsigned int)(hi - lo));
+}
+
+// ##################################
+// ## GPIO
+// ##################################
+
+/**
+ * "gpiobench <pin> [n]": schaltet einen Ausgang n-mal um, einmal über die
+ * Einzelpin-Funktion und einmal über gpio_write_masked. Am Pin lässt sich
+ * die Frequenz zusätzlich mit einem Oszilloskop nachmessen.
+ */
+static int cmd_gpiobench(int argc, char** argv) {
+    if (argc < 2) {
+        console_puts("Usage: gpiobench <pin> [n]\n");
+        return SHELL_ERROR;
+    }
+    unsigned int pin = simple_atoi(argv[1]);
+    long n = argc > 2 ? simple_atol(argv[2]) : 1000000;
+    if (pin > GPIO_MAX_PIN || (pin >= 14 && pin <= 15) || n <= 0) {
+        console_puts("Error: Invalid pin (UART pins 14/15 are not allowed)\n");
+        return SHELL_ERROR;
+    }
+
+    GpioPinConfig config = { pin, GPIO_FUNCTION_OUT, Pull_None };
+    gpio_configure(&config, 1);
+
+    unsigned long start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        gpio_setPinOutputBool(pin, i & 1);
+    }
+    print_rate("single pin: ", n, timer_ticks() - start, "toggles");
+
+    unsigned int bank = pin / 32;
+    unsigned int bit = 1u << (pin % 32);
+    start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        gpio_write_masked(bank, bit, (i & 1) ? bit : 0);
+    }
+    print_rate("masked:     ", n, timer_ticks() - start, "toggles");
+
+    gpio_setPinOutputBool(pin, 0);
+    return SHELL_OK;
+}
+SHELL_COMMAND(gpiobench, cmd_gpiobench, "<pin> [n] - measure the GPIO toggle rate");
+
+// ##################################
+// ## Grafik
+// ##################################
+
+#define LINEBENCH_POLY_POINTS 256
+
+/**
+ * "linebench [n]": zeichnet n zufällige Segmente je Lastfall.
+ * "random" reicht ein Viertel über den Rand hinaus und testet so auch das
+ * Clipping, "short" sind Segmente bis 32 Pixel, "axis" nur waagerechte und
+ * senkrechte Linien, "polyline" ein Zug aus zufälligen Punkten.
+ */
+static int cmd_linebench(int argc, char** argv) {
+    long n = argc > 1 ? simple_atol(argv[1]) : 10000;
+    int w = fb_width(), h = fb_height();
+    if (n <= 0 || w == 0) {
+        console_puts("Error: Invalid count or no framebuffer\n");
+        return SHELL_ERROR;
+    }
+    bench_rand_state = 2463534242u;
+
+    unsigned long start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        drawLine(bench_rand_range(-w / 4, w + w / 4), bench_rand_range(-h / 4, h + h / 4),
+                 bench_rand_range(-w / 4, w + w / 4), bench_rand_range(-h / 4, h + h / 4),
+                 bench_rand() & 0x0f);
+    }
+    print_rate("random:   ", n, timer_ticks() - start, "lines");
+
+    start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        int x = bench_rand_range(0, w), y = bench_rand_range(0, h);
+        drawLine(x, y, x + bench_rand_range(-32, 33), y + bench_rand_range(-32, 33), bench_rand() & 0x0f);
+    }
+    print_rate("short:    ", n, timer_ticks() - start, "lines");
+
+    start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        int a = bench_rand_range(0, w), b = bench_rand_range(0, h);
+        if (i & 1) drawLine(a, 0, a, b, bench_rand() & 0x0f);
+        else drawLine(0, b, a, b, bench_rand() & 0x0f);
+    }
+    print_rate("axis:     ", n, timer_ticks() - start, "lines");
+
+    static int points[2 * LINEBENCH_POLY_POINTS];
+    for (int i = 0; i < LINEBENCH_POLY_POINTS; i++) {
+        points[2 * i] = bench_rand_range(0, w);
+        points[2 * i + 1] = bench_rand_range(0, h);
+    }
+    long polys = (n + LINEBENCH_POLY_POINTS - 2) / (LINEBENCH_POLY_POINTS - 1);
+    start = timer_ticks();
+    for (long i = 0; i < polys; i++) {
+        drawPolyline(points, LINEBENCH_POLY_POINTS, bench_rand() & 0x0f);
+    }
+    print_rate("polyline: ", polys * (LINEBENCH_POLY_POINTS - 1), timer_ticks() - start, "lines");
+
+    return SHELL_OK;
+}
+SHELL_COMMAND(linebench, cmd_linebench, "[n] - measure line drawing throughput");
+
+/**
+ * "fillbench [n]": n gefüllte Formen je Art, vollständig auf dem Schirm.
+ * Die Pixelzahl wird aus der Fläche berechnet (bei Kreisen und Dreiecken
+ * also gerundet), die Rate ist damit eine gute Näherung für Pixel/s.
+ */
+static int cmd_fillbench(int argc, char** argv) {
+    long n = argc > 1 ? simple_atol(argv[1]) : 2000;
+    int w = fb_width(), h = fb_height();
+    if (n <= 0 || w < 256 || h < 256) {
+        console_puts("Error: Invalid count or no framebuffer\n");
+        return SHELL_ERROR;
+    }
+    bench_rand_state = 2463534242u;
+
+    long pixels = 0;
+    unsigned long start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        int x = bench_rand_range(0, w - 128), y = bench_rand_range(0, h - 128);
+        int rw = bench_rand_range(8, 128), rh = bench_rand_range(8, 128);
+        drawRect(x, y, x + rw - 1, y + rh - 1, bench_rand() & 0xff, 1);
+        pixels += rw * rh;
+    }
+    print_rate("rect:     ", pixels, timer_ticks() - start, "pixels");
+
+    pixels = 0;
+    start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        int r = bench_rand_range(4, 64);
+        drawCircle(bench_rand_range(r, w - r), bench_rand_range(r, h - r), r, bench_rand() & 0xff, 1);
+        pixels += 355 * r * r / 113; // pi * r²
+    }
+    print_rate("circle:   ", pixels, timer_ticks() - start, "pixels");
+
+    pixels = 0;
+    start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        int x = bench_rand_range(0, w - 128), y = bench_rand_range(0, h - 128);
+        int x1 = x + bench_rand_range(0, 128), y1 = y + bench_rand_range(0, 128);
+        int x2 = x + bench_rand_range(0, 128), y2 = y + bench_rand_range(0, 128);
+        int x3 = x + bench_rand_range(0, 128), y3 = y + bench_rand_range(0, 128);
+        drawTriangle(x1, y1, x2, y2, x3, y3, bench_rand() & 0xff, 1);
+        long area = (long)(x2 - x1) * (y3 - y1) - (long)(y2 - y1) * (x3 - x1);
+        pixels += (area < 0 ? -area : area) / 2;
+    }
+    print_rate("triangle: ", pixels, timer_ticks() - start, "pixels");
+
+    // Konkaver Stern mit 8 Zacken, Fläche über die Gaußsche Trapezformel
+    static const int star[] = { 64,0, 80,44, 109,19, 89,60, 128,64, 89,68, 109,109, 80,84,
+                                64,128, 48,84, 19,109, 39,68, 0,64, 39,60, 19,19, 48,44 };
+    int points[32];
+    long star_area = 0;
+    for (int i = 0; i < 16; i++) {
+        int j = (i + 1) % 16;
+        star_area += (long)star[2 * i] * star[2 * j + 1] - (long)star[2 * j] * star[2 * i + 1];
+    }
+    if (star_area < 0) star_area = -star_area;
+
+    pixels = 0;
+    start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        int x = bench_rand_range(0, w - 129), y = bench_rand_range(0, h - 129);
+        for (int k = 0; k < 16; k++) {
+            points[2 * k] = star[2 * k] + x;
+            points[2 * k + 1] = star[2 * k + 1] + y;
+        }
+        drawPolygon(points, 16, bench_rand() & 0xff, 1);
+        pixels += star_area / 2;
+    }
+    print_rate("polygon:  ", pixels, timer_ticks() - start, "pixels");
+
+    return SHELL_OK;
+}
+SHELL_COMMAND(fillbench, cmd_fillbench, "[n] - measure filled shape throughput in pixels/s");
+
+// Testbilder für blitbench, einmal angelegt und danach wiederverwendet
+static Image* blitbench_images[3];
+
+static Image* blitbench_image(int index, unsigned int w, unsigned int h) {
+    if (blitbench_images[index] == NULL) {
+        Image* img = blit_create(w, h, BLIT_ALPHA);
+        if (img == NULL) return NULL;
+        img->key = 0xFF00FF;
+        // Farbverlauf, Alpha schräg verlaufend, jede 8. Spalte Schlüsselfarbe
+        for (unsigned int y = 0; y < h; y++) {
+            for (unsigned int x = 0; x < w; x++) {
+                unsigned int a = ((x + y) * 255) / (w + h);
+                unsigned int rgb = (x % 8 == 0) ? 0xFF00FF : ((x * 255 / w) << 16) | ((y * 255 / h) << 8) | 0x80;
+                img->pixels[y * w + x] = (a << 24) | rgb;
+            }
+        }
+        blitbench_images[index] = img;
+    }
+    return blitbench_images[index];
+}
+
+/**
+ * "blitbench [n]": n Blits mit 32x32 je Modus, bei 256x256 und Vollbild
+ * entsprechend weniger, sodass jeweils etwa gleich viele Pixel anfallen.
+ * Die Position wechselt, damit auch nicht ausgerichtete Ziele vorkommen.
+ */
+static int cmd_blitbench(int argc, char** argv) {
+    long n = argc > 1 ? simple_atol(argv[1]) : 2000;
+    unsigned int w = fb_width(), h = fb_height();
+    if (n <= 0 || w < 256 || h < 256) {
+        console_puts("Error: Invalid count or no framebuffer\n");
+        return SHELL_ERROR;
+    }
+
+    static const char* mode_names[] = { "opaque   ", "colorkey ", "alpha    " };
+    unsigned int sizes[3][2] = { { 32, 32 }, { 256, 256 }, { w, h } };
+    bench_rand_state = 2463534242u;
+
+    for (int i = 0; i < 3; i++) {
+        Image* img = blitbench_image(i, sizes[i][0], sizes[i][1]);
+        if (img == NULL) {
+            console_puts("Error: Out of memory\n");
+            return SHELL_ERROR;
+        }
+        long pixels = (long)img->width * img->height;
+        long count = n * 1024 / pixels;
+        if (count < 1) count = 1;
+
+        console_putint(img->width);
+        console_puts("x");
+        console_putint(img->height);
+        console_puts(" (");
+        console_putlong(count);
+        console_puts(" blits)\n");
+
+        for (int mode = BLIT_OPAQUE; mode <= BLIT_ALPHA; mode++) {
+            unsigned long start = timer_ticks();
+            for (long k = 0; k < count; k++) {
+                int x = bench_rand_range(0, w - img->width + 1);
+                int y = bench_rand_range(0, h - img->height + 1);
+                blit_mode(img, x, y, mode);
+            }
+            print_rate(mode_names[mode], count * pixels, timer_ticks() - start, "pixels");
+        }
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(blitbench, cmd_blitbench, "[n] - measure blit throughput for 32x32, 256x256 and full screen");
+
+// ##################################
+// ## UART
+// ##################################
+
+/**
+ * "uartbench [n]": misst die Kosten von uart_writeByteBlocking, solange
+ * die Bytes nur in die Software-Queue wandern (n wird dafür begrenzt).
+ * Zeigt, was die inlined Registerzugriffe pro Byte kosten.
+ */
+static int cmd_uartbench(int argc, char** argv) {
+    long n = argc > 1 ? simple_atol(argv[1]) : 4096;
+    if (n <= 0 || n > 8192) {
+        console_puts("Error: n must be between 1 and 8192\n");
+        return SHELL_ERROR;
+    }
+
+    // Mit leerer Queue starten, damit nichts blockiert
+    uart_flush();
+
+    unsigned long start = timer_ticks();
+    unsigned long cycles = timer_cycles();
+    for (long i = 0; i < n; i++) {
+        uart_writeByteBlocking('.');
+    }
+    cycles = timer_cycles() - cycles;
+    unsigned long ticks = timer_ticks() - start;
+    uart_flush();
+
+    console_puts("\n");
+    print_rate("uart queue: ", n, ticks, "bytes");
+    console_puts("cycles/byte: ");
+    console_putlong(cycles / n);
+    console_puts("\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(uartbench, cmd_uartbench, "[n] - measure the cost per byte of uart_writeByteBlocking");
+
+// ##################################
+// ## Konsole
+// ##################################
+
+#define VTBENCH_LINES   8
+#define VTBENCH_CHANGED 3  // Werte, die sich pro Aktualisierung ändern
+#define VTBENCH_ROW     2  // Erste Zeile des Blocks (1-basiert)
+#define VTBENCH_BAUD    115200
+
+static const char* vtbench_labels[VTBENCH_LINES] = {
+    "cpu clock   ", "load        ", "uptime      ", "uart rx     ",
+    "uart tx     ", "gpio events ", "heap used   ", "frames      "
+};
+
+static unsigned long vtbench_append(char* buffer, unsigned long len, const char* s) {
+    while (*s) buffer[len++] = *s++;
+    return len;
+}
+
+// Wert rechtsbündig in 10 Zeichen
+static unsigned long vtbench_value(char* buffer, unsigned long len, long value) {
+    char digits[21];
+    const char* s = simple_ltoa(value, digits);
+    for (unsigned long pad = strlen_simple(s); pad < 10; pad++) buffer[len++] = ' ';
+    return vtbench_append(buffer, len, s);
+}
+
+static long vtbench_field(int line, long refresh) {
+    return line < VTBENCH_CHANGED ? line * 1000 + refresh * (line + 1) : line * 1000;
+}
+
+// Ohne Escape-Sequenzen: der ganze Block als neue Zeilen
+static unsigned long vtbench_plain(char* buffer, long refresh) {
+    unsigned long len = 0;
+    for (int i = 0; i < VTBENCH_LINES; i++) {
+        len = vtbench_append(buffer, len, vtbench_labels[i]);
+        len = vtbench_value(buffer, len, vtbench_field(i, refresh));
+        buffer[len++] = '\n';
+    }
+    return len;
+}
+
+// Mit ANSI: Cursor sichern, nur die geänderten Felder überschreiben, zurück
+static unsigned long vtbench_ansi(char* buffer, long refresh) {
+    char digits[12];
+    unsigned long len = vtbench_append(buffer, 0, "\x1b" "7");
+    for (int i = 0; i < VTBENCH_CHANGED; i++) {
+        len = vtbench_append(buffer, len, "\x1b[");
+        len = vtbench_append(buffer, len, simple_itoa(VTBENCH_ROW + i, digits));
+        len = vtbench_append(buffer, len, ";13H");
+        len = vtbench_value(buffer, len, vtbench_field(i, refresh));
+    }
+    return vtbench_append(buffer, len, "\x1b" "8");
+}
+
+static void vtbench_report(const char* label, unsigned long bytes, unsigned long ticks, long n) {
+    console_puts(label);
+    console_putlong(bytes / n);
+    console_puts(" bytes/refresh (");
+    console_putlong(bytes * 10 * 1000000 / VTBENCH_BAUD / n);
+    console_puts(" us on the wire at 115200 baud), ");
+    console_putlong(timer_ticks_to_us(ticks) / n);
+    console_puts(" us render\n");
+}
+
+/**
+ * "vtbench [n]": typische Statusanzeige mit 8 Zeilen, von denen sich pro
+ * Aktualisierung 3 Werte ändern. Ohne Escape-Sequenzen muss der Host den
+ * ganzen Block neu schicken (die Konsole scrollt dabei), mit ANSI nur die
+ * geänderten Felder. Verglichen werden Bytes auf der Leitung und die
+ * Renderzeit (nur Framebuffer, inklusive fb_flush).
+ */
+static int cmd_vtbench(int argc, char** argv) {
+    long n = argc > 1 ? simple_atol(argv[1]) : 100;
+    if (n <= 0 || fb_buffer() == NULL) {
+        console_puts("Error: Invalid refresh count or no framebuffer\n");
+        return SHELL_ERROR;
+    }
+    char buffer[VTBENCH_LINES * 32];
+
+    unsigned long plain_bytes = 0, plain_ticks = 0;
+    for (long r = 0; r < n; r++) {
+        unsigned long len = vtbench_plain(buffer, r);
+        unsigned long start = timer_ticks();
+        console_render(buffer, len);
+        fb_flush();
+        plain_ticks += timer_ticks() - start;
+        plain_bytes += len;
+    }
+
+    // Block einmal an feste Stelle zeichnen, danach nur noch Felder ändern
+    char setup[] = "\x1b[2J\x1b[2;1H";
+    console_render(setup, sizeof(setup) - 1);
+    console_render(buffer, vtbench_plain(buffer, 0));
+
+    unsigned long ansi_bytes = 0, ansi_ticks = 0;
+    for (long r = 0; r < n; r++) {
+        unsigned long len = vtbench_ansi(buffer, r);
+        unsigned long start = timer_ticks();
+        console_render(buffer, len);
+        fb_flush();
+        ansi_ticks += timer_ticks() - start;
+        ansi_bytes += len;
+    }
+
+    console_puts("\n");
+    vtbench_report("plain: ", plain_bytes, plain_ticks, n);
+    vtbench_report("ansi:  ", ansi_bytes, ansi_ticks, n);
+    return SHELL_OK;
+}
+SHELL_COMMAND(vtbench, cmd_vtbench, "[n] - compare a status refresh as plain text and with ANSI sequences");
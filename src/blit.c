@@ -0,0 +1,350 @@
+// src/blit.c
+#include "blit.h"
+#include "fb.h"
+#include "mem.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+// Grenzen der Asset-Section (siehe link.ld)
+extern const char __assets_start[];
+extern const char __assets_end[];
+
+// mkasset schreibt den Header mit fester Größe
+_Static_assert(sizeof(Image) == 64, "Image header must be 64 bytes");
+
+// 4 Pixel in einem NEON-Register (GCC-Vektorerweiterung)
+typedef unsigned int u32x4 __attribute__((vector_size(16)));
+typedef unsigned long u64x2 __attribute__((vector_size(16)));
+
+// ##################################
+// ## Assets
+// ##################################
+
+const Image* blit_first() {
+    const Image* img = (const Image*)__assets_start;
+    if ((const char*)img >= __assets_end || img->magic != ASSET_MAGIC) return NULL;
+    return img;
+}
+
+const Image* blit_next(const Image* img) {
+    const Image* next = (const Image*)((const char*)img + img->size);
+    if ((const char*)next >= __assets_end || next->magic != ASSET_MAGIC) return NULL;
+    return next;
+}
+
+const Image* blit_find(const char* name) {
+    for (const Image* img = blit_first(); img != NULL; img = blit_next(img)) {
+        if (strcmp_simple(img->name, name) == 0) return img;
+    }
+    return NULL;
+}
+
+Image* blit_create(unsigned int width, unsigned int height, unsigned int format) {
+    unsigned long size = sizeof(Image) + (unsigned long)width * height * 4;
+    size = (size + 15) & ~15ul;
+    Image* img = mem_alloc(size);
+    if (img == NULL) return NULL;
+    memset(img, 0, size);
+    img->magic = ASSET_MAGIC;
+    img->size = (unsigned int)size;
+    img->width = width;
+    img->height = height;
+    img->format = format;
+    return img;
+}
+
+// ##################################
+// ## Zeilen-Kernel
+// ##################################
+
+/*
+ * Jeder Kernel bearbeitet eine Zeile: einzeln bis das Ziel 16-Byte-
+ * ausgerichtet ist, dann 4 Pixel pro Schritt. Die Quelle darf dabei
+ * beliebig (auf 4 Byte) ausgerichtet sein; das erlaubt die MMU, die RAM
+ * und Framebuffer als Normal-Speicher abbildet (siehe mmu.c).
+ */
+#define ALIGNED16(p) ((((unsigned long)(p)) & 15) == 0)
+
+// Wie u32x4, aber nur auf 4 Byte ausgerichtet (ungeausgerichtetes ldr q)
+typedef unsigned int u32x4u __attribute__((vector_size(16), aligned(4)));
+
+// Quelle über Ziel legen; das Alphabyte des Ziels bleibt erhalten
+static inline unsigned int blend_pixel(unsigned int s, unsigned int d) {
+    // a auf 0..256 strecken, damit >> 8 statt / 255 reicht
+    unsigned int a = s >> 24;
+    a += a >> 7;
+    unsigned int ia = 256 - a;
+    unsigned int rb = (((s & 0xFF00FF) * a + (d & 0xFF00FF) * ia) >> 8) & 0xFF00FF;
+    unsigned int g  = (((s & 0x00FF00) * a + (d & 0x00FF00) * ia) >> 8) & 0x00FF00;
+    return rb | g | (d & 0xFF000000);
+}
+
+static void row_copy(unsigned int* d, const unsigned int* s, int n) {
+    while (n > 0 && !ALIGNED16(d)) { *d++ = *s++; n--; }
+    for (; n >= 4; n -= 4, d += 4, s += 4) {
+        *(u32x4*)d = *(const u32x4u*)s;
+    }
+    while (n-- > 0) *d++ = *s++;
+}
+
+static void row_colorkey(unsigned int* d, const unsigned int* s, int n, unsigned int key) {
+    while (n > 0 && !ALIGNED16(d)) {
+        if ((*s & 0xFFFFFF) != key) *d = *s;
+        d++; s++; n--;
+    }
+    u32x4 rgb = { 0xFFFFFF, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF };
+    u32x4 k = { key, key, key, key };
+    for (; n >= 4; n -= 4, d += 4, s += 4) {
+        u32x4 sv = *(const u32x4u*)s;
+        u32x4 m = (u32x4)((sv & rgb) != k); // -1 = Pixel zeichnen
+        *(u32x4*)d = (sv & m) | (*(u32x4*)d & ~m);
+    }
+    while (n-- > 0) {
+        if ((*s & 0xFFFFFF) != key) *d = *s;
+        d++; s++;
+    }
+}
+
+static void row_alpha(unsigned int* d, const unsigned int* s, int n) {
+    while (n > 0 && !ALIGNED16(d)) { *d = blend_pixel(*s, *d); d++; s++; n--; }
+
+    u32x4 amask = { 0xFF000000, 0xFF000000, 0xFF000000, 0xFF000000 };
+    u32x4 rbmask = { 0xFF00FF, 0xFF00FF, 0xFF00FF, 0xFF00FF };
+    u32x4 gmask = { 0x00FF00, 0x00FF00, 0x00FF00, 0x00FF00 };
+    u32x4 full = { 256, 256, 256, 256 };
+    for (; n >= 4; n -= 4, d += 4, s += 4) {
+        u32x4 sv = *(const u32x4u*)s;
+        u64x2 av = (u64x2)(sv & amask);
+        // Häufige Fälle in Icons: 4 deckende oder 4 durchsichtige Pixel
+        if ((av[0] | av[1]) == 0) continue;
+        u32x4 dv = *(u32x4*)d;
+        if ((av[0] & av[1]) == 0xFF000000FF000000ul) {
+            *(u32x4*)d = (sv & ~amask) | (dv & amask);
+            continue;
+        }
+
+        u32x4 a = sv >> 24;
+        a += a >> 7;
+        u32x4 ia = full - a;
+        u32x4 rb = (((sv & rbmask) * a + (dv & rbmask) * ia) >> 8) & rbmask;
+        u32x4 g  = (((sv & gmask) * a + (dv & gmask) * ia) >> 8) & gmask;
+        *(u32x4*)d = rb | g | (dv & amask);
+    }
+    while (n-- > 0) { *d = blend_pixel(*s, *d); d++; s++; }
+}
+
+/*
+ * 16 und 8 Bit: die Quelle wird pro Pixel ins Zielformat gewandelt. Wie in
+ * fb.c wird die Pixelgröße B als Konstante eingesetzt, damit jede Variante
+ * ohne Formatabfragen in der Schleife auskommt. Alpha wird bei 16 Bit gegen
+ * das entpackte Ziel gemischt, bei 8 Bit (Palette) ab 50 % gedeckt gezeichnet.
+ */
+static inline unsigned int unpack565(unsigned int p) {
+    unsigned int r = (p >> 11) & 0x1F, g = (p >> 5) & 0x3F, b = p & 0x1F;
+    return (r << 3 | r >> 2) << 16 | (g << 2 | g >> 4) << 8 | (b << 3 | b >> 2);
+}
+
+static inline __attribute__((always_inline))
+void row_packed(unsigned char* d, const unsigned int* s, int n, unsigned int key, int mode, int B) {
+    for (int i = 0; i < n; i++, d += B) {
+        unsigned int p = s[i];
+        if (mode == BLIT_COLORKEY && (p & 0xFFFFFF) == key) continue;
+        if (mode == BLIT_ALPHA) {
+            unsigned int a = p >> 24;
+            if (B == 1 ? a < 128 : a == 0) continue;
+            if (B == 2 && a != 255) p = blend_pixel(p, unpack565(*(unsigned short*)d));
+        }
+        if (B == 2) *(unsigned short*)d = fb_rgb565(p);
+        else *d = fb_cube_index(p);
+    }
+}
+
+typedef void (*RowKernel)(unsigned char* d, const unsigned int* s, int n, unsigned int key);
+
+static void row32_copy(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_copy((unsigned int*)d, s, n); }
+static void row32_key(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_colorkey((unsigned int*)d, s, n, key); }
+static void row32_alpha(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_alpha((unsigned int*)d, s, n); }
+static void row16_copy(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_packed(d, s, n, key, BLIT_OPAQUE, 2); }
+static void row16_key(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_packed(d, s, n, key, BLIT_COLORKEY, 2); }
+static void row16_alpha(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_packed(d, s, n, key, BLIT_ALPHA, 2); }
+static void row8_copy(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_packed(d, s, n, key, BLIT_OPAQUE, 1); }
+static void row8_key(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_packed(d, s, n, key, BLIT_COLORKEY, 1); }
+static void row8_alpha(unsigned char* d, const unsigned int* s, int n, unsigned int key) { row_packed(d, s, n, key, BLIT_ALPHA, 1); }
+
+// [Bytes pro Pixel / 2][Modus]
+static const RowKernel row_kernels[3][3] = {
+    { row8_copy, row8_key, row8_alpha },
+    { row16_copy, row16_key, row16_alpha },
+    { row32_copy, row32_key, row32_alpha }
+};
+
+static RowKernel row_kernel(int mode) {
+    if (mode < BLIT_OPAQUE || mode > BLIT_ALPHA) mode = BLIT_ALPHA;
+    return row_kernels[fb_depth() / 16][mode];
+}
+
+// ##################################
+// ## Blits
+// ##################################
+
+void blit_rect(const Image* img, int sx, int sy, int w, int h, int x, int y, int mode) {
+    unsigned char* fb = fb_buffer();
+    const FbRect* c = fb_get_clip();
+    if (img == NULL || fb == NULL) return;
+
+    // Quelle auf das Bild begrenzen
+    if (sx < 0) { w += sx; x -= sx; sx = 0; }
+    if (sy < 0) { h += sy; y -= sy; sy = 0; }
+    if (sx + w > (int)img->width) w = img->width - sx;
+    if (sy + h > (int)img->height) h = img->height - sy;
+
+    // Ziel auf das Clip-Rechteck begrenzen
+    if (x < c->x1) { w -= c->x1 - x; sx += c->x1 - x; x = c->x1; }
+    if (y < c->y1) { h -= c->y1 - y; sy += c->y1 - y; y = c->y1; }
+    if (x + w > c->x2 + 1) w = c->x2 + 1 - x;
+    if (y + h > c->y2 + 1) h = c->y2 + 1 - y;
+    if (w <= 0 || h <= 0) return;
+    fb_begin_draw(x, y, x + w - 1, y + h - 1);
+
+    unsigned int pitch = fb_pitch();
+    RowKernel kernel = row_kernel(mode);
+    const unsigned int* src = img->pixels + (long)sy * img->width + sx;
+    unsigned char* dst = fb + (long)y * pitch + (long)x * (fb_depth() / 8);
+
+    for (int row = 0; row < h; row++, src += img->width, dst += pitch) {
+        kernel(dst, src, w, img->key);
+    }
+    fb_mark_dirty(x, y, x + w - 1, y + h - 1);
+}
+
+void blit_mode(const Image* img, int x, int y, int mode) {
+    if (img == NULL) return;
+    blit_rect(img, 0, 0, img->width, img->height, x, y, mode);
+}
+
+void blit(const Image* img, int x, int y) {
+    if (img == NULL) return;
+    blit_rect(img, 0, 0, img->width, img->height, x, y, img->format);
+}
+
+// Pixel pro Zwischenzeile in blit_scaled (liegt auf dem Stack)
+#define SCALE_CHUNK 256
+
+/**
+ * Nearest Neighbour in 16.16-Festkomma: der Quellpixel für Zielspalte i ist
+ * (i * step) >> 16. Beim Clippen links/oben wird der Startwert einfach um
+ * die übersprungenen Schritte weitergezählt.
+ */
+void blit_scaled(const Image* img, int x, int y, int w, int h, int mode) {
+    unsigned char* fb = fb_buffer();
+    const FbRect* c = fb_get_clip();
+    if (img == NULL || fb == NULL || w <= 0 || h <= 0) return;
+    if (w == (int)img->width && h == (int)img->height) { blit_mode(img, x, y, mode); return; }
+
+    unsigned long xstep = ((unsigned long)img->width << 16) / w;
+    unsigned long ystep = ((unsigned long)img->height << 16) / h;
+    unsigned long fx0 = 0, fy = 0;
+
+    if (x < c->x1) { fx0 = xstep * (c->x1 - x); w -= c->x1 - x; x = c->x1; }
+    if (y < c->y1) { fy = ystep * (c->y1 - y); h -= c->y1 - y; y = c->y1; }
+    if (x + w > c->x2 + 1) w = c->x2 + 1 - x;
+    if (y + h > c->y2 + 1) h = c->y2 + 1 - y;
+    if (w <= 0 || h <= 0) return;
+    fb_begin_draw(x, y, x + w - 1, y + h - 1);
+
+    unsigned int pitch = fb_pitch();
+    unsigned int bytes = fb_depth() / 8;
+    RowKernel kernel = row_kernel(mode);
+    unsigned int line[SCALE_CHUNK] __attribute__((aligned(16)));
+    unsigned char* dst = fb + (long)y * pitch + (long)x * bytes;
+
+    for (int row = 0; row < h; row++, fy += ystep, dst += pitch) {
+        const unsigned int* src = img->pixels + (fy >> 16) * img->width;
+        unsigned long fx = fx0;
+        // Quellpixel stückweise sammeln und mit dem Zeilenkernel zeichnen
+        for (int i = 0; i < w; i += SCALE_CHUNK) {
+            int n = w - i < SCALE_CHUNK ? w - i : SCALE_CHUNK;
+            for (int j = 0; j < n; j++, fx += xstep) line[j] = src[fx >> 16];
+            kernel(dst + (long)i * bytes, line, n, img->key);
+        }
+    }
+    fb_mark_dirty(x, y, x + w - 1, y + h - 1);
+}
+
+// Pixel pro Stück in blit_stream (auf dem Heap, einmal angelegt)
+#define STREAM_PIXELS 16384
+
+// Liest genau n Bytes, solange die Quelle nicht vorher endet
+static bool read_full(blit_read_t read, void* ctx, void* buffer, unsigned long n) {
+    unsigned char* p = buffer;
+    while (n > 0) {
+        long got = read(ctx, p, n);
+        if (got <= 0) return false;
+        p += got;
+        n -= got;
+    }
+    return true;
+}
+
+/**
+ * Die Zeilen landen blockweise in einem Zwischenbild, dessen Header wie
+ * ein Ausschnitt des ganzen Bildes aussieht; gezeichnet wird dann mit
+ * blit_rect, Clipping und Pixelformat kommen von dort.
+ */
+int blit_stream(blit_read_t read, void* ctx, int x, int y) {
+    static Image* chunk = NULL;
+    if (chunk == NULL) chunk = blit_create(STREAM_PIXELS, 1, BLIT_OPAQUE);
+    if (chunk == NULL) return -1;
+
+    Image header;
+    if (!read_full(read, ctx, &header, sizeof(header))) return -1;
+    if (header.magic != ASSET_MAGIC || header.width == 0 || header.width > STREAM_PIXELS) return -1;
+
+    unsigned int rows = STREAM_PIXELS / header.width;
+    chunk->width = header.width;
+    chunk->format = header.format;
+    chunk->key = header.key;
+    for (unsigned int row = 0; row < header.height; row += rows) {
+        unsigned int n = header.height - row < rows ? header.height - row : rows;
+        if (!read_full(read, ctx, chunk->pixels, (unsigned long)n * header.width * 4)) return -1;
+        chunk->height = n;
+        blit_rect(chunk, 0, 0, header.width, n, x, y + row, header.format);
+    }
+    return 0;
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+static int cmd_assets(int argc, char** argv) {
+    for (const Image* img = blit_first(); img != NULL; img = blit_next(img)) {
+        console_puts(img->name);
+        console_puts(": ");
+        console_putint(img->width);
+        console_puts("x");
+        console_putint(img->height);
+        console_puts(img->format == BLIT_ALPHA ? " alpha\n" : img->format == BLIT_COLORKEY ? " colorkey\n" : " opaque\n");
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(assets, cmd_assets, "- list the images embedded in the kernel");
+
+// "blit <name> <x> <y> [w h]": zeichnet ein Asset, optional skaliert
+static int cmd_blit(int argc, char** argv) {
+    if (argc != 4 && argc != 6) {
+        console_puts("Usage: blit <name> <x> <y> [w h]\n");
+        return SHELL_ERROR;
+    }
+    const Image* img = blit_find(argv[1]);
+    if (img == NULL) {
+        console_puts("Error: Unknown asset (see 'assets')\n");
+        return SHELL_ERROR;
+    }
+    int x = simple_atoi(argv[2]), y = simple_atoi(argv[3]);
+    if (argc == 6) blit_scaled(img, x, y, simple_atoi(argv[4]), simple_atoi(argv[5]), img->format);
+    else blit(img, x, y);
+    return SHELL_OK;
+}
+SHELL_COMMAND(blit, cmd_blit, "<name> <x> <y> [w h] - draw an embedded image");
@@ -0,0 +1,207 @@
+// src/clock.c
+#include "clock.h"
+#include "mb.h"
+#include "uart.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+// Letzter bekannter Kerntakt, um Änderungen zu erkennen
+static unsigned int core_clock;
+
+typedef struct {
+    bool enabled;
+    unsigned long last;         // Zeitpunkt des letzten Updates
+    unsigned long busy, total;  // Ticks im aktuellen Zeitraum
+    unsigned int min, max;      // Grenzen des ARM-Takts
+    unsigned int rate;          // Zuletzt eingestellter ARM-Takt
+    unsigned int load;          // Last des letzten Zeitraums in Prozent
+    unsigned long changes;      // Anzahl der Taktwechsel
+} Governor;
+
+static Governor governor;
+
+// ##################################
+// ## Mailbox
+// ##################################
+
+// Tag mit den Werten (id, rate[, 0]) senden; liefert die Rate der Antwort
+static unsigned int clock_call(unsigned int tag, unsigned int id, unsigned int rate) {
+    bool set = tag == MBOX_TAG_SETCLKRATE;
+
+    mbox[0] = (set ? 9 : 8) * 4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = tag;
+    mbox[3] = set ? 12 : 8;
+    mbox[4] = 0;
+    mbox[5] = id;
+    mbox[6] = rate;
+    if (set) {
+        mbox[7] = 0; // Turbo-Einstellungen nicht überspringen
+        mbox[8] = MBOX_TAG_LAST;
+    } else {
+        mbox[7] = MBOX_TAG_LAST;
+    }
+
+    if (!mbox_call(MBOX_CH_PROP) || mbox[5] != id) return 0;
+    return mbox[6];
+}
+
+// Kerntakt neu lesen und abhängige Teiler nachziehen
+static void clock_check_core() {
+    unsigned int hz = clock_call(MBOX_TAG_GETCLKRATE, CLOCK_CORE, 0);
+    if (hz == 0 || hz == core_clock) return;
+    core_clock = hz;
+    uart_set_clock(hz);
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+unsigned int clock_rate(unsigned int id) { return clock_call(MBOX_TAG_GETCLKRATE, id, 0); }
+unsigned int clock_measured(unsigned int id) { return clock_call(MBOX_TAG_GETMEASCLK, id, 0); }
+unsigned int clock_min(unsigned int id) { return clock_call(MBOX_TAG_GETMINCLK, id, 0); }
+unsigned int clock_max(unsigned int id) { return clock_call(MBOX_TAG_GETMAXCLK, id, 0); }
+
+unsigned int clock_set_rate(unsigned int id, unsigned int hz) {
+    // Die Firmware kann den Kerntakt mit anderen Takten zusammen ändern. Was
+    // dann noch in der Sende-FIFO steht, ginge mit dem alten Teiler, aber dem
+    // neuen Takt hinaus: vorher alles senden, danach den Teiler nachziehen.
+    uart_drain();
+    unsigned int actual = clock_call(MBOX_TAG_SETCLKRATE, id, hz);
+    clock_check_core();
+    return actual;
+}
+
+void clock_init() {
+    clock_check_core();
+    unsigned int max = clock_max(CLOCK_ARM);
+    if (max != 0) clock_set_rate(CLOCK_ARM, max);
+}
+
+// ##################################
+// ## Governor
+// ##################################
+
+void clock_governor_enable(bool on) {
+    governor.min = clock_min(CLOCK_ARM);
+    governor.max = clock_max(CLOCK_ARM);
+    governor.rate = clock_rate(CLOCK_ARM);
+    governor.enabled = on && governor.min != 0 && governor.max != 0 && governor.rate != 0;
+    governor.last = timer_ticks();
+    governor.busy = 0;
+    governor.total = 0;
+    // Ausgeschaltet gilt wieder der Takt aus clock_init
+    if (!on && governor.max != 0) clock_set_rate(CLOCK_ARM, governor.max);
+}
+
+void clock_governor_update(bool busy) {
+    if (!governor.enabled) return;
+
+    unsigned long now = timer_ticks();
+    unsigned long delta = now - governor.last;
+    governor.last = now;
+    governor.total += delta;
+    if (busy) governor.busy += delta;
+    if (governor.total < timer_freq() / 1000 * CLOCK_GOV_PERIOD_MS) return;
+
+    governor.load = governor.busy * 100 / governor.total;
+    governor.busy = 0;
+    governor.total = 0;
+
+    unsigned int target = governor.max;
+    if (governor.load < CLOCK_GOV_UP_PERCENT) {
+        target = (unsigned long)governor.max * governor.load / CLOCK_GOV_UP_PERCENT;
+        if (target < governor.min) target = governor.min;
+    }
+    // Kleine Schwankungen ignorieren: erst ab 10 % Unterschied umschalten
+    // (Raten in Hz: diff * 10 liefe in 32 Bit schon ab 430 MHz über)
+    unsigned int current = governor.rate;
+    unsigned int diff = target > current ? target - current : current - target;
+    if (diff < current / 10) return;
+
+    unsigned int actual = clock_set_rate(CLOCK_ARM, target);
+    if (actual != 0) governor.rate = actual;
+    governor.changes++;
+
+    // Die Mailbox-Aufrufe gehören nicht zur Last des nächsten Zeitraums
+    governor.last = timer_ticks();
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+static const struct {
+    unsigned int id;
+    const char* name;
+} clock_names[] = {
+    { CLOCK_ARM, "arm" }, { CLOCK_CORE, "core" }, { CLOCK_EMMC, "emmc" },
+    { CLOCK_EMMC2, "emmc2" }, { CLOCK_UART, "uart" }
+};
+
+#define CLOCK_NAMES (sizeof(clock_names) / sizeof(clock_names[0]))
+
+static void put_mhz(unsigned int hz) {
+    console_putint(hz / 1000000);
+    console_puts(" MHz");
+}
+
+static int cmd_clock(int argc, char** argv) {
+    if (argc == 1) {
+        for (unsigned int i = 0; i < CLOCK_NAMES; i++) {
+            unsigned int id = clock_names[i].id;
+            console_puts(clock_names[i].name);
+            console_puts(": ");
+            put_mhz(clock_rate(id));
+            console_puts(" (measured ");
+            put_mhz(clock_measured(id));
+            console_puts(", min ");
+            put_mhz(clock_min(id));
+            console_puts(", max ");
+            put_mhz(clock_max(id));
+            console_puts(")\n");
+        }
+        console_puts("governor: ");
+        console_puts(governor.enabled ? "on, load " : "off, load ");
+        console_putint(governor.load);
+        console_puts("%, ");
+        console_putlong(governor.changes);
+        console_puts(" changes\n");
+        return SHELL_OK;
+    }
+
+    if (argc == 3 && strcmp_simple(argv[1], "governor") == 0) {
+        if (strcmp_simple(argv[2], "on") == 0) clock_governor_enable(true);
+        else if (strcmp_simple(argv[2], "off") == 0) clock_governor_enable(false);
+        else {
+            console_puts("Usage: clock governor on|off\n");
+            return SHELL_ERROR;
+        }
+        return SHELL_OK;
+    }
+
+    if (argc == 3) {
+        for (unsigned int i = 0; i < CLOCK_NAMES; i++) {
+            if (strcmp_simple(argv[1], clock_names[i].name) != 0) continue;
+            long mhz = simple_atol(argv[2]);
+            if (mhz <= 0) break;
+            if (clock_names[i].id == CLOCK_ARM && governor.enabled) {
+                console_puts("Note: governor disabled\n");
+                governor.enabled = false;
+            }
+            put_mhz(clock_set_rate(clock_names[i].id, mhz * 1000000));
+            console_puts("\n");
+            return SHELL_OK;
+        }
+    }
+
+    console_puts("Usage: clock [arm|core|emmc|emmc2|uart <MHz>] | clock governor on|off\n");
+    return SHELL_ERROR;
+}
+SHELL_COMMAND(clock, cmd_clock, "[<name> <MHz>|governor on|off] - show or set clock rates");
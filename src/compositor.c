@@ -0,0 +1,337 @@
+// src/compositor.c
+#include "compositor.h"
+#include "fb.h"
+#include "smp.h"
+#include "shell.h"
+#include "console.h"
+#include "timer.h"
+#include "crc32.h"
+
+// ##################################
+// ## Display-Liste
+// ##################################
+
+enum {
+    CMD_RECT,
+    CMD_LINE,
+    CMD_CIRCLE,
+    CMD_TRIANGLE,
+    CMD_POLYGON,
+    CMD_TEXT,
+    CMD_BLIT
+};
+
+typedef struct {
+    unsigned char type;
+    unsigned char attr;
+    unsigned char fill;  // bzw. Blit-Modus
+    int p[6];            // Koordinaten je nach Typ
+    const void* data;    // Text, Punktliste oder Bild
+    FbRect bounds;       // Betroffene Pixel (inklusive), für den Kacheltest
+} CompCmd;
+
+static CompCmd comp_cmds[COMP_MAX_CMDS];
+static unsigned int comp_cmd_count = 0;
+
+static char comp_arena[COMP_ARENA] __attribute__((aligned(16)));
+static unsigned int comp_arena_used = 0;
+
+static int min3(int a, int b, int c) { int m = a < b ? a : b; return m < c ? m : c; }
+static int max3(int a, int b, int c) { int m = a > b ? a : b; return m > c ? m : c; }
+
+static CompCmd* comp_add(int type, unsigned char attr, int fill, int x1, int y1, int x2, int y2) {
+    if (comp_cmd_count >= COMP_MAX_CMDS) return NULL;
+    CompCmd* cmd = &comp_cmds[comp_cmd_count++];
+    cmd->type = type;
+    cmd->attr = attr;
+    cmd->fill = fill;
+    cmd->data = NULL;
+    cmd->bounds = (FbRect){ x1, y1, x2, y2 };
+    return cmd;
+}
+
+static void* comp_arena_alloc(unsigned int size) {
+    size = (size + 15) & ~15u;
+    if (comp_arena_used + size > COMP_ARENA) return NULL;
+    void* p = comp_arena + comp_arena_used;
+    comp_arena_used += size;
+    return p;
+}
+
+void comp_begin() {
+    comp_cmd_count = 0;
+    comp_arena_used = 0;
+}
+
+unsigned int comp_count() {
+    return comp_cmd_count;
+}
+
+bool comp_rect(int x1, int y1, int x2, int y2, unsigned char attr, int fill) {
+    CompCmd* cmd = comp_add(CMD_RECT, attr, fill, x1, y1, x2, y2);
+    if (cmd == NULL) return false;
+    cmd->p[0] = x1; cmd->p[1] = y1; cmd->p[2] = x2; cmd->p[3] = y2;
+    return true;
+}
+
+bool comp_clear(unsigned char attr) {
+    attr &= 0x0f;
+    return comp_rect(0, 0, fb_width() - 1, fb_height() - 1, attr | (attr << 4), 1);
+}
+
+bool comp_line(int x1, int y1, int x2, int y2, unsigned char attr) {
+    CompCmd* cmd = comp_add(CMD_LINE, attr, 0, x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2,
+                            x1 > x2 ? x1 : x2, y1 > y2 ? y1 : y2);
+    if (cmd == NULL) return false;
+    cmd->p[0] = x1; cmd->p[1] = y1; cmd->p[2] = x2; cmd->p[3] = y2;
+    return true;
+}
+
+bool comp_circle(int x0, int y0, int radius, unsigned char attr, int fill) {
+    CompCmd* cmd = comp_add(CMD_CIRCLE, attr, fill, x0 - radius, y0 - radius, x0 + radius, y0 + radius);
+    if (cmd == NULL) return false;
+    cmd->p[0] = x0; cmd->p[1] = y0; cmd->p[2] = radius;
+    return true;
+}
+
+bool comp_triangle(int x1, int y1, int x2, int y2, int x3, int y3, unsigned char attr, int fill) {
+    CompCmd* cmd = comp_add(CMD_TRIANGLE, attr, fill, min3(x1, x2, x3), min3(y1, y2, y3),
+                            max3(x1, x2, x3), max3(y1, y2, y3));
+    if (cmd == NULL) return false;
+    cmd->p[0] = x1; cmd->p[1] = y1; cmd->p[2] = x2;
+    cmd->p[3] = y2; cmd->p[4] = x3; cmd->p[5] = y3;
+    return true;
+}
+
+bool comp_polygon(const int* points, int count, unsigned char attr, int fill) {
+    if (count < 2) return true;
+    int* copy = comp_arena_alloc(count * 2 * sizeof(int));
+    if (copy == NULL) return false;
+
+    FbRect b = { points[0], points[1], points[0], points[1] };
+    for (int i = 0; i < count; i++) {
+        int x = points[2 * i], y = points[2 * i + 1];
+        copy[2 * i] = x;
+        copy[2 * i + 1] = y;
+        if (x < b.x1) b.x1 = x;
+        if (x > b.x2) b.x2 = x;
+        if (y < b.y1) b.y1 = y;
+        if (y > b.y2) b.y2 = y;
+    }
+    CompCmd* cmd = comp_add(CMD_POLYGON, attr, fill, b.x1, b.y1, b.x2, b.y2);
+    if (cmd == NULL) return false;
+    cmd->p[0] = count;
+    cmd->data = copy;
+    return true;
+}
+
+bool comp_text(int x, int y, const char* s, unsigned char attr) {
+    // Ausdehnung wie in drawString: '\r' und '\n' springen zurück auf x = 0
+    int longest = 0, column = 0, lines = 1, x_min = x;
+    for (const char* c = s; *c; c++) {
+        if (*c == '\n' || *c == '\r') {
+            x_min = 0;
+            column = 0;
+            if (*c == '\n') lines++;
+        } else if (++column > longest) {
+            longest = column;
+        }
+    }
+
+    unsigned int size = strlen_simple(s) + 1;
+    char* copy = comp_arena_alloc(size);
+    if (copy == NULL) return false;
+    memcpy(copy, s, size);
+
+    int x_max = (x > 0 ? x : 0) + longest * FB_FONT_WIDTH - 1;
+    CompCmd* cmd = comp_add(CMD_TEXT, attr, 0, x_min < x ? x_min : x, y, x_max, y + lines * FB_FONT_HEIGHT - 1);
+    if (cmd == NULL) return false;
+    cmd->p[0] = x; cmd->p[1] = y;
+    cmd->data = copy;
+    return true;
+}
+
+bool comp_blit(const Image* img, int x, int y, int mode) {
+    if (img == NULL) return true;
+    CompCmd* cmd = comp_add(CMD_BLIT, 0, mode, x, y, x + img->width - 1, y + img->height - 1);
+    if (cmd == NULL) return false;
+    cmd->p[0] = x; cmd->p[1] = y;
+    cmd->data = img;
+    return true;
+}
+
+// ##################################
+// ## Rastern
+// ##################################
+
+static void comp_draw(const CompCmd* cmd) {
+    const int* p = cmd->p;
+    switch (cmd->type) {
+        case CMD_RECT:     drawRect(p[0], p[1], p[2], p[3], cmd->attr, cmd->fill); break;
+        case CMD_LINE:     drawLine(p[0], p[1], p[2], p[3], cmd->attr); break;
+        case CMD_CIRCLE:   drawCircle(p[0], p[1], p[2], cmd->attr, cmd->fill); break;
+        case CMD_TRIANGLE: drawTriangle(p[0], p[1], p[2], p[3], p[4], p[5], cmd->attr, cmd->fill); break;
+        case CMD_POLYGON:  drawPolygon(cmd->data, p[0], cmd->attr, cmd->fill); break;
+        case CMD_TEXT:     drawString(p[0], p[1], (char*)cmd->data, cmd->attr); break;
+        case CMD_BLIT:     blit_mode(cmd->data, p[0], p[1], cmd->fill); break;
+    }
+}
+
+// Läuft auf jedem beteiligten Core: Kacheln core, core + cores, ...
+static void comp_worker(unsigned int core, unsigned int cores, void* arg) {
+    int w = fb_width(), h = fb_height();
+    int tiles_x = (w + COMP_TILE - 1) / COMP_TILE;
+    int tiles = tiles_x * ((h + COMP_TILE - 1) / COMP_TILE);
+
+    for (int t = core; t < tiles; t += cores) {
+        FbRect tile;
+        tile.x1 = (t % tiles_x) * COMP_TILE;
+        tile.y1 = (t / tiles_x) * COMP_TILE;
+        tile.x2 = tile.x1 + COMP_TILE - 1;
+        tile.y2 = tile.y1 + COMP_TILE - 1;
+        fb_set_clip(tile.x1, tile.y1, tile.x2, tile.y2);
+
+        for (unsigned int i = 0; i < comp_cmd_count; i++) {
+            const CompCmd* cmd = &comp_cmds[i];
+            if (cmd->bounds.x2 < tile.x1 || cmd->bounds.x1 > tile.x2 ||
+                cmd->bounds.y2 < tile.y1 || cmd->bounds.y1 > tile.y2) continue;
+            comp_draw(cmd);
+        }
+    }
+    fb_reset_clip();
+}
+
+void comp_render(unsigned int cores) {
+    if (fb_buffer() == NULL) return;
+    // Einmal hier statt auf jedem Core (Software-Cursor, siehe fb_set_draw_hook)
+    fb_begin_draw(0, 0, fb_width() - 1, fb_height() - 1);
+    smp_run(comp_worker, NULL, cores);
+    fb_flush();
+}
+
+// ##################################
+// ## Benchmark
+// ##################################
+
+// Skala der Rundinstrumente: 225° bis -45° in 27°-Schritten, Werte * 1000
+#define GAUGE_STEPS 11
+static const int gauge_cos[GAUGE_STEPS] = { -707, -951, -988, -809, -454, 0, 454, 809, 988, 951, 707 };
+static const int gauge_sin[GAUGE_STEPS] = { -707, -309, 156, 588, 891, 1000, 891, 588, 156, -309, -707 };
+
+// Ein Armaturenbrett: Hintergrund, Rundinstrumente, Balken- und
+// Liniendiagramm, Beschriftungen und Symbole
+static void comp_build_dashboard(unsigned int frame) {
+    int w = fb_width(), h = fb_height();
+    comp_begin();
+    comp_clear(0x01);
+
+    // Vier Rundinstrumente mit Skala und Zeiger
+    for (int g = 0; g < 4; g++) {
+        int cx = w / 8 + g * w / 4, cy = h / 4, r = h / 6;
+        comp_circle(cx, cy, r, 0x8f, 1);
+        for (int t = 0; t < GAUGE_STEPS; t++) {
+            comp_line(cx + gauge_cos[t] * (r - 12) / 1000, cy - gauge_sin[t] * (r - 12) / 1000,
+                      cx + gauge_cos[t] * (r - 2) / 1000, cy - gauge_sin[t] * (r - 2) / 1000, 0x0f);
+        }
+        int v = (frame * 7 + g * 3) % GAUGE_STEPS;
+        int nx = cx + gauge_cos[v] * (r - 16) / 1000, ny = cy - gauge_sin[v] * (r - 16) / 1000;
+        int px = gauge_sin[v] * 6 / 1000, py = gauge_cos[v] * 6 / 1000; // Senkrecht zum Zeiger
+        comp_triangle(cx - px, cy - py, cx + px, cy + py, nx, ny, 0xcc, 1);
+        comp_circle(cx, cy, 8, 0x77, 1);
+        comp_text(cx - 3 * FB_FONT_WIDTH, cy + r / 2, "GAUGE", 0x0e);
+    }
+
+    // Balkendiagramm
+    int base = h * 9 / 10, bar_w = w / 2 / 32;
+    for (int b = 0; b < 32; b++) {
+        int bh = ((b * 37 + frame * 13) % 100) * h / 300 + 8;
+        comp_rect(w / 32 + b * bar_w, base - bh, w / 32 + (b + 1) * bar_w - 3, base, 0x2a, 1);
+    }
+    comp_line(w / 32, base + 1, w / 2, base + 1, 0x0f);
+
+    // Liniendiagramm aus 200 Segmenten (Dreieckswelle)
+    int x0 = w * 17 / 32, yb = h * 9 / 10, prev_y = yb;
+    for (int i = 0; i <= 200; i++) {
+        int t = (i * 4 + frame * 6) % 200;
+        int y = yb - h / 40 - (t < 100 ? t : 200 - t) * h / 400;
+        if (i > 0) comp_line(x0 + (i - 1) * (w * 14 / 32) / 200, prev_y, x0 + i * (w * 14 / 32) / 200, y, 0x0b);
+        prev_y = y;
+    }
+
+    // Beschriftungen
+    for (int i = 0; i < 8; i++) {
+        comp_text(x0, h / 2 + i * 2 * FB_FONT_HEIGHT, "Sensor 0x1F  OK  42.0 C  1013 hPa", 0x07);
+    }
+
+    // Symbole
+    for (int i = 0; i < 8; i++) {
+        comp_blit(blit_find("warning"), w - 48, h / 2 + i * 40, BLIT_COLORKEY);
+    }
+    comp_blit(blit_find("logo"), w - 160, h / 2, BLIT_ALPHA);
+}
+
+/**
+ * "compbench [frames]": zeichnet das Armaturenbrett mit 1, 2 und 4 Cores
+ * und gibt Bilder/s, die Beschleunigung und eine CRC des Framebuffers aus.
+ * Die CRC muss für alle Core-Anzahlen gleich sein.
+ */
+static int cmd_compbench(int argc, char** argv) {
+    long frames = argc > 1 ? simple_atol(argv[1]) : 20;
+    unsigned char* fb = fb_buffer();
+    if (frames <= 0 || fb == NULL) {
+        console_puts("Error: Invalid frame count or no framebuffer\n");
+        return SHELL_ERROR;
+    }
+
+    unsigned long base_us = 0;
+    FbStats shadow = { 0 };
+    for (unsigned int cores = 1; cores <= SMP_MAX_CORES; cores *= 2) {
+        if (cores > smp_cores()) break;
+
+        unsigned long ticks = 0;
+        unsigned long flushes = fb_stats()->flushes;
+        for (long f = 0; f < frames; f++) {
+            comp_build_dashboard(f);
+            unsigned long start = timer_ticks();
+            comp_render(cores);
+            ticks += timer_ticks() - start;
+        }
+        // Schattenpuffer an: Statistik des letzten Bildes merken
+        if (fb_stats()->flushes != flushes) shadow = *fb_stats();
+        unsigned long us = timer_ticks_to_us(ticks);
+        if (us == 0) us = 1;
+        if (cores == 1) base_us = us;
+
+        unsigned int crc = 0;
+        for (unsigned int y = 0; y < fb_height(); y++) {
+            crc = crc32_update(crc, fb + y * fb_pitch(), fb_width() * (fb_depth() / 8));
+        }
+
+        console_putint(cores);
+        console_puts(" core(s): ");
+        console_putlong(frames * 1000000 / us);
+        console_puts(" frames/s, ");
+        console_putlong(us / frames);
+        console_puts(" us/frame, speedup x");
+        console_putlong(base_us * 100 / us / 100);
+        console_puts(".");
+        long frac = base_us * 100 / us % 100;
+        if (frac < 10) console_puts("0");
+        console_putlong(frac);
+        console_puts(", crc ");
+        console_puthex(crc);
+        console_puts("\n");
+    }
+    console_puts(" (");
+    console_putint(comp_count());
+    console_puts(" commands per frame)\n");
+    if (shadow.flushes) {
+        console_puts(" shadow: ");
+        console_putlong(shadow.drawn);
+        console_puts(" bytes drawn, ");
+        console_putlong(shadow.flushed);
+        console_puts(" bytes flushed per frame\n");
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(compbench, cmd_compbench, "[frames] - render a dashboard on 1, 2 and 4 cores");
@@ -2,102 +2,426 @@
 #include "console.h"
 #include "uart.h"
 #include "fb.h"
+#include "shell.h"
+#include "cursor.h"
 #include "string_utils.h" // Für simple_itoa, simple_uint_to_hex_string
 
-// Konfiguration für die Textdarstellung auf dem Framebuffer
-#define FONT_WIDTH 8      // Annahme: Breite eines Zeichens in Pixeln
-#define FONT_HEIGHT 16    // Annahme: Höhe eines Zeichens in Pixeln
-#define TEXT_COLOR 0x0F   // Weiß (Annahme: 0x0F ist Weiß in deiner Farbpalette)
-#define BG_COLOR 0x00     // Schwarz (Annahme: 0x00 ist Schwarz)
-
-// Aktuelle Cursorposition auf dem Framebuffer
-static unsigned int current_x = 0;
-static unsigned int current_y = 0;
-
-// Bildschirmdimensionen (müssen von fb.h oder fb_init abgerufen werden)
-// Annahme: Deine fb_init setzt diese oder es gibt globale Variablen/Funktionen dafür.
-// Fürs Beispiel feste Werte, idealerweise aus fb.h/fb_get_resolution()
-#define SCREEN_WIDTH 1920 // Beispiel Raspberry Pi typische Auflösung
-#define SCREEN_HEIGHT 1080 // Beispiel Raspberry Pi typische Auflösung
-
-// Hilfsfunktion für den Zeilenumbruch und Scrollen
-static void console_newline() {
-    current_x = 0;
-    current_y += FONT_HEIGHT;
-
-    // Wenn der untere Bildschirmrand erreicht ist
-    if (current_y + FONT_HEIGHT > SCREEN_HEIGHT) {
-        // --- Einfaches Scrollen (Bildschirm löschen und von oben anfangen) ---
-        // Das ist die einfachste Methode, aber nicht "flüssig".
-        // drawRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BG_COLOR, 1); // Alles löschen
-        // current_y = 0;
-
-        // --- Besser: Tatsächliches Scrollen durch Verschieben des Bildinhalts ---
-        // Dies erfordert, dass du eine Funktion hast, die einen Bereich des FB kopiert.
-        // Wenn du keine hast, musst du sie in fb.c hinzufügen oder die oben einfache Methode nehmen.
-        // Beispiel: scroll_framebuffer(FONT_HEIGHT, BG_COLOR); // Verschiebt alles um FONT_HEIGHT Pixel nach oben
-        // current_y -= FONT_HEIGHT; // Bleibt auf der letzten sichtbaren Zeile, da der Inhalt gescrollt wurde.
-
-        // Hier ist eine rudimentäre Scroll-Logik, die Pixel für Pixel verschiebt.
-        // Besser wäre eine optimierte Funktion in fb.c, die größere Blöcke verschiebt.
-        // Für diesen Prototypen nehmen wir die einfache "clear and reset" Methode,
-        // da eine performante Scroll-Implementierung tiefer in fb.c gehen würde.
-        // Wenn du eine drawImage/copyRect-Funktion hast, wäre es:
-        // copy_rect(0, FONT_HEIGHT, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT - FONT_HEIGHT);
-        // drawRect(0, SCREEN_HEIGHT - FONT_HEIGHT, SCREEN_WIDTH, FONT_HEIGHT, BG_COLOR, 1); // Letzte Zeile leeren
-        // current_y = SCREEN_HEIGHT - FONT_HEIGHT; // Bleibt auf der letzten Zeile
-
-
-        // Prototypen-Lösung (löscht und setzt Cursor zurück):
-        drawRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BG_COLOR, 1); // Löscht den gesamten Bildschirm
-        current_x = 0;
-        current_y = 0;
+// Zeichenzelle: die 8x8-Glyphe oben, darunter 8 Pixel Zeilenabstand
+#define CELL_WIDTH  FB_FONT_WIDTH
+#define CELL_HEIGHT 16
+#define TEXT_COLOR  0x0F  // Weiß (VGA-Palette)
+#define BG_COLOR    0x00  // Schwarz
+#define TAB_WIDTH   8
+
+#define VT_MAX_PARAMS 8
+
+static bool console_muted = false;
+
+// ##################################
+// ## Terminalzustand
+// ##################################
+
+enum {
+    VT_NORMAL,
+    VT_ESC,      // Nach ESC
+    VT_ESC_SKIP, // ESC ( / ESC ) / ESC #: ein Byte überspringen
+    VT_CSI       // Nach ESC [
+};
+
+typedef struct {
+    int col, row;
+    int cols, rows;            // Größe in Zellen, aus der Framebuffer-Auflösung
+    int top, bottom;           // Scroll-Bereich (Zeilen, inklusive)
+    unsigned char fg, bg;      // VGA-Farben 0-15
+    bool bold, reverse;
+    bool wrap_pending;         // In die letzte Spalte geschrieben, Umbruch steht aus
+
+    int saved_col, saved_row;  // ESC 7 / ESC 8
+    unsigned char saved_fg, saved_bg;
+    bool saved_bold, saved_reverse;
+
+    int state;
+    int params[VT_MAX_PARAMS];
+    int nparams;
+    bool private_mode;         // CSI ? ...
+} Vt;
+
+static Vt vt;
+
+// ANSI-Reihenfolge (Schwarz, Rot, Grün, Gelb, Blau, Magenta, Cyan, Weiß) auf vgapal
+static const unsigned char ansi_to_vga[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+// Attribut für drawChar: Vordergrund im unteren, Hintergrund im oberen Nibble
+static unsigned char vt_attr() {
+    unsigned char fg = vt.fg, bg = vt.bg;
+    if (vt.bold && fg < 8) fg += 8;
+    if (vt.reverse) { unsigned char t = fg; fg = bg; bg = t; }
+    return fg | bg << 4;
+}
+
+static unsigned char vt_background() {
+    return vt.reverse ? (vt.bold && vt.fg < 8 ? vt.fg + 8 : vt.fg) : vt.bg;
+}
+
+static void vt_reset_attributes() {
+    vt.fg = TEXT_COLOR;
+    vt.bg = BG_COLOR;
+    vt.bold = false;
+    vt.reverse = false;
+}
+
+// ##################################
+// ## Flächenoperationen
+// ##################################
+
+// Zellen [c1, c2] der Zeilen [r1, r2] mit der aktuellen Hintergrundfarbe füllen
+static void vt_erase(int c1, int r1, int c2, int r2) {
+    if (c1 > c2 || r1 > r2) return;
+    fb_fill_rect(c1 * CELL_WIDTH, r1 * CELL_HEIGHT, (c2 + 1) * CELL_WIDTH - 1, (r2 + 1) * CELL_HEIGHT - 1,
+                 vt_background());
+}
+
+// Zeilen top..bottom um n nach oben (n > 0) oder unten (n < 0) schieben
+static void vt_scroll(int top, int bottom, int n) {
+    int lines = bottom - top + 1;
+    int count = n < 0 ? -n : n;
+    if (count >= lines) {
+        vt_erase(0, top, vt.cols - 1, bottom);
+        return;
+    }
+    int w = vt.cols * CELL_WIDTH, h = (lines - count) * CELL_HEIGHT;
+    if (n > 0) {
+        fb_move_rect(0, (top + count) * CELL_HEIGHT, w, h, 0, -count * CELL_HEIGHT);
+        vt_erase(0, bottom - count + 1, vt.cols - 1, bottom);
+    } else {
+        fb_move_rect(0, top * CELL_HEIGHT, w, h, 0, count * CELL_HEIGHT);
+        vt_erase(0, top, vt.cols - 1, top + count - 1);
     }
 }
 
+// Rest der Zeile ab der Cursorspalte um n Zellen nach rechts (n > 0) oder links schieben
+static void vt_shift_chars(int n) {
+    int count = n < 0 ? -n : n;
+    int rest = vt.cols - vt.col;
+    if (count >= rest) {
+        vt_erase(vt.col, vt.row, vt.cols - 1, vt.row);
+        return;
+    }
+    int y = vt.row * CELL_HEIGHT, w = (rest - count) * CELL_WIDTH;
+    if (n > 0) {
+        fb_move_rect(vt.col * CELL_WIDTH, y, w, CELL_HEIGHT, count * CELL_WIDTH, 0);
+        vt_erase(vt.col, vt.row, vt.col + count - 1, vt.row);
+    } else {
+        fb_move_rect((vt.col + count) * CELL_WIDTH, y, w, CELL_HEIGHT, -count * CELL_WIDTH, 0);
+        vt_erase(vt.cols - count, vt.row, vt.cols - 1, vt.row);
+    }
+}
+
+// ##################################
+// ## Cursor
+// ##################################
+
+static int clamp(int v, int lo, int hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static void vt_goto(int col, int row) {
+    vt.col = clamp(col, 0, vt.cols - 1);
+    vt.row = clamp(row, 0, vt.rows - 1);
+    vt.wrap_pending = false;
+}
+
+// Zeilenvorschub; am unteren Rand des Scroll-Bereichs wird gescrollt
+static void vt_index() {
+    if (vt.row == vt.bottom) vt_scroll(vt.top, vt.bottom, 1);
+    else if (vt.row < vt.rows - 1) vt.row++;
+    vt.wrap_pending = false;
+}
+
+static void vt_reverse_index() {
+    if (vt.row == vt.top) vt_scroll(vt.top, vt.bottom, -1);
+    else if (vt.row > 0) vt.row--;
+    vt.wrap_pending = false;
+}
+
+static void vt_save() {
+    vt.saved_col = vt.col;
+    vt.saved_row = vt.row;
+    vt.saved_fg = vt.fg;
+    vt.saved_bg = vt.bg;
+    vt.saved_bold = vt.bold;
+    vt.saved_reverse = vt.reverse;
+}
+
+static void vt_restore() {
+    vt_goto(vt.saved_col, vt.saved_row);
+    vt.fg = vt.saved_fg;
+    vt.bg = vt.saved_bg;
+    vt.bold = vt.saved_bold;
+    vt.reverse = vt.saved_reverse;
+}
+
+static void vt_full_reset() {
+    vt_reset_attributes();
+    vt.top = 0;
+    vt.bottom = vt.rows - 1;
+    vt_erase(0, 0, vt.cols - 1, vt.rows - 1);
+    vt_goto(0, 0);
+    vt_save();
+}
+
+// Größe an den Framebuffer anpassen (nach fb_init oder beim ersten Zeichen)
+static bool vt_geometry() {
+    if (fb_buffer() == NULL) return false;
+    int cols = fb_width() / CELL_WIDTH, rows = fb_height() / CELL_HEIGHT;
+    if (cols == vt.cols && rows == vt.rows) return true;
+    if (vt.cols == 0) {
+        vt_reset_attributes();
+        vt_save();
+    }
+    vt.cols = cols;
+    vt.rows = rows;
+    vt.top = 0;
+    vt.bottom = rows - 1;
+    vt_goto(vt.col, vt.row);
+    return true;
+}
+
+// ##################################
+// ## Escape-Sequenzen
+// ##################################
+
+// Parameter i, 0 oder fehlend ergibt def
+static int vt_param(int i, int def) {
+    return i < vt.nparams && vt.params[i] > 0 ? vt.params[i] : def;
+}
+
+static void vt_sgr() {
+    if (vt.nparams == 0) {
+        vt.nparams = 1;
+        vt.params[0] = 0;
+    }
+    for (int i = 0; i < vt.nparams; i++) {
+        int p = vt.params[i];
+        if (p == 0) vt_reset_attributes();
+        else if (p == 1) vt.bold = true;
+        else if (p == 22) vt.bold = false;
+        else if (p == 7) vt.reverse = true;
+        else if (p == 27) vt.reverse = false;
+        else if (p >= 30 && p <= 37) vt.fg = ansi_to_vga[p - 30];
+        else if (p == 39) vt.fg = TEXT_COLOR;
+        else if (p >= 40 && p <= 47) vt.bg = ansi_to_vga[p - 40];
+        else if (p == 49) vt.bg = BG_COLOR;
+        else if (p >= 90 && p <= 97) vt.fg = ansi_to_vga[p - 90] + 8;
+        else if (p >= 100 && p <= 107) vt.bg = ansi_to_vga[p - 100] + 8;
+    }
+}
+
+// Antwort an den Host (Cursorposition für Gerätestatus-Abfragen)
+static void vt_report_cursor() {
+    char buffer[12];
+    uart_writeText("\x1b[");
+    uart_writeText(simple_itoa(vt.row + 1, buffer));
+    uart_writeText(";");
+    uart_writeText(simple_itoa(vt.col + 1, buffer));
+    uart_writeText("R");
+}
+
+static void vt_csi(char final) {
+    int n = vt_param(0, 1);
+    bool in_region = vt.row >= vt.top && vt.row <= vt.bottom;
+
+    if (vt.private_mode) return; // z.B. ?25h/l (Cursor ein/aus), hier ohne Wirkung
+
+    switch (final) {
+    case 'A': vt_goto(vt.col, in_region ? clamp(vt.row - n, vt.top, vt.bottom) : vt.row - n); break;
+    case 'B': vt_goto(vt.col, in_region ? clamp(vt.row + n, vt.top, vt.bottom) : vt.row + n); break;
+    case 'C': vt_goto(vt.col + n, vt.row); break;
+    case 'D': vt_goto(vt.col - n, vt.row); break;
+    case 'E': vt_goto(0, vt.row + n); break;
+    case 'F': vt_goto(0, vt.row - n); break;
+    case 'G': case '`': vt_goto(n - 1, vt.row); break;
+    case 'd': vt_goto(vt.col, n - 1); break;
+    case 'H': case 'f': vt_goto(vt_param(1, 1) - 1, n - 1); break;
+    case 'J':
+        switch (vt_param(0, 0)) {
+        case 0:
+            vt_erase(vt.col, vt.row, vt.cols - 1, vt.row);
+            vt_erase(0, vt.row + 1, vt.cols - 1, vt.rows - 1);
+            break;
+        case 1:
+            vt_erase(0, 0, vt.cols - 1, vt.row - 1);
+            vt_erase(0, vt.row, vt.col, vt.row);
+            break;
+        default:
+            vt_erase(0, 0, vt.cols - 1, vt.rows - 1);
+        }
+        break;
+    case 'K':
+        switch (vt_param(0, 0)) {
+        case 0: vt_erase(vt.col, vt.row, vt.cols - 1, vt.row); break;
+        case 1: vt_erase(0, vt.row, vt.col, vt.row); break;
+        default: vt_erase(0, vt.row, vt.cols - 1, vt.row);
+        }
+        break;
+    case 'L': if (in_region) vt_scroll(vt.row, vt.bottom, -n); break;
+    case 'M': if (in_region) vt_scroll(vt.row, vt.bottom, n); break;
+    case '@': vt_shift_chars(n); break;
+    case 'P': vt_shift_chars(-n); break;
+    case 'X': vt_erase(vt.col, vt.row, clamp(vt.col + n - 1, 0, vt.cols - 1), vt.row); break;
+    case 'S': vt_scroll(vt.top, vt.bottom, n); break;
+    case 'T': vt_scroll(vt.top, vt.bottom, -n); break;
+    case 'm': vt_sgr(); break;
+    case 'r': {
+        int top = vt_param(0, 1) - 1, bottom = vt_param(1, vt.rows) - 1;
+        if (top < bottom && bottom < vt.rows) {
+            vt.top = top;
+            vt.bottom = bottom;
+            vt_goto(0, 0);
+        }
+        break;
+    }
+    case 's': vt_save(); break;
+    case 'u': vt_restore(); break;
+    case 'n': if (vt_param(0, 0) == 6) vt_report_cursor(); break;
+    }
+}
+
+static void vt_putglyph(char c) {
+    if (vt.wrap_pending) {
+        vt.col = 0;
+        vt_index();
+    }
+    int x = vt.col * CELL_WIDTH, y = vt.row * CELL_HEIGHT;
+    drawChar(c, x, y, vt_attr());
+    fb_fill_rect(x, y + FB_FONT_HEIGHT, x + CELL_WIDTH - 1, y + CELL_HEIGHT - 1, vt_background());
+    if (vt.col == vt.cols - 1) vt.wrap_pending = true;
+    else vt.col++;
+}
+
+/**
+ * Zustandsautomat für VT100/ANSI. '\n' wirkt wie CR+LF (wie bisher in der
+ * Shell). Löschen, Scrollen und Einfügen/Entfernen arbeiten direkt auf
+ * Rechtecken des Framebuffers (fb_fill_rect, fb_move_rect), es wird nie
+ * Text neu gezeichnet.
+ */
+static void vt_feed(unsigned char c) {
+    // CAN und SUB brechen jede Sequenz ab, ESC beginnt eine neue
+    if (c == 0x18 || c == 0x1A) { vt.state = VT_NORMAL; return; }
+    if (c == 0x1B) { vt.state = VT_ESC; return; }
+
+    switch (vt.state) {
+    case VT_ESC:
+        vt.state = VT_NORMAL;
+        switch (c) {
+        case '[':
+            vt.state = VT_CSI;
+            vt.nparams = 0;
+            vt.private_mode = false;
+            for (int i = 0; i < VT_MAX_PARAMS; i++) vt.params[i] = 0;
+            break;
+        case '(': case ')': case '#': vt.state = VT_ESC_SKIP; break;
+        case '7': vt_save(); break;
+        case '8': vt_restore(); break;
+        case 'c': vt_full_reset(); break;
+        case 'D': vt_index(); break;
+        case 'E': vt.col = 0; vt_index(); break;
+        case 'M': vt_reverse_index(); break;
+        }
+        return;
+
+    case VT_ESC_SKIP:
+        vt.state = VT_NORMAL;
+        return;
+
+    case VT_CSI:
+        if (c >= '0' && c <= '9') {
+            if (vt.nparams == 0) vt.nparams = 1;
+            int *p = &vt.params[vt.nparams - 1];
+            if (*p < 10000) *p = *p * 10 + (c - '0');
+        } else if (c == ';') {
+            if (vt.nparams == 0) vt.nparams = 1;
+            if (vt.nparams < VT_MAX_PARAMS) vt.nparams++;
+        } else if (c == '?') {
+            vt.private_mode = true;
+        } else if (c >= 0x40 && c <= 0x7E) {
+            vt.state = VT_NORMAL;
+            vt_csi(c);
+        }
+        // Zwischenbytes (0x20-0x2F) werden ignoriert
+        return;
+    }
+
+    switch (c) {
+    case '\n': vt.col = 0; vt_index(); break;
+    case '\r': vt.col = 0; vt.wrap_pending = false; break;
+    case '\b': if (vt.col > 0) vt.col--; vt.wrap_pending = false; break;
+    case '\t': vt_goto((vt.col / TAB_WIDTH + 1) * TAB_WIDTH, vt.row); break;
+    case 0x0B: case 0x0C: vt_index(); break;
+    default:
+        if (c >= ' ' && c != 0x7F) vt_putglyph(c);
+    }
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
 
 void console_init() {
     uart_init(); // UART initialisieren
     fb_init();   // Framebuffer initialisieren
+    if (vt_geometry()) vt_full_reset();
+    fb_flush();
+}
 
-    // Bildschirm löschen und Cursorposition initialisieren
-    drawRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BG_COLOR, 1); // Hintergrundfarbe setzen
-    current_x = 0;
-    current_y = 0;
+void console_set_mute(bool mute) {
+    console_muted = mute;
 }
 
-void console_putc(char c) {
+void console_render(const char* s, unsigned long n) {
+    if (console_muted || !vt_geometry()) return;
+    cursor_erase();
+    while (n--) vt_feed(*s++);
+}
+
+// Zeichen ausgeben, ohne den Schattenpuffer zu flushen
+static void console_emit(char c) {
     uart_writeByteBlocking(c); // Immer auf UART schreiben
+    if (c == '\n') uart_writeByteBlocking('\r');
+    if (vt_geometry()) {
+        cursor_erase(); // Nur der Software-Cursor, sonst ohne Wirkung
+        vt_feed(c);
+    }
+}
 
-    // Spezialbehandlung für Steuerzeichen für den Framebuffer
-    if (c == '\n') {
-        uart_writeByteBlocking('\r');
-        console_newline(); // Zeilenumbruch und Scrollen
-    } else if (c == '\r') {
-        current_x = 0; // Cursor an den Anfang der aktuellen Zeile
-    } else if (c == '\b') {
-        // Backspace: Cursor zurück und Zeichen löschen
-        if (current_x >= FONT_WIDTH) {
-            current_x -= FONT_WIDTH;
-            drawRect(current_x, current_y, FONT_WIDTH, FONT_HEIGHT, BG_COLOR, 1); // Zeichen löschen
-        }
-    } else {
-        // Normales druckbares Zeichen
-        drawChar(c, current_x, current_y, TEXT_COLOR);
-        current_x += FONT_WIDTH;
+// Cursor an die Schreibposition setzen (sofern die Konsole ihn führt) und
+// alles ausgeben. Der Hardware-Cursor kostet dabei nur einen Mailbox-Aufruf,
+// wenn sich die Position geändert hat.
+static void console_flush() {
+    if (cursor_owner() == CURSOR_CONSOLE) cursor_move(vt.col * CELL_WIDTH, vt.row * CELL_HEIGHT);
+    else cursor_redraw();
+    fb_flush();
+}
 
-        // Zeilenumbruch, falls der rechte Rand erreicht ist
-        if (current_x + FONT_WIDTH > SCREEN_WIDTH) {
-            console_newline();
-        }
-    }
+void console_putc(char c) {
+    if (console_muted) return;
+    console_emit(c);
+    console_flush();
 }
 
 void console_puts(const char* s) {
+    if (console_muted) return;
     while (*s != '\0') {
-        console_putc(*s);
+        console_emit(*s);
         s++;
     }
+    console_flush();
+}
+
+void console_write(const char* s, unsigned long n) {
+    if (console_muted) return;
+    while (n--) console_emit(*s++);
+    console_flush();
 }
 
 void console_putint(int i) {
@@ -105,8 +429,43 @@ void console_putint(int i) {
     console_puts(simple_itoa(i, buffer));
 }
 
+void console_putlong(long l) {
+    char buffer[21]; // Genug Platz für -9,223,372,036,854,775,808 und Null-Terminator
+    console_puts(simple_ltoa(l, buffer));
+}
+
 void console_puthex(unsigned int val) {
     char buffer[10]; // Genug Platz für 0xFFFFFFFF und Null-Terminator
     console_puts("0x");
     console_puts(simple_uint_to_hex_string(val, buffer)); // Annahme: simple_uint_to_hex_string existiert
 }
+
+// ##################################
+// ## Shell
+// ##################################
+
+#define VT_EXIT_KEY 0x1D // Ctrl-]
+
+// "vt": alle Bytes von der seriellen Schnittstelle gehen direkt an die
+// Bildschirmkonsole, z.B. für Dashboards, die vom Host per Escape-Sequenz
+// aktualisiert werden. Es wird erst geflusht, wenn keine Daten mehr anstehen.
+static int cmd_vt(int argc, char** argv) {
+    console_puts("Passthrough to the screen, Ctrl-] to exit\n");
+    bool pending = false;
+    for (;;) {
+        unsigned char byte;
+        if (!uart_read_byte(&byte)) {
+            if (pending) console_flush();
+            pending = false;
+            continue;
+        }
+        if (byte == VT_EXIT_KEY) break;
+        char c = byte;
+        console_render(&c, 1);
+        pending = true;
+    }
+    fb_flush();
+    console_puts("\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(vt, cmd_vt, "- pass serial input through to the screen (ANSI/VT100), Ctrl-] exits");
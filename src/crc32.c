@@ -0,0 +1,28 @@
+// src/crc32.c
+#include "crc32.h"
+
+static unsigned int crc32_table[256];
+static int crc32_table_ready = 0;
+
+// Die Tabelle wird beim ersten Aufruf berechnet (spart 1 KB im Image)
+static void crc32_init_table() {
+    for (unsigned int i = 0; i < 256; i++) {
+        unsigned int c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc32_table[i] = c;
+    }
+    crc32_table_ready = 1;
+}
+
+unsigned int crc32_update(unsigned int crc, const void* data, unsigned long len) {
+    const unsigned char* p = data;
+    if (!crc32_table_ready) crc32_init_table();
+
+    crc = ~crc;
+    while (len--) {
+        crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
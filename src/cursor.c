@@ -0,0 +1,419 @@
+// src/cursor.c
+#include "cursor.h"
+#include "mb.h"
+#include "mmu.h"
+#include "fb.h"
+#include "blit.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+#define CURSOR_SIZE 16 // Beide Sprites sind 16x16 Pixel (0xAARRGGBB)
+
+// Der VideoCore liest die Sprite-Pixel über den ungecachten Bus-Alias
+#define BUS_ALIAS 0xC0000000
+
+// Im Längenwort eines Tags gesetzt, wenn die Firmware ihn bearbeitet hat
+#define TAG_RESPONSE 0x80000000
+
+// Koordinaten in "set cursor state" beziehen sich auf den Framebuffer,
+// nicht auf die (eventuell skalierte) Anzeige
+#define STATE_FB_COORDS 1
+
+enum {
+    MODE_NONE,     // Vor cursor_init oder ohne Framebuffer
+    MODE_HARDWARE,
+    MODE_SOFTWARE
+};
+
+typedef struct {
+    int mode;
+    int owner;
+    bool visible;
+    int x, y;                  // Hotspot
+    const Image* shape;
+    int hot_x, hot_y;
+
+    // Hardware: was die Firmware zuletzt bekommen hat
+    bool hw_visible;
+    int hw_x, hw_y;
+
+    // Software: gesicherte Pixel unter dem Sprite
+    bool drawn;
+    FbRect saved_rect;
+    unsigned int saved_depth, saved_pitch;
+    unsigned char saved[CURSOR_SIZE * CURSOR_SIZE * 4];
+} Cursor;
+
+static Cursor cursor;
+static CursorStats stats;
+
+static Image* shape_underline;
+static Image* shape_arrow;
+
+// ##################################
+// ## Sprites
+// ##################################
+
+// 'X' schwarz, '.' weiß, ' ' durchsichtig
+static const char* const arrow_rows[CURSOR_SIZE] = {
+    "X               ",
+    "XX              ",
+    "X.X             ",
+    "X..X            ",
+    "X...X           ",
+    "X....X          ",
+    "X.....X         ",
+    "X......X        ",
+    "X.......X       ",
+    "X........X      ",
+    "X.....XXXXX     ",
+    "X..X..X         ",
+    "X.X X..X        ",
+    "XX  X..X        ",
+    "X    X..X       ",
+    "     XXXX       ",
+};
+
+static void build_shapes() {
+    shape_arrow = blit_create(CURSOR_SIZE, CURSOR_SIZE, BLIT_ALPHA);
+    shape_underline = blit_create(CURSOR_SIZE, CURSOR_SIZE, BLIT_ALPHA);
+    if (shape_arrow == NULL || shape_underline == NULL) return;
+
+    for (int y = 0; y < CURSOR_SIZE; y++) {
+        for (int x = 0; x < CURSOR_SIZE; x++) {
+            char c = arrow_rows[y][x];
+            shape_arrow->pixels[y * CURSOR_SIZE + x] = c == 'X' ? 0xFF000000 : c == '.' ? 0xFFFFFFFF : 0;
+        }
+    }
+    // Zwei Zeilen unter der Glyphe einer Zeichenzelle (8x16, siehe console.c)
+    for (int y = FB_FONT_HEIGHT + 1; y <= FB_FONT_HEIGHT + 2; y++) {
+        for (int x = 0; x < FB_FONT_WIDTH; x++) shape_underline->pixels[y * CURSOR_SIZE + x] = 0xFFFFFFFF;
+    }
+}
+
+// ##################################
+// ## Hardware
+// ##################################
+
+static bool hw_set_shape(const Image* img, int hot_x, int hot_y) {
+    // Die Firmware liest die Pixel aus dem Speicher, nicht aus unserem Cache
+    cache_clean(img->pixels, img->width * img->height * 4);
+
+    mbox[0] = 12 * 4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = MBOX_TAG_SETCURSORINFO;
+    mbox[3] = 24;
+    mbox[4] = 0;
+    mbox[5] = img->width;
+    mbox[6] = img->height;
+    mbox[7] = 0; // Unbenutzt
+    mbox[8] = (unsigned int)(unsigned long)img->pixels | BUS_ALIAS;
+    mbox[9] = hot_x;
+    mbox[10] = hot_y;
+    mbox[11] = MBOX_TAG_LAST;
+
+    stats.firmware_calls++;
+    return mbox_call(MBOX_CH_PROP) && (mbox[4] & TAG_RESPONSE) && mbox[5] == 0;
+}
+
+static bool hw_set_state(bool visible, int x, int y) {
+    mbox[0] = 10 * 4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = MBOX_TAG_SETCURSORSTATE;
+    mbox[3] = 16;
+    mbox[4] = 0;
+    mbox[5] = visible;
+    mbox[6] = x;
+    mbox[7] = y;
+    mbox[8] = STATE_FB_COORDS;
+    mbox[9] = MBOX_TAG_LAST;
+
+    stats.firmware_calls++;
+    if (!mbox_call(MBOX_CH_PROP) || !(mbox[4] & TAG_RESPONSE) || mbox[5] != 0) return false;
+    cursor.hw_visible = visible;
+    cursor.hw_x = x;
+    cursor.hw_y = y;
+    return true;
+}
+
+// ##################################
+// ## Software
+// ##################################
+
+// Sprite-Rechteck, auf das Clip-Rechteck begrenzt (wie in blit_rect)
+static bool sw_rect(FbRect* r) {
+    const FbRect* c = fb_get_clip();
+    r->x1 = cursor.x - cursor.hot_x;
+    r->y1 = cursor.y - cursor.hot_y;
+    r->x2 = r->x1 + (int)cursor.shape->width - 1;
+    r->y2 = r->y1 + (int)cursor.shape->height - 1;
+    if (r->x1 < c->x1) r->x1 = c->x1;
+    if (r->y1 < c->y1) r->y1 = c->y1;
+    if (r->x2 > c->x2) r->x2 = c->x2;
+    if (r->y2 > c->y2) r->y2 = c->y2;
+    return r->x1 <= r->x2 && r->y1 <= r->y2;
+}
+
+static void sw_erase() {
+    if (!cursor.drawn) return;
+    cursor.drawn = false;
+    fb_set_draw_hook(NULL);
+
+    // Nach einem Wechsel der Farbtiefe passen die gesicherten Bytes nicht mehr
+    unsigned char* fb = fb_buffer();
+    if (fb == NULL || fb_depth() != cursor.saved_depth || fb_pitch() != cursor.saved_pitch) return;
+
+    const FbRect* r = &cursor.saved_rect;
+    unsigned int bpp = cursor.saved_depth / 8;
+    unsigned long row = (unsigned long)(r->x2 - r->x1 + 1) * bpp;
+    const unsigned char* src = cursor.saved;
+    for (int y = r->y1; y <= r->y2; y++, src += row) {
+        memcpy(fb + (long)y * cursor.saved_pitch + (long)r->x1 * bpp, src, row);
+    }
+    fb_mark_dirty(r->x1, r->y1, r->x2, r->y2);
+}
+
+/**
+ * Hook aus fb.c: wer über das Sprite zeichnet, entfernt es vorher. Sonst
+ * würde cursor_erase später die gesicherten, inzwischen veralteten Pixel
+ * über die neue Zeichnung schreiben. Der Cursor erscheint mit dem nächsten
+ * cursor_move bzw. cursor_redraw wieder.
+ */
+static void sw_before_draw(int x1, int y1, int x2, int y2) {
+    const FbRect* r = &cursor.saved_rect;
+    if (x2 < r->x1 || x1 > r->x2 || y2 < r->y1 || y1 > r->y2) return;
+    sw_erase();
+    stats.overdrawn++;
+}
+
+static void sw_draw() {
+    unsigned char* fb = fb_buffer();
+    FbRect r;
+    if (cursor.drawn || fb == NULL || !sw_rect(&r)) return;
+
+    unsigned int bpp = fb_depth() / 8;
+    unsigned int pitch = fb_pitch();
+    unsigned long row = (unsigned long)(r.x2 - r.x1 + 1) * bpp;
+    unsigned char* dst = cursor.saved;
+    for (int y = r.y1; y <= r.y2; y++, dst += row) {
+        memcpy(dst, fb + (long)y * pitch + (long)r.x1 * bpp, row);
+    }
+    cursor.saved_rect = r;
+    cursor.saved_depth = fb_depth();
+    cursor.saved_pitch = pitch;
+
+    blit_mode(cursor.shape, cursor.x - cursor.hot_x, cursor.y - cursor.hot_y, BLIT_ALPHA);
+    cursor.drawn = true;
+    fb_set_draw_hook(sw_before_draw);
+    stats.redraws++;
+}
+
+// ##################################
+// ## Modus und Form
+// ##################################
+
+static void hide_current() {
+    if (cursor.mode == MODE_HARDWARE && cursor.hw_visible) hw_set_state(false, cursor.x, cursor.y);
+    if (cursor.mode == MODE_SOFTWARE) sw_erase();
+}
+
+// Zeigt den Cursor im aktuellen Modus an der aktuellen Stelle an (sofern
+// sichtbar); lehnt die Firmware ab, geht es in Software weiter
+static void apply() {
+    if (cursor.mode == MODE_HARDWARE) {
+        bool same = cursor.hw_visible == cursor.visible &&
+                    (!cursor.visible || (cursor.hw_x == cursor.x && cursor.hw_y == cursor.y));
+        if (same || hw_set_state(cursor.visible, cursor.x, cursor.y)) return;
+        cursor.mode = MODE_SOFTWARE;
+    }
+    if (cursor.mode == MODE_SOFTWARE && cursor.visible) sw_draw();
+}
+
+static void set_mode(int mode) {
+    hide_current();
+    cursor.mode = mode;
+    cursor.hw_visible = false;
+    if (mode == MODE_HARDWARE && !hw_set_shape(cursor.shape, cursor.hot_x, cursor.hot_y)) {
+        cursor.mode = MODE_SOFTWARE;
+    }
+    apply();
+}
+
+static void set_shape(const Image* img, int hot_x, int hot_y) {
+    if (cursor.mode == MODE_SOFTWARE) sw_erase();
+    cursor.shape = img;
+    cursor.hot_x = hot_x;
+    cursor.hot_y = hot_y;
+    if (cursor.mode == MODE_HARDWARE && !hw_set_shape(img, hot_x, hot_y)) {
+        if (cursor.hw_visible) hw_set_state(false, cursor.x, cursor.y);
+        cursor.mode = MODE_SOFTWARE;
+    }
+    apply();
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void cursor_init() {
+    if (fb_buffer() == NULL) return;
+    build_shapes();
+    if (shape_underline == NULL || shape_arrow == NULL) return;
+
+    cursor.owner = CURSOR_CONSOLE;
+    cursor.shape = shape_underline;
+    cursor.visible = true;
+    set_mode(MODE_HARDWARE);
+}
+
+void cursor_move(int x, int y) {
+    if (cursor.mode == MODE_NONE) return;
+    stats.moves++;
+    if (x == cursor.x && y == cursor.y && (cursor.mode == MODE_HARDWARE || cursor.drawn)) return;
+
+    if (cursor.mode == MODE_SOFTWARE) sw_erase();
+    cursor.x = x;
+    cursor.y = y;
+    apply();
+}
+
+void cursor_show(bool visible) {
+    if (cursor.mode == MODE_NONE) return;
+    cursor.visible = visible;
+    if (cursor.mode == MODE_SOFTWARE && !visible) sw_erase();
+    apply();
+}
+
+void cursor_set_owner(int owner) {
+    if (cursor.mode == MODE_NONE || owner == cursor.owner) return;
+    cursor.owner = owner;
+    if (owner == CURSOR_POINTER) set_shape(shape_arrow, 0, 0);
+    else set_shape(shape_underline, 0, 0);
+}
+
+int cursor_owner() {
+    return cursor.owner;
+}
+
+void cursor_erase() {
+    if (cursor.mode == MODE_SOFTWARE) sw_erase();
+}
+
+void cursor_redraw() {
+    if (cursor.mode == MODE_SOFTWARE && cursor.visible) sw_draw();
+}
+
+bool cursor_is_hardware() {
+    return cursor.mode == MODE_HARDWARE;
+}
+
+const CursorStats* cursor_stats() {
+    return &stats;
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+static void print_status() {
+    console_puts(cursor.mode == MODE_HARDWARE ? "hardware" : "software");
+    console_puts(cursor.visible ? ", visible" : ", hidden");
+    console_puts(cursor.owner == CURSOR_CONSOLE ? ", console" : ", pointer");
+    console_puts(" at ");
+    console_putint(cursor.x);
+    console_puts(",");
+    console_putint(cursor.y);
+    console_puts("\nmoves: ");
+    console_putlong(stats.moves);
+    console_puts(", firmware calls: ");
+    console_putlong(stats.firmware_calls);
+    console_puts(", redraws: ");
+    console_putlong(stats.redraws);
+    console_puts(", overdrawn: ");
+    console_putlong(stats.overdrawn);
+    console_puts("\n");
+}
+
+/*
+ * Bewegt den Cursor n-mal um eine Zeichenzelle weiter (wie beim Tippen)
+ * und gibt jedes Mal aus. Gemessen werden Zeit und geflushte Bytes pro
+ * Schritt; ohne Schattenpuffer zählt fb_stats nichts, dann steht dort 0.
+ */
+static void bench_mode(const char* label, long n) {
+    const FbStats* fs = fb_stats();
+    unsigned long flushed = fs->total_flushed;
+    unsigned long calls = stats.firmware_calls;
+    int x0 = cursor.x, y0 = cursor.y;
+
+    unsigned long start = timer_ticks();
+    for (long i = 0; i < n; i++) {
+        cursor_move((i % 64) * FB_FONT_WIDTH, y0);
+        fb_flush();
+    }
+    unsigned long us = timer_ticks_to_us(timer_ticks() - start);
+    cursor_move(x0, y0);
+    fb_flush();
+
+    console_puts(label);
+    console_putlong(us * 1000 / n);
+    console_puts(" ns/move, ");
+    console_putlong((fs->total_flushed - flushed) / n);
+    console_puts(" bytes flushed/move, ");
+    console_putlong(stats.firmware_calls - calls);
+    console_puts(" firmware calls\n");
+}
+
+/**
+ * "cursor [on|off|hw|sw|console|pointer x y|bench [n]]": ohne Argument
+ * Zustand und Statistik. "pointer x y" übernimmt den Cursor wie ein
+ * Zeigegerät (Pfeil an x,y), "console" gibt ihn an die Konsole zurück.
+ */
+static int cmd_cursor(int argc, char** argv) {
+    if (cursor.mode == MODE_NONE) {
+        console_puts("Error: no framebuffer\n");
+        return SHELL_ERROR;
+    }
+    if (argc < 2) {
+        print_status();
+        return SHELL_OK;
+    }
+
+    const char* cmd = argv[1];
+    if (strcmp_simple(cmd, "on") == 0 || strcmp_simple(cmd, "off") == 0) {
+        cursor_show(strcmp_simple(cmd, "on") == 0);
+    } else if (strcmp_simple(cmd, "hw") == 0) {
+        set_mode(MODE_HARDWARE);
+        if (cursor.mode != MODE_HARDWARE) console_puts("Firmware has no hardware cursor, using software\n");
+    } else if (strcmp_simple(cmd, "sw") == 0) {
+        set_mode(MODE_SOFTWARE);
+    } else if (strcmp_simple(cmd, "console") == 0) {
+        cursor_set_owner(CURSOR_CONSOLE);
+    } else if (strcmp_simple(cmd, "pointer") == 0 && argc == 4) {
+        cursor_set_owner(CURSOR_POINTER);
+        cursor_move(simple_atoi(argv[2]), simple_atoi(argv[3]));
+    } else if (strcmp_simple(cmd, "bench") == 0) {
+        long n = argc > 2 ? simple_atol(argv[2]) : 1000;
+        if (n <= 0) {
+            console_puts("Error: Invalid move count\n");
+            return SHELL_ERROR;
+        }
+        bool visible = cursor.visible;
+        int mode = cursor.mode;
+        cursor_show(true);
+        if (mode == MODE_HARDWARE) bench_mode("hardware: ", n);
+        set_mode(MODE_SOFTWARE);
+        bench_mode("software: ", n);
+        set_mode(mode);
+        cursor_show(visible);
+    } else {
+        console_puts("Error: unknown option ");
+        console_puts(cmd);
+        console_puts("\n");
+        return SHELL_ERROR;
+    }
+    fb_flush();
+    return SHELL_OK;
+}
+SHELL_COMMAND(cursor, cmd_cursor, "[on|off|hw|sw|console|pointer x y|bench [n]] - hardware cursor with software fallback");
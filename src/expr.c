@@ -0,0 +1,445 @@
+// src/expr.c
+#include "expr.h"
+#include "vars.h"
+
+// ##################################
+// ## Bytecode
+// ##################################
+// Jeder Befehl ist 4 Bytes groß: op, dst, a, b.
+// LOADK: dst = consts[a]      LOADV: dst = vars_values[a | b << 8]
+// Unäre Befehle: dst = op a   Binäre Befehle: dst = a op b
+// RET:   Ergebnis steht in Register a
+
+enum {
+    OP_LOADK, OP_LOADV, OP_RET,
+    OP_NEG, OP_NOT, OP_LNOT,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_AND, OP_OR, OP_XOR, OP_SHL, OP_SHR,
+    OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE
+};
+
+// ##################################
+// ## Tokenizer
+// ##################################
+
+enum {
+    TOK_END, TOK_NUM, TOK_IDENT, TOK_LPAREN, TOK_RPAREN, TOK_OP, TOK_ERROR
+};
+
+typedef struct {
+    const char* pos;     // Lesezeiger im Quelltext
+    int tok;             // Aktuelles Token
+    int tok_op;          // Bei TOK_OP: OP_...-Code des binären Operators bzw. Zeichen
+    char tok_char;       // Erstes Zeichen des Operators (für unäre Operatoren)
+    long tok_num;        // Bei TOK_NUM
+    char tok_name[64];   // Bei TOK_IDENT
+
+    ExprProgram* prog;
+    int next_reg;
+    int depth;           // Rekursionstiefe von parse_expr
+    int error;           // Erster aufgetretener Fehler
+} Parser;
+
+static bool is_ident_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static void next_token(Parser* p) {
+    const char* s = p->pos;
+    while (*s == ' ' || *s == '\t') s++;
+
+    char c = *s;
+    if (c == '\0') {
+        p->tok = TOK_END;
+    } else if (c >= '0' && c <= '9') {
+        // Unsigned: zu lange Zahlen laufen modulo 2^64 über (wie simple_atol)
+        unsigned long value = 0;
+        if (c == '0' && (s[1] == 'x' || s[1] == 'X')) {
+            s += 2;
+            while (1) {
+                char h = *s;
+                if (h >= '0' && h <= '9') value = value * 16 + (h - '0');
+                else if (h >= 'a' && h <= 'f') value = value * 16 + (h - 'a' + 10);
+                else if (h >= 'A' && h <= 'F') value = value * 16 + (h - 'A' + 10);
+                else break;
+                s++;
+            }
+        } else {
+            while (*s >= '0' && *s <= '9') value = value * 10 + (*s++ - '0');
+        }
+        p->tok = is_ident_char(*s) ? TOK_ERROR : TOK_NUM;
+        p->tok_num = (long)value;
+    } else if (is_ident_char(c)) {
+        unsigned int len = 0;
+        while (is_ident_char(*s)) {
+            if (len < sizeof(p->tok_name) - 1) p->tok_name[len++] = *s;
+            s++;
+        }
+        p->tok_name[len] = '\0';
+        p->tok = TOK_IDENT;
+    } else if (c == '(') {
+        p->tok = TOK_LPAREN;
+        s++;
+    } else if (c == ')') {
+        p->tok = TOK_RPAREN;
+        s++;
+    } else {
+        char n = s[1];
+        p->tok = TOK_OP;
+        p->tok_char = c;
+        s++;
+        switch (c) {
+            case '+': p->tok_op = OP_ADD; break;
+            case '-': p->tok_op = OP_SUB; break;
+            case '*': p->tok_op = OP_MUL; break;
+            case '/': p->tok_op = OP_DIV; break;
+            case '%': p->tok_op = OP_MOD; break;
+            case '&': p->tok_op = OP_AND; break;
+            case '|': p->tok_op = OP_OR;  break;
+            case '^': p->tok_op = OP_XOR; break;
+            case '~': p->tok_op = -1;     break; // nur unär
+            case '<':
+                if (n == '<')      { p->tok_op = OP_SHL; s++; }
+                else if (n == '=') { p->tok_op = OP_LE;  s++; }
+                else                 p->tok_op = OP_LT;
+                break;
+            case '>':
+                if (n == '>')      { p->tok_op = OP_SHR; s++; }
+                else if (n == '=') { p->tok_op = OP_GE;  s++; }
+                else                 p->tok_op = OP_GT;
+                break;
+            case '=':
+                if (n == '=')      { p->tok_op = OP_EQ;  s++; }
+                else                 p->tok = TOK_ERROR;
+                break;
+            case '!':
+                if (n == '=')      { p->tok_op = OP_NE;  s++; }
+                else                 p->tok_op = -1;    // nur unär (!x)
+                break;
+            default:
+                p->tok = TOK_ERROR;
+        }
+    }
+    p->pos = s;
+}
+
+// ##################################
+// ## Pratt-Parser mit Codeerzeugung
+// ##################################
+// Jeder Teilausdruck wird entweder als Konstante zurückgegeben (dann wird
+// noch kein Code erzeugt und Konstanten können gefaltet werden) oder liegt
+// in einem Register. Register werden wie ein Stack vergeben.
+
+typedef struct {
+    bool is_const;
+    long value;
+    int reg;
+} Operand;
+
+// Bindungsstärke der binären Operatoren (0 = kein binärer Operator)
+static int binding_power(int op) {
+    switch (op) {
+        case OP_OR:  return 1;
+        case OP_XOR: return 2;
+        case OP_AND: return 3;
+        case OP_EQ: case OP_NE: return 4;
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: return 5;
+        case OP_SHL: case OP_SHR: return 6;
+        case OP_ADD: case OP_SUB: return 7;
+        case OP_MUL: case OP_DIV: case OP_MOD: return 8;
+        default: return 0;
+    }
+}
+#define UNARY_BINDING_POWER 9
+
+// Der erste Fehler ist der aussagekräftigste: Folgefehler (z.B. die
+// fehlende Klammer nach einem zu tief geschachtelten Ausdruck) überschreiben ihn nicht
+static void set_error(Parser* p, int err) {
+    if (p->error == EXPR_OK) p->error = err;
+}
+
+static void emit(Parser* p, int op, int dst, int a, int b) {
+    ExprProgram* prog = p->prog;
+    if (prog->code_len >= EXPR_MAX_CODE) {
+        set_error(p, EXPR_ERR_TOO_COMPLEX);
+        return;
+    }
+    ExprInsn* insn = &prog->code[prog->code_len++];
+    insn->op = op;
+    insn->dst = dst;
+    insn->a = a;
+    insn->b = b;
+}
+
+static int alloc_reg(Parser* p) {
+    if (p->next_reg >= EXPR_MAX_REGS) {
+        set_error(p, EXPR_ERR_TOO_COMPLEX);
+        return 0;
+    }
+    return p->next_reg++;
+}
+
+// Sorgt dafür, dass der Operand in einem Register liegt
+static int materialize(Parser* p, Operand* o) {
+    if (!o->is_const) return o->reg;
+
+    ExprProgram* prog = p->prog;
+    int k;
+    for (k = 0; k < prog->const_count; k++) {
+        if (prog->consts[k] == o->value) break;
+    }
+    if (k == prog->const_count) {
+        if (k >= EXPR_MAX_CONSTS) {
+            set_error(p, EXPR_ERR_TOO_COMPLEX);
+            return 0;
+        }
+        prog->consts[prog->const_count++] = o->value;
+    }
+    o->reg = alloc_reg(p);
+    o->is_const = false;
+    emit(p, OP_LOADK, o->reg, k, 0);
+    return o->reg;
+}
+
+// Gemeinsame Semantik von VM und Konstantenfaltung
+static int apply_binary(int op, long a, long b, long* out) {
+    switch (op) {
+        case OP_ADD: *out = (long)((unsigned long)a + (unsigned long)b); break;
+        case OP_SUB: *out = (long)((unsigned long)a - (unsigned long)b); break;
+        case OP_MUL: *out = (long)((unsigned long)a * (unsigned long)b); break;
+        case OP_DIV:
+            if (b == 0) return EXPR_ERR_DIV_ZERO;
+            *out = (b == -1) ? (long)(0UL - (unsigned long)a) : a / b;
+            break;
+        case OP_MOD:
+            if (b == 0) return EXPR_ERR_DIV_ZERO;
+            *out = (b == -1) ? 0 : a % b;
+            break;
+        case OP_AND: *out = a & b; break;
+        case OP_OR:  *out = a | b; break;
+        case OP_XOR: *out = a ^ b; break;
+        case OP_SHL: *out = (long)((unsigned long)a << (b & 63)); break;
+        case OP_SHR: *out = a >> (b & 63); break;
+        case OP_LT:  *out = a < b;  break;
+        case OP_LE:  *out = a <= b; break;
+        case OP_GT:  *out = a > b;  break;
+        case OP_GE:  *out = a >= b; break;
+        case OP_EQ:  *out = a == b; break;
+        case OP_NE:  *out = a != b; break;
+    }
+    return EXPR_OK;
+}
+
+static Operand parse_expr(Parser* p, int min_bp);
+
+static Operand parse_prefix(Parser* p) {
+    Operand o = { true, 0, 0 };
+
+    if (p->tok == TOK_NUM) {
+        o.value = p->tok_num;
+        next_token(p);
+    } else if (p->tok == TOK_IDENT) {
+        int slot = vars_slot(p->tok_name);
+        if (slot < 0) {
+            set_error(p, EXPR_ERR_UNKNOWN_VAR);
+            return o;
+        }
+        o.is_const = false;
+        o.reg = alloc_reg(p);
+        emit(p, OP_LOADV, o.reg, slot & 0xFF, (slot >> 8) & 0xFF);
+        if (slot > 0xFFFF) set_error(p, EXPR_ERR_TOO_COMPLEX);
+        next_token(p);
+    } else if (p->tok == TOK_LPAREN) {
+        next_token(p);
+        o = parse_expr(p, 0);
+        if (p->error != EXPR_OK) return o;
+        if (p->tok != TOK_RPAREN) {
+            set_error(p, EXPR_ERR_SYNTAX);
+            return o;
+        }
+        next_token(p);
+    } else if (p->tok == TOK_OP && (p->tok_char == '-' || p->tok_char == '~' || p->tok_char == '!')) {
+        char c = p->tok_char;
+        next_token(p);
+        o = parse_expr(p, UNARY_BINDING_POWER);
+        if (p->error != EXPR_OK) return o;
+        if (o.is_const) {
+            if (c == '-') o.value = (long)(0UL - (unsigned long)o.value);
+            else if (c == '~') o.value = ~o.value;
+            else o.value = !o.value;
+        } else {
+            emit(p, c == '-' ? OP_NEG : (c == '~' ? OP_NOT : OP_LNOT), o.reg, o.reg, 0);
+        }
+    } else {
+        set_error(p, EXPR_ERR_SYNTAX);
+    }
+    return o;
+}
+
+static Operand parse_expr(Parser* p, int min_bp) {
+    // Reine Konstanten belegen keine Register: Klammern und unäre
+    // Operatoren begrenzt nur die Tiefe (Stack)
+    if (p->depth >= EXPR_MAX_DEPTH) {
+        set_error(p, EXPR_ERR_TOO_COMPLEX);
+        Operand none = { true, 0, 0 };
+        return none;
+    }
+    p->depth++;
+    Operand lhs = parse_prefix(p);
+
+    while (p->error == EXPR_OK && p->tok == TOK_OP) {
+        int op = p->tok_op;
+        int bp = binding_power(op);
+        if (bp == 0) {
+            set_error(p, EXPR_ERR_SYNTAX);
+            break;
+        }
+        if (bp <= min_bp) break; // Linksassoziativ
+        next_token(p);
+
+        int saved_reg = p->next_reg;
+        Operand rhs = parse_expr(p, bp);
+        if (p->error != EXPR_OK) break;
+
+        if (lhs.is_const && rhs.is_const) {
+            long folded;
+            // Division durch 0 nicht falten, sondern zur Laufzeit melden
+            if (apply_binary(op, lhs.value, rhs.value, &folded) == EXPR_OK) {
+                lhs.value = folded;
+                continue;
+            }
+        }
+
+        // Beide Seiten in Register bringen. Liegt nur die rechte Seite schon
+        // in einem Register, wird die linke danach geladen; das Ergebnis
+        // landet immer im niedrigeren Register.
+        int a = materialize(p, &lhs);
+        int b = materialize(p, &rhs);
+        int dst = a < b ? a : b;
+        emit(p, op, dst, a, b);
+        lhs.is_const = false;
+        lhs.reg = dst;
+        p->next_reg = (saved_reg > dst + 1) ? saved_reg : dst + 1;
+    }
+    p->depth--;
+    return lhs;
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+int expr_compile(const char* src, ExprProgram* prog) {
+    Parser p;
+    p.pos = src;
+    p.prog = prog;
+    p.next_reg = 0;
+    p.depth = 0;
+    p.error = EXPR_OK;
+    prog->code_len = 0;
+    prog->const_count = 0;
+
+    next_token(&p);
+    Operand result = parse_expr(&p, 0);
+    if (p.error == EXPR_OK && p.tok != TOK_END) {
+        p.error = EXPR_ERR_SYNTAX;
+    }
+    if (p.error == EXPR_OK) {
+        int reg = materialize(&p, &result);
+        emit(&p, OP_RET, 0, reg, 0);
+    }
+    return p.error;
+}
+
+int expr_run(const ExprProgram* prog, long* result) {
+    long r[EXPR_MAX_REGS];
+    const ExprInsn* pc = prog->code;
+    const long* vars = vars_values;
+
+    while (1) {
+        const ExprInsn insn = *pc++;
+        switch (insn.op) {
+            case OP_LOADK: r[insn.dst] = prog->consts[insn.a]; break;
+            case OP_LOADV: r[insn.dst] = vars[insn.a | (insn.b << 8)]; break;
+            case OP_RET:   *result = r[insn.a]; return EXPR_OK;
+            case OP_NEG:   r[insn.dst] = (long)(0UL - (unsigned long)r[insn.a]); break;
+            case OP_NOT:   r[insn.dst] = ~r[insn.a]; break;
+            case OP_LNOT:  r[insn.dst] = !r[insn.a]; break;
+            case OP_ADD:   r[insn.dst] = (long)((unsigned long)r[insn.a] + (unsigned long)r[insn.b]); break;
+            case OP_SUB:   r[insn.dst] = (long)((unsigned long)r[insn.a] - (unsigned long)r[insn.b]); break;
+            case OP_MUL:   r[insn.dst] = (long)((unsigned long)r[insn.a] * (unsigned long)r[insn.b]); break;
+            case OP_AND:   r[insn.dst] = r[insn.a] & r[insn.b]; break;
+            case OP_OR:    r[insn.dst] = r[insn.a] | r[insn.b]; break;
+            case OP_XOR:   r[insn.dst] = r[insn.a] ^ r[insn.b]; break;
+            case OP_LT:    r[insn.dst] = r[insn.a] < r[insn.b];  break;
+            case OP_GT:    r[insn.dst] = r[insn.a] > r[insn.b];  break;
+            case OP_EQ:    r[insn.dst] = r[insn.a] == r[insn.b]; break;
+            default: {
+                // Seltenere Operationen mit Sonderfällen (Division, Shifts, ...)
+                int err = apply_binary(insn.op, r[insn.a], r[insn.b], &r[insn.dst]);
+                if (err != EXPR_OK) return err;
+            }
+        }
+    }
+}
+
+// ##################################
+// ## LRU-Cache übersetzter Ausdrücke
+// ##################################
+
+#define EXPR_CACHE_SIZE    8
+#define EXPR_CACHE_SRC_MAX 64 // Längere Ausdrücke werden nicht gecacht
+
+typedef struct {
+    char src[EXPR_CACHE_SRC_MAX];
+    unsigned int hash;
+    unsigned int last_used; // 0 = Eintrag frei
+    ExprProgram prog;
+} ExprCacheEntry;
+
+static ExprCacheEntry expr_cache[EXPR_CACHE_SIZE];
+static unsigned int expr_cache_clock = 0;
+
+int expr_eval(const char* src, long* result) {
+    unsigned int len = strlen_simple(src);
+    if (len >= EXPR_CACHE_SRC_MAX) {
+        ExprProgram prog;
+        int err = expr_compile(src, &prog);
+        return err != EXPR_OK ? err : expr_run(&prog, result);
+    }
+
+    unsigned int hash = hash_string(src);
+    ExprCacheEntry* victim = &expr_cache[0];
+    for (int i = 0; i < EXPR_CACHE_SIZE; i++) {
+        ExprCacheEntry* e = &expr_cache[i];
+        if (e->last_used != 0 && e->hash == hash && strcmp_simple(e->src, src) == 0) {
+            e->last_used = ++expr_cache_clock;
+            return expr_run(&e->prog, result);
+        }
+        if (e->last_used < victim->last_used) victim = e;
+    }
+
+    // Fehlschlag: übersetzen und den am längsten unbenutzten Eintrag ersetzen.
+    // Fehlerhafte Ausdrücke werden nicht gecacht (z.B. weil eine Variable erst
+    // später angelegt wird).
+    ExprProgram prog;
+    int err = expr_compile(src, &prog);
+    if (err != EXPR_OK) return err;
+
+    victim->prog = prog;
+    memcpy(victim->src, src, len + 1);
+    victim->hash = hash;
+    victim->last_used = ++expr_cache_clock;
+    return expr_run(&victim->prog, result);
+}
+
+const char* expr_error_string(int err) {
+    switch (err) {
+        case EXPR_OK:              return "OK";
+        case EXPR_ERR_SYNTAX:      return "Syntax error";
+        case EXPR_ERR_UNKNOWN_VAR: return "Variable not found";
+        case EXPR_ERR_TOO_COMPLEX: return "Expression too complex";
+        case EXPR_ERR_DIV_ZERO:    return "Division by zero";
+        default:                   return "Unknown error";
+    }
+}
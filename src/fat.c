@@ -0,0 +1,676 @@
+// src/fat.c
+#include "fat.h"
+#include "bcache.h"
+#include "sd.h"
+#include "mem.h"
+#include "smp.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+#define BLOCK_SIZE        BCACHE_BLOCK_SIZE
+#define DIR_ENTRY_SIZE    32
+
+#define FAT_ENTRY_MASK    0x0FFFFFFF
+#define FAT_BAD_CLUSTER   0x0FFFFFF7
+#define FAT_END_OF_CHAIN  0x0FFFFFF8 // und größer
+
+// Extent-Cache: Ketten mit mehr Fragmenten werden jenseits davon über die
+// FAT weiterverfolgt (mit einem Cursor pro Datei)
+#define CHAIN_SLOTS       32
+#define CHAIN_EXTENTS     64
+
+// Verzeichniscache, direkt abgebildet über den Hash des Pfads
+#define DIRCACHE_SIZE     256 // Zweierpotenz
+#define DIRCACHE_PATH     112
+
+typedef struct {
+    unsigned int cluster;
+    unsigned int length;        // Cluster
+} Extent;
+
+typedef struct {
+    unsigned int first;         // Schlüssel, 0 = frei
+    unsigned int extents;       // Belegte Einträge in extent[]
+    unsigned int covered;       // Von extent[] abgedeckte Cluster
+    unsigned int clusters;      // Länge der ganzen Kette
+    unsigned long last_used;
+    Extent extent[CHAIN_EXTENTS];
+} Chain;
+
+typedef struct {
+    char path[DIRCACHE_PATH];   // Kleingeschrieben, ohne führendes '/'
+    unsigned int cluster;
+    unsigned int size;
+    unsigned char attr;
+} DirCacheEntry;
+
+typedef struct {
+    bool mounted;
+    unsigned long fat_lba;      // Erster Block der ersten FAT
+    unsigned long data_lba;     // Block von Cluster 2
+    unsigned int cluster_shift; // log2(Blöcke pro Cluster)
+    unsigned int cluster_bytes;
+    unsigned int clusters;      // Anzahl Datencluster
+    unsigned int root;          // Startcluster der Wurzel
+} Volume;
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+static Volume vol;
+static Chain chains[CHAIN_SLOTS];
+static unsigned long chain_clock = 0;
+static DirCacheEntry dircache[DIRCACHE_SIZE];
+static FatStats stats;
+
+// ##################################
+// ## Hilfsfunktionen
+// ##################################
+
+static inline unsigned int le16(const unsigned char* p) { return p[0] | p[1] << 8; }
+static inline unsigned int le32(const unsigned char* p) { return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24; }
+
+static inline char lower(char c) { return (c >= 'A' && c <= 'Z') ? c + 32 : c; }
+
+static inline unsigned long cluster_lba(unsigned int cluster) {
+    return vol.data_lba + ((unsigned long)(cluster - 2) << vol.cluster_shift);
+}
+
+static inline bool valid_cluster(unsigned int cluster) {
+    return cluster >= 2 && cluster < vol.clusters + 2;
+}
+
+// Nächster Cluster der Kette; 0 am Ende, FAT_BAD_CLUSTER bei Fehlern
+static unsigned int fat_next(unsigned int cluster) {
+    const unsigned char* block = bcache_block(vol.fat_lba + cluster / (BLOCK_SIZE / 4));
+    if (block == NULL) return FAT_BAD_CLUSTER;
+    stats.fat_reads++;
+
+    unsigned int next = le32(block + (cluster % (BLOCK_SIZE / 4)) * 4) & FAT_ENTRY_MASK;
+    if (next >= FAT_END_OF_CHAIN) return 0;
+    if (!valid_cluster(next)) return FAT_BAD_CLUSTER;
+    return next;
+}
+
+// ##################################
+// ## Extent-Cache
+// ##################################
+
+/**
+ * Läuft die Kette ab first einmal ganz ab. Aufeinanderfolgende Cluster
+ * werden zu einem Extent zusammengefasst; die ersten CHAIN_EXTENTS
+ * Extents bleiben gespeichert, der Rest wird nur gezählt.
+ */
+static Chain* chain_get(unsigned int first) {
+    if (!valid_cluster(first)) return NULL;
+
+    Chain* victim = &chains[0];
+    for (int i = 0; i < CHAIN_SLOTS; i++) {
+        if (chains[i].first == first) {
+            stats.chain_hits++;
+            chains[i].last_used = ++chain_clock;
+            return &chains[i];
+        }
+        if (chains[i].last_used < victim->last_used) victim = &chains[i];
+    }
+    stats.chain_misses++;
+
+    Chain* c = victim;
+    c->first = 0;
+    c->extents = 0;
+    c->covered = 0;
+    c->clusters = 0;
+
+    unsigned int cluster = first;
+    unsigned int limit = vol.clusters; // Schutz gegen Zyklen
+    while (cluster != 0) {
+        if (cluster == FAT_BAD_CLUSTER || c->clusters == limit) return NULL;
+
+        if (c->extents > 0 && c->clusters == c->covered) {
+            Extent* last = &c->extent[c->extents - 1];
+            if (last->cluster + last->length == cluster) {
+                last->length++;
+                c->covered++;
+            } else if (c->extents < CHAIN_EXTENTS) {
+                c->extent[c->extents++] = (Extent){ cluster, 1 };
+                c->covered++;
+            }
+        } else if (c->extents == 0) {
+            c->extent[c->extents++] = (Extent){ cluster, 1 };
+            c->covered++;
+        }
+        c->clusters++;
+        cluster = fat_next(cluster);
+    }
+    c->first = first;
+    c->last_used = ++chain_clock;
+    return c;
+}
+
+/**
+ * Cluster zum Index index der Datei und die Zahl der Cluster, die ab dort
+ * am Stück folgen. 0 bei einem Fehler.
+ */
+static unsigned int file_cluster(FatFile* f, unsigned int index, unsigned int* contiguous) {
+    Chain* c = chain_get(f->cluster);
+    if (c == NULL) return 0;
+
+    if (index < c->covered) {
+        unsigned int start = 0;
+        for (unsigned int i = 0; i < c->extents; i++) {
+            const Extent* e = &c->extent[i];
+            if (index < start + e->length) {
+                *contiguous = start + e->length - index;
+                return e->cluster + (index - start);
+            }
+            start += e->length;
+        }
+        return 0;
+    }
+
+    // Hinter den Extents: ab dem Cursor der Datei (oder dem Ende der Extents)
+    // über die FAT weiterlaufen
+    if (f->walk_cluster == 0 || f->walk_index > index) {
+        const Extent* last = &c->extent[c->extents - 1];
+        f->walk_index = c->covered - 1;
+        f->walk_cluster = last->cluster + last->length - 1;
+    }
+    while (f->walk_index < index) {
+        unsigned int next = fat_next(f->walk_cluster);
+        if (next == 0 || next == FAT_BAD_CLUSTER) return 0;
+        f->walk_cluster = next;
+        f->walk_index++;
+    }
+    *contiguous = 1;
+    return f->walk_cluster;
+}
+
+// ##################################
+// ## Dateien lesen
+// ##################################
+
+// Block mit der aktuellen Position (ohne Kopie); *offset = Position im Block
+static const unsigned char* current_block(FatFile* f, unsigned int* offset) {
+    unsigned int contiguous;
+    unsigned int cluster = file_cluster(f, f->pos / vol.cluster_bytes, &contiguous);
+    if (cluster == 0) return NULL;
+
+    unsigned int in_cluster = f->pos % vol.cluster_bytes;
+    *offset = in_cluster % BLOCK_SIZE;
+    return bcache_block(cluster_lba(cluster) + in_cluster / BLOCK_SIZE);
+}
+
+long fat_read(FatFile* f, void* buffer, unsigned long n) {
+    if (!vol.mounted) return -FAT_ERR_NOT_MOUNTED;
+    if (f->pos >= f->size) return 0;
+    if (n > f->size - f->pos) n = f->size - f->pos;
+
+    unsigned char* out = buffer;
+    unsigned long done = 0;
+    while (done < n) {
+        unsigned int contiguous;
+        unsigned int cluster = file_cluster(f, f->pos / vol.cluster_bytes, &contiguous);
+        if (cluster == 0) return -FAT_ERR_CORRUPT;
+
+        unsigned int in_cluster = f->pos % vol.cluster_bytes;
+        unsigned long lba = cluster_lba(cluster) + in_cluster / BLOCK_SIZE;
+        unsigned int in_block = in_cluster % BLOCK_SIZE;
+        unsigned long chunk = (unsigned long)contiguous * vol.cluster_bytes - in_cluster;
+        if (chunk > n - done) chunk = n - done;
+
+        if (in_block == 0 && chunk >= BLOCK_SIZE) {
+            // Ganze Blöcke eines Extents: ein Zugriff (bei großen Mengen
+            // direkt per DMA in den Puffer, siehe bcache_read)
+            chunk &= ~(unsigned long)(BLOCK_SIZE - 1);
+            if (bcache_read(lba, chunk / BLOCK_SIZE, out) != SD_OK) return -FAT_ERR_IO;
+        } else {
+            const unsigned char* block = bcache_block(lba);
+            if (block == NULL) return -FAT_ERR_IO;
+            if (chunk > BLOCK_SIZE - in_block) chunk = BLOCK_SIZE - in_block;
+            memcpy(out, block + in_block, chunk);
+        }
+        out += chunk;
+        done += chunk;
+        f->pos += chunk;
+    }
+    return done;
+}
+
+int fat_map(FatFile* f, unsigned long pos, unsigned long* lba, unsigned long* blocks) {
+    if (!vol.mounted) return FAT_ERR_NOT_MOUNTED;
+    if (f->dir) return FAT_ERR_IS_DIR;
+    if (pos >= f->size) return FAT_ERR_RANGE;
+
+    unsigned int contiguous;
+    unsigned int cluster = file_cluster(f, pos / vol.cluster_bytes, &contiguous);
+    if (cluster == 0) return FAT_ERR_CORRUPT;
+
+    unsigned int in_cluster = pos % vol.cluster_bytes;
+    *lba = cluster_lba(cluster) + in_cluster / BLOCK_SIZE;
+    *blocks = ((unsigned long)contiguous * vol.cluster_bytes - in_cluster) / BLOCK_SIZE;
+
+    // Nicht über den letzten Block der Datei hinaus
+    unsigned long left = (f->size - 1) / BLOCK_SIZE - pos / BLOCK_SIZE + 1;
+    if (*blocks > left) *blocks = left;
+    return FAT_OK;
+}
+
+int fat_seek(FatFile* f, unsigned long pos) {
+    f->pos = pos < f->size ? pos : f->size;
+    return FAT_OK;
+}
+
+int fat_read_line(FatFile* f, char* buffer, unsigned int size) {
+    if (!vol.mounted) return -FAT_ERR_NOT_MOUNTED;
+    if (f->pos >= f->size) return FAT_EOF;
+
+    // len zählt weiter, wenn der Puffer voll ist, damit der Aufrufer
+    // abgeschnittene Zeilen erkennt
+    unsigned int len = 0;
+    while (f->pos < f->size) {
+        unsigned int offset;
+        const unsigned char* block = current_block(f, &offset);
+        if (block == NULL) return -FAT_ERR_IO;
+
+        // Bis zum Blockende oder Zeilenende direkt im Cache suchen
+        unsigned long end = BLOCK_SIZE - offset;
+        if (end > f->size - f->pos) end = f->size - f->pos;
+        for (unsigned int i = 0; i < end; i++) {
+            char c = block[offset + i];
+            if (c == '\n') {
+                f->pos += i + 1;
+                buffer[len < size ? len : size - 1] = '\0';
+                return len;
+            }
+            if (c != '\r') {
+                if (len < size - 1) buffer[len] = c;
+                len++;
+            }
+        }
+        f->pos += end;
+    }
+    buffer[len < size ? len : size - 1] = '\0';
+    return len;
+}
+
+// ##################################
+// ## Verzeichnisse
+// ##################################
+
+// Kurzname "NAME    EXT" -> "name.ext" (Kleinschreibung nach den NT-Flags)
+static void short_name(const unsigned char* e, char* out) {
+    bool lower_base = e[12] & 0x08, lower_ext = e[12] & 0x10;
+    int n = 0;
+    for (int i = 0; i < 8 && e[i] != ' '; i++) {
+        char c = (i == 0 && e[i] == 0x05) ? (char)0xE5 : e[i];
+        out[n++] = lower_base ? lower(c) : c;
+    }
+    if (e[8] != ' ') {
+        out[n++] = '.';
+        for (int i = 8; i < 11 && e[i] != ' '; i++) out[n++] = lower_ext ? lower(e[i]) : e[i];
+    }
+    out[n] = '\0';
+}
+
+static unsigned char short_checksum(const unsigned char* e) {
+    unsigned char sum = 0;
+    for (int i = 0; i < 11; i++) sum = ((sum & 1) << 7) + (sum >> 1) + e[i];
+    return sum;
+}
+
+// Position der 13 UCS-2-Zeichen in einem LFN-Eintrag
+static const unsigned char lfn_offsets[13] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+
+int fat_readdir(FatFile* dir, FatDirEntry* entry) {
+    if (!vol.mounted) return -FAT_ERR_NOT_MOUNTED;
+    if (!dir->dir) return -FAT_ERR_NOT_DIR;
+
+    char lfn[FAT_NAME_MAX];
+    lfn[0] = '\0';
+    int lfn_sequence = 0;           // Erwartete nächste Nummer, 0 = kein LFN
+    unsigned char lfn_checksum = 0;
+
+    while (dir->pos < dir->size) {
+        unsigned int offset;
+        const unsigned char* block = current_block(dir, &offset);
+        if (block == NULL) return -FAT_ERR_IO;
+        const unsigned char* e = block + offset;
+        dir->pos += DIR_ENTRY_SIZE;
+        stats.dir_scans++;
+
+        if (e[0] == 0x00) {
+            dir->pos = dir->size;   // Ende des Verzeichnisses
+            return 0;
+        }
+        if (e[0] == 0xE5) {
+            lfn[0] = '\0';
+            lfn_sequence = 0;
+            continue;
+        }
+
+        if ((e[11] & 0x3F) == FAT_ATTR_LFN) {
+            int sequence = e[0] & 0x1F;
+            if (e[0] & 0x40) {
+                lfn_sequence = sequence;
+                lfn_checksum = e[13];
+                lfn[sequence * 13 < FAT_NAME_MAX ? sequence * 13 : FAT_NAME_MAX - 1] = '\0';
+            } else if (sequence != lfn_sequence || e[13] != lfn_checksum) {
+                lfn[0] = '\0';
+                lfn_sequence = 0;
+                continue;
+            }
+            if (lfn_sequence == 0 || sequence == 0) continue;
+            for (int i = 0; i < 13; i++) {
+                unsigned int pos = (sequence - 1) * 13 + i;
+                unsigned int c = le16(e + lfn_offsets[i]);
+                if (pos >= FAT_NAME_MAX - 1) break;
+                if (c == 0x0000) lfn[pos] = '\0';
+                else if (c != 0xFFFF) lfn[pos] = c < 0x80 ? (char)c : '?';
+            }
+            lfn_sequence = sequence - 1;
+            continue;
+        }
+
+        if (e[11] & FAT_ATTR_VOLUME) {
+            lfn[0] = '\0';
+            lfn_sequence = 0;
+            continue;
+        }
+        if (e[0] == '.' && (e[1] == ' ' || (e[1] == '.' && e[2] == ' '))) continue;
+
+        // Ein vollständiger LFN endet mit Nummer 1 direkt vor dem Kurznamen
+        bool have_lfn = lfn_sequence == 0 && lfn_checksum == short_checksum(e) && lfn[0] != '\0';
+        if (have_lfn) {
+            unsigned int i = 0;
+            for (; lfn[i] != '\0' && i < FAT_NAME_MAX - 1; i++) entry->name[i] = lfn[i];
+            entry->name[i] = '\0';
+        } else {
+            short_name(e, entry->name);
+        }
+        lfn[0] = '\0';
+        lfn_sequence = 0;
+
+        entry->attr = e[11];
+        entry->cluster = le16(e + 20) << 16 | le16(e + 26);
+        entry->size = le32(e + 28);
+        return 1;
+    }
+    return 0;
+}
+
+// ##################################
+// ## Pfade und Verzeichniscache
+// ##################################
+
+static bool names_equal(const char* a, const char* b, unsigned int len) {
+    for (unsigned int i = 0; i < len; i++) {
+        if (lower(a[i]) != lower(b[i])) return false;
+    }
+    return a[len] == '\0';
+}
+
+static DirCacheEntry* dircache_slot(const char* path, unsigned int len) {
+    return &dircache[hash_string_n(path, len) & (DIRCACHE_SIZE - 1)];
+}
+
+static DirCacheEntry* dircache_find(const char* path, unsigned int len) {
+    if (len >= DIRCACHE_PATH) return NULL;
+    DirCacheEntry* d = dircache_slot(path, len);
+    if (d->cluster == 0 && d->path[0] == '\0') return NULL;
+    if (strncmp_simple(d->path, path, len) != 0 || d->path[len] != '\0') return NULL;
+    return d;
+}
+
+static void dircache_insert(const char* path, unsigned int len, const FatDirEntry* e) {
+    if (len >= DIRCACHE_PATH) return;
+    DirCacheEntry* d = dircache_slot(path, len);
+    memcpy(d->path, path, len);
+    d->path[len] = '\0';
+    d->cluster = e->cluster;
+    d->size = e->size;
+    d->attr = e->attr;
+}
+
+static void open_entry(FatFile* f, unsigned int cluster, unsigned int size, bool dir) {
+    f->cluster = cluster;
+    f->pos = 0;
+    f->dir = dir;
+    f->walk_index = 0;
+    f->walk_cluster = 0;
+    f->size = size;
+    if (dir) {
+        Chain* c = chain_get(cluster);
+        f->size = c ? (unsigned long)c->clusters * vol.cluster_bytes : 0;
+    }
+}
+
+int fat_open(const char* path, FatFile* f) {
+    if (!vol.mounted) return FAT_ERR_NOT_MOUNTED;
+
+    // Pfad kleingeschrieben und ohne doppelte '/' als Schlüssel
+    char key[FAT_NAME_MAX];
+    unsigned int len = 0;
+    for (const char* p = path; *p != '\0' && len < sizeof(key) - 1; p++) {
+        if (*p == '/' && (len == 0 || key[len - 1] == '/')) continue;
+        key[len++] = lower(*p);
+    }
+    if (len > 0 && key[len - 1] == '/') len--;
+    key[len] = '\0';
+
+    unsigned int cluster = vol.root, size = 0;
+    bool dir = true;
+    unsigned int start = 0;
+
+    // Längsten bekannten Präfix aus dem Cache nehmen
+    for (unsigned int end = len; end > 0; end--) {
+        if (end != len && key[end] != '/') continue;
+        DirCacheEntry* d = dircache_find(key, end);
+        if (d != NULL) {
+            stats.dir_hits++;
+            cluster = d->cluster;
+            size = d->size;
+            dir = d->attr & FAT_ATTR_DIRECTORY;
+            start = end == len ? len : end + 1;
+            break;
+        }
+    }
+
+    while (start < len) {
+        if (!dir) return FAT_ERR_NOT_DIR;
+        stats.dir_misses++;
+
+        unsigned int end = start;
+        while (end < len && key[end] != '/') end++;
+
+        FatFile d;
+        open_entry(&d, cluster, 0, true);
+        FatDirEntry e;
+        int r;
+        while ((r = fat_readdir(&d, &e)) > 0) {
+            if (names_equal(e.name, key + start, end - start)) break;
+        }
+        if (r < 0) return -r;
+        if (r == 0) return FAT_ERR_NOT_FOUND;
+
+        dircache_insert(key, end, &e);
+        cluster = e.cluster;
+        size = e.size;
+        dir = e.attr & FAT_ATTR_DIRECTORY;
+        start = end + 1;
+    }
+
+    open_entry(f, cluster, size, dir);
+    return FAT_OK;
+}
+
+// ##################################
+// ## Einhängen
+// ##################################
+
+static bool is_fat32_boot_sector(const unsigned char* b) {
+    return (b[0] == 0xEB || b[0] == 0xE9) && le16(b + 11) == BLOCK_SIZE && le16(b + 22) == 0 &&
+           memcmp(b + 82, "FAT32", 5) == 0;
+}
+
+int fat_mount() {
+    vol.mounted = false;
+    fat_drop_caches();
+
+    const unsigned char* b = bcache_block(0);
+    if (b == NULL) return FAT_ERR_IO;
+
+    unsigned long start = 0;
+    if (!is_fat32_boot_sector(b)) {
+        // MBR: erste Partition mit Typ FAT32 (CHS 0x0B oder LBA 0x0C)
+        if (b[510] != 0x55 || b[511] != 0xAA) return FAT_ERR_FORMAT;
+        for (int i = 0; i < 4 && start == 0; i++) {
+            const unsigned char* p = b + 446 + i * 16;
+            if (p[4] == 0x0B || p[4] == 0x0C) start = le32(p + 8);
+        }
+        if (start == 0) return FAT_ERR_FORMAT;
+        b = bcache_block(start);
+        if (b == NULL) return FAT_ERR_IO;
+        if (!is_fat32_boot_sector(b)) return FAT_ERR_FORMAT;
+    }
+
+    unsigned int per_cluster = b[13];
+    unsigned int reserved = le16(b + 14);
+    unsigned int fats = b[16];
+    unsigned long total = le16(b + 19) ? le16(b + 19) : le32(b + 32);
+    unsigned long fat_size = le32(b + 36);
+    if (per_cluster == 0 || (per_cluster & (per_cluster - 1)) || fats == 0 || fat_size == 0) {
+        return FAT_ERR_FORMAT;
+    }
+
+    vol.fat_lba = start + reserved;
+    vol.data_lba = vol.fat_lba + fats * fat_size;
+    vol.cluster_shift = __builtin_ctz(per_cluster);
+    vol.cluster_bytes = per_cluster * BLOCK_SIZE;
+    vol.clusters = (total - (vol.data_lba - start)) >> vol.cluster_shift;
+    vol.root = le32(b + 44);
+    if (!valid_cluster(vol.root)) return FAT_ERR_FORMAT;
+
+    vol.mounted = true;
+    return FAT_OK;
+}
+
+bool fat_mounted() {
+    return vol.mounted;
+}
+
+void fat_drop_caches() {
+    memset(chains, 0, sizeof(chains));
+    memset(dircache, 0, sizeof(dircache));
+    chain_clock = 0;
+}
+
+const FatStats* fat_stats() {
+    return &stats;
+}
+
+const char* fat_error_string(int err) {
+    switch (err) {
+    case FAT_OK:              return "ok";
+    case FAT_ERR_NOT_MOUNTED: return "no FAT32 volume mounted";
+    case FAT_ERR_FORMAT:      return "no FAT32 partition";
+    case FAT_ERR_IO:          return "read error";
+    case FAT_ERR_CORRUPT:     return "corrupt cluster chain";
+    case FAT_ERR_NOT_FOUND:   return "not found";
+    case FAT_ERR_NOT_DIR:     return "not a directory";
+    case FAT_ERR_IS_DIR:      return "is a directory";
+    case FAT_ERR_RANGE:       return "beyond end of file";
+    default:                  return "unknown error";
+    }
+}
+
+// ##################################
+// ## Benchmark
+// ##################################
+
+static void print_error(const char* what, int err) {
+    console_puts(what);
+    console_puts(": ");
+    console_puts(fat_error_string(err));
+    console_puts("\n");
+}
+
+/**
+ * "fatbench <file> [small-file]": liest die Datei mit kaltem Cache (Extents,
+ * Verzeichnis und Blöcke verworfen) in 64-KB-Stücken und misst danach das
+ * Öffnen einer kleinen Datei kalt und warm.
+ */
+static int cmd_fatbench(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        console_puts("Usage: fatbench <file> [small-file]\n");
+        return SHELL_ERROR;
+    }
+    if (!vol.mounted) {
+        print_error("fatbench", FAT_ERR_NOT_MOUNTED);
+        return SHELL_ERROR;
+    }
+
+    static unsigned char* buffer = NULL;
+    if (buffer == NULL) buffer = mem_alloc_aligned(64 * 1024, CACHE_LINE);
+    if (buffer == NULL) return SHELL_ERROR;
+
+    bcache_drop();
+    fat_drop_caches();
+    bcache_reset_stats();
+
+    FatFile f;
+    unsigned long start = timer_ticks();
+    int err = fat_open(argv[1], &f);
+    if (err != FAT_OK) {
+        print_error(argv[1], err);
+        return SHELL_ERROR;
+    }
+    if (f.dir) {
+        print_error(argv[1], FAT_ERR_IS_DIR);
+        return SHELL_ERROR;
+    }
+    long n;
+    unsigned long total = 0;
+    while ((n = fat_read(&f, buffer, 64 * 1024)) > 0) total += n;
+    unsigned long us = timer_ticks_to_us(timer_ticks() - start);
+    if (n < 0) {
+        print_error(argv[1], -n);
+        return SHELL_ERROR;
+    }
+
+    Chain* c = chain_get(f.cluster);
+    console_puts("sequential: ");
+    console_putlong(total);
+    console_puts(" bytes in ");
+    console_putlong(us / 1000);
+    console_puts(" ms, ");
+    console_putlong(us ? total * 1000000 / 1024 / us : 0);
+    console_puts(" KB/s, ");
+    console_putint(c ? c->extents : 0);
+    console_puts(" extents, ");
+    console_putlong(sd_stats()->read_commands);
+    console_puts(" card commands\n");
+
+    const char* small = argc == 3 ? argv[2] : argv[1];
+    for (int warm = 0; warm < 2; warm++) {
+        if (!warm) {
+            bcache_drop();
+            fat_drop_caches();
+        }
+        start = timer_ticks();
+        err = fat_open(small, &f);
+        if (err == FAT_OK) n = fat_read(&f, buffer, 512);
+        us = timer_ticks_to_us(timer_ticks() - start);
+        if (err != FAT_OK) {
+            print_error(small, err);
+            return SHELL_ERROR;
+        }
+        console_puts(warm ? "open+read 512 B, warm: " : "open+read 512 B, cold: ");
+        console_putlong(us);
+        console_puts(" us\n");
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(fatbench, cmd_fatbench, "<file> [small-file] - FAT32 sequential read and open latency");
@@ -1,11 +1,201 @@
 #include "gpio.h"
 #include "mb.h"
 #include "terminal.h"
+#include "string_utils.h" // Für bool
+#include "fb.h"
+#include "smp.h"
+#include "shell.h"
+#include "console.h"
+#include "mem.h"
+#include "mmio.h"
 
 unsigned int width, height, pitch, isrgb;
-unsigned char *fb;
+unsigned char *fb;          // Zeichenziel: Framebuffer oder Schattenpuffer
+static unsigned char *fb_front; // Framebuffer im GPU-Speicher
+static unsigned int depth;  // Bits pro Pixel: 32, 16 oder 8
+static unsigned int bytes;  // Bytes pro Pixel
 
-void fb_init()
+// Pixelwerte der 16 VGA-Farben im aktuellen Format
+static unsigned int fb_colors[16];
+
+// Clip-Rechteck je Core, damit der Compositor auf allen Cores gleichzeitig
+// in verschiedene Kacheln zeichnen kann. Eigene Cache-Zeile je Core.
+typedef struct {
+    FbRect rect;
+} __attribute__((aligned(CACHE_LINE))) FbClip;
+
+static FbClip fb_clips[SMP_MAX_CORES] = {
+    { { 0, 0, -1, -1 } }, { { 0, 0, -1, -1 } }, { { 0, 0, -1, -1 } }, { { 0, 0, -1, -1 } }
+};
+
+static inline const FbRect *clip()
+{
+    return &fb_clips[smp_core_id()].rect;
+}
+
+// Schattenpuffer im cachebaren RAM (siehe fb_set_shadow); shadow ist NULL,
+// solange er aus ist. Der Speicher bleibt reserviert (kein free).
+static unsigned char *shadow;
+static unsigned char *shadow_buffer;
+static unsigned long shadow_capacity;
+
+// Geänderte Bereiche je Core, werden erst in fb_flush zusammengeführt
+#define FB_DIRTY_MAX 16
+
+typedef struct {
+    FbRect rects[FB_DIRTY_MAX];
+    int count;
+    unsigned long drawn;    // Geschriebene Bytes seit dem letzten fb_flush
+} __attribute__((aligned(CACHE_LINE))) FbDirty;
+
+static FbDirty fb_dirty[SMP_MAX_CORES];
+static FbStats stats;
+
+// Vor dem Zeichnen (siehe fb_set_draw_hook), meist NULL
+static fb_draw_hook_t draw_hook;
+
+static inline void fb_count(long pixels)
+{
+    if (shadow) fb_dirty[smp_core_id()].drawn += pixels * bytes;
+}
+
+// ##################################
+// ## Pixelformate
+// ##################################
+
+/*
+ * Die inneren Schleifen gibt es je Pixelformat einmal. Sie werden aus den
+ * generischen Funktionen unten erzeugt, die die Pixelgröße B als Konstante
+ * bekommen; nach dem Inlining bleibt davon keine Abfrage pro Pixel übrig.
+ * Die Primitive wählen die Variante einmal pro Aufruf über fb_format.
+ */
+#define FB_INLINE static inline __attribute__((always_inline))
+
+FB_INLINE void px_store(unsigned char *p, unsigned int color, int B)
+{
+    if (B == 4) *(unsigned int *)p = color;
+    else if (B == 2) *(unsigned short *)p = color;
+    else *p = color;
+}
+
+// Pixelwert auf 64 Bit vervielfachen
+FB_INLINE unsigned long px_pattern(unsigned int color, int B)
+{
+    if (B == 4) return color | (unsigned long)color << 32;
+    if (B == 2) return (color & 0xFFFF) * 0x0001000100010001ul;
+    return (color & 0xFF) * 0x0101010101010101ul;
+}
+
+// n Pixel ab p; bis zur 8-Byte-Grenze einzeln, dann 64 Bit am Stück
+FB_INLINE void gen_span(unsigned char *p, int n, unsigned int color, int B)
+{
+    unsigned char *end = p + (long)n * B;
+    while (p < end && ((unsigned long)p & 7)) { px_store(p, color, B); p += B; }
+    unsigned long pattern = px_pattern(color, B);
+    for (; p + 8 <= end; p += 8) *(unsigned long *)p = pattern;
+    for (; p < end; p += B) px_store(p, color, B);
+}
+
+FB_INLINE void gen_vline(unsigned char *p, int n, unsigned int color, int B)
+{
+    for (; n > 0; n--, p += pitch) px_store(p, color, B);
+}
+
+FB_INLINE void gen_line(unsigned char *p, long n, long step_m, long step_n,
+                        long err, long two_d, long two_dmin, unsigned int color, int B)
+{
+    for (; n > 0; n--) {
+        px_store(p, color, B);
+        p += step_m;
+        err += two_dmin;
+        if (err >= two_d) {
+            err -= two_d;
+            p += step_n;
+        }
+    }
+}
+
+// Ganzes, ungeclipptes Zeichen (FONT_WIDTH x FONT_HEIGHT)
+FB_INLINE void gen_glyph(unsigned char *p, const unsigned char *glyph,
+                         unsigned int fg, unsigned int bg, int B)
+{
+    for (int i = 0; i < FONT_HEIGHT; i++, p += pitch, glyph += FONT_BPL) {
+        unsigned char bits = *glyph;
+        for (int j = 0; j < FONT_WIDTH; j++) {
+            px_store(p + j * B, (bits >> j) & 1 ? fg : bg, B);
+        }
+    }
+}
+
+typedef struct {
+    void (*pixel)(unsigned char *p, unsigned int color);
+    void (*span)(unsigned char *p, int n, unsigned int color);
+    void (*vline)(unsigned char *p, int n, unsigned int color);
+    void (*line)(unsigned char *p, long n, long step_m, long step_n,
+                 long err, long two_d, long two_dmin, unsigned int color);
+    void (*glyph)(unsigned char *p, const unsigned char *glyph, unsigned int fg, unsigned int bg);
+} FbFormat;
+
+#define FB_FORMAT(B)                                                                     \
+    static void pixel_##B(unsigned char *p, unsigned int c) { px_store(p, c, B); }      \
+    static void span_##B(unsigned char *p, int n, unsigned int c) { gen_span(p, n, c, B); } \
+    static void vline_##B(unsigned char *p, int n, unsigned int c) { gen_vline(p, n, c, B); } \
+    static void line_##B(unsigned char *p, long n, long sm, long sn, long e, long td, long tdm, unsigned int c) \
+        { gen_line(p, n, sm, sn, e, td, tdm, c, B); }                                   \
+    static void glyph_##B(unsigned char *p, const unsigned char *g, unsigned int fg, unsigned int bg) \
+        { gen_glyph(p, g, fg, bg, B); }                                                 \
+    static const FbFormat fb_format_##B = { pixel_##B, span_##B, vline_##B, line_##B, glyph_##B };
+
+FB_FORMAT(4)
+FB_FORMAT(2)
+FB_FORMAT(1)
+
+static const FbFormat *fb_format = &fb_format_4;
+
+static inline unsigned char *fb_addr(int x, int y)
+{
+    return fb + (long)y * pitch + (long)x * bytes;
+}
+
+// ##################################
+// ## Modus und Palette
+// ##################################
+
+// Palette für 8 Bit: 16 VGA-Farben, 6x6x6-Farbwürfel, 24 Graustufen
+static unsigned int palette_entry(int i)
+{
+    if (i < 16) return vgapal[i];
+    if (i < 232) {
+        i -= 16;
+        return (i / 36) * 51 << 16 | (i / 6 % 6) * 51 << 8 | (i % 6) * 51;
+    }
+    unsigned int g = 8 + (i - 232) * 10;
+    return g << 16 | g << 8 | g;
+}
+
+// Die Palette passt nicht in einen Mailbox-Puffer, daher in Stücken
+#define PALETTE_CHUNK 32
+
+static bool fb_load_palette()
+{
+    for (int offset = 0; offset < 256; offset += PALETTE_CHUNK) {
+        mbox[0] = (8 + PALETTE_CHUNK) * 4;
+        mbox[1] = MBOX_REQUEST;
+        mbox[2] = MBOX_TAG_SETPALETTE;
+        mbox[3] = (2 + PALETTE_CHUNK) * 4;
+        mbox[4] = 0;
+        mbox[5] = offset;
+        mbox[6] = PALETTE_CHUNK;
+        for (int i = 0; i < PALETTE_CHUNK; i++) mbox[7 + i] = palette_entry(offset + i);
+        mbox[7 + PALETTE_CHUNK] = MBOX_TAG_LAST;
+
+        // Antwort: 0 = gültig
+        if (!mbox_call(MBOX_CH_PROP) || mbox[5] != 0) return false;
+    }
+    return true;
+}
+
+static bool fb_setup(unsigned int bpp)
 {
     mbox[0] = 35*4; // Length of message in bytes
     mbox[1] = MBOX_REQUEST;
@@ -31,7 +221,7 @@ void fb_init()
     mbox[17] = MBOX_TAG_SETDEPTH;
     mbox[18] = 4;
     mbox[19] = 4;
-    mbox[20] = 32; // Bits per pixel
+    mbox[20] = bpp; // Bits per pixel
 
     mbox[21] = MBOX_TAG_SETPXLORDR;
     mbox[22] = 4;
@@ -51,58 +241,758 @@ void fb_init()
 
     mbox[34] = MBOX_TAG_LAST;
 
-    // Check call is successful and we have a pointer with depth 32
-    if (mbox_call(MBOX_CH_PROP) && mbox[20] == 32 && mbox[28] != 0) {
-        mbox[28] &= 0x3FFFFFFF; // Convert GPU address to ARM address
-        width = mbox[10];       // Actual physical width
-        height = mbox[11];      // Actual physical height
-        pitch = mbox[33];       // Number of bytes per line
-        isrgb = mbox[24];       // Pixel order
-        fb = (unsigned char *)((long)mbox[28]);
+    // Check call is successful and we have a pointer with the requested depth
+    if (!mbox_call(MBOX_CH_PROP) || mbox[20] != bpp || mbox[28] == 0) return false;
+
+    // fb_load_palette benutzt denselben Mailbox-Puffer: Antwort vorher sichern
+    unsigned int new_width = mbox[10];   // Actual physical width
+    unsigned int new_height = mbox[11];  // Actual physical height
+    unsigned int new_pitch = mbox[33];   // Number of bytes per line
+    unsigned int new_isrgb = mbox[24];   // Pixel order
+    unsigned char *new_fb = (unsigned char *)((long)(mbox[28] & 0x3FFFFFFF)); // GPU -> ARM address
+    if (bpp == 8 && !fb_load_palette()) return false;
+
+    // Erst wenn alle Schritte geklappt haben, gilt der neue Modus
+    bool use_shadow = shadow != NULL;
+    shadow = NULL;
+
+    width = new_width;
+    height = new_height;
+    pitch = new_pitch;
+    isrgb = new_isrgb;
+    fb_front = new_fb;
+    fb = fb_front;
+    depth = bpp;
+    bytes = bpp / 8;
+    fb_format = bytes == 4 ? &fb_format_4 : bytes == 2 ? &fb_format_2 : &fb_format_1;
+    for (int i = 0; i < 16; i++) fb_colors[i] = bpp == 8 ? (unsigned int)i : fb_map_rgb(vgapal[i]);
+
+    for (int i = 0; i < SMP_MAX_CORES; i++) {
+        fb_clips[i].rect = (FbRect){ 0, 0, (int)width - 1, (int)height - 1 };
+    }
+    // Reicht der Speicher nicht für den größeren Schattenpuffer, läuft der
+    // Modus eben ohne ihn (fb zeigt direkt auf den Framebuffer)
+    if (use_shadow) fb_set_shadow(true);
+    return true;
+}
+
+void fb_init()
+{
+    fb_setup(32);
+}
+
+bool fb_set_depth(unsigned int bpp)
+{
+    if (bpp != 32 && bpp != 16 && bpp != 8) return false;
+    unsigned int previous = depth;
+    if (fb_setup(bpp)) return true;
+
+    // Die Firmware kann den Puffer schon neu angelegt haben, auch wenn sie
+    // die Tiefe ablehnt: den alten Modus vollständig neu einrichten
+    fb_setup(previous);
+    return false;
+}
+
+unsigned int fb_map_rgb(unsigned int rgb)
+{
+    if (depth == 16) return fb_rgb565(rgb);
+    if (depth == 8) return fb_cube_index(rgb);
+    return rgb & 0xFFFFFF;
+}
+
+unsigned int fb_pixel_to_rgb(unsigned int pixel)
+{
+    if (depth == 16) {
+        unsigned int r = (pixel >> 11) & 0x1F, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+        return (r << 3 | r >> 2) << 16 | (g << 2 | g >> 4) << 8 | (b << 3 | b >> 2);
+    }
+    if (depth == 8) return palette_entry(pixel & 0xFF);
+    return pixel & 0xFFFFFF;
+}
+
+unsigned int fb_color(unsigned char attr)
+{
+    return fb_colors[attr & 0x0f];
+}
+
+// ##################################
+// ## Zeichen-Hook
+// ##################################
+
+// Ecken in beliebiger Reihenfolge, z.B. die Endpunkte einer Linie
+static inline void fb_before_draw(int x1, int y1, int x2, int y2)
+{
+    if (!draw_hook) return;
+    draw_hook(x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2, x1 > x2 ? x1 : x2, y1 > y2 ? y1 : y2);
+}
+
+void fb_set_draw_hook(fb_draw_hook_t hook)
+{
+    draw_hook = hook;
+}
+
+void fb_begin_draw(int x1, int y1, int x2, int y2)
+{
+    fb_before_draw(x1, y1, x2, y2);
+}
+
+// ##################################
+// ## Schattenpuffer
+// ##################################
+
+static inline long rect_area(const FbRect *r)
+{
+    return (long)(r->x2 - r->x1 + 1) * (r->y2 - r->y1 + 1);
+}
+
+static inline FbRect rect_union(const FbRect *a, const FbRect *b)
+{
+    return (FbRect){ a->x1 < b->x1 ? a->x1 : b->x1, a->y1 < b->y1 ? a->y1 : b->y1,
+                     a->x2 > b->x2 ? a->x2 : b->x2, a->y2 > b->y2 ? a->y2 : b->y2 };
+}
+
+/**
+ * Nimmt r in die Liste auf. Zwei Rechtecke werden verschmolzen, sobald ihre
+ * Hülle nicht größer ist als beide zusammen (überlappend oder bündig
+ * nebeneinander, z.B. Zeichen einer Zeile). Ist die Liste voll, wird r mit
+ * dem Rechteck verschmolzen, dessen Hülle am wenigsten wächst.
+ */
+static void dirty_add(FbDirty *d, FbRect r)
+{
+    for (;;) {
+        int i;
+        for (i = 0; i < d->count; i++) {
+            FbRect u = rect_union(&d->rects[i], &r);
+            if (rect_area(&u) <= rect_area(&d->rects[i]) + rect_area(&r)) break;
+        }
+        if (i == d->count && d->count < FB_DIRTY_MAX) {
+            d->rects[d->count++] = r;
+            return;
+        }
+        if (i == d->count) {
+            long best = -1;
+            for (int j = 0; j < d->count; j++) {
+                FbRect u = rect_union(&d->rects[j], &r);
+                long growth = rect_area(&u) - rect_area(&d->rects[j]);
+                if (best < 0 || growth < best) { best = growth; i = j; }
+            }
+        }
+        // Hülle entnehmen und erneut einfügen, sie kann weitere Rechtecke schlucken
+        r = rect_union(&d->rects[i], &r);
+        d->rects[i] = d->rects[--d->count];
     }
 }
 
+// Markiert ein Rechteck (auf das Clip-Rechteck begrenzt) als geändert
+static void fb_dirty_rect(int x1, int y1, int x2, int y2)
+{
+    if (!shadow) return;
+    const FbRect *c = clip();
+    FbRect r = { x1 > c->x1 ? x1 : c->x1, y1 > c->y1 ? y1 : c->y1,
+                 x2 < c->x2 ? x2 : c->x2, y2 < c->y2 ? y2 : c->y2 };
+    if (r.x1 > r.x2 || r.y1 > r.y2) return;
+    dirty_add(&fb_dirty[smp_core_id()], r);
+}
+
+void fb_mark_dirty(int x1, int y1, int x2, int y2)
+{
+    if (!shadow || x1 > x2 || y1 > y2) return;
+    fb_dirty_rect(x1, y1, x2, y2);
+    fb_count((long)(x2 - x1 + 1) * (y2 - y1 + 1));
+}
+
+typedef unsigned int fb_u32x4 __attribute__((vector_size(16)));
+
+// Kopiert [x1, x2) Bytes jeder Zeile y1..y2 in 16-Byte-Schritten, 64 Byte pro
+// Runde; ist der Pitch kein Vielfaches von 16, bleibt am Zeilenende ein Rest
+static void shadow_copy(unsigned long x1, unsigned long x2, int y1, int y2)
+{
+    for (int y = y1; y <= y2; y++) {
+        const fb_u32x4 *s = (const fb_u32x4 *)(shadow + (long)y * pitch + x1);
+        fb_u32x4 *d = (fb_u32x4 *)(fb_front + (long)y * pitch + x1);
+        unsigned long n = (x2 - x1) / 16;
+        for (; n >= 4; n -= 4, s += 4, d += 4) {
+            fb_u32x4 a = s[0], b = s[1], c = s[2], e = s[3];
+            d[0] = a; d[1] = b; d[2] = c; d[3] = e;
+        }
+        while (n-- > 0) *d++ = *s++;
+
+        const unsigned char *sb = (const unsigned char *)s;
+        unsigned char *db = (unsigned char *)d;
+        for (unsigned long tail = (x2 - x1) % 16; tail > 0; tail--) *db++ = *sb++;
+    }
+}
+
+unsigned long fb_flush()
+{
+    if (!shadow) return 0;
+
+    FbDirty all;
+    all.count = 0;
+    all.drawn = 0;
+    for (int core = 0; core < SMP_MAX_CORES; core++) {
+        FbDirty *d = &fb_dirty[core];
+        for (int i = 0; i < d->count; i++) dirty_add(&all, d->rects[i]);
+        all.drawn += d->drawn;
+        d->count = 0;
+        d->drawn = 0;
+    }
+
+    // Auf ganze Cache-Zeilen erweitern: der Schattenpuffer ist ohnehin die
+    // Wahrheit, und der GPU-Speicher bekommt nur volle, ausgerichtete Stores
+    unsigned long flushed = 0;
+    for (int i = 0; i < all.count; i++) {
+        FbRect *r = &all.rects[i];
+        unsigned long x1 = ((unsigned long)r->x1 * bytes) & ~(unsigned long)(CACHE_LINE - 1);
+        unsigned long x2 = ((unsigned long)(r->x2 + 1) * bytes + CACHE_LINE - 1) & ~(unsigned long)(CACHE_LINE - 1);
+        if (x2 > pitch) x2 = pitch;
+        shadow_copy(x1, x2, r->y1, r->y2);
+        flushed += (x2 - x1) * (r->y2 - r->y1 + 1);
+    }
+    dsb(); // Bild vollständig im Speicher, bevor die GPU es liest
+
+    stats.flushes++;
+    stats.drawn = all.drawn;
+    stats.flushed = flushed;
+    stats.total_drawn += all.drawn;
+    stats.total_flushed += flushed;
+    return flushed;
+}
+
+bool fb_set_shadow(bool on)
+{
+    if (fb_front == NULL) return false;
+    if (shadow) fb_flush();
+    shadow = NULL;
+    fb = fb_front;
+    if (!on) return true;
+
+    unsigned long size = (unsigned long)pitch * height;
+    if (size > shadow_capacity) {
+        unsigned char *buffer = mem_alloc_aligned(size, CACHE_LINE);
+        if (buffer == NULL) return false;
+        shadow_buffer = buffer;
+        shadow_capacity = size;
+    }
+    // Aktuellen Bildschirminhalt übernehmen, danach wird nur noch geschrieben
+    memcpy(shadow_buffer, fb_front, size);
+    for (int i = 0; i < SMP_MAX_CORES; i++) {
+        fb_dirty[i].count = 0;
+        fb_dirty[i].drawn = 0;
+    }
+    shadow = shadow_buffer;
+    fb = shadow;
+    return true;
+}
+
+const FbStats *fb_stats() { return &stats; }
+
+void fb_set_clip(int x1, int y1, int x2, int y2)
+{
+    FbRect *r = &fb_clips[smp_core_id()].rect;
+    r->x1 = x1 < 0 ? 0 : x1;
+    r->y1 = y1 < 0 ? 0 : y1;
+    r->x2 = x2 >= (int)width ? (int)width - 1 : x2;
+    r->y2 = y2 >= (int)height ? (int)height - 1 : y2;
+}
+
+void fb_reset_clip()
+{
+    fb_set_clip(0, 0, width - 1, height - 1);
+}
+
+const FbRect *fb_get_clip()
+{
+    return clip();
+}
+
+unsigned int fb_width() { return width; }
+unsigned int fb_height() { return height; }
+unsigned int fb_pitch() { return pitch; }
+unsigned int fb_depth() { return depth; }
+unsigned char *fb_buffer() { return fb; }
+unsigned char *fb_front_buffer() { return fb_front; }
+
+static void fb_pixel(int x, int y, unsigned int color)
+{
+    const FbRect *c = clip();
+    if (x < c->x1 || x > c->x2 || y < c->y1 || y > c->y2) return;
+    fb_format->pixel(fb_addr(x, y), color);
+    fb_count(1);
+}
+
 void drawPixel(int x, int y, unsigned char attr)
 {
-    int offs = (y * pitch) + (x * 4);
-    *((unsigned int*)(fb + offs)) = vgapal[attr & 0x0f];
+    fb_before_draw(x, y, x, y);
+    fb_pixel(x, y, fb_colors[attr & 0x0f]);
+    fb_dirty_rect(x, y, x, y);
 }
 
+// ##################################
+// ## Linien
+// ##################################
+
+// Waagerechter Span [x1, x2] in Zeile y, bereits geclippt
+static inline void fb_span(int x1, int x2, int y, unsigned int color)
+{
+    fb_format->span(fb_addr(x1, y), x2 - x1 + 1, color);
+    fb_count(x2 - x1 + 1);
+}
+
+static void fb_hline(int x1, int x2, int y, unsigned int color)
+{
+    const FbRect *c = clip();
+    if (x1 > x2) { int t = x1; x1 = x2; x2 = t; }
+    if (y < c->y1 || y > c->y2 || x2 < c->x1 || x1 > c->x2) return;
+    if (x1 < c->x1) x1 = c->x1;
+    if (x2 > c->x2) x2 = c->x2;
+    fb_span(x1, x2, y, color);
+}
+
+static void fb_vline(int x, int y1, int y2, unsigned int color)
+{
+    const FbRect *c = clip();
+    if (y1 > y2) { int t = y1; y1 = y2; y2 = t; }
+    if (x < c->x1 || x > c->x2 || y2 < c->y1 || y1 > c->y2) return;
+    if (y1 < c->y1) y1 = c->y1;
+    if (y2 > c->y2) y2 = c->y2;
+
+    fb_format->vline(fb_addr(x, y1), y2 - y1 + 1, color);
+    fb_count(y2 - y1 + 1);
+}
+
+// Kleinstes i >= 0 mit floor((2*i*dmin + d) / (2*d)) >= k
+static long line_first_step(long k, long d, long dmin)
+{
+    if (k <= 0) return 0;
+    long num = 2 * d * k - d;
+    return (num + 2 * dmin - 1) / (2 * dmin);
+}
+
+/**
+ * Bresenham für alle Oktanten, Endpunkte inklusive.
+ * Die Hauptachse ist die mit der größeren Ausdehnung d, die Nebenachse
+ * springt an Schritt i um k(i) = floor((2*i*dmin + d) / (2*d)).
+ * Weil k(i) monoton ist, lässt sich der sichtbare Bereich [i0, i1] vorab
+ * exakt bestimmen (Liang-Barsky auf den Schrittindex). Die geclippte Linie
+ * trifft dadurch genau dieselben Pixel wie die ungeclippte, und die
+ * innere Schleife braucht keine Bereichsprüfungen mehr.
+ */
+static void fb_line(int x1, int y1, int x2, int y2, unsigned int color)
+{
+    if (y1 == y2) { fb_hline(x1, x2, y1, color); return; }
+    if (x1 == x2) { fb_vline(x1, y1, y2, color); return; }
+
+    int dx = x2 - x1, dy = y2 - y1;
+    int sx = dx < 0 ? -1 : 1, sy = dy < 0 ? -1 : 1;
+    long adx = dx < 0 ? -(long)dx : dx;
+    long ady = dy < 0 ? -(long)dy : dy;
+
+    // Auf Haupt- (m) und Nebenachse (n) abbilden
+    bool xmajor = adx >= ady;
+    long d    = xmajor ? adx : ady;
+    long dmin = xmajor ? ady : adx;
+    long m0   = xmajor ? x1 : y1;
+    long n0   = xmajor ? y1 : x1;
+    int sm    = xmajor ? sx : sy;
+    int sn    = xmajor ? sy : sx;
+    const FbRect *c = clip();
+    long mmin = xmajor ? c->x1 : c->y1, mmax = xmajor ? c->x2 : c->y2;
+    long nmin = xmajor ? c->y1 : c->x1, nmax = xmajor ? c->y2 : c->x2;
+
+    // Hauptachse: m0 + sm*i muss in [mmin, mmax] liegen
+    long i0 = 0, i1 = d;
+    long lo = sm > 0 ? mmin - m0 : m0 - mmax;
+    long hi = sm > 0 ? mmax - m0 : m0 - mmin;
+    if (lo > i0) i0 = lo;
+    if (hi < i1) i1 = hi;
+    if (i0 > i1) return;
+
+    // Nebenachse: n0 + sn*k(i) muss in [nmin, nmax] liegen
+    long kmin = sn > 0 ? nmin - n0 : n0 - nmax;
+    long kmax = sn > 0 ? nmax - n0 : n0 - nmin;
+    if (kmax < 0) return;
+    lo = line_first_step(kmin, d, dmin);
+    hi = line_first_step(kmax + 1, d, dmin) - 1;
+    if (lo > i0) i0 = lo;
+    if (hi < i1) i1 = hi;
+    if (i0 > i1) return;
+
+    // Fehlerterm und Position am ersten sichtbaren Schritt
+    long acc = 2 * i0 * dmin + d;
+    long k = acc / (2 * d);
+    long err = acc - k * 2 * d; // in [0, 2d)
+    long m = m0 + sm * i0, n = n0 + sn * k;
+    long x = xmajor ? m : n, y = xmajor ? n : m;
+
+    long step_m = xmajor ? sm * (long)bytes : sm * (long)pitch;
+    long step_n = xmajor ? sn * (long)pitch : sn * (long)bytes;
+    fb_format->line(fb_addr(x, y), i1 - i0 + 1, step_m, step_n, err, 2 * d, 2 * dmin, color);
+    fb_count(i1 - i0 + 1);
+}
+
+// Schräge Linien werden in Stücke entlang der Hauptachse zerlegt, damit
+// nicht ihr ganzes umschließendes Rechteck als geändert gilt
+#define DIRTY_LINE_STEP 64
+
+static void fb_dirty_line(int x1, int y1, int x2, int y2)
+{
+    if (!shadow) return;
+    long dx = x2 - x1, dy = y2 - y1;
+    long d = dx < 0 ? -dx : dx;
+    if ((dy < 0 ? -dy : dy) > d) d = dy < 0 ? -dy : dy;
+
+    for (long i = 0; i <= d; i += DIRTY_LINE_STEP) {
+        long j = i + DIRTY_LINE_STEP < d ? i + DIRTY_LINE_STEP : d;
+        int xa = x1 + (d ? dx * i / d : 0), ya = y1 + (d ? dy * i / d : 0);
+        int xb = x1 + (d ? dx * j / d : 0), yb = y1 + (d ? dy * j / d : 0);
+        // Ein Pixel Reserve für die Rundung von Bresenham
+        fb_dirty_rect((xa < xb ? xa : xb) - 1, (ya < yb ? ya : yb) - 1,
+                      (xa > xb ? xa : xb) + 1, (ya > yb ? ya : yb) + 1);
+    }
+}
+
+void drawLine(int x1, int y1, int x2, int y2, unsigned char attr)
+{
+    fb_before_draw(x1, y1, x2, y2);
+    fb_line(x1, y1, x2, y2, fb_colors[attr & 0x0f]);
+    fb_dirty_line(x1, y1, x2, y2);
+}
+
+void drawPolyline(const int *points, int count, unsigned char attr)
+{
+    unsigned int color = fb_colors[attr & 0x0f];
+    for (int i = 1; i < count; i++) {
+        fb_before_draw(points[2 * i - 2], points[2 * i - 1], points[2 * i], points[2 * i + 1]);
+        fb_line(points[2 * i - 2], points[2 * i - 1], points[2 * i], points[2 * i + 1], color);
+        fb_dirty_line(points[2 * i - 2], points[2 * i - 1], points[2 * i], points[2 * i + 1]);
+    }
+}
+
+// ##################################
+// ## Flächen
+// ##################################
+
 void drawRect(int x1, int y1, int x2, int y2, unsigned char attr, int fill)
 {
-    int y=y1;
+    if (x1 > x2 || y1 > y2) return;
+    fb_before_draw(x1, y1, x2, y2);
+    unsigned int color = fb_colors[attr & 0x0f];
 
-    while (y <= y2) {
-       int x=x1;
-       while (x <= x2) {
-	  if ((x == x1 || x == x2) || (y == y1 || y == y2)) drawPixel(x, y, attr);
-	  else if (fill) drawPixel(x, y, (attr & 0xf0) >> 4);
-          x++;
-       }
-       y++;
+    if (fill && y2 - y1 > 1 && x2 - x1 > 1) {
+        unsigned int bg = fb_colors[(attr & 0xf0) >> 4];
+        for (int y = y1 + 1; y < y2; y++) fb_hline(x1 + 1, x2 - 1, y, bg);
     }
+    fb_hline(x1, x2, y1, color);
+    fb_hline(x1, x2, y2, color);
+    fb_vline(x1, y1, y2, color);
+    fb_vline(x2, y1, y2, color);
+    fb_dirty_rect(x1, y1, x2, y2);
 }
 
-void drawLine(int x1, int y1, int x2, int y2, unsigned char attr)  
-{  
-    int dx, dy, p, x, y;
+void fb_fill_rect(int x1, int y1, int x2, int y2, unsigned char attr)
+{
+    const FbRect *c = clip();
+    if (x1 < c->x1) x1 = c->x1;
+    if (y1 < c->y1) y1 = c->y1;
+    if (x2 > c->x2) x2 = c->x2;
+    if (y2 > c->y2) y2 = c->y2;
+    if (x1 > x2 || y1 > y2) return;
+    fb_before_draw(x1, y1, x2, y2);
 
-    dx = x2-x1;
-    dy = y2-y1;
-    x = x1;
-    y = y1;
-    p = 2*dy-dx;
+    unsigned int color = fb_colors[attr & 0x0f];
+    for (int y = y1; y <= y2; y++) fb_span(x1, x2, y, color);
+    fb_dirty_rect(x1, y1, x2, y2);
+}
 
-    while (x<x2) {
-       if (p >= 0) {
-          drawPixel(x,y,attr);
-          y++;
-          p = p+2*dy-2*dx;
-       } else {
-          drawPixel(x,y,attr);
-          p = p+2*dy;
-       }
-       x++;
+// Eine Zeile verschieben; überlappt nur bei waagerechten Verschiebungen
+static void fb_row_move(unsigned char *d, const unsigned char *s, unsigned long n)
+{
+    bool aligned = (((unsigned long)d | (unsigned long)s | n) & 7) == 0;
+    if (d <= s || d >= s + n) {
+        if (aligned) {
+            for (unsigned long i = 0; i < n; i += 8) *(unsigned long *)(d + i) = *(const unsigned long *)(s + i);
+        } else {
+            for (unsigned long i = 0; i < n; i++) d[i] = s[i];
+        }
+    } else if (aligned) {
+        while (n) { n -= 8; *(unsigned long *)(d + n) = *(const unsigned long *)(s + n); }
+    } else {
+        while (n--) d[n] = s[n];
+    }
+}
+
+void fb_move_rect(int x, int y, int w, int h, int dx, int dy)
+{
+    // Quelle auf den Bildschirm, Ziel auf das Clip-Rechteck begrenzen
+    const FbRect *c = clip();
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > (int)width) w = width - x;
+    if (y + h > (int)height) h = height - y;
+    int tx = x + dx, ty = y + dy;
+    if (tx < c->x1) { w -= c->x1 - tx; x += c->x1 - tx; tx = c->x1; }
+    if (ty < c->y1) { h -= c->y1 - ty; y += c->y1 - ty; ty = c->y1; }
+    if (tx + w > c->x2 + 1) w = c->x2 + 1 - tx;
+    if (ty + h > c->y2 + 1) h = c->y2 + 1 - ty;
+    if (w <= 0 || h <= 0) return;
+    // Auch die Quelle: ein Cursor dort würde mitverschoben
+    fb_before_draw(x, y, x + w - 1, y + h - 1);
+    fb_before_draw(tx, ty, tx + w - 1, ty + h - 1);
+
+    unsigned long n = (unsigned long)w * bytes;
+    if (dy > 0) {
+        // Nach unten: von unten nach oben kopieren, damit nichts überschrieben wird
+        for (int row = h - 1; row >= 0; row--) fb_row_move(fb_addr(tx, ty + row), fb_addr(x, y + row), n);
+    } else {
+        for (int row = 0; row < h; row++) fb_row_move(fb_addr(tx, ty + row), fb_addr(x, y + row), n);
+    }
+    fb_count((long)w * h);
+    fb_dirty_rect(tx, ty, tx + w - 1, ty + h - 1);
+}
+
+// Ganzzahlige Division mit Abrunden bzw. Aufrunden, b > 0
+static long div_floor(long a, long b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+static long div_ceil(long a, long b)  { return -div_floor(-a, b); }
+
+/**
+ * Füllt ein Dreieck über inkrementelle Kantenfunktionen
+ * E(x,y) = A*x + B*y + C. Pro Zeile wird E nur um B weitergezählt, die
+ * Spangrenzen ergeben sich direkt aus E >= 0 je Kante - es werden also keine
+ * Pixel außerhalb des Dreiecks getestet. Top-Left-Regel: linke und obere
+ * Kanten gehören zum Dreieck, rechte und untere nicht. Damit füllen
+ * aneinandergrenzende Dreiecke jedes Pixel genau einmal.
+ */
+static void fb_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, unsigned int color)
+{
+    long area = (long)(x2 - x1) * (y3 - y1) - (long)(y2 - y1) * (x3 - x1);
+    if (area == 0) return;
+    if (area < 0) { int t = x2; x2 = x3; x3 = t; t = y2; y2 = y3; y3 = t; }
+
+    int vx[3] = { x1, x2, x3 }, vy[3] = { y1, y2, y3 };
+    long A[3], B[3], C[3];
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        A[i] = vy[i] - vy[j];
+        B[i] = vx[j] - vx[i];
+        C[i] = -(A[i] * vx[i] + B[i] * vy[i]);
+        if (!(A[i] > 0 || (A[i] == 0 && B[i] > 0))) C[i] -= 1; // Nicht oben/links: E > 0
+    }
+
+    int ymin = y1, ymax = y1, xmin = x1, xmax = x1;
+    for (int i = 1; i < 3; i++) {
+        if (vy[i] < ymin) ymin = vy[i];
+        if (vy[i] > ymax) ymax = vy[i];
+        if (vx[i] < xmin) xmin = vx[i];
+        if (vx[i] > xmax) xmax = vx[i];
+    }
+    const FbRect *c = clip();
+    if (ymin < c->y1) ymin = c->y1;
+    if (ymax > c->y2) ymax = c->y2;
+    if (xmin < c->x1) xmin = c->x1;
+    if (xmax > c->x2) xmax = c->x2;
+
+    long e[3];
+    for (int i = 0; i < 3; i++) e[i] = B[i] * ymin + C[i];
+
+    for (int y = ymin; y <= ymax; y++) {
+        long left = xmin, right = xmax;
+        for (int i = 0; i < 3; i++) {
+            // A*x + e >= 0 nach x auflösen
+            if (A[i] > 0) {
+                long x = div_ceil(-e[i], A[i]);
+                if (x > left) left = x;
+            } else if (A[i] < 0) {
+                long x = div_floor(e[i], -A[i]);
+                if (x < right) right = x;
+            } else if (e[i] < 0) {
+                right = left - 1;
+            }
+            e[i] += B[i];
+        }
+        if (left <= right) fb_span(left, right, y, color);
+    }
+}
+
+void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, unsigned char attr, int fill)
+{
+    int xmin = x1 < x2 ? x1 : x2, xmax = x1 > x2 ? x1 : x2;
+    int ymin = y1 < y2 ? y1 : y2, ymax = y1 > y2 ? y1 : y2;
+    if (x3 < xmin) xmin = x3;
+    if (x3 > xmax) xmax = x3;
+    if (y3 < ymin) ymin = y3;
+    if (y3 > ymax) ymax = y3;
+    fb_before_draw(xmin, ymin, xmax, ymax);
+
+    if (fill) fb_fill_triangle(x1, y1, x2, y2, x3, y3, fb_colors[(attr & 0xf0) >> 4]);
+
+    unsigned int color = fb_colors[attr & 0x0f];
+    fb_line(x1, y1, x2, y2, color);
+    fb_line(x2, y2, x3, y3, color);
+    fb_line(x3, y3, x1, y1, color);
+    fb_dirty_rect(xmin, ymin, xmax, ymax);
+}
+
+#define POLY_MAX_EDGES 256
+
+// Kante für den Scanline-Füller. x wird exakt als xi + rem/dy geführt.
+typedef struct {
+    int ymin, ymax;  // Zeilen ymin..ymax-1
+    long xi, rem;    // Ganzzahlanteil und Rest in [0, dy)
+    long q, r, dy;   // Schritt pro Zeile: q + r/dy
+} PolyEdge;
+
+// Arbeitsspeicher je Core, da der Compositor Polygone parallel füllt
+typedef struct {
+    PolyEdge edges[POLY_MAX_EDGES];
+    PolyEdge *active[POLY_MAX_EDGES];
+    long xs[POLY_MAX_EDGES];
+} __attribute__((aligned(CACHE_LINE))) PolyScratch;
+
+static PolyScratch poly_scratch[SMP_MAX_CORES];
+
+/**
+ * Scanline-Füller mit Kantentabelle (Even-Odd-Regel), für konvexe und
+ * konkave Polygone. Die Kanten werden nach ymin sortiert, die aktive Liste
+ * pro Zeile nach x sortiert (Insertion Sort, die Reihenfolge ändert sich von
+ * Zeile zu Zeile kaum). Gleiche Pixelregel wie fb_fill_triangle.
+ */
+static void fb_fill_polygon(const int *points, int count, unsigned int color)
+{
+    if (count < 3 || count > POLY_MAX_EDGES) return;
+
+    PolyScratch *scratch = &poly_scratch[smp_core_id()];
+    PolyEdge *poly_edges = scratch->edges;
+    PolyEdge **poly_active = scratch->active;
+    long *poly_xs = scratch->xs;
+
+    int edges = 0, ystart = 0x7fffffff, yend = -0x7fffffff;
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        int xa = points[2 * i], ya = points[2 * i + 1];
+        int xb = points[2 * j], yb = points[2 * j + 1];
+        if (ya == yb) continue; // Waagerechte Kanten tragen nichts bei
+        if (ya > yb) { int t = xa; xa = xb; xb = t; t = ya; ya = yb; yb = t; }
+
+        PolyEdge e;
+        e.ymin = ya;
+        e.ymax = yb;
+        e.dy = yb - ya;
+        e.q = div_floor(xb - xa, e.dy);
+        e.r = (xb - xa) - e.q * e.dy;
+        e.xi = xa;
+        e.rem = 0;
+        if (ya < ystart) ystart = ya;
+        if (yb > yend) yend = yb;
+
+        // Nach ymin einsortieren
+        int k = edges++;
+        while (k > 0 && poly_edges[k - 1].ymin > e.ymin) {
+            poly_edges[k] = poly_edges[k - 1];
+            k--;
+        }
+        poly_edges[k] = e;
+    }
+    const FbRect *c = clip();
+    if (ystart < c->y1) ystart = c->y1;
+    if (yend > c->y2 + 1) yend = c->y2 + 1;
+
+    int next = 0, active = 0;
+    for (int y = ystart; y < yend; y++) {
+        // Neue Kanten aktivieren; oberhalb des Bildschirms beginnende vorspulen
+        while (next < edges && poly_edges[next].ymin <= y) {
+            PolyEdge *e = &poly_edges[next++];
+            if (e->ymax <= y) continue;
+            long skip = y - e->ymin;
+            if (skip > 0) {
+                long num = e->r * skip;
+                e->xi += e->q * skip + num / e->dy;
+                e->rem = num % e->dy;
+            }
+            poly_active[active++] = e;
+        }
+
+        // Beendete Kanten entfernen, x aufrunden und sortieren
+        int n = 0;
+        for (int i = 0; i < active; i++) {
+            PolyEdge *e = poly_active[i];
+            if (e->ymax <= y) continue;
+            poly_active[n] = e;
+            long x = e->xi + (e->rem > 0);
+            int k = n++;
+            while (k > 0 && poly_xs[k - 1] > x) {
+                poly_xs[k] = poly_xs[k - 1];
+                k--;
+            }
+            poly_xs[k] = x;
+        }
+        active = n;
+
+        for (int i = 0; i + 1 < active; i += 2) {
+            long xl = poly_xs[i], xr = poly_xs[i + 1] - 1;
+            if (xl < c->x1) xl = c->x1;
+            if (xr > c->x2) xr = c->x2;
+            if (xl <= xr) fb_span(xl, xr, y, color);
+        }
+
+        for (int i = 0; i < active; i++) {
+            PolyEdge *e = poly_active[i];
+            e->xi += e->q;
+            e->rem += e->r;
+            if (e->rem >= e->dy) {
+                e->rem -= e->dy;
+                e->xi++;
+            }
+        }
+    }
+}
+
+void drawPolygon(const int *points, int count, unsigned char attr, int fill)
+{
+    if (count < 2) return;
+
+    // Hülle nur, wenn sie gebraucht wird: für den Hook und die Füllung im Schattenpuffer
+    int xmin = points[0], xmax = points[0], ymin = points[1], ymax = points[1];
+    if (draw_hook || (fill && shadow)) {
+        for (int i = 1; i < count; i++) {
+            if (points[2 * i] < xmin) xmin = points[2 * i];
+            if (points[2 * i] > xmax) xmax = points[2 * i];
+            if (points[2 * i + 1] < ymin) ymin = points[2 * i + 1];
+            if (points[2 * i + 1] > ymax) ymax = points[2 * i + 1];
+        }
+        fb_before_draw(xmin, ymin, xmax, ymax);
+    }
+    if (fill) fb_fill_polygon(points, count, fb_colors[(attr & 0xf0) >> 4]);
+
+    unsigned int color = fb_colors[attr & 0x0f];
+    drawPolyline(points, count, attr);
+    fb_line(points[2 * count - 2], points[2 * count - 1], points[0], points[1], color);
+
+    if (fill && shadow) {
+        fb_dirty_rect(xmin, ymin, xmax, ymax);
+    } else {
+        fb_dirty_line(points[2 * count - 2], points[2 * count - 1], points[0], points[1]);
+    }
+}
+
+/**
+ * Füllt eine Ellipse zeilenweise: jede Zeile wird genau einmal als Span
+ * geschrieben. Die halbe Breite wird von der Mitte nach außen nur
+ * verkleinert, insgesamt also O(rx + ry) Schritte. Gefüllt wird
+ * x²·ry² + y²·rx² <= rx²·ry² + slack. Kreise nutzen slack = -r³
+ * (entspricht x² + y² <= r² - r), damit die Füllung im Umriss bleibt.
+ */
+static void fb_fill_ellipse(int x0, int y0, long rx, long ry, long slack, unsigned int color)
+{
+    long rx2 = rx * rx, ry2 = ry * ry;
+    long limit = rx2 * ry2 + slack;
+    long x = rx;
+
+    for (long dy = 0; dy <= ry; dy++) {
+        while (x >= 0 && x * x * ry2 + dy * dy * rx2 > limit) x--;
+        if (x < 0) break;
+        fb_hline(x0 - x, x0 + x, y0 + dy, color);
+        if (dy) fb_hline(x0 - x, x0 + x, y0 - dy, color);
     }
 }
 
@@ -111,22 +1001,21 @@ void drawCircle(int x0, int y0, int radius, unsigned char attr, int fill)
     int x = radius;
     int y = 0;
     int err = 0;
+
+    if (radius < 0) return;
+    fb_before_draw(x0 - radius, y0 - radius, x0 + radius, y0 + radius);
+    unsigned int color = fb_colors[attr & 0x0f];
+    if (fill) fb_fill_ellipse(x0, y0, radius, radius, -(long)radius * radius * radius, fb_colors[(attr & 0xf0) >> 4]);
  
     while (x >= y) {
-	if (fill) {
-	   drawLine(x0 - y, y0 + x, x0 + y, y0 + x, (attr & 0xf0) >> 4);
-	   drawLine(x0 - x, y0 + y, x0 + x, y0 + y, (attr & 0xf0) >> 4);
-	   drawLine(x0 - x, y0 - y, x0 + x, y0 - y, (attr & 0xf0) >> 4);
-	   drawLine(x0 - y, y0 - x, x0 + y, y0 - x, (attr & 0xf0) >> 4);
-	}
-	drawPixel(x0 - y, y0 + x, attr);
-	drawPixel(x0 + y, y0 + x, attr);
-	drawPixel(x0 - x, y0 + y, attr);
-        drawPixel(x0 + x, y0 + y, attr);
-	drawPixel(x0 - x, y0 - y, attr);
-	drawPixel(x0 + x, y0 - y, attr);
-	drawPixel(x0 - y, y0 - x, attr);
-	drawPixel(x0 + y, y0 - x, attr);
+	fb_pixel(x0 - y, y0 + x, color);
+	fb_pixel(x0 + y, y0 + x, color);
+	fb_pixel(x0 - x, y0 + y, color);
+        fb_pixel(x0 + x, y0 + y, color);
+	fb_pixel(x0 - x, y0 - y, color);
+	fb_pixel(x0 + x, y0 - y, color);
+	fb_pixel(x0 - y, y0 - x, color);
+	fb_pixel(x0 + y, y0 - x, color);
 
 	if (err <= 0) {
 	    y += 1;
@@ -138,21 +1027,83 @@ void drawCircle(int x0, int y0, int radius, unsigned char attr, int fill)
 	    err -= 2*x + 1;
 	}
     }
+    fb_dirty_rect(x0 - radius, y0 - radius, x0 + radius, y0 + radius);
+}
+
+static void ellipse_plot4(int x0, int y0, long x, long y, unsigned int color)
+{
+    fb_pixel(x0 + x, y0 + y, color);
+    fb_pixel(x0 - x, y0 + y, color);
+    fb_pixel(x0 + x, y0 - y, color);
+    fb_pixel(x0 - x, y0 - y, color);
+}
+
+// Mittelpunkt-Algorithmus für Ellipsen in zwei Bereichen (flach, dann steil)
+void drawEllipse(int x0, int y0, int rx, int ry, unsigned char attr, int fill)
+{
+    if (rx < 0 || ry < 0) return;
+    fb_before_draw(x0 - rx, y0 - ry, x0 + rx, y0 + ry);
+    if (fill) fb_fill_ellipse(x0, y0, rx, ry, 0, fb_colors[(attr & 0xf0) >> 4]);
+
+    unsigned int color = fb_colors[attr & 0x0f];
+    long rx2 = (long)rx * rx, ry2 = (long)ry * ry;
+    long x = 0, y = ry;
+    long px = 0, py = 2 * rx2 * y;
+
+    long p = ry2 - rx2 * ry + rx2 / 4;
+    while (px < py) {
+        ellipse_plot4(x0, y0, x, y, color);
+        x++;
+        px += 2 * ry2;
+        if (p < 0) {
+            p += ry2 + px;
+        } else {
+            y--;
+            py -= 2 * rx2;
+            p += ry2 + px - py;
+        }
+    }
+
+    p = (ry2 * (2 * x + 1) * (2 * x + 1)) / 4 + rx2 * (y - 1) * (y - 1) - rx2 * ry2;
+    while (y >= 0) {
+        ellipse_plot4(x0, y0, x, y, color);
+        y--;
+        py -= 2 * rx2;
+        if (p > 0) {
+            p += rx2 - py;
+        } else {
+            x++;
+            px += 2 * ry2;
+            p += rx2 - py + px;
+        }
+    }
+    fb_dirty_rect(x0 - rx, y0 - ry, x0 + rx, y0 + ry);
 }
 
 void drawChar(unsigned char ch, int x, int y, unsigned char attr)
 {
     unsigned char *glyph = (unsigned char *)&font + (ch < FONT_NUMGLYPHS ? ch : 0) * FONT_BPG;
+    const FbRect *c = clip();
+    fb_before_draw(x, y, x + FONT_WIDTH - 1, y + FONT_HEIGHT - 1);
+
+    // Vollständig sichtbar: Formatvariante ohne Clipping pro Pixel
+    if (x >= c->x1 && x + FONT_WIDTH - 1 <= c->x2 && y >= c->y1 && y + FONT_HEIGHT - 1 <= c->y2) {
+        fb_format->glyph(fb_addr(x, y), glyph, fb_colors[attr & 0x0f], fb_colors[(attr & 0xf0) >> 4]);
+        fb_count(FONT_WIDTH * FONT_HEIGHT);
+        fb_dirty_rect(x, y, x + FONT_WIDTH - 1, y + FONT_HEIGHT - 1);
+        return;
+    }
 
     for (int i=0;i<FONT_HEIGHT;i++) {
 	for (int j=0;j<FONT_WIDTH;j++) {
 	    unsigned char mask = 1 << j;
 	    unsigned char col = (*glyph & mask) ? attr & 0x0f : (attr & 0xf0) >> 4;
 
-	    drawPixel(x+j, y+i, col);
+	    fb_pixel(x+j, y+i, fb_colors[col]);
 	}
 	glyph += FONT_BPL;
     }
+    fb_dirty_rect(x, y, x + FONT_WIDTH - 1, y + FONT_HEIGHT - 1);
 }
 
 void drawString(int x, int y, char *s, unsigned char attr)
@@ -169,3 +1120,67 @@ void drawString(int x, int y, char *s, unsigned char attr)
        s++;
     }
 }
+
+// ##################################
+// ## Shell
+// ##################################
+
+static int cmd_fbmode(int argc, char **argv)
+{
+    if (argc == 1) {
+        console_putint(fb_depth());
+        console_puts(" bpp, ");
+        console_putint(fb_width());
+        console_puts("x");
+        console_putint(fb_height());
+        console_puts(", pitch ");
+        console_putint(fb_pitch());
+        console_puts("\n");
+        return SHELL_OK;
+    }
+    int bpp = argc == 2 ? simple_atoi(argv[1]) : 0;
+    if (bpp != 32 && bpp != 16 && bpp != 8) {
+        console_puts("Usage: fbmode [32|16|8]\n");
+        return SHELL_ERROR;
+    }
+    if (!fb_set_depth(bpp)) {
+        console_puts("Error: Mode not supported by the firmware\n");
+        return SHELL_ERROR;
+    }
+    fb_before_draw(0, 0, width - 1, height - 1);
+    for (unsigned int y = 0; y < height; y++) fb_span(0, width - 1, y, fb_colors[0]);
+    fb_dirty_rect(0, 0, width - 1, height - 1);
+    return SHELL_OK;
+}
+SHELL_COMMAND(fbmode, cmd_fbmode, "[32|16|8] - show or switch the framebuffer depth");
+
+static int cmd_fbshadow(int argc, char **argv)
+{
+    if (argc == 2 && (strcmp_simple(argv[1], "on") == 0 || strcmp_simple(argv[1], "off") == 0)) {
+        if (!fb_set_shadow(argv[1][1] == 'n')) {
+            console_puts("Error: Out of memory for the shadow buffer\n");
+            return SHELL_ERROR;
+        }
+        return SHELL_OK;
+    }
+    if (argc != 1) {
+        console_puts("Usage: fbshadow [on|off]\n");
+        return SHELL_ERROR;
+    }
+
+    // Die Ausgabe selbst wird geflusht und verändert die Statistik
+    FbStats st = stats;
+    console_puts(shadow ? "shadow on, " : "shadow off, ");
+    console_putlong(st.flushes);
+    console_puts(" flushes\nlast flush: ");
+    console_putlong(st.drawn);
+    console_puts(" bytes drawn, ");
+    console_putlong(st.flushed);
+    console_puts(" bytes flushed\ntotal: ");
+    console_putlong(st.total_drawn);
+    console_puts(" bytes drawn, ");
+    console_putlong(st.total_flushed);
+    console_puts(" bytes flushed\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(fbshadow, cmd_fbshadow, "[on|off] - cached shadow framebuffer and flush statistics");
@@ -0,0 +1,298 @@
+// src/files.c
+#include "initramfs.h"
+#include "fat.h"
+#include "blit.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+/*
+ * Shell-Befehle für Dateien. Pfade unter /sd liegen auf der FAT32-Partition
+ * der SD-Karte, alle anderen im initramfs. Gelesen wird in beiden Fällen
+ * stückweise, Dateien von der Karte werden also nie ganz geladen.
+ */
+
+// Geöffnete Datei aus einer der beiden Quellen
+typedef struct {
+    bool sd;
+    FatFile fat;
+    const char* data;       // initramfs
+    unsigned long size;
+    unsigned long pos;
+} File;
+
+// Verschachtelungstiefe von "run"
+#define RUN_MAX_DEPTH 8
+static int run_depth = 0;
+
+// ##################################
+// ## Dateien
+// ##################################
+
+// Pfad auf der Karte (ohne "/sd") oder NULL für das initramfs
+static const char* sd_path(const char* path) {
+    if (strncmp_simple(path, "/sd", 3) != 0) return NULL;
+    if (path[3] != '\0' && path[3] != '/') return NULL;
+    return path + 3;
+}
+
+// Öffnet eine reguläre Datei; NULL oder eine Fehlermeldung
+static const char* file_open(const char* path, File* f) {
+    const char* sub = sd_path(path);
+    f->sd = sub != NULL;
+    f->pos = 0;
+    if (f->sd) {
+        int err = fat_open(sub, &f->fat);
+        if (err == FAT_OK && f->fat.dir) err = FAT_ERR_IS_DIR;
+        return err == FAT_OK ? NULL : fat_error_string(err);
+    }
+
+    const InitramfsEntry* e = initramfs_find(path);
+    if (e == NULL) return "not found";
+    if (!initramfs_is_file(e)) return "is a directory";
+    f->data = e->data;
+    f->size = e->size;
+    return NULL;
+}
+
+// Passt als blit_read_t
+static long file_read(void* ctx, void* buffer, unsigned long n) {
+    File* f = ctx;
+    if (f->sd) return fat_read(&f->fat, buffer, n);
+
+    if (n > f->size - f->pos) n = f->size - f->pos;
+    memcpy(buffer, f->data + f->pos, n);
+    f->pos += n;
+    return n;
+}
+
+// Wie fat_read_line: volle Länge der Zeile, FAT_EOF am Ende oder -Fehlercode
+static int file_read_line(File* f, char* buffer, unsigned int size) {
+    if (f->sd) return fat_read_line(&f->fat, buffer, size);
+    if (f->pos >= f->size) return FAT_EOF;
+
+    unsigned int len = 0;
+    while (f->pos < f->size) {
+        char c = f->data[f->pos++];
+        if (c == '\n') break;
+        if (c != '\r') {
+            if (len < size - 1) buffer[len] = c;
+            len++;
+        }
+    }
+    buffer[len < size ? len : size - 1] = '\0';
+    return len;
+}
+
+static void print_error(const char* cmd, const char* path, const char* msg) {
+    console_puts(cmd);
+    console_puts(": ");
+    console_puts(path);
+    console_puts(": ");
+    console_puts(msg);
+    console_puts("\n");
+}
+
+// ##################################
+// ## Verzeichnisse
+// ##################################
+
+// Größe rechtsbündig (Verzeichnisse mit "-") und Name
+static void print_entry(const char* name, unsigned long size, bool dir) {
+    if (dir) {
+        console_puts("       -");
+    } else {
+        char buffer[21];
+        simple_ltoa(size, buffer);
+        for (unsigned int i = strlen_simple(buffer); i < 8; i++) console_puts(" ");
+        console_puts(buffer);
+    }
+    console_puts(" ");
+    console_puts(name);
+    console_puts(dir ? "/\n" : "\n");
+}
+
+static int list_sd(const char* path, const char* sub) {
+    FatFile dir;
+    int err = fat_open(sub, &dir);
+    if (err != FAT_OK) {
+        print_error("ls", path, fat_error_string(err));
+        return SHELL_ERROR;
+    }
+    if (!dir.dir) {
+        console_puts(path);
+        console_puts("\n");
+        return SHELL_OK;
+    }
+
+    FatDirEntry e;
+    while ((err = fat_readdir(&dir, &e)) > 0) {
+        if (e.attr & (FAT_ATTR_HIDDEN | FAT_ATTR_SYSTEM)) continue;
+        print_entry(e.name, e.size, e.attr & FAT_ATTR_DIRECTORY);
+    }
+    if (err < 0) {
+        print_error("ls", path, fat_error_string(-err));
+        return SHELL_ERROR;
+    }
+    return SHELL_OK;
+}
+
+static int list_initramfs(const char* path) {
+    // Die Wurzel hat keinen eigenen Eintrag im Archiv
+    const char* p = path;
+    while (*p == '/' || (p[0] == '.' && (p[1] == '/' || p[1] == '\0'))) p++;
+
+    const char* dir = "";
+    unsigned int len = 0;
+    if (*p != '\0') {
+        const InitramfsEntry* e = initramfs_find(path);
+        if (e == NULL) {
+            print_error("ls", path, "not found");
+            return SHELL_ERROR;
+        }
+        if (!initramfs_is_dir(e)) {
+            console_puts(e->name);
+            console_puts("\n");
+            return SHELL_OK;
+        }
+        dir = e->name;
+        len = strlen_simple(dir);
+    } else if (fat_mounted()) {
+        print_entry("sd", 0, true);
+    }
+
+    for (unsigned int n = 0; n < initramfs_count(); n++) {
+        const InitramfsEntry* e = initramfs_entry(n);
+        const char* name = e->name;
+        if (len > 0) {
+            if (strncmp_simple(name, dir, len) != 0 || name[len] != '/') continue;
+            name += len + 1;
+        }
+        const char* q = name;
+        while (*q != '\0' && *q != '/') q++;
+        if (*q == '/') continue; // Tiefer verschachtelt
+
+        print_entry(name, e->size, initramfs_is_dir(e));
+    }
+    return SHELL_OK;
+}
+
+// "ls [dir]": direkte Einträge eines Verzeichnisses
+static int cmd_ls(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "";
+    const char* sub = sd_path(path);
+    return sub != NULL ? list_sd(path, sub) : list_initramfs(path);
+}
+SHELL_COMMAND(ls, cmd_ls, "[dir] - list files (initramfs, SD card under /sd)");
+
+// ##################################
+// ## Dateien ausgeben und ausführen
+// ##################################
+
+static int cmd_cat(int argc, char** argv) {
+    if (argc < 2) {
+        console_puts("Usage: cat <file> [<file> ...]\n");
+        return SHELL_ERROR;
+    }
+    for (int i = 1; i < argc; i++) {
+        File f;
+        const char* err = file_open(argv[i], &f);
+        if (err != NULL) {
+            print_error("cat", argv[i], err);
+            return SHELL_ERROR;
+        }
+        char buffer[512];
+        long n;
+        while ((n = file_read(&f, buffer, sizeof(buffer))) > 0) console_write(buffer, n);
+        if (n < 0) {
+            print_error("cat", argv[i], fat_error_string(-n));
+            return SHELL_ERROR;
+        }
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(cat, cmd_cat, "<file> [<file> ...] - print files");
+
+// "run: script:N: msg"
+static void print_line_error(const char* path, int line_no, const char* msg) {
+    console_puts("run: ");
+    console_puts(path);
+    console_puts(":");
+    console_putint(line_no);
+    console_puts(": ");
+    console_puts(msg);
+    console_puts("\n");
+}
+
+/**
+ * "run <script>": führt ein Skript Zeile für Zeile aus. Leere Zeilen und
+ * Zeilen mit '#' am Anfang werden übersprungen, beim ersten
+ * fehlgeschlagenen Befehl, einer zu langen Zeile oder einem Lesefehler
+ * bricht das Skript mit SHELL_ERROR ab.
+ */
+static int cmd_run(int argc, char** argv) {
+    if (argc != 2) {
+        console_puts("Usage: run <script>\n");
+        return SHELL_ERROR;
+    }
+    File f;
+    const char* err = file_open(argv[1], &f);
+    if (err != NULL) {
+        print_error("run", argv[1], err);
+        return SHELL_ERROR;
+    }
+    if (run_depth == RUN_MAX_DEPTH) {
+        console_puts("run: scripts nested too deeply\n");
+        return SHELL_ERROR;
+    }
+
+    // Eigener Puffer pro Zeile, shell_execute zerlegt ihn an Ort und Stelle
+    char line[256];
+    int len = 0, line_no = 0, status = SHELL_OK;
+    run_depth++;
+    while (status == SHELL_OK && (len = file_read_line(&f, line, sizeof(line))) >= 0) {
+        line_no++;
+        // Eine abgeschnittene Zeile wäre ein anderer Befehl
+        if (len >= (int)sizeof(line)) {
+            print_line_error(argv[1], line_no, "line too long (max 255 characters)");
+            status = SHELL_ERROR;
+            break;
+        }
+        for (int i = 0; i < len; i++) {
+            if (line[i] == '\t') line[i] = ' ';
+        }
+        if (len == 0 || line[0] == '#') continue;
+
+        status = shell_execute(line);
+        if (status != SHELL_OK) print_line_error(argv[1], line_no, "command failed");
+    }
+    if (len < 0 && len != FAT_EOF) {
+        print_error("run", argv[1], fat_error_string(-len));
+        status = SHELL_ERROR;
+    }
+    run_depth--;
+    return status;
+}
+SHELL_COMMAND(run, cmd_run, "<script> - run shell commands from a file");
+
+// "show <file> [x y]": zeichnet ein Bild im Asset-Format (tools/mkasset)
+static int cmd_show(int argc, char** argv) {
+    if (argc != 2 && argc != 4) {
+        console_puts("Usage: show <file> [x y]\n");
+        return SHELL_ERROR;
+    }
+    File f;
+    const char* err = file_open(argv[1], &f);
+    if (err != NULL) {
+        print_error("show", argv[1], err);
+        return SHELL_ERROR;
+    }
+    int x = argc == 4 ? simple_atoi(argv[2]) : 0;
+    int y = argc == 4 ? simple_atoi(argv[3]) : 0;
+    if (blit_stream(file_read, &f, x, y) != 0) {
+        print_error("show", argv[1], "not an image or read error");
+        return SHELL_ERROR;
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(show, cmd_show, "<file> [x y] - draw an image file (mkasset format)");
@@ -1,69 +1,44 @@
 #include "gpio.h"
 
-// Private Enums und Defines, die nur hier gebraucht werden
-enum {
-    GPFSEL0         = PERIPHERAL_BASE + 0x200000,
-    GPSET0          = PERIPHERAL_BASE + 0x20001C,
-    GPCLR0          = PERIPHERAL_BASE + 0x200028,
-    GPPUPPDN0       = PERIPHERAL_BASE + 0x2000E4
-};// ... alle anderen enums wie GPIO_FUNCTION_OUT, Pull_None etc. ...
-  
-enum {
-    GPIO_MAX_PIN        = 53,
-    GPIO_FUNCTION_OUT   = 1,
-    GPIO_FUNCTION_ALT5  = 2,
-    GPIO_FUNCTION_ALT3  = 7
-};
+// Die Einzelpin-Funktionen sind static inline in gpio.h.
 
 enum {
-    Pull_None = 0,
-    Pull_Down = 2,
-    Pull_Up   = 1
+    GPFSEL_COUNT    = 6,    // 10 Pins pro Register, 3 Bit pro Pin
+    GPPUPPDN_COUNT  = 4     // 16 Pins pro Register, 2 Bit pro Pin
 };
 
+/**
+ * Sammelt erst alle Änderungen pro Register und schreibt dann jedes
+ * betroffene GPFSEL- und GPPUPPDN-Register genau einmal.
+ */
+void gpio_configure(const GpioPinConfig* pins, unsigned int count) {
+    unsigned int fsel_mask[GPFSEL_COUNT] = { 0 };
+    unsigned int fsel_value[GPFSEL_COUNT] = { 0 };
+    unsigned int pull_mask[GPPUPPDN_COUNT] = { 0 };
+    unsigned int pull_value[GPPUPPDN_COUNT] = { 0 };
+
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int pin = pins[i].pin;
+        if (pin > GPIO_MAX_PIN || pins[i].function > 7 || pins[i].pull > 3) continue;
+
+        RegField fsel = GPIO_PIN_FIELD(0, pin, 3);
+        fsel_mask[pin / 10] |= mmio_field_mask(fsel);
+        fsel_value[pin / 10] = (fsel_value[pin / 10] & ~mmio_field_mask(fsel)) | ((unsigned int)pins[i].function << fsel.shift);
+
+        RegField pull = GPIO_PIN_FIELD(0, pin, 2);
+        pull_mask[pin / 16] |= mmio_field_mask(pull);
+        pull_value[pin / 16] = (pull_value[pin / 16] & ~mmio_field_mask(pull)) | ((unsigned int)pins[i].pull << pull.shift);
+    }
 
-void mmio_write(long reg, unsigned int val) { *(volatile unsigned int *)reg = val; }
-unsigned int mmio_read(long reg) { return *(volatile unsigned int *)reg; }
-
-unsigned int gpio_call(unsigned int pin_number, unsigned int value, unsigned int base, unsigned int field_size, unsigned int field_max) {
-    unsigned int field_mask = (1 << field_size) - 1;
-  
-    if (pin_number > field_max) return 0;
-    if (value > field_mask) return 0; 
-
-    unsigned int num_fields = 32 / field_size;
-    unsigned int reg = base + ((pin_number / num_fields) * 4);
-    unsigned int shift = (pin_number % num_fields) * field_size;
-
-    unsigned int curval = mmio_read(reg);
-    curval &= ~(field_mask << shift);
-    curval |= value << shift;
-    mmio_write(reg, curval);
-
-    return 1;
-}
-
-unsigned int gpio_set       (unsigned int pin_number, unsigned int value) { return gpio_call(pin_number, value, GPSET0, 1, GPIO_MAX_PIN); }
-unsigned int gpio_clear     (unsigned int pin_number, unsigned int value) { return gpio_call(pin_number, value, GPCLR0, 1, GPIO_MAX_PIN); }
-unsigned int gpio_pull      (unsigned int pin_number, unsigned int value) { return gpio_call(pin_number, value, GPPUPPDN0, 2, GPIO_MAX_PIN); }
-unsigned int gpio_function  (unsigned int pin_number, unsigned int value) { return gpio_call(pin_number, value, GPFSEL0, 3, GPIO_MAX_PIN); }
-
-void gpio_useAsAlt5(unsigned int pin_number) {
-    gpio_pull(pin_number, Pull_None);
-    gpio_function(pin_number, GPIO_FUNCTION_ALT5);
-}
-
-void gpio_initOutputPinWithPullNone(unsigned int pin_number) {
-    gpio_pull(pin_number, Pull_None);
-    gpio_function(pin_number, GPIO_FUNCTION_OUT);
-}
-
-void gpio_setPinOutputBool(unsigned int pin_number, unsigned int onOrOff) {
-    if (onOrOff) {
-        gpio_set(pin_number, 1);
-    } else {
-        gpio_clear(pin_number, 1);
+    // Wie bei den Einzel-Funktionen: erst Pull, dann Funktion
+    for (unsigned int r = 0; r < GPPUPPDN_COUNT; r++) {
+        if (pull_mask[r] == 0) continue;
+        long reg = GPPUPPDN0 + r * 4;
+        mmio_write(reg, (mmio_read(reg) & ~pull_mask[r]) | pull_value[r]);
+    }
+    for (unsigned int r = 0; r < GPFSEL_COUNT; r++) {
+        if (fsel_mask[r] == 0) continue;
+        long reg = GPFSEL0 + r * 4;
+        mmio_write(reg, (mmio_read(reg) & ~fsel_mask[r]) | fsel_value[r]);
     }
 }
-
-// ... Implementierung von mmio_write, mmio_read, gpio_call, gpio_set etc. ...
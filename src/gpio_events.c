@@ -0,0 +1,237 @@
+// src/gpio_events.c
+#include "gpio_events.h"
+#include "gpio.h"
+#include "irq.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "uart.h"
+
+// ##################################
+// ## Register
+// ##################################
+
+// Registeradressen siehe regs.h
+
+// Reihenfolge wie die GPIO_EVENT_...-Bits
+static const long event_enable_regs[] = { GPREN0, GPFEN0, GPHEN0, GPLEN0, GPAREN0, GPAFEN0 };
+#define EVENT_TYPE_COUNT 6
+#define GPIO_PIN_COUNT   (GPIO_MAX_PIN + 1)
+
+// ##################################
+// ## Queue und Statistik
+// ##################################
+
+#define EVENT_QUEUE_SIZE 1024 // Zweierpotenz
+
+static GpioEvent event_queue[EVENT_QUEUE_SIZE];
+static unsigned int event_queue_head = 0; // Nur der Interrupt schreibt
+static unsigned int event_queue_tail = 0; // Nur die Hauptschleife schreibt
+
+static gpio_event_callback_t pin_callbacks[GPIO_PIN_COUNT];
+static unsigned char pin_types[GPIO_PIN_COUNT];
+static volatile unsigned long pin_events[GPIO_PIN_COUNT];
+static volatile unsigned long pin_dropped[GPIO_PIN_COUNT];
+
+// Stand beim letzten 'gpioev', für die Rate
+static unsigned long stats_last_ticks = 0;
+static unsigned long stats_last_events[GPIO_PIN_COUNT];
+
+// ##################################
+// ## Interrupt
+// ##################################
+
+static void event_push(const GpioEvent* event) {
+    unsigned int head = event_queue_head;
+    unsigned int tail = __atomic_load_n(&event_queue_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= EVENT_QUEUE_SIZE) {
+        pin_dropped[event->pin]++;
+        return;
+    }
+    event_queue[head & (EVENT_QUEUE_SIZE - 1)] = *event;
+    __atomic_store_n(&event_queue_head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void handle_bank(unsigned int bank, unsigned long now) {
+    unsigned int status = mmio_read(GPEDS0 + bank * 4);
+    if (status == 0) return;
+
+    // Sofort löschen, damit währenddessen neue Flanken wieder erkannt werden
+    mmio_write(GPEDS0 + bank * 4, status);
+    unsigned int levels = mmio_read(GPLEV0 + bank * 4);
+
+    while (status) {
+        unsigned int bit = __builtin_ctz(status);
+        status &= status - 1;
+
+        GpioEvent event;
+        event.timestamp = now;
+        event.pin = bank * 32 + bit;
+        event.level = (levels >> bit) & 1;
+        if (event.pin > GPIO_MAX_PIN) continue;
+
+        pin_events[event.pin]++;
+        if (pin_types[event.pin] & (GPIO_EVENT_HIGH | GPIO_EVENT_LOW)) {
+            // Pegelerkennung ist one-shot, siehe gpio_events.h
+            mmio_write(GPHEN0 + bank * 4, mmio_read(GPHEN0 + bank * 4) & ~(1u << bit));
+            mmio_write(GPLEN0 + bank * 4, mmio_read(GPLEN0 + bank * 4) & ~(1u << bit));
+        }
+        if (pin_callbacks[event.pin] != NULL) {
+            pin_callbacks[event.pin](&event);
+        }
+        event_push(&event);
+    }
+}
+
+// Die drei Bank-Interrupts teilen die Pins anders auf als die Register.
+// Beide Status-Register zu lesen ist billiger als die Aufteilung nachzubilden.
+static void gpio_irq(unsigned int id) {
+    unsigned long now = timer_ticks();
+    handle_bank(0, now);
+    handle_bank(1, now);
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void gpio_events_init() {
+    for (unsigned int bank = 0; bank < 2; bank++) {
+        for (unsigned int t = 0; t < EVENT_TYPE_COUNT; t++) {
+            mmio_write(event_enable_regs[t] + bank * 4, 0);
+        }
+        mmio_write(GPEDS0 + bank * 4, 0xFFFFFFFF);
+    }
+    irq_register(IRQ_GPIO_BANK0, gpio_irq);
+    irq_register(IRQ_GPIO_BANK1, gpio_irq);
+    irq_register(IRQ_GPIO_BANK2, gpio_irq);
+}
+
+bool gpio_event_enable(unsigned int pin, unsigned int types, gpio_event_callback_t callback) {
+    if (pin > GPIO_MAX_PIN || types == 0 || types >= (1u << EVENT_TYPE_COUNT)) return false;
+
+    unsigned int bank = pin / 32;
+    unsigned int bit = 1u << (pin % 32);
+
+    unsigned long flags = irq_save();
+    pin_callbacks[pin] = callback;
+    pin_types[pin] = types;
+    for (unsigned int t = 0; t < EVENT_TYPE_COUNT; t++) {
+        long reg = event_enable_regs[t] + bank * 4;
+        unsigned int value = mmio_read(reg);
+        mmio_write(reg, (types & (1u << t)) ? value | bit : value & ~bit);
+    }
+    irq_restore(flags);
+    return true;
+}
+
+void gpio_event_disable(unsigned int pin) {
+    if (pin > GPIO_MAX_PIN) return;
+
+    unsigned int bank = pin / 32;
+    unsigned int bit = 1u << (pin % 32);
+
+    unsigned long flags = irq_save();
+    for (unsigned int t = 0; t < EVENT_TYPE_COUNT; t++) {
+        long reg = event_enable_regs[t] + bank * 4;
+        mmio_write(reg, mmio_read(reg) & ~bit);
+    }
+    mmio_write(GPEDS0 + bank * 4, bit);
+    pin_types[pin] = 0;
+    pin_callbacks[pin] = NULL;
+    irq_restore(flags);
+}
+
+bool gpio_event_pop(GpioEvent* event) {
+    unsigned int tail = event_queue_tail;
+    unsigned int head = __atomic_load_n(&event_queue_head, __ATOMIC_ACQUIRE);
+    if (tail == head) return false;
+
+    *event = event_queue[tail & (EVENT_QUEUE_SIZE - 1)];
+    __atomic_store_n(&event_queue_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool gpio_events_update() {
+    GpioEvent event;
+    bool any = false;
+    while (gpio_event_pop(&event)) any = true;
+    return any;
+}
+
+// ##################################
+// ## Shell-Befehl
+// ##################################
+
+static unsigned int parse_types(const char* name) {
+    if (strcmp_simple(name, "rising") == 0)   return GPIO_EVENT_RISING;
+    if (strcmp_simple(name, "falling") == 0)  return GPIO_EVENT_FALLING;
+    if (strcmp_simple(name, "both") == 0)     return GPIO_EVENT_RISING | GPIO_EVENT_FALLING;
+    if (strcmp_simple(name, "high") == 0)     return GPIO_EVENT_HIGH;
+    if (strcmp_simple(name, "low") == 0)      return GPIO_EVENT_LOW;
+    if (strcmp_simple(name, "arising") == 0)  return GPIO_EVENT_ASYNC_RISING;
+    if (strcmp_simple(name, "afalling") == 0) return GPIO_EVENT_ASYNC_FALLING;
+    if (strcmp_simple(name, "aboth") == 0)    return GPIO_EVENT_ASYNC_RISING | GPIO_EVENT_ASYNC_FALLING;
+    return 0;
+}
+
+static void print_stats() {
+    unsigned long now = timer_ticks();
+    unsigned long elapsed_us = timer_ticks_to_us(now - stats_last_ticks);
+    if (elapsed_us == 0) elapsed_us = 1;
+
+    console_puts("pin      events    events/s     dropped\n");
+    for (unsigned int pin = 0; pin < GPIO_PIN_COUNT; pin++) {
+        unsigned long events = pin_events[pin];
+        if (pin_types[pin] == 0 && events == 0) continue;
+
+        console_putint(pin);
+        console_puts("\t ");
+        console_putlong(events);
+        console_puts("\t ");
+        console_putlong((events - stats_last_events[pin]) * 1000000 / elapsed_us);
+        console_puts("\t ");
+        console_putlong(pin_dropped[pin]);
+        console_puts("\n");
+        stats_last_events[pin] = events;
+    }
+    stats_last_ticks = now;
+}
+
+/**
+ * gpioev                       Statistik (Rate seit dem letzten Aufruf)
+ * gpioev on <pin> <type>       Erkennung einschalten
+ * gpioev off <pin>             Erkennung ausschalten
+ * gpioev watch                 Ereignisse live ausgeben, Ende mit einer Taste
+ */
+static int cmd_gpioev(int argc, char** argv) {
+    if (argc == 1) {
+        print_stats();
+        return SHELL_OK;
+    }
+    if (strcmp_simple(argv[1], "on") == 0 && argc == 4) {
+        unsigned int types = parse_types(argv[3]);
+        if (types != 0 && gpio_event_enable(simple_atoi(argv[2]), types, NULL)) {
+            console_puts("OK.\n");
+            return SHELL_OK;
+        }
+    } else if (strcmp_simple(argv[1], "off") == 0 && argc == 3) {
+        gpio_event_disable(simple_atoi(argv[2]));
+        console_puts("OK.\n");
+        return SHELL_OK;
+    } else if (strcmp_simple(argv[1], "watch") == 0) {
+        GpioEvent event;
+        unsigned char key;
+        while (!uart_read_byte(&key)) {
+            if (!gpio_event_pop(&event)) continue;
+            console_putlong(timer_ticks_to_us(event.timestamp));
+            console_puts(" us: pin ");
+            console_putint(event.pin);
+            console_puts(event.level ? " high\n" : " low\n");
+        }
+        return SHELL_OK;
+    }
+    console_puts("Usage: gpioev [on <pin> rising|falling|both|high|low|arising|afalling|aboth | off <pin> | watch]\n");
+    return SHELL_ERROR;
+}
+SHELL_COMMAND(gpioev, cmd_gpioev, "[on <pin> <type> | off <pin> | watch] - GPIO event detection and rates");
@@ -0,0 +1,162 @@
+// src/initramfs.c
+#include "initramfs.h"
+#include "mem.h"
+#include "string_utils.h"
+
+// Grenzen der Section .initramfs (siehe link.ld)
+extern const char __initramfs_start[];
+extern const char __initramfs_end[];
+
+#define CPIO_HEADER_SIZE 110
+#define CPIO_TRAILER     "TRAILER!!!"
+
+// Feldnummern im newc-Header (je 8 Hex-Ziffern nach der 6-stelligen Magic)
+enum {
+    CPIO_MODE     = 1,
+    CPIO_FILESIZE = 6,
+    CPIO_NAMESIZE = 11
+};
+
+static InitramfsEntry* entries = NULL;
+static unsigned int entry_count = 0;
+
+// Offene Adressierung wie die Befehlstabelle der Shell
+static const InitramfsEntry** path_index = NULL;
+static unsigned int index_mask = 0;
+
+// ##################################
+// ## Archiv lesen
+// ##################################
+
+static unsigned long cpio_field(const char* header, int field) {
+    const char* p = header + 6 + field * 8;
+    unsigned long value = 0;
+    for (int i = 0; i < 8; i++) {
+        char c = p[i];
+        unsigned int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return 0;
+        value = value << 4 | digit;
+    }
+    return value;
+}
+
+static inline unsigned long align4(unsigned long offset) {
+    return (offset + 3) & ~3UL;
+}
+
+// "./" und "/" am Anfang überspringen
+static const char* skip_prefix(const char* path) {
+    while (1) {
+        if (path[0] == '/') path++;
+        else if (path[0] == '.' && path[1] == '/') path += 2;
+        else return path;
+    }
+}
+
+/**
+ * Läuft einmal über das Archiv. Mit out == NULL wird nur gezählt, sonst
+ * werden die Einträge gefüllt. Verzeichniseinträge "." werden übersprungen.
+ */
+static unsigned int cpio_scan(InitramfsEntry* out) {
+    unsigned long size = __initramfs_end - __initramfs_start;
+    unsigned long offset = 0;
+    unsigned int count = 0;
+
+    while (offset + CPIO_HEADER_SIZE <= size) {
+        const char* header = __initramfs_start + offset;
+        if (memcmp(header, "070701", 6) != 0 && memcmp(header, "070702", 6) != 0) break;
+
+        unsigned long namesize = cpio_field(header, CPIO_NAMESIZE);
+        unsigned long filesize = cpio_field(header, CPIO_FILESIZE);
+        unsigned long name_offset = offset + CPIO_HEADER_SIZE;
+        unsigned long data_offset = align4(name_offset + namesize);
+        if (namesize == 0 || data_offset + filesize > size) break;
+
+        const char* name = __initramfs_start + name_offset;
+        if (name[namesize - 1] != '\0') break;
+        if (strcmp_simple(name, CPIO_TRAILER) == 0) break;
+
+        name = skip_prefix(name);
+        if (name[0] != '\0' && strcmp_simple(name, ".") != 0) {
+            if (out != NULL) {
+                out[count].name = name;
+                out[count].data = __initramfs_start + data_offset;
+                out[count].size = filesize;
+                out[count].mode = cpio_field(header, CPIO_MODE);
+            }
+            count++;
+        }
+        offset = align4(data_offset + filesize);
+    }
+    return count;
+}
+
+void initramfs_init() {
+    unsigned int count = cpio_scan(NULL);
+    if (count == 0) return;
+
+    unsigned int size = 4;
+    while (size < 2 * count) size *= 2;
+    entries = mem_alloc(count * sizeof(InitramfsEntry));
+    path_index = mem_alloc(size * sizeof(const InitramfsEntry*));
+    if (entries == NULL || path_index == NULL) {
+        path_index = NULL;
+        return;
+    }
+    memset(path_index, 0, size * sizeof(const InitramfsEntry*));
+    index_mask = size - 1;
+    entry_count = cpio_scan(entries);
+
+    for (unsigned int n = 0; n < entry_count; n++) {
+        const InitramfsEntry* e = &entries[n];
+        unsigned int i = hash_string(e->name) & index_mask;
+        while (path_index[i] != NULL) i = (i + 1) & index_mask;
+        path_index[i] = e;
+    }
+}
+
+// ##################################
+// ## Zugriff
+// ##################################
+
+// Sucht path[0..len-1]; so braucht ein abschließendes "/" keine Kopie
+static const InitramfsEntry* find_entry(const char* path, unsigned int len) {
+    if (path_index == NULL) return NULL;
+
+    unsigned int i = hash_string_n(path, len) & index_mask;
+    while (path_index[i] != NULL) {
+        const char* name = path_index[i]->name;
+        if (strncmp_simple(name, path, len) == 0 && name[len] == '\0') return path_index[i];
+        i = (i + 1) & index_mask;
+    }
+    return NULL;
+}
+
+static unsigned int path_length(const char* path) {
+    unsigned int len = strlen_simple(path);
+    while (len > 0 && path[len - 1] == '/') len--;
+    return len;
+}
+
+const InitramfsEntry* initramfs_find(const char* path) {
+    path = skip_prefix(path);
+    return find_entry(path, path_length(path));
+}
+
+const void* initramfs_data(const char* path, unsigned long* size) {
+    const InitramfsEntry* e = initramfs_find(path);
+    if (e == NULL || !initramfs_is_file(e)) return NULL;
+    *size = e->size;
+    return e->data;
+}
+
+unsigned int initramfs_count() {
+    return entry_count;
+}
+
+const InitramfsEntry* initramfs_entry(unsigned int i) {
+    return i < entry_count ? &entries[i] : NULL;
+}
@@ -0,0 +1,119 @@
+// src/irq.c
+#include "irq.h"
+#include "regs.h"
+#include "console.h"
+#include "uart.h"
+
+// ##################################
+// ## GIC-400 Register
+// ##################################
+
+// Registeradressen siehe regs.h
+
+#define GIC_SPURIOUS     1020
+#define GIC_PRIORITY     0xA0   // Für alle Interrupts gleich, keine Verschachtelung
+#define GIC_PRIORITY_ALL 0xF0   // Maske im CPU-Interface: alles durchlassen
+
+static irq_handler_t irq_handlers[IRQ_MAX];
+static unsigned int irq_lines = 0;
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void irq_init() {
+    mmio_write(GICD_CTLR, 0);
+
+    irq_lines = (mmio_field_get(GICD_TYPER_IT_LINES) + 1) * 32;
+    if (irq_lines > IRQ_MAX) irq_lines = IRQ_MAX;
+
+    // Alle Shared Peripheral Interrupts (ab ID 32) aus, nicht anstehend,
+    // pegelgesteuert, an Core 0 und mit gleicher Priorität
+    for (unsigned int id = 32; id < irq_lines; id += 32) {
+        mmio_write(GICD_ICENABLER + id / 8, 0xFFFFFFFF);
+        mmio_write(GICD_ICPENDR + id / 8, 0xFFFFFFFF);
+    }
+    for (unsigned int id = 32; id < irq_lines; id += 16) {
+        mmio_write(GICD_ICFGR + id / 4, 0);
+    }
+    for (unsigned int id = 32; id < irq_lines; id += 4) {
+        mmio_write(GICD_IPRIORITYR + id, GIC_PRIORITY * 0x01010101u);
+        mmio_write(GICD_ITARGETSR + id, 0x01010101);
+    }
+
+    mmio_write(GICD_CTLR, 1);
+    mmio_write(GICC_PMR, GIC_PRIORITY_ALL);
+    mmio_write(GICC_CTLR, 1);
+}
+
+bool irq_register(unsigned int id, irq_handler_t handler) {
+    if (id >= irq_lines || handler == NULL) return false;
+    irq_handlers[id] = handler;
+    mmio_write(GICD_ISENABLER + (id / 32) * 4, 1u << (id % 32));
+    return true;
+}
+
+void irq_unregister(unsigned int id) {
+    if (id >= irq_lines) return;
+    mmio_write(GICD_ICENABLER + (id / 32) * 4, 1u << (id % 32));
+    irq_handlers[id] = NULL;
+}
+
+void irq_enable() {
+    asm volatile("msr daifclr, #2" ::: "memory");
+}
+
+void irq_disable() {
+    asm volatile("msr daifset, #2" ::: "memory");
+}
+
+unsigned long irq_save() {
+    unsigned long flags;
+    asm volatile("mrs %0, daif; msr daifset, #2" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+void irq_restore(unsigned long flags) {
+    asm volatile("msr daif, %0" :: "r"(flags) : "memory");
+}
+
+// ##################################
+// ## Aufrufe aus vectors.S
+// ##################################
+
+void irq_handle() {
+    // Alle anstehenden Interrupts abarbeiten, bevor wir zurückkehren
+    while (1) {
+        unsigned int iar = mmio_read_acquire(GICC_IAR);
+        unsigned int id = mmio_field_extract(GICC_IAR_ID, iar);
+        if (id >= GIC_SPURIOUS) break;
+
+        if (id < IRQ_MAX && irq_handlers[id] != NULL) {
+            irq_handlers[id](id);
+        }
+        mmio_write_release(GICC_EOIR, iar);
+    }
+}
+
+static void put_hex64(unsigned long value) {
+    console_puthex((unsigned int)(value >> 32));
+    console_puts(":");
+    console_puthex((unsigned int)value);
+}
+
+void exception_report(unsigned long type, unsigned long esr, unsigned long elr, unsigned long far) {
+    console_set_mute(false);
+    console_puts("\n*** Unexpected exception, vector ");
+    console_putint((int)type);
+    console_puts("\n    ESR: ");
+    put_hex64(esr);
+    console_puts("\n    ELR: ");
+    put_hex64(elr);
+    console_puts("\n    FAR: ");
+    put_hex64(far);
+    console_puts("\n    System halted.\n");
+    uart_flush();
+    while (1) {
+        asm volatile("wfe");
+    }
+}
@@ -2,13 +2,47 @@
 #include "uart.h"
 #include "shell.h"
 #include "fb.h"
+#include "cursor.h"
+#include "mem.h"
+#include "irq.h"
+#include "gpio_events.h"
+#include "blit.h"
+#include "mmu.h"
+#include "smp.h"
+#include "clock.h"
+#include "initramfs.h"
+#include "sd.h"
+#include "bcache.h"
+#include "fat.h"
+#include "pvars.h"
+#include "timer.h"
+#include "string_utils.h"
 
 void kernel_main() {
+    mem_init();
+    mmu_init();
     uart_init();
+    clock_init();
     shell_init();
+    initramfs_init();
     fb_init();
+    cursor_init();
+    if (sd_init() == SD_OK) { // Ohne Karte geht es ohne Speicher weiter
+        bcache_init();
+        if (fat_mount() == FAT_OK) pvars_mount(); // Variablen aus vars.log
+    }
+    smp_init();
+    irq_init();
+    gpio_events_init();
+    irq_enable();
 
-    uart_writeText("Welcome to OhneBS!\n");
+    // Der Systemzähler läuft ab dem Einschalten: so lassen sich das normale
+    // und das komprimierte Image (make zimage) direkt vergleichen
+    char boot_ms[21];
+    simple_ltoa(timer_ticks_to_us(timer_ticks()) / 1000, boot_ms);
+    uart_writeText("Welcome to OhneBS! (");
+    uart_writeText(boot_ms);
+    uart_writeText(" ms since power-on)\n");
     drawRect(150,150,400,400,0x03,0);
     drawRect(300,300,350,350,0x2e,1);
 
@@ -21,9 +55,20 @@ void kernel_main() {
     drawString(100,100,"Hello world!",0x0f);
 
     drawLine(100,500,350,700,0x0c);
+
+    int star[] = { 1500,200, 1560,380, 1400,270, 1600,270, 1440,380, 1500,200 };
+    drawPolyline(star, 6, 0x0a);
+
+    drawTriangle(1400,600, 1700,650, 1520,900, 0x4e,1);
+    drawEllipse(600,850,200,80,0x5d,1);
+
+    blit(blit_find("logo"), 1760, 40);
+    blit(blit_find("warning"), 1700, 72);
     
     while (1) {
-        shell_update(); // Die richtige Update-Funktion aufrufen
-
+        bool busy = shell_update(); // Die richtige Update-Funktion aufrufen
+        busy |= gpio_events_update();
+        busy |= pvars_update();
+        clock_governor_update(busy);
     }
 }
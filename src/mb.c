@@ -1,21 +1,16 @@
 // Mailboxes for screen output
 
-#include "gpio.h"
+#include "mmio.h"
+#include "regs.h"
+#include "mmu.h"
 
-// The buffer must be 16-byte aligned as only the upper 28 bits of the address can be passed via the mailbox
-volatile unsigned int __attribute__((aligned(16))) mbox[36];
+// The buffer must be 16-byte aligned as only the upper 28 bits of the address can be passed via the mailbox.
+// With the data cache on it also must not share a cache line with anything else,
+// so it is aligned to and padded up to whole 64-byte lines.
+volatile unsigned int __attribute__((aligned(64))) mbox[48];
 
 enum {
-    VIDEOCORE_MBOX = (PERIPHERAL_BASE + 0x0000B880),
-    MBOX_READ      = (VIDEOCORE_MBOX + 0x0),
-    MBOX_POLL      = (VIDEOCORE_MBOX + 0x10),
-    MBOX_SENDER    = (VIDEOCORE_MBOX + 0x14),
-    MBOX_STATUS    = (VIDEOCORE_MBOX + 0x18),
-    MBOX_CONFIG    = (VIDEOCORE_MBOX + 0x1C),
-    MBOX_WRITE     = (VIDEOCORE_MBOX + 0x20),
-    MBOX_RESPONSE  = 0x80000000,
-    MBOX_FULL      = 0x80000000,
-    MBOX_EMPTY     = 0x40000000
+    MBOX_RESPONSE  = 0x80000000
 };
 
 unsigned int mbox_call(unsigned char ch)
@@ -24,17 +19,25 @@ unsigned int mbox_call(unsigned char ch)
     unsigned int r = ((unsigned int)((long) &mbox) &~ 0xF) | (ch & 0xF);
 
     // Wait until we can write
-    while (mmio_read(MBOX_STATUS) & MBOX_FULL);
+    while (mmio_field_get(MBOX_STATUS_FULL));
     
-    // Write the address of our buffer to the mailbox with the channel appended
-    mmio_write(MBOX_WRITE, r);
+    // The VideoCore reads the buffer from memory, not from our cache
+    cache_clean(mbox, sizeof(mbox));
+
+    // Write the address of our buffer to the mailbox with the channel appended.
+    // The barrier makes sure the buffer contents reach memory first.
+    mmio_write_sync(MBOX_WRITE, r);
 
     while (1) {
         // Is there a reply?
-        while (mmio_read(MBOX_STATUS) & MBOX_EMPTY);
+        while (mmio_field_get(MBOX_STATUS_EMPTY));
 
-        // Is it a reply to our message?
-        if (r == mmio_read(MBOX_READ)) return mbox[1]==MBOX_RESPONSE; // Is it successful?
+        // Is it a reply to our message? Read the buffer only after the reply,
+        // dropping any stale cache lines first.
+        if (r == mmio_read_acquire(MBOX_READ)) {
+            cache_flush(mbox, sizeof(mbox));
+            return mbox[1]==MBOX_RESPONSE; // Is it successful?
+        }
            
     }
     return 0;
@@ -0,0 +1,90 @@
+// src/mem.c
+#include "mem.h"
+#include "mb.h"
+#include "string_utils.h"
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+// Vom Linker-Skript definiert: erstes Byte hinter .bss
+extern char _end[];
+
+// Fallback, falls die Firmware die ARM-Speichergröße nicht liefert
+// (Standardwert des Pi 4 mit gpu_mem=76)
+#define HEAP_FALLBACK_END 0x3B400000UL
+
+static unsigned long heap_start = 0;
+static unsigned long heap_next = 0;
+static unsigned long heap_end = 0;
+static unsigned long ram_total = 1UL << 30; // Ohne Revisionscode: nur das erste GB
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void mem_init() {
+    heap_start = ((unsigned long)_end + 15) & ~15UL;
+    heap_next = heap_start;
+    heap_end = HEAP_FALLBACK_END;
+
+    // Die Firmware nach dem für die ARM-Cores reservierten Speicher fragen
+    mbox[0] = 8*4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = MBOX_TAG_GETARMMEM;
+    mbox[3] = 8;
+    mbox[4] = 0;
+    mbox[5] = 0; // Basisadresse
+    mbox[6] = 0; // Größe in Bytes
+    mbox[7] = MBOX_TAG_LAST;
+
+    if (mbox_call(MBOX_CH_PROP) && mbox[6] != 0) {
+        unsigned long end = (unsigned long)mbox[5] + mbox[6];
+        if (end > heap_start) heap_end = end;
+    }
+
+    // Gesamter RAM aus dem Revisionscode: im neuen Format (Bit 23) stehen in
+    // den Bits 20-22 256 MB << n
+    mbox[0] = 7*4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = MBOX_TAG_GETBOARDREV;
+    mbox[3] = 4;
+    mbox[4] = 0;
+    mbox[5] = 0;
+    mbox[6] = MBOX_TAG_LAST;
+
+    if (mbox_call(MBOX_CH_PROP) && (mbox[5] & (1u << 23))) {
+        ram_total = (256UL << 20) << ((mbox[5] >> 20) & 7);
+    }
+}
+
+void* mem_alloc_aligned(unsigned long size, unsigned long align) {
+    if (heap_next == 0) mem_init();
+
+    unsigned long addr = (heap_next + align - 1) & ~(align - 1);
+    if (addr + size > heap_end || addr + size < addr) {
+        return NULL;
+    }
+    heap_next = addr + size;
+    return (void*)addr;
+}
+
+void* mem_alloc(unsigned long size) {
+    return mem_alloc_aligned(size, 16);
+}
+
+unsigned long mem_ram_end() {
+    return heap_end;
+}
+
+unsigned long mem_ram_total() {
+    return ram_total;
+}
+
+unsigned long mem_used() {
+    return heap_next - heap_start;
+}
+
+unsigned long mem_free() {
+    return heap_end - heap_next;
+}
@@ -0,0 +1,557 @@
+// src/membench.c
+// Speicherbenchmarks: STREAM (copy, scale, add, triad) mit skalaren,
+// ldp/stp- und NEON-Schleifen über Puffergrößen von L1 bis DRAM, die
+// Ladelatenz per Pointer-Chasing und die Schreibrate in den Framebuffer.
+// Alles läuft auf dem aufrufenden Core.
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+#include "timer.h"
+#include "mem.h"
+#include "fb.h"
+
+// Größtes Feld; die drei Felder liegen direkt hintereinander
+#define ARRAY_MAX      (8ul << 20)
+#define REGION_SIZE    (3 * ARRAY_MAX)
+
+#define STREAM_TRAFFIC (32ul << 20) // Bytes pro Messung, mindestens 2 Durchläufe
+#define TRIALS         3            // Gemeldet wird die beste Messung
+#define CHASE_MAX      (16ul << 20)
+#define CHASE_STEPS    (1ul << 21)
+#define LINE           64
+
+#define SCALAR_K       3.0          // Faktor wie im Original-STREAM
+
+// Der Compiler soll die Schleifen weder selbst vektorisieren noch durch
+// memcpy/memset ersetzen, sonst misst "scalar" etwas anderes
+#define PLAIN_LOOP __attribute__((noinline, optimize("no-tree-vectorize", "no-tree-loop-distribute-patterns")))
+
+typedef double f64x2 __attribute__((vector_size(16)));
+
+static unsigned char* region;
+static bool csv;
+
+// ##################################
+// ## Ausgabe
+// ##################################
+
+static void put_column(const char* s, unsigned int width) {
+    for (unsigned int i = strlen_simple(s); i < width; i++) console_puts(" ");
+    console_puts(s);
+}
+
+static void put_number(unsigned long value, unsigned int width) {
+    char buffer[21];
+    simple_ltoa(value, buffer);
+    put_column(buffer, width);
+}
+
+// Zehntel als "12.3"
+static void format_tenths(unsigned long tenths, char* buffer) {
+    simple_ltoa(tenths / 10, buffer);
+    unsigned int n = strlen_simple(buffer);
+    buffer[n] = '.';
+    buffer[n + 1] = '0' + tenths % 10;
+    buffer[n + 2] = '\0';
+}
+
+// "4K", "1M"
+static void format_size(unsigned long bytes, char* buffer) {
+    bool mb = bytes >= (1ul << 20);
+    simple_ltoa(mb ? bytes >> 20 : bytes >> 10, buffer);
+    unsigned int n = strlen_simple(buffer);
+    buffer[n] = mb ? 'M' : 'K';
+    buffer[n + 1] = '\0';
+}
+
+// Eine Zeile der maschinenlesbaren Ausgabe: test,variant,bytes,value,unit
+static void put_csv(const char* test, const char* variant, unsigned long bytes,
+                    const char* value, const char* unit) {
+    char buffer[21];
+    console_puts(test);
+    console_puts(",");
+    console_puts(variant);
+    console_puts(",");
+    console_puts(simple_ltoa(bytes, buffer));
+    console_puts(",");
+    console_puts(value);
+    console_puts(",");
+    console_puts(unit);
+    console_puts("\n");
+}
+
+// Bytes pro Mikrosekunde sind MB/s (10^6 Bytes)
+static unsigned long rate_mb(unsigned long bytes, unsigned long ticks) {
+    unsigned long us = timer_ticks_to_us(ticks);
+    return bytes / (us ? us : 1);
+}
+
+// ##################################
+// ## STREAM-Kernel
+// ##################################
+
+/*
+ * Wie im Original: copy c = a, scale b = k*c, add c = a+b, triad a = b+k*c.
+ * n ist ein Vielfaches von 4 und nicht 0. Jede Variante verarbeitet 32
+ * Bytes pro Feld und Durchlauf, damit sich nur die Befehle unterscheiden.
+ */
+
+PLAIN_LOOP static void copy_scalar(double* d, const double* a, unsigned long n) {
+    for (unsigned long i = 0; i < n; i++) d[i] = a[i];
+}
+
+PLAIN_LOOP static void scale_scalar(double* d, const double* a, double k, unsigned long n) {
+    for (unsigned long i = 0; i < n; i++) d[i] = k * a[i];
+}
+
+PLAIN_LOOP static void add_scalar(double* d, const double* a, const double* b, unsigned long n) {
+    for (unsigned long i = 0; i < n; i++) d[i] = a[i] + b[i];
+}
+
+PLAIN_LOOP static void triad_scalar(double* d, const double* a, const double* b, double k, unsigned long n) {
+    for (unsigned long i = 0; i < n; i++) d[i] = a[i] + k * b[i];
+}
+
+// Paarweise Lade- und Speicherbefehle, von Hand ausgerollt
+static void copy_ldp(double* d, const double* a, unsigned long n) {
+    asm volatile(
+        "1: ldp x4, x5, [%[a]], #16\n"
+        "   ldp x6, x7, [%[a]], #16\n"
+        "   stp x4, x5, [%[d]], #16\n"
+        "   stp x6, x7, [%[d]], #16\n"
+        "   subs %[n], %[n], #4\n"
+        "   b.ne 1b\n"
+        : [d] "+r"(d), [a] "+r"(a), [n] "+r"(n)
+        :: "x4", "x5", "x6", "x7", "cc", "memory");
+}
+
+static void scale_ldp(double* d, const double* a, double k, unsigned long n) {
+    asm volatile(
+        "1: ldp d0, d1, [%[a]], #16\n"
+        "   ldp d2, d3, [%[a]], #16\n"
+        "   fmul d0, d0, %d[k]\n"
+        "   fmul d1, d1, %d[k]\n"
+        "   fmul d2, d2, %d[k]\n"
+        "   fmul d3, d3, %d[k]\n"
+        "   stp d0, d1, [%[d]], #16\n"
+        "   stp d2, d3, [%[d]], #16\n"
+        "   subs %[n], %[n], #4\n"
+        "   b.ne 1b\n"
+        : [d] "+r"(d), [a] "+r"(a), [n] "+r"(n)
+        : [k] "w"(k)
+        : "v0", "v1", "v2", "v3", "cc", "memory");
+}
+
+static void add_ldp(double* d, const double* a, const double* b, unsigned long n) {
+    asm volatile(
+        "1: ldp d0, d1, [%[a]], #16\n"
+        "   ldp d2, d3, [%[a]], #16\n"
+        "   ldp d4, d5, [%[b]], #16\n"
+        "   ldp d6, d7, [%[b]], #16\n"
+        "   fadd d0, d0, d4\n"
+        "   fadd d1, d1, d5\n"
+        "   fadd d2, d2, d6\n"
+        "   fadd d3, d3, d7\n"
+        "   stp d0, d1, [%[d]], #16\n"
+        "   stp d2, d3, [%[d]], #16\n"
+        "   subs %[n], %[n], #4\n"
+        "   b.ne 1b\n"
+        : [d] "+r"(d), [a] "+r"(a), [b] "+r"(b), [n] "+r"(n)
+        :: "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "cc", "memory");
+}
+
+static void triad_ldp(double* d, const double* a, const double* b, double k, unsigned long n) {
+    asm volatile(
+        "1: ldp d0, d1, [%[a]], #16\n"
+        "   ldp d2, d3, [%[a]], #16\n"
+        "   ldp d4, d5, [%[b]], #16\n"
+        "   ldp d6, d7, [%[b]], #16\n"
+        "   fmadd d0, d4, %d[k], d0\n"
+        "   fmadd d1, d5, %d[k], d1\n"
+        "   fmadd d2, d6, %d[k], d2\n"
+        "   fmadd d3, d7, %d[k], d3\n"
+        "   stp d0, d1, [%[d]], #16\n"
+        "   stp d2, d3, [%[d]], #16\n"
+        "   subs %[n], %[n], #4\n"
+        "   b.ne 1b\n"
+        : [d] "+r"(d), [a] "+r"(a), [b] "+r"(b), [n] "+r"(n)
+        : [k] "w"(k)
+        : "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "cc", "memory");
+}
+
+// Zwei q-Register pro Feld und Durchlauf
+PLAIN_LOOP static void copy_neon(double* d, const double* a, unsigned long n) {
+    f64x2* dv = (f64x2*)d;
+    const f64x2* av = (const f64x2*)a;
+    for (unsigned long i = 0; i < n / 2; i += 2) {
+        f64x2 x0 = av[i], x1 = av[i + 1];
+        dv[i] = x0;
+        dv[i + 1] = x1;
+    }
+}
+
+PLAIN_LOOP static void scale_neon(double* d, const double* a, double k, unsigned long n) {
+    f64x2* dv = (f64x2*)d;
+    const f64x2* av = (const f64x2*)a;
+    f64x2 kv = { k, k };
+    for (unsigned long i = 0; i < n / 2; i += 2) {
+        f64x2 x0 = av[i], x1 = av[i + 1];
+        dv[i] = kv * x0;
+        dv[i + 1] = kv * x1;
+    }
+}
+
+PLAIN_LOOP static void add_neon(double* d, const double* a, const double* b, unsigned long n) {
+    f64x2* dv = (f64x2*)d;
+    const f64x2* av = (const f64x2*)a;
+    const f64x2* bv = (const f64x2*)b;
+    for (unsigned long i = 0; i < n / 2; i += 2) {
+        f64x2 x0 = av[i], x1 = av[i + 1];
+        f64x2 y0 = bv[i], y1 = bv[i + 1];
+        dv[i] = x0 + y0;
+        dv[i + 1] = x1 + y1;
+    }
+}
+
+PLAIN_LOOP static void triad_neon(double* d, const double* a, const double* b, double k, unsigned long n) {
+    f64x2* dv = (f64x2*)d;
+    const f64x2* av = (const f64x2*)a;
+    const f64x2* bv = (const f64x2*)b;
+    f64x2 kv = { k, k };
+    for (unsigned long i = 0; i < n / 2; i += 2) {
+        f64x2 x0 = av[i], x1 = av[i + 1];
+        f64x2 y0 = bv[i], y1 = bv[i + 1];
+        dv[i] = x0 + kv * y0;
+        dv[i + 1] = x1 + kv * y1;
+    }
+}
+
+typedef struct {
+    const char* name;
+    void (*copy)(double* d, const double* a, unsigned long n);
+    void (*scale)(double* d, const double* a, double k, unsigned long n);
+    void (*add)(double* d, const double* a, const double* b, unsigned long n);
+    void (*triad)(double* d, const double* a, const double* b, double k, unsigned long n);
+} StreamVariant;
+
+static const StreamVariant variants[] = {
+    { "scalar", copy_scalar, scale_scalar, add_scalar, triad_scalar },
+    { "ldp",    copy_ldp,    scale_ldp,    add_ldp,    triad_ldp },
+    { "neon",   copy_neon,   scale_neon,   add_neon,   triad_neon },
+};
+#define VARIANT_COUNT (sizeof(variants) / sizeof(variants[0]))
+
+enum { OP_COPY, OP_SCALE, OP_ADD, OP_TRIAD, OP_COUNT };
+static const char* const op_names[OP_COUNT] = { "copy", "scale", "add", "triad" };
+
+// Bytes pro Element: gelesen plus geschrieben, wie STREAM sie zählt
+static const unsigned int op_bytes[OP_COUNT] = { 16, 16, 24, 24 };
+
+// Bytes pro Feld: mit 3 Feldern passen 4K und 8K in den L1 (32 KB),
+// 64K und 256K in den L2 (1 MB), der Rest kommt aus dem DRAM
+static const unsigned long stream_sizes[] = {
+    4ul << 10, 8ul << 10, 64ul << 10, 256ul << 10, 1ul << 20, 4ul << 20, 8ul << 20
+};
+#define STREAM_SIZE_COUNT (sizeof(stream_sizes) / sizeof(stream_sizes[0]))
+
+static void stream_op(const StreamVariant* v, int op, double* a, double* b, double* c, unsigned long n) {
+    switch (op) {
+    case OP_COPY:  v->copy(c, a, n); break;
+    case OP_SCALE: v->scale(b, c, SCALAR_K, n); break;
+    case OP_ADD:   v->add(c, a, b, n); break;
+    case OP_TRIAD: v->triad(a, b, c, SCALAR_K, n); break;
+    }
+}
+
+// Beste Rate aus TRIALS Messungen in MB/s
+static unsigned long stream_measure(const StreamVariant* v, int op, unsigned long bytes) {
+    double* a = (double*)region;
+    double* b = (double*)(region + ARRAY_MAX);
+    double* c = (double*)(region + 2 * ARRAY_MAX);
+    unsigned long n = bytes / sizeof(double);
+    unsigned long traffic = n * op_bytes[op];
+    unsigned long reps = STREAM_TRAFFIC / traffic;
+    if (reps < 2) reps = 2;
+
+    unsigned long best = ~0ul;
+    for (int t = 0; t < TRIALS; t++) {
+        unsigned long start = timer_ticks();
+        for (unsigned long r = 0; r < reps; r++) stream_op(v, op, a, b, c, n);
+        unsigned long ticks = timer_ticks() - start;
+        if (ticks < best) best = ticks;
+    }
+    return rate_mb(traffic * reps, best);
+}
+
+static void stream_init(unsigned long bytes) {
+    double* a = (double*)region;
+    double* b = (double*)(region + ARRAY_MAX);
+    double* c = (double*)(region + 2 * ARRAY_MAX);
+    for (unsigned long i = 0; i < bytes / sizeof(double); i++) {
+        a[i] = 1.0;
+        b[i] = 2.0;
+        c[i] = 0.0;
+    }
+}
+
+static void run_stream() {
+    if (!csv) {
+        console_puts("STREAM in MB/s, size per array (copy/scale use 2 arrays, add/triad 3)\n");
+        console_puts("variant  size");
+        for (int op = 0; op < OP_COUNT; op++) put_column(op_names[op], 8);
+        console_puts("\n");
+    }
+
+    for (unsigned int v = 0; v < VARIANT_COUNT; v++) {
+        for (unsigned int s = 0; s < STREAM_SIZE_COUNT; s++) {
+            unsigned long bytes = stream_sizes[s];
+            stream_init(bytes);
+            unsigned long rates[OP_COUNT];
+            for (int op = 0; op < OP_COUNT; op++) rates[op] = stream_measure(&variants[v], op, bytes);
+
+            char buffer[21];
+            if (csv) {
+                for (int op = 0; op < OP_COUNT; op++) {
+                    put_csv(op_names[op], variants[v].name, bytes, simple_ltoa(rates[op], buffer), "MB/s");
+                }
+                continue;
+            }
+            console_puts(variants[v].name);
+            format_size(bytes, buffer);
+            put_column(buffer, 13 - strlen_simple(variants[v].name));
+            for (int op = 0; op < OP_COUNT; op++) put_number(rates[op], 8);
+            console_puts("\n");
+        }
+    }
+}
+
+// ##################################
+// ## Latenz
+// ##################################
+
+// Einfacher xorshift-Zufallsgenerator, reproduzierbar über den Startwert
+static unsigned int rand_state;
+
+static unsigned int membench_rand() {
+    unsigned int x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+/**
+ * Verkettet die Cache-Zeilen des Puffers in zufälliger Reihenfolge zu
+ * einem einzigen Zyklus (Sattolo): Der nächste Zeiger hängt immer vom
+ * vorherigen Load ab, und der Prefetcher findet kein Muster.
+ */
+static void chase_build(unsigned long bytes) {
+    unsigned long lines = bytes / LINE;
+    unsigned int* order = (unsigned int*)(region + CHASE_MAX);
+    for (unsigned long i = 0; i < lines; i++) order[i] = i;
+    rand_state = 2463534242u;
+    for (unsigned long i = lines - 1; i > 0; i--) {
+        unsigned long j = membench_rand() % i;
+        unsigned int t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (unsigned long i = 0; i < lines; i++) {
+        *(void**)(region + i * LINE) = region + (unsigned long)order[i] * LINE;
+    }
+}
+
+static void* chase(void* p, unsigned long steps) {
+    void** q = p;
+    for (unsigned long i = 0; i < steps; i += 8) {
+        q = *q; q = *q; q = *q; q = *q;
+        q = *q; q = *q; q = *q; q = *q;
+    }
+    return q;
+}
+
+static void run_latency() {
+    if (!csv) console_puts("\nload latency (random chase, one load per cache line)\n    size       ns  cycles\n");
+
+    for (unsigned long bytes = 4ul << 10; bytes <= CHASE_MAX; bytes *= 4) {
+        chase_build(bytes);
+        void* p = chase(region, bytes / LINE); // Einmal durch, zum Aufwärmen
+
+        unsigned long start = timer_ticks();
+        unsigned long cycles = timer_cycles();
+        p = chase(p, CHASE_STEPS);
+        cycles = timer_cycles() - cycles;
+        unsigned long us = timer_ticks_to_us(timer_ticks() - start);
+        // Das Ergebnis verwenden, damit die Kette nicht wegoptimiert wird
+        if (p == NULL) console_puts("broken chain\n");
+
+        char ns[24], cyc[24];
+        format_tenths(us * 10000 / CHASE_STEPS, ns);
+        format_tenths(cycles * 10 / CHASE_STEPS, cyc);
+        if (csv) {
+            put_csv("latency", "chase", bytes, ns, "ns");
+            put_csv("latency", "chase", bytes, cyc, "cycles");
+            continue;
+        }
+        char size[21];
+        format_size(bytes, size);
+        put_column(size, 8);
+        put_column(ns, 9);
+        put_column(cyc, 8);
+        console_puts("\n");
+    }
+}
+
+// ##################################
+// ## Framebuffer
+// ##################################
+
+// Füllen mit Nullen (schwarz in allen Farbtiefen); bytes ist ein Vielfaches von 64
+
+PLAIN_LOOP static void fill_str(void* p, unsigned long bytes) {
+    unsigned int* d = p;
+    for (unsigned long i = 0; i < bytes / 4; i++) d[i] = 0;
+}
+
+static void fill_stp(void* p, unsigned long bytes) {
+    asm volatile(
+        "1: stp xzr, xzr, [%[p]], #16\n"
+        "   stp xzr, xzr, [%[p]], #16\n"
+        "   stp xzr, xzr, [%[p]], #16\n"
+        "   stp xzr, xzr, [%[p]], #16\n"
+        "   subs %[n], %[n], #64\n"
+        "   b.ne 1b\n"
+        : [p] "+r"(p), [n] "+r"(bytes) :: "cc", "memory");
+}
+
+static void fill_neon(void* p, unsigned long bytes) {
+    asm volatile(
+        "   movi v0.2d, #0\n"
+        "1: stp q0, q0, [%[p]], #32\n"
+        "   stp q0, q0, [%[p]], #32\n"
+        "   subs %[n], %[n], #64\n"
+        "   b.ne 1b\n"
+        : [p] "+r"(p), [n] "+r"(bytes) :: "v0", "cc", "memory");
+}
+
+typedef struct {
+    const char* name;
+    void (*fill)(void* p, unsigned long bytes);
+} FillVariant;
+
+static const FillVariant fills[] = {
+    { "str",  fill_str },
+    { "stp",  fill_stp },
+    { "neon", fill_neon },
+};
+#define FILL_COUNT (sizeof(fills) / sizeof(fills[0]))
+
+static unsigned long fill_measure(const FillVariant* f, void* p, unsigned long bytes) {
+    unsigned long best = ~0ul;
+    for (int t = 0; t < TRIALS; t++) {
+        unsigned long start = timer_ticks();
+        f->fill(p, bytes);
+        asm volatile("dsb sy" ::: "memory"); // Auch die Write-Combining-Puffer zählen
+        unsigned long ticks = timer_ticks() - start;
+        if (ticks < best) best = ticks;
+    }
+    return rate_mb(bytes, best);
+}
+
+/*
+ * Der Framebuffer der GPU ist nicht cachebar; jeder Store geht über den
+ * Write-Combining-Puffer. Zum Vergleich dieselbe Menge in cachebares RAM.
+ * Ist der Schattenpuffer an, wird der Bildschirm danach wiederhergestellt,
+ * sonst bleibt er schwarz.
+ */
+static void run_fb() {
+    unsigned char* front = fb_front_buffer();
+    if (front == NULL) return;
+    unsigned long bytes = ((unsigned long)fb_pitch() * fb_height()) & ~(unsigned long)(LINE - 1);
+    if (bytes == 0) return;
+
+    // Der RAM-Vergleich braucht dieselbe Menge im Testbereich; sonst eine
+    // Zeile pro Variante, damit CSV-Logs nicht einfach Zeilen verlieren
+    if (bytes > REGION_SIZE) {
+        if (!csv) {
+            console_puts("\nframebuffer test skipped: ");
+            console_putlong(bytes >> 10);
+            console_puts(" KB do not fit the ");
+            console_putlong(REGION_SIZE >> 10);
+            console_puts(" KB test region\n");
+            return;
+        }
+        for (unsigned int i = 0; i < FILL_COUNT; i++) {
+            put_csv("fb_write", fills[i].name, bytes, "skipped", "MB/s");
+            put_csv("ram_write", fills[i].name, bytes, "skipped", "MB/s");
+        }
+        return;
+    }
+
+    if (!csv) {
+        console_puts("\nwrite bandwidth in MB/s (");
+        console_putlong(bytes >> 10);
+        console_puts(" KB)\nstore  gpu      ram\n");
+    }
+    for (unsigned int i = 0; i < FILL_COUNT; i++) {
+        // Die Ausgabe der letzten Zeile hat den Cursor wieder gezeichnet
+        fb_begin_draw(0, 0, fb_width() - 1, fb_height() - 1);
+        unsigned long gpu = fill_measure(&fills[i], front, bytes);
+        unsigned long ram = fill_measure(&fills[i], region, bytes);
+        char buffer[21];
+        if (csv) {
+            put_csv("fb_write", fills[i].name, bytes, simple_ltoa(gpu, buffer), "MB/s");
+            put_csv("ram_write", fills[i].name, bytes, simple_ltoa(ram, buffer), "MB/s");
+            continue;
+        }
+        console_puts(fills[i].name);
+        put_number(gpu, 10 - strlen_simple(fills[i].name));
+        put_number(ram, 9);
+        console_puts("\n");
+    }
+
+    if (fb_buffer() != front) {
+        fb_mark_dirty(0, 0, fb_width() - 1, fb_height() - 1);
+        fb_flush();
+    }
+}
+
+// ##################################
+// ## Befehl
+// ##################################
+
+/**
+ * "membench [stream|latency|fb] [csv]": ohne Auswahl laufen alle Teile.
+ * Mit "csv" kommt pro Messwert eine Zeile test,variant,bytes,value,unit
+ * für Skripte auf der Gegenseite der UART.
+ */
+static int cmd_membench(int argc, char** argv) {
+    bool stream = false, latency = false, fbwrite = false;
+    csv = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp_simple(argv[i], "csv") == 0) csv = true;
+        else if (strcmp_simple(argv[i], "stream") == 0) stream = true;
+        else if (strcmp_simple(argv[i], "latency") == 0) latency = true;
+        else if (strcmp_simple(argv[i], "fb") == 0) fbwrite = true;
+        else {
+            console_puts("Error: unknown option ");
+            console_puts(argv[i]);
+            console_puts("\n");
+            return SHELL_ERROR;
+        }
+    }
+    if (!stream && !latency && !fbwrite) stream = latency = fbwrite = true;
+
+    if (region == NULL) region = mem_alloc_aligned(REGION_SIZE, LINE);
+    if (region == NULL) {
+        console_puts("Error: out of memory\n");
+        return SHELL_ERROR;
+    }
+
+    if (csv) console_puts("test,variant,bytes,value,unit\n");
+    if (stream) run_stream();
+    if (latency) run_latency();
+    if (fbwrite) run_fb();
+    return SHELL_OK;
+}
+SHELL_COMMAND(membench, cmd_membench, "[stream|latency|fb] [csv] - memory bandwidth and latency");
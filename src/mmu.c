@@ -0,0 +1,112 @@
+// src/mmu.c
+#include "mmu.h"
+#include "mem.h"
+#include "mmio.h"
+
+// ##################################
+// ## Tabellen und Attribute
+// ##################################
+
+// Indizes in MAIR_EL1
+enum {
+    MT_DEVICE   = 0, // Device-nGnRnE
+    MT_NORMAL   = 1, // Normal, Inner/Outer Write-Back, Read/Write-Allocate
+    MT_NORMAL_NC = 2 // Normal, nicht gecacht
+};
+#define MAIR_VALUE ((0x00ul << (8 * MT_DEVICE)) | (0xFFul << (8 * MT_NORMAL)) | (0x44ul << (8 * MT_NORMAL_NC)))
+
+// Bits in Block-Deskriptoren (Level 2, 2 MB)
+#define PTE_VALID      (1ul << 0)
+#define PTE_TABLE      (3ul << 0)
+#define PTE_BLOCK      (1ul << 0)
+#define PTE_ATTR(i)    ((unsigned long)(i) << 2)
+#define PTE_INNER_SH   (3ul << 8)
+#define PTE_AF         (1ul << 10)
+#define PTE_PXN        (1ul << 53)
+#define PTE_UXN        (1ul << 54)
+
+// TCR_EL1: 4 KB Granule, 32-Bit-Adressraum (T0SZ = 32, Start auf Level 1),
+// Tabellenzugriffe gecacht und Inner Shareable, TTBR1 aus (EPD1)
+#define TCR_VALUE ((32ul << 0) | (1ul << 8) | (1ul << 10) | (3ul << 12) | (0ul << 14) | (1ul << 23))
+
+#define SCTLR_M (1ul << 0)
+#define SCTLR_C (1ul << 2)
+#define SCTLR_I (1ul << 12)
+
+#define BLOCK_SIZE   (2ul << 20)
+#define PERIPH_START 0xFC000000ul
+#define HIGH_RAM     0x40000000ul
+
+static unsigned long mmu_l1[512] __attribute__((aligned(4096)));
+static unsigned long mmu_l2[4][512] __attribute__((aligned(4096)));
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void mmu_init() {
+    // Unterhalb von 1 GB gehört alles ab dem Ende des ARM-Speichers der
+    // VideoCore (GPU-Speicher, Framebuffer); darüber ist wieder RAM, aber
+    // nur so viel, wie bestückt ist. Ein Block, den sich ARM und VideoCore
+    // teilen, wird nicht gecacht (abgerundet).
+    unsigned long ram_end = mem_ram_end() & ~(BLOCK_SIZE - 1);
+    unsigned long ram_total = mem_ram_total();
+
+    for (unsigned long i = 0; i < 4 * 512; i++) {
+        unsigned long addr = i * BLOCK_SIZE;
+        unsigned long desc = addr | PTE_BLOCK | PTE_AF;
+        if (addr >= PERIPH_START) {
+            desc |= PTE_ATTR(MT_DEVICE) | PTE_PXN | PTE_UXN;
+        } else if (addr >= HIGH_RAM && addr + BLOCK_SIZE > ram_total) {
+            desc = 0; // Kein RAM: Zugriffe lösen einen Fault aus
+        } else if (addr >= ram_end && addr < HIGH_RAM) {
+            desc |= PTE_ATTR(MT_NORMAL_NC) | PTE_INNER_SH | PTE_PXN | PTE_UXN;
+        } else {
+            desc |= PTE_ATTR(MT_NORMAL) | PTE_INNER_SH;
+        }
+        mmu_l2[i / 512][i % 512] = desc;
+    }
+    for (int i = 0; i < 4; i++) {
+        mmu_l1[i] = (unsigned long)mmu_l2[i] | PTE_TABLE;
+    }
+
+    mmu_enable();
+}
+
+void mmu_enable() {
+    unsigned long sctlr;
+
+    asm volatile("tlbi vmalle1; dsb ish; isb" ::: "memory");
+    asm volatile("msr mair_el1, %0" :: "r"(MAIR_VALUE));
+    asm volatile("msr tcr_el1, %0" :: "r"(TCR_VALUE));
+    asm volatile("msr ttbr0_el1, %0" :: "r"((unsigned long)mmu_l1));
+    isb();
+
+    asm volatile("mrs %0, sctlr_el1" : "=r"(sctlr));
+    sctlr |= SCTLR_M | SCTLR_C | SCTLR_I;
+    asm volatile("msr sctlr_el1, %0; isb" :: "r"(sctlr) : "memory");
+}
+
+static unsigned long cache_line_size() {
+    unsigned long ctr;
+    asm volatile("mrs %0, ctr_el0" : "=r"(ctr));
+    return 4ul << ((ctr >> 16) & 0xF); // DminLine in Worten
+}
+
+void cache_clean(const volatile void* addr, unsigned long size) {
+    unsigned long line = cache_line_size();
+    unsigned long p = (unsigned long)addr & ~(line - 1);
+    for (; p < (unsigned long)addr + size; p += line) {
+        asm volatile("dc cvac, %0" :: "r"(p) : "memory");
+    }
+    dsb();
+}
+
+void cache_flush(const volatile void* addr, unsigned long size) {
+    unsigned long line = cache_line_size();
+    unsigned long p = (unsigned long)addr & ~(line - 1);
+    for (; p < (unsigned long)addr + size; p += line) {
+        asm volatile("dc civac, %0" :: "r"(p) : "memory");
+    }
+    dsb();
+}
@@ -0,0 +1,590 @@
+// src/pvars.c
+#include "pvars.h"
+#include "vars.h"
+#include "fat.h"
+#include "bcache.h"
+#include "sd.h"
+#include "crc32.h"
+#include "mem.h"
+#include "smp.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+#define BLOCK_SIZE      BCACHE_BLOCK_SIZE
+#define PVARS_MAGIC     0x5653424F          // "OBSV"
+#define WINDOW_BLOCKS   BCACHE_LINE_BLOCKS  // Puffer für den Group Commit (4 KB)
+#define SCAN_BLOCKS     32                  // Blöcke pro Lesezugriff beim Booten
+#define MIN_HALF_BLOCKS (WINDOW_BLOCKS + 1)
+#define RECORD_HEADER   16
+
+// Block 0 jeder Hälfte
+typedef struct {
+    unsigned int magic;
+    unsigned int generation;
+    unsigned int complete;      // 0: Kompaktierung in diese Hälfte lief noch
+    unsigned int crc;           // Über die Felder davor
+} PvarsHeader;
+
+// Ab Block 1, auf 8 Bytes ausgerichtet; Records reichen nie über ein Blockende
+typedef struct {
+    unsigned int crc;           // Über die Generation, den Rest des Records und den Namen
+    unsigned char name_len;     // 0: Rest des Blocks ist frei
+    unsigned char reserved[3];
+    long value;
+    char name[];
+} PvarsRecord;
+
+typedef struct {
+    bool mounted;
+    bool compacting;
+    FatFile file;
+    unsigned long half_blocks;  // Blöcke pro Hälfte, Block 0 ist der Kopf
+    unsigned int half;          // Aktive Hälfte
+    unsigned int generation;
+    unsigned int last_generation; // Höchste je in einen Kopf geschriebene
+    unsigned long tail;         // Byte-Offset des nächsten Records in der Hälfte
+    unsigned long window_block; // Block der Hälfte am Anfang von window
+    bool dirty;                 // window enthält ungeschriebene Records
+    unsigned long last_append;  // timer_ticks()
+} Store;
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+static Store store;
+static PvarsStats stats;
+
+// Die Blöcke ab window_block, wie sie nach dem nächsten Commit auf der Karte stehen
+static unsigned char window[WINDOW_BLOCKS * BLOCK_SIZE] __attribute__((aligned(CACHE_LINE)));
+static unsigned char scan_buffer[SCAN_BLOCKS * BLOCK_SIZE] __attribute__((aligned(CACHE_LINE)));
+
+// Slots der Variablentabelle, die ins Log gehören (wächst mit vars_count)
+static unsigned char* persistent = NULL;
+static unsigned int persistent_capacity = 0;
+
+// ##################################
+// ## Blöcke und Records
+// ##################################
+
+static int read_blocks(unsigned int half, unsigned long first, unsigned long count, void* buffer) {
+    fat_seek(&store.file, (half * store.half_blocks + first) * BLOCK_SIZE);
+    long n = fat_read(&store.file, buffer, count * BLOCK_SIZE);
+    return n == (long)(count * BLOCK_SIZE) ? PVARS_OK : PVARS_ERR_IO;
+}
+
+// Die Datei kann aus mehreren Extents bestehen: stückweise abbilden
+static int write_blocks(unsigned int half, unsigned long first, unsigned long count, const void* buffer) {
+    const unsigned char* data = buffer;
+    while (count > 0) {
+        unsigned long lba, run;
+        unsigned long pos = (half * store.half_blocks + first) * BLOCK_SIZE;
+        if (fat_map(&store.file, pos, &lba, &run) != FAT_OK) return PVARS_ERR_IO;
+        if (run > count) run = count;
+        if (bcache_write(lba, run, data) != SD_OK) return PVARS_ERR_IO;
+        first += run;
+        count -= run;
+        data += run * BLOCK_SIZE;
+    }
+    return PVARS_OK;
+}
+
+static inline unsigned int record_size(unsigned int name_len) {
+    return (RECORD_HEADER + name_len + 7) & ~7u;
+}
+
+// Die Generation gehört mit zur CRC: Records aus einer früheren Nutzung
+// der Hälfte sind damit ungültig und beenden den Log
+static unsigned int record_crc(unsigned int generation, const PvarsRecord* r) {
+    unsigned int crc = crc32_update(0, &generation, sizeof(generation));
+    return crc32_update(crc, &r->name_len, RECORD_HEADER - sizeof(r->crc) + r->name_len);
+}
+
+static bool record_valid(const unsigned char* block, unsigned int offset, unsigned int generation) {
+    const PvarsRecord* r = (const PvarsRecord*)(block + offset);
+    return r->name_len > 0 && r->name_len <= PVARS_NAME_MAX &&
+           offset + record_size(r->name_len) <= BLOCK_SIZE && r->crc == record_crc(generation, r);
+}
+
+static bool mark_persistent(int slot) {
+    if ((unsigned int)slot >= persistent_capacity) {
+        unsigned int capacity = persistent_capacity ? persistent_capacity : 256;
+        while (capacity <= (unsigned int)slot) capacity *= 2;
+        unsigned char* p = mem_alloc(capacity);
+        if (p == NULL) return false;
+        memset(p, 0, capacity);
+        if (persistent != NULL) memcpy(p, persistent, persistent_capacity);
+        persistent = p;
+        persistent_capacity = capacity;
+    }
+    persistent[slot] = 1;
+    return true;
+}
+
+// ##################################
+// ## Schreiben
+// ##################################
+
+/**
+ * Schreibt die Blöcke des Fensters bis zum letzten Record in einem
+ * Zugriff auf die Karte und schiebt das Fenster auf den Block, in dem das
+ * Ende liegt (ein angefangener Block wird beim nächsten Commit neu
+ * geschrieben).
+ */
+static int commit() {
+    if (!store.dirty) return PVARS_OK;
+
+    unsigned long first = store.window_block;
+    unsigned long count = (store.tail - 1) / BLOCK_SIZE - first + 1;
+    int err = write_blocks(store.half, first, count, window);
+    if (err == PVARS_OK && bcache_sync() != SD_OK) err = PVARS_ERR_IO;
+    if (err != PVARS_OK) return err;
+
+    stats.commits++;
+    stats.committed_blocks += count;
+    store.dirty = false;
+
+    unsigned long tail_block = store.tail / BLOCK_SIZE;
+    if (tail_block > first) {
+        if (tail_block - first < WINDOW_BLOCKS) {
+            memcpy(window, window + (tail_block - first) * BLOCK_SIZE, BLOCK_SIZE);
+        } else {
+            memset(window, 0, BLOCK_SIZE);
+        }
+        memset(window + BLOCK_SIZE, 0, sizeof(window) - BLOCK_SIZE);
+        store.window_block = tail_block;
+    }
+    return PVARS_OK;
+}
+
+static int compact();
+
+static int append(const char* name, unsigned int name_len, long value) {
+    unsigned int size = record_size(name_len);
+    unsigned long offset = store.tail % BLOCK_SIZE;
+    if (offset + size > BLOCK_SIZE) store.tail += BLOCK_SIZE - offset; // Rest bleibt frei
+
+    if (store.tail / BLOCK_SIZE >= store.half_blocks) {
+        // Während der Kompaktierung heißt das: der Stand passt nicht hinein
+        if (store.compacting) return PVARS_ERR_FULL;
+        return compact(); // Schreibt auch diesen Wert (er steht schon in der Tabelle)
+    }
+    if (store.tail / BLOCK_SIZE >= store.window_block + WINDOW_BLOCKS) {
+        int err = commit();
+        if (err != PVARS_OK) return err;
+    }
+
+    PvarsRecord* r = (PvarsRecord*)(window + store.tail - store.window_block * BLOCK_SIZE);
+    memset(r, 0, size);
+    r->name_len = name_len;
+    r->value = value;
+    memcpy(r->name, name, name_len);
+    r->crc = record_crc(store.generation, r);
+
+    store.tail += size;
+    store.dirty = true;
+    store.last_append = timer_ticks();
+    stats.appends++;
+    return PVARS_OK;
+}
+
+static int write_header(unsigned int half, unsigned int generation, bool complete) {
+    memset(scan_buffer, 0, BLOCK_SIZE);
+    PvarsHeader* h = (PvarsHeader*)scan_buffer;
+    h->magic = PVARS_MAGIC;
+    h->generation = generation;
+    h->complete = complete;
+    h->crc = crc32_update(0, h, 3 * sizeof(unsigned int));
+    int err = write_blocks(half, 0, 1, scan_buffer);
+    if (err == PVARS_OK && bcache_sync() != SD_OK) err = PVARS_ERR_IO;
+    return err;
+}
+
+// Angefangenen Block ins Fenster holen, alles hinter dem Ende leeren
+static int load_window(unsigned long end) {
+    store.tail = end;
+    store.window_block = end / BLOCK_SIZE;
+    store.dirty = false;
+    memset(window, 0, sizeof(window));
+    unsigned int offset = end % BLOCK_SIZE;
+    if (offset == 0) return PVARS_OK;
+    int err = read_blocks(store.half, store.window_block, 1, window);
+    memset(window + offset, 0, BLOCK_SIZE - offset);
+    return err;
+}
+
+/**
+ * Schreibt alle persistenten Variablen in die andere Hälfte. Ihr Kopf
+ * bekommt zuerst eine neue, nie benutzte Generation (noch unvollständig),
+ * damit Records eines abgebrochenen Versuchs nie wieder gültig werden, und
+ * wird erst vollständig, wenn alle Records auf der Karte sind. Bis dahin
+ * bleibt beim Booten die alte Hälfte gültig.
+ */
+static int compact() {
+    int err = commit(); // Danach steht die alte Hälfte komplett auf der Karte
+    if (err != PVARS_OK) return err;
+
+    Store old = store;
+    store.half = !store.half;
+    store.generation = ++store.last_generation;
+    store.tail = BLOCK_SIZE;
+    store.window_block = 1;
+    store.compacting = true;
+    memset(window, 0, sizeof(window));
+
+    err = write_header(store.half, store.generation, false);
+    unsigned int count = vars_count();
+    for (unsigned int slot = 0; slot < count && slot < persistent_capacity && err == PVARS_OK; slot++) {
+        if (!persistent[slot]) continue;
+        const char* name = vars_slot_name(slot);
+        err = append(name, strlen_simple(name), vars_values[slot]);
+    }
+    if (err == PVARS_OK) err = commit();
+    if (err == PVARS_OK) err = write_header(store.half, store.generation, true);
+    store.compacting = false;
+
+    if (err != PVARS_OK) {
+        // Auf der Karte gilt weiter die alte Hälfte
+        unsigned int last_generation = store.last_generation;
+        store = old;
+        store.last_generation = last_generation;
+        load_window(store.tail);
+        return err;
+    }
+    stats.compactions++;
+    return PVARS_OK;
+}
+
+// ##################################
+// ## Booten
+// ##################################
+
+static void restore(const PvarsRecord* r) {
+    char name[PVARS_NAME_MAX + 1];
+    memcpy(name, r->name, r->name_len);
+    name[r->name_len] = '\0';
+
+    int slot = vars_intern(name);
+    if (slot < 0 || !mark_persistent(slot)) return; // Heap voll
+    vars_values[slot] = r->value;
+    stats.restored++;
+}
+
+/**
+ * Liest die aktive Hälfte bis zum ersten ungültigen Record oder leeren
+ * Block und liefert die Position hinter dem letzten gültigen Record.
+ */
+static int scan(unsigned long* end) {
+    *end = BLOCK_SIZE;
+    for (unsigned long block = 1; block < store.half_blocks; block += SCAN_BLOCKS) {
+        unsigned long count = store.half_blocks - block;
+        if (count > SCAN_BLOCKS) count = SCAN_BLOCKS;
+        int err = read_blocks(store.half, block, count, scan_buffer);
+        if (err != PVARS_OK) return err;
+
+        for (unsigned long i = 0; i < count; i++) {
+            const unsigned char* data = scan_buffer + i * BLOCK_SIZE;
+            unsigned int offset = 0;
+            stats.scanned_blocks++;
+            while (offset + RECORD_HEADER <= BLOCK_SIZE && record_valid(data, offset, store.generation)) {
+                const PvarsRecord* r = (const PvarsRecord*)(data + offset);
+                restore(r);
+                offset += record_size(r->name_len);
+            }
+            if (offset == 0) return PVARS_OK; // Leerer Block: Ende
+            *end = (block + i) * BLOCK_SIZE + offset;
+
+            // Ein Record, der nicht gilt, aber auch nicht das freie Ende
+            // des Blocks markiert, beendet den Log
+            bool free_rest = offset + RECORD_HEADER > BLOCK_SIZE || data[offset + 4] == 0;
+            if (!free_rest) return PVARS_OK;
+        }
+    }
+    return PVARS_OK;
+}
+
+/**
+ * Bricht ein Commit mittendrin ab, können hinter dem Ende schon gültige
+ * Records liegen, die beim nächsten Booten wieder auftauchen würden,
+ * sobald der Log bis dorthin gewachsen ist. Ein Commit schreibt höchstens
+ * ein Fenster: so weit werden solche Blöcke gelöscht.
+ */
+static int scrub_after_tail() {
+    unsigned long first = store.window_block + 1;
+    if (first >= store.half_blocks) return PVARS_OK;
+    unsigned long count = store.half_blocks - first;
+    if (count > WINDOW_BLOCKS) count = WINDOW_BLOCKS;
+
+    int err = read_blocks(store.half, first, count, scan_buffer);
+    if (err != PVARS_OK) return err;
+    for (unsigned long i = 0; i < count; i++) {
+        if (!record_valid(scan_buffer + i * BLOCK_SIZE, 0, store.generation)) continue;
+        memset(scan_buffer + i * BLOCK_SIZE, 0, BLOCK_SIZE);
+        err = write_blocks(store.half, first + i, 1, scan_buffer + i * BLOCK_SIZE);
+        if (err != PVARS_OK) return err;
+    }
+    return bcache_sync() == SD_OK ? PVARS_OK : PVARS_ERR_IO;
+}
+
+// Generation aus einem Kopfblock, 0 wenn er ungültig ist
+static unsigned int header_generation(const unsigned char* block, bool* complete) {
+    const PvarsHeader* h = (const PvarsHeader*)block;
+    if (h->magic != PVARS_MAGIC || h->crc != crc32_update(0, h, 3 * sizeof(unsigned int))) return 0;
+    *complete = h->complete;
+    return h->generation;
+}
+
+static int mount() {
+    if (!fat_mounted()) return PVARS_ERR_NOT_MOUNTED;
+    if (fat_open(PVARS_FILE, &store.file) != FAT_OK || store.file.dir) return PVARS_ERR_NO_FILE;
+    store.half_blocks = store.file.size / BLOCK_SIZE / 2;
+    if (store.half_blocks < MIN_HALF_BLOCKS) return PVARS_ERR_TOO_SMALL;
+
+    // Gültig ist die vollständige Hälfte mit der höheren Generation
+    unsigned int generation[2];
+    bool complete[2] = { false, false };
+    store.last_generation = 0;
+    for (unsigned int half = 0; half < 2; half++) {
+        int err = read_blocks(half, 0, 1, scan_buffer);
+        if (err != PVARS_OK) return err;
+        generation[half] = header_generation(scan_buffer, &complete[half]);
+        if (generation[half] > store.last_generation) store.last_generation = generation[half];
+        if (!complete[half]) generation[half] = 0;
+    }
+
+    unsigned long end = BLOCK_SIZE;
+    if (generation[0] == 0 && generation[1] == 0) {
+        // Neue Datei: Hälfte 0 mit leerem Log
+        store.half = 0;
+        store.generation = ++store.last_generation;
+        memset(scan_buffer, 0, BLOCK_SIZE);
+        int err = write_blocks(0, 1, 1, scan_buffer);
+        if (err == PVARS_OK) err = write_header(0, store.generation, true);
+        if (err != PVARS_OK) return err;
+    } else {
+        store.half = generation[1] > generation[0];
+        store.generation = generation[store.half];
+        int err = scan(&end);
+        if (err != PVARS_OK) return err;
+    }
+
+    int err = load_window(end);
+    if (err != PVARS_OK) return err;
+    return scrub_after_tail();
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+int pvars_mount() {
+    unsigned long start = timer_ticks();
+    store.mounted = false;
+    int err = mount();
+    store.mounted = err == PVARS_OK;
+    stats.restore_us = timer_ticks_to_us(timer_ticks() - start);
+    return err;
+}
+
+bool pvars_mounted() {
+    return store.mounted;
+}
+
+int pvars_set(const char* name, long value) {
+    int slot = vars_intern(name);
+    if (slot < 0) return PVARS_ERR_MEMORY;
+    vars_values[slot] = value;
+    if (!store.mounted) return PVARS_ERR_NOT_MOUNTED;
+
+    unsigned int len = strlen_simple(name);
+    if (len > PVARS_NAME_MAX) return PVARS_ERR_NAME;
+    if (!mark_persistent(slot)) return PVARS_ERR_MEMORY;
+    return append(name, len, value);
+}
+
+int pvars_sync() {
+    if (!store.mounted) return PVARS_ERR_NOT_MOUNTED;
+    return commit();
+}
+
+bool pvars_update() {
+    if (!store.dirty) return false;
+    unsigned long delay = timer_freq() / 1000 * PVARS_COMMIT_DELAY_MS;
+    if (timer_ticks() - store.last_append < delay) return false;
+
+    if (commit() != PVARS_OK) {
+        stats.errors++;
+        store.last_append = timer_ticks(); // Nach der nächsten Pause erneut
+    }
+    return true;
+}
+
+const PvarsStats* pvars_stats() {
+    return &stats;
+}
+
+const char* pvars_error_string(int err) {
+    switch (err) {
+    case PVARS_OK:              return "ok";
+    case PVARS_ERR_NOT_MOUNTED: return "no FAT32 volume mounted";
+    case PVARS_ERR_NO_FILE:     return "no " PVARS_FILE " on the card";
+    case PVARS_ERR_TOO_SMALL:   return PVARS_FILE " is too small";
+    case PVARS_ERR_IO:          return "card I/O error";
+    case PVARS_ERR_FULL:        return "variables do not fit into " PVARS_FILE;
+    case PVARS_ERR_NAME:        return "name too long to be saved";
+    case PVARS_ERR_MEMORY:      return "out of memory for variables";
+    default:                    return "unknown error";
+    }
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+static unsigned int persistent_count() {
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < persistent_capacity; i++) n += persistent[i];
+    return n;
+}
+
+static void print_status() {
+    console_puts(PVARS_FILE ": ");
+    console_putlong(store.file.size);
+    console_puts(" bytes, half ");
+    console_putint(store.half);
+    console_puts(", generation ");
+    console_putlong(store.generation);
+    console_puts("\nlog: ");
+    console_putlong(store.tail - BLOCK_SIZE);
+    console_puts(" of ");
+    console_putlong((store.half_blocks - 1) * BLOCK_SIZE);
+    console_puts(" bytes, ");
+    console_putint(persistent_count());
+    console_puts(store.dirty ? " variables, commit pending\n" : " variables\n");
+    console_puts("restore: ");
+    console_putlong(stats.restored);
+    console_puts(" records from ");
+    console_putlong(stats.scanned_blocks);
+    console_puts(" blocks in ");
+    console_putlong(stats.restore_us);
+    console_puts(" us\nappends: ");
+    console_putlong(stats.appends);
+    console_puts(", commits: ");
+    console_putlong(stats.commits);
+    console_puts(" (");
+    console_putlong(stats.committed_blocks);
+    console_puts(" blocks), compactions: ");
+    console_putlong(stats.compactions);
+    console_puts(", errors: ");
+    console_putlong(stats.errors);
+    console_puts("\n");
+}
+
+#define BENCH_NAMES 16
+
+static void bench_name(char* name, long i) {
+    char digits[21];
+    strncpy_simple(name, "pvbench", 8);
+    simple_ltoa(i % BENCH_NAMES, digits);
+    strncpy_simple(name + 7, digits, 3);
+}
+
+static void bench_report(const char* label, long n, unsigned long ticks, const SdStats* before) {
+    const SdStats* sd = sd_stats();
+    unsigned long us = timer_ticks_to_us(ticks);
+    if (us == 0) us = 1;
+    console_puts(label);
+    console_putlong(n * 1000000 / us);
+    console_puts(" sets/s, ");
+    console_putlong(sd->write_commands - before->write_commands);
+    console_puts(" write commands, ");
+    console_putlong(sd->write_blocks - before->write_blocks);
+    console_puts(" blocks\n");
+}
+
+/*
+ * Setzt n-mal eine von 16 Variablen: einmal mit Group Commit am Ende,
+ * einmal mit einem Commit nach jedem set. Danach werden die Variablen
+ * wieder flüchtig und eine Kompaktierung entfernt sie aus dem Log.
+ */
+static int bench(long n) {
+    int err = commit();
+    char name[16];
+    SdStats before;
+
+    before = *sd_stats();
+    unsigned long start = timer_ticks();
+    for (long i = 0; i < n && err == PVARS_OK; i++) {
+        bench_name(name, i);
+        err = pvars_set(name, i);
+    }
+    if (err == PVARS_OK) err = commit();
+    if (err == PVARS_OK) bench_report("group commit: ", n, timer_ticks() - start, &before);
+
+    long single = n < 200 ? n : 200;
+    before = *sd_stats();
+    start = timer_ticks();
+    for (long i = 0; i < single && err == PVARS_OK; i++) {
+        bench_name(name, i);
+        err = pvars_set(name, i);
+        if (err == PVARS_OK) err = commit();
+    }
+    if (err == PVARS_OK) bench_report("commit per set: ", single, timer_ticks() - start, &before);
+
+    for (long i = 0; i < BENCH_NAMES; i++) {
+        bench_name(name, i);
+        int slot = vars_slot(name);
+        if (slot >= 0 && (unsigned int)slot < persistent_capacity) persistent[slot] = 0;
+    }
+    start = timer_ticks();
+    if (err == PVARS_OK) err = compact();
+    if (err == PVARS_OK) {
+        console_puts("compaction: ");
+        console_putlong(timer_ticks_to_us(timer_ticks() - start));
+        console_puts(" us\n");
+    }
+    return err;
+}
+
+/**
+ * "pvars [sync|compact|mount|bench [n]]": ohne Argument Zustand, Kosten
+ * der Wiederherstellung beim Booten und Statistik.
+ */
+static int cmd_pvars(int argc, char** argv) {
+    int err = PVARS_OK;
+    if (argc > 1 && strcmp_simple(argv[1], "mount") == 0) {
+        err = pvars_mount();
+    } else if (!store.mounted) {
+        err = PVARS_ERR_NO_FILE;
+        if (!fat_mounted()) err = PVARS_ERR_NOT_MOUNTED;
+    } else if (argc < 2) {
+        print_status();
+    } else if (strcmp_simple(argv[1], "sync") == 0) {
+        err = commit();
+    } else if (strcmp_simple(argv[1], "compact") == 0) {
+        err = compact();
+    } else if (strcmp_simple(argv[1], "bench") == 0) {
+        long n = argc > 2 ? simple_atol(argv[2]) : 1000;
+        if (n <= 0) {
+            console_puts("Error: Invalid count\n");
+            return SHELL_ERROR;
+        }
+        err = bench(n);
+    } else {
+        console_puts("Error: unknown option ");
+        console_puts(argv[1]);
+        console_puts("\n");
+        return SHELL_ERROR;
+    }
+
+    if (err != PVARS_OK) {
+        console_puts("pvars: ");
+        console_puts(pvars_error_string(err));
+        console_puts("\n");
+        return SHELL_ERROR;
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND(pvars, cmd_pvars, "[sync|compact|mount|bench [n]] - variables saved in vars.log on the SD card");
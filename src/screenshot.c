@@ -0,0 +1,248 @@
+// src/screenshot.c
+#include "screenshot.h"
+#include "fb.h"
+#include "mem.h"
+#include "uart.h"
+#include "crc32.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+// Zuordnung Pixelwert -> Tabellenindex, direkt abgebildet. Kollisionen
+// kosten nur eine erneut übertragene Farbe, der Decoder merkt davon nichts.
+#define SHOT_HASH_SIZE 1024
+
+#define SHOT_BUFFER 256
+
+enum { RUN_NONE, RUN_COLOR, RUN_SKIP };
+
+typedef struct {
+    unsigned int palette[SHOT_PALETTE_SIZE]; // Pixelwerte im Framebuffer-Format
+    short hash[SHOT_HASH_SIZE];
+    unsigned int next;                       // Nächster freier Index
+
+    int run;                                 // RUN_...
+    unsigned int value;
+    unsigned long length;
+
+    unsigned char buffer[SHOT_BUFFER];
+    unsigned int fill;
+    unsigned int crc;
+    unsigned long bytes;
+} ShotEncoder;
+
+static ShotEncoder enc;
+
+// Voriger Frame (Pixelwerte) für den Delta-Modus
+static unsigned int* shot_prev;
+static unsigned long shot_prev_capacity;
+static unsigned int shot_prev_width, shot_prev_height, shot_prev_depth;
+
+// Eine Zeile, auf die Farbbits maskiert
+static unsigned int shot_line[4096];
+
+// ##################################
+// ## Ausgabe
+// ##################################
+
+static void shot_flush() {
+    enc.crc = crc32_update(enc.crc, enc.buffer, enc.fill);
+    for (unsigned int i = 0; i < enc.fill; i++) uart_writeByteBlocking(enc.buffer[i]);
+    enc.bytes += enc.fill;
+    enc.fill = 0;
+}
+
+static inline void shot_byte(unsigned int b) {
+    if (enc.fill == SHOT_BUFFER) shot_flush();
+    enc.buffer[enc.fill++] = b;
+}
+
+static void shot_varint(unsigned long v) {
+    while (v >= 0x80) {
+        shot_byte((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    shot_byte(v);
+}
+
+static inline unsigned int shot_hash(unsigned int v) {
+    return (v * 2654435761u) >> 22; // 10 Bit
+}
+
+static void shot_emit_run() {
+    unsigned long n = enc.length;
+    if (enc.run == RUN_SKIP) {
+        shot_byte(SHOT_SKIP);
+        shot_varint(n - 1);
+        return;
+    }
+    if (enc.run != RUN_COLOR) return;
+
+    unsigned int h = shot_hash(enc.value);
+    int idx = enc.hash[h];
+    if (idx < 0 || enc.palette[idx] != enc.value) {
+        idx = enc.next;
+        enc.next = enc.next == SHOT_PALETTE_SIZE - 1 ? SHOT_FIXED_COLORS : enc.next + 1;
+        enc.palette[idx] = enc.value;
+        enc.hash[h] = idx;
+        unsigned int rgb = fb_pixel_to_rgb(enc.value);
+        shot_byte(SHOT_NEW);
+        shot_byte(rgb >> 16);
+        shot_byte((rgb >> 8) & 0xFF);
+        shot_byte(rgb & 0xFF);
+        shot_varint(n - 1);
+    } else if (idx < SHOT_FIXED_COLORS && n <= 8) {
+        shot_byte(idx << 3 | (n - 1));
+    } else if (n <= 64) {
+        shot_byte(0x80 | (n - 1));
+        shot_byte(idx);
+    } else {
+        shot_byte(SHOT_RUN);
+        shot_byte(idx);
+        shot_varint(n - 1);
+    }
+}
+
+// ##################################
+// ## Kodierung
+// ##################################
+
+static void shot_read_row(int y, unsigned int width) {
+    const unsigned char* row = fb_buffer() + (long)y * fb_pitch();
+    switch (fb_depth()) {
+    case 32:
+        for (unsigned int x = 0; x < width; x++) shot_line[x] = ((const unsigned int*)row)[x] & 0xFFFFFF;
+        break;
+    case 16:
+        for (unsigned int x = 0; x < width; x++) shot_line[x] = ((const unsigned short*)row)[x];
+        break;
+    default:
+        for (unsigned int x = 0; x < width; x++) shot_line[x] = row[x];
+    }
+}
+
+/**
+ * Kodiert und sendet den Framebuffer. Mit delta werden unveränderte Pixel
+ * gegenüber dem letzten gesendeten Frame übersprungen, sofern Größe und
+ * Format gleich geblieben sind. Liefert die Anzahl gesendeter Bytes.
+ */
+static unsigned long screenshot_send(bool delta) {
+    unsigned int width = fb_width(), height = fb_height(), depth = fb_depth();
+    unsigned long pixels = (unsigned long)width * height;
+
+    if (pixels > shot_prev_capacity) {
+        unsigned int* buffer = mem_alloc(pixels * sizeof(unsigned int));
+        if (buffer != NULL) {
+            shot_prev = buffer;
+            shot_prev_capacity = pixels;
+        }
+        shot_prev_width = 0; // Inhalt ungültig
+    }
+    bool have_prev = pixels <= shot_prev_capacity;
+    if (width != shot_prev_width || height != shot_prev_height || depth != shot_prev_depth) delta = false;
+    if (!have_prev) delta = false;
+
+    enc.next = SHOT_FIXED_COLORS;
+    enc.run = RUN_NONE;
+    enc.length = 0;
+    enc.fill = 0;
+    enc.crc = 0;
+    enc.bytes = 0;
+    for (int i = 0; i < SHOT_HASH_SIZE; i++) enc.hash[i] = -1;
+
+    // Header mit den 16 Farben der Konsole als feste Startfarben
+    const char* magic = SHOT_MAGIC;
+    for (int i = 0; i < 4; i++) shot_byte(magic[i]);
+    shot_byte(SHOT_VERSION);
+    shot_byte(delta ? SHOT_FLAG_DELTA : 0);
+    shot_byte(width & 0xFF);
+    shot_byte(width >> 8);
+    shot_byte(height & 0xFF);
+    shot_byte(height >> 8);
+    for (int i = 0; i < SHOT_FIXED_COLORS; i++) {
+        unsigned int pixel = fb_color(i), rgb = fb_pixel_to_rgb(pixel);
+        enc.palette[i] = pixel;
+        enc.hash[shot_hash(pixel)] = i;
+        shot_byte(rgb >> 16);
+        shot_byte((rgb >> 8) & 0xFF);
+        shot_byte(rgb & 0xFF);
+    }
+
+    for (unsigned int y = 0; y < height; y++) {
+        unsigned int* prev = have_prev ? shot_prev + (unsigned long)y * width : NULL;
+        shot_read_row(y, width);
+        for (unsigned int x = 0; x < width; x++) {
+            unsigned int v = shot_line[x];
+            if (enc.run == RUN_COLOR && v == enc.value) {
+                enc.length++;
+            } else if (delta && prev[x] == v) {
+                if (enc.run != RUN_SKIP) {
+                    shot_emit_run();
+                    enc.run = RUN_SKIP;
+                    enc.length = 0;
+                }
+                enc.length++;
+            } else {
+                shot_emit_run();
+                enc.run = RUN_COLOR;
+                enc.value = v;
+                enc.length = 1;
+            }
+        }
+        if (prev) memcpy(prev, shot_line, width * sizeof(unsigned int));
+    }
+    shot_emit_run();
+    shot_byte(SHOT_END);
+    shot_flush();
+
+    unsigned int crc = enc.crc;
+    for (int i = 0; i < 4; i++) uart_writeByteBlocking((crc >> (8 * i)) & 0xFF);
+    uart_flush();
+
+    if (have_prev) {
+        shot_prev_width = width;
+        shot_prev_height = height;
+        shot_prev_depth = depth;
+    }
+    return enc.bytes + 4;
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+/**
+ * "screenshot [delta]": sendet den Bildschirm als Binärframe über den UART
+ * (tools/fbgrab schreibt daraus PNGs) und meldet danach Größe,
+ * Kompressionsrate gegenüber 24-Bit-RGB und Dauer.
+ */
+static int cmd_screenshot(int argc, char** argv) {
+    bool delta = argc == 2 && strcmp_simple(argv[1], "delta") == 0;
+    if ((argc == 2 && !delta) || argc > 2) {
+        console_puts("Usage: screenshot [delta]\n");
+        return SHELL_ERROR;
+    }
+    if (fb_buffer() == NULL || fb_width() > sizeof(shot_line) / sizeof(shot_line[0])) {
+        console_puts("Error: No framebuffer\n");
+        return SHELL_ERROR;
+    }
+
+    // Der Frame soll nicht mitten in noch wartender Konsolenausgabe landen
+    uart_flush();
+    fb_flush();
+    unsigned long start = timer_ticks();
+    unsigned long bytes = screenshot_send(delta);
+    unsigned long us = timer_ticks_to_us(timer_ticks() - start);
+
+    unsigned long raw = (unsigned long)fb_width() * fb_height() * 3;
+    console_puts("\nscreenshot: ");
+    console_putlong(bytes);
+    console_puts(" bytes, ratio ");
+    console_putlong(raw / bytes);
+    console_puts(":1 vs. RGB, ");
+    console_putlong(us / 1000);
+    console_puts(" ms\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(screenshot, cmd_screenshot, "[delta] - stream the screen over the UART (decode with tools/fbgrab)");
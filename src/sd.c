@@ -0,0 +1,576 @@
+// src/sd.c
+#include "sd.h"
+#include "regs.h"
+#include "mb.h"
+#include "mmu.h"
+#include "smp.h"
+#include "clock.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+#include "string_utils.h"
+
+// ##################################
+// ## Befehle und Register
+// ##################################
+
+// EMMC_CMDTM: Transfer-Modus (Bit 0-15) und Befehl (Bit 16-31)
+enum {
+    TM_DMA          = 1 << 0,
+    TM_BLOCK_COUNT  = 1 << 1,
+    TM_AUTO_CMD12   = 1 << 2,
+    TM_READ         = 1 << 4,
+    TM_MULTI_BLOCK  = 1 << 5,
+
+    CMD_RESP_NONE   = 0 << 16,
+    CMD_RESP_136    = 1 << 16,
+    CMD_RESP_48     = 2 << 16,
+    CMD_RESP_48BUSY = 3 << 16,
+    CMD_CRC_CHECK   = 1 << 19,
+    CMD_INDEX_CHECK = 1 << 20,
+    CMD_DATA        = 1 << 21
+};
+
+#define CMD_INDEX(n) ((unsigned int)(n) << 24)
+
+// Antworttypen der SD-Spezifikation
+#define RESP_R1  (CMD_RESP_48 | CMD_CRC_CHECK | CMD_INDEX_CHECK)
+#define RESP_R1B (CMD_RESP_48BUSY | CMD_CRC_CHECK | CMD_INDEX_CHECK)
+#define RESP_R2  (CMD_RESP_136 | CMD_CRC_CHECK)
+#define RESP_R3  CMD_RESP_48
+#define RESP_R6  RESP_R1
+#define RESP_R7  RESP_R1
+
+enum {
+    CMD_GO_IDLE          = CMD_INDEX(0)  | CMD_RESP_NONE,
+    CMD_ALL_SEND_CID     = CMD_INDEX(2)  | RESP_R2,
+    CMD_SEND_RCA         = CMD_INDEX(3)  | RESP_R6,
+    CMD_SWITCH_FUNC      = CMD_INDEX(6)  | RESP_R1 | CMD_DATA | TM_READ,
+    CMD_SELECT_CARD      = CMD_INDEX(7)  | RESP_R1B,
+    CMD_SEND_IF_COND     = CMD_INDEX(8)  | RESP_R7,
+    CMD_SEND_CSD         = CMD_INDEX(9)  | RESP_R2,
+    CMD_SET_BLOCKLEN     = CMD_INDEX(16) | RESP_R1,
+    CMD_READ_SINGLE      = CMD_INDEX(17) | RESP_R1 | CMD_DATA | TM_READ,
+    CMD_READ_MULTI       = CMD_INDEX(18) | RESP_R1 | CMD_DATA | TM_READ | TM_MULTI_BLOCK | TM_BLOCK_COUNT | TM_AUTO_CMD12,
+    CMD_WRITE_SINGLE     = CMD_INDEX(24) | RESP_R1 | CMD_DATA,
+    CMD_WRITE_MULTI      = CMD_INDEX(25) | RESP_R1 | CMD_DATA | TM_MULTI_BLOCK | TM_BLOCK_COUNT | TM_AUTO_CMD12,
+    CMD_APP_CMD          = CMD_INDEX(55) | RESP_R1,
+    CMD_STOP_TRANSMISSION = CMD_INDEX(12) | RESP_R1B,
+
+    ACMD_SET_BUS_WIDTH   = CMD_INDEX(6)  | RESP_R1,
+    ACMD_SD_SEND_OP_COND = CMD_INDEX(41) | RESP_R3
+};
+
+// EMMC_INTERRUPT
+enum {
+    INT_CMD_DONE  = 1 << 0,
+    INT_DATA_DONE = 1 << 1,
+    INT_ERROR     = 1 << 15,
+    INT_ERRORS    = 0xFFFF0000,
+    INT_CMD_ERRORS   = 0x000F0000, // Timeout, CRC, End-Bit, Index der Antwort
+    INT_CMD_TIMEOUT  = 1 << 16,
+    INT_DATA_TIMEOUT = 1 << 20
+};
+
+// OCR-Bits für ACMD41
+enum {
+    OCR_VOLTAGES = 0x00FF8000,  // 2,7-3,6 V
+    OCR_HCS      = 1u << 30,    // Host kann SDHC / Karte ist SDHC (CCS)
+    OCR_READY    = 1u << 31
+};
+
+#define SD_INIT_CLOCK        400000
+#define SD_DEFAULT_CLOCK     25000000
+#define SD_HIGH_SPEED_CLOCK  50000000
+
+#define CMD_TIMEOUT_US       100000
+// Busy nach einem Schreibzugriff oder STOP (R1b, DAT_INHIBIT): die
+// Spezifikation erlaubt 250 ms (SDSC/SDHC) bzw. 500 ms (SDXC), mit Reserve
+#define BUSY_TIMEOUT_US      1000000
+#define OP_COND_TIMEOUT_US   1000000
+#define DATA_TIMEOUT_US      500000   // Pro Befehl, plus DATA_TIMEOUT_PER_BLOCK
+#define DATA_TIMEOUT_PER_BLOCK 1000
+
+// Der GPIO-Expander schaltet die Signalspannung der Karte (0 = 3,3 V)
+#define EXPANDER_SD_IO_1V8   132
+
+// Ein Befehl überträgt höchstens 65535 Blöcke, ein ADMA2-Deskriptor 64 KB
+#define ADMA_MAX_LENGTH      65536
+#define ADMA_MAX_DESCRIPTORS (SD_MAX_SEGMENTS * 4)
+
+// ADMA2-Deskriptor, 32-Bit-Adressen
+typedef struct {
+    unsigned short attr;
+    unsigned short length;  // 0 = 65536
+    unsigned int address;
+} AdmaDescriptor;
+
+enum {
+    ADMA_VALID = 1 << 0,
+    ADMA_END   = 1 << 1,
+    ADMA_TRAN  = 2 << 4
+};
+
+// Der EMMC2 liegt beim BCM2711 hinter einem eigenen Bus (emmc2bus im Device
+// Tree). Ab Stepping C0 (Pi 400, Pi 4B ab Rev. 1.4) bildet er den ARM-Speicher
+// unterhalb von 0xFC000000 1:1 ab, beim B0 (Pi 4B Rev. 1.1/1.2) nur das erste
+// GB, und zwar ab der Busadresse 0xC0000000. Puffer und Deskriptoren müssen
+// dort also unter 1 GB liegen; Kernel und Heap liegen im ARM-Speicher der
+// Firmware und damit darunter (siehe mem.c).
+#define EMMC_BUS_ADDRESS(p) ((unsigned int)(unsigned long)(p) + emmc_bus_offset)
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+static SdCard card;
+static SdStats stats;
+static unsigned int last_interrupt; // Für Fehlermeldungen
+static unsigned int emmc_bus_offset; // 0 ab C0, 0xC0000000 beim B0
+
+static AdmaDescriptor adma_table[ADMA_MAX_DESCRIPTORS] __attribute__((aligned(CACHE_LINE)));
+
+// Puffer für den Status von CMD6 (64 Byte)
+static unsigned char switch_status[64] __attribute__((aligned(CACHE_LINE)));
+
+// ##################################
+// ## Hilfsfunktionen
+// ##################################
+
+static unsigned long deadline_after(unsigned long us) {
+    return timer_ticks() + us * timer_freq() / 1000000;
+}
+
+static bool expired(unsigned long deadline) {
+    return (long)(timer_ticks() - deadline) > 0;
+}
+
+// Wartet, bis das Feld den Wert hat; false bei Timeout
+static bool wait_field(RegField f, unsigned int value, unsigned long us) {
+    unsigned long deadline = deadline_after(us);
+    while (mmio_field_get(f) != value) {
+        if (expired(deadline)) return false;
+    }
+    return true;
+}
+
+// Wartet auf eines der Bits in INTERRUPT oder einen Fehler
+static int wait_interrupt(unsigned int mask, unsigned long us) {
+    unsigned long deadline = deadline_after(us);
+    unsigned int irq;
+    while (((irq = mmio_read(EMMC_INTERRUPT)) & (mask | INT_ERROR)) == 0) {
+        if (expired(deadline)) {
+            last_interrupt = irq;
+            return SD_ERR_TIMEOUT;
+        }
+    }
+    last_interrupt = irq;
+    if (irq & INT_ERRORS) {
+        mmio_write(EMMC_INTERRUPT, irq);
+        if (irq & (INT_CMD_TIMEOUT | INT_DATA_TIMEOUT)) return SD_ERR_TIMEOUT;
+        return (irq & INT_CMD_ERRORS) ? SD_ERR_COMMAND : SD_ERR_DATA;
+    }
+    mmio_write(EMMC_INTERRUPT, irq & mask);
+    return SD_OK;
+}
+
+// Setzt Befehls- und/oder Datenleitung nach einem Fehler zurück
+static void reset_lines(bool data) {
+    mmio_field_set(EMMC_CONTROL1_SRST_CMD, 1);
+    wait_field(EMMC_CONTROL1_SRST_CMD, 0, CMD_TIMEOUT_US);
+    if (data) {
+        mmio_field_set(EMMC_CONTROL1_SRST_DATA, 1);
+        wait_field(EMMC_CONTROL1_SRST_DATA, 0, CMD_TIMEOUT_US);
+    }
+    mmio_write(EMMC_INTERRUPT, 0xFFFFFFFF);
+}
+
+/**
+ * Sendet einen Befehl und wartet auf die Antwort (bei R1b auch auf das
+ * Ende des Busy-Signals). Datenbefehle warten hier nur auf die Antwort.
+ */
+static int sd_command(unsigned int cmdtm, unsigned int arg) {
+    bool busy = (cmdtm & CMD_RESP_48BUSY) == CMD_RESP_48BUSY;
+    if (!wait_field(EMMC_STATUS_CMD_INHIBIT, 0, CMD_TIMEOUT_US)) return SD_ERR_TIMEOUT;
+    if ((busy || (cmdtm & CMD_DATA)) && !wait_field(EMMC_STATUS_DAT_INHIBIT, 0, BUSY_TIMEOUT_US)) {
+        return SD_ERR_TIMEOUT;
+    }
+
+    stats.commands++;
+    mmio_write(EMMC_INTERRUPT, 0xFFFFFFFF);
+    mmio_write(EMMC_ARG1, arg);
+    mmio_write_sync(EMMC_CMDTM, cmdtm);
+
+    int err = wait_interrupt(INT_CMD_DONE, CMD_TIMEOUT_US);
+    if (err == SD_OK && busy) err = wait_interrupt(INT_DATA_DONE, BUSY_TIMEOUT_US);
+    if (err != SD_OK) {
+        stats.errors++;
+        reset_lines(busy);
+    }
+    return err;
+}
+
+static int sd_app_command(unsigned int cmdtm, unsigned int arg) {
+    int err = sd_command(CMD_APP_CMD, card.rca << 16);
+    if (err != SD_OK) return err;
+    return sd_command(cmdtm, arg);
+}
+
+/**
+ * Bustakt einstellen: SDCLK = Basistakt / (2 * Teiler), Teiler 0 = Basistakt.
+ * Der Basistakt kommt von der Firmware, sonst aus den Capabilities.
+ */
+static bool sd_set_clock(unsigned int hz) {
+    unsigned int base = clock_rate(CLOCK_EMMC2);
+    if (base == 0) base = mmio_field_get(EMMC_CAPABILITIES_BASE_MHZ) * 1000000;
+    if (base == 0) return false;
+
+    unsigned int divider = 0;
+    if (hz < base) {
+        divider = (base + 2 * hz - 1) / (2 * hz);
+        if (divider > 0x3FF) divider = 0x3FF;
+    }
+
+    wait_field(EMMC_STATUS_CMD_INHIBIT, 0, CMD_TIMEOUT_US);
+    wait_field(EMMC_STATUS_DAT_INHIBIT, 0, BUSY_TIMEOUT_US);
+    mmio_field_set(EMMC_CONTROL1_CLK_EN, 0);
+    timer_delay_us(10);
+
+    mmio_field_set(EMMC_CONTROL1_CLK_FREQ8, divider & 0xFF);
+    mmio_field_set(EMMC_CONTROL1_CLK_MS2, divider >> 8);
+    mmio_field_set(EMMC_CONTROL1_CLK_INTLEN, 1);
+    if (!wait_field(EMMC_CONTROL1_CLK_STABLE, 1, CMD_TIMEOUT_US)) return false;
+
+    mmio_field_set(EMMC_CONTROL1_CLK_EN, 1);
+    timer_delay_us(10);
+    card.clock = divider ? base / (2 * divider) : base;
+    return true;
+}
+
+// Signalspannung über den GPIO-Expander auf 3,3 V stellen
+static void sd_set_io_voltage() {
+    mbox[0] = 8 * 4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = MBOX_TAG_SETGPIOSTATE;
+    mbox[3] = 8;
+    mbox[4] = 0;
+    mbox[5] = EXPANDER_SD_IO_1V8;
+    mbox[6] = 0;
+    mbox[7] = MBOX_TAG_LAST;
+    mbox_call(MBOX_CH_PROP); // Ohne Expander (z.B. QEMU) bleibt es beim Standard
+}
+
+// ##################################
+// ## Datenübertragung
+// ##################################
+
+static int sd_transfer(unsigned int cmdtm, unsigned int arg, unsigned int block_size,
+                       const SdSegment* segs, unsigned int count) {
+    bool read = cmdtm & TM_READ;
+    unsigned long blocks = 0;
+    unsigned int n = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned long address = (unsigned long)segs[i].data;
+        unsigned long length = (unsigned long)segs[i].blocks * block_size;
+        if ((address | length) & (CACHE_LINE - 1)) return SD_ERR_ALIGN;
+
+        if (read) cache_flush(segs[i].data, length); // Keine schmutzigen Zeilen über dem DMA
+        else cache_clean(segs[i].data, length);
+
+        while (length > 0) {
+            unsigned long chunk = length < ADMA_MAX_LENGTH ? length : ADMA_MAX_LENGTH;
+            if (n == ADMA_MAX_DESCRIPTORS) return SD_ERR_RANGE;
+            adma_table[n].attr = ADMA_VALID | ADMA_TRAN;
+            adma_table[n].length = chunk & 0xFFFF;
+            adma_table[n].address = EMMC_BUS_ADDRESS(address);
+            address += chunk;
+            length -= chunk;
+            n++;
+        }
+        blocks += segs[i].blocks;
+    }
+    if (n == 0 || blocks > 0xFFFF) return SD_ERR_RANGE;
+    adma_table[n - 1].attr |= ADMA_END;
+    cache_clean(adma_table, sizeof(adma_table));
+
+    mmio_write(EMMC_BLKSIZECNT, blocks << 16 | block_size);
+    mmio_write(EMMC_ADMA_ADDR, EMMC_BUS_ADDRESS(adma_table));
+
+    int err = sd_command(cmdtm | TM_DMA, arg);
+    if (err == SD_OK) {
+        err = wait_interrupt(INT_DATA_DONE, DATA_TIMEOUT_US + blocks * DATA_TIMEOUT_PER_BLOCK);
+        if (err != SD_OK) {
+            stats.errors++;
+            reset_lines(true);
+            if (cmdtm & TM_MULTI_BLOCK) sd_command(CMD_STOP_TRANSMISSION, 0);
+        }
+    }
+
+    // Was die CPU während des DMA spekulativ geladen hat, ist veraltet
+    if (read) {
+        for (unsigned int i = 0; i < count; i++) cache_flush(segs[i].data, segs[i].blocks * block_size);
+    }
+    return err;
+}
+
+static int sd_transfer_blocks(bool write, unsigned long lba, const SdSegment* segs, unsigned int count) {
+    if (!card.ready) return SD_ERR_NO_CARD;
+    if (count == 0 || count > SD_MAX_SEGMENTS) return SD_ERR_RANGE;
+
+    unsigned long blocks = 0;
+    for (unsigned int i = 0; i < count; i++) blocks += segs[i].blocks;
+    if (blocks == 0 || lba + blocks > card.blocks) return SD_ERR_RANGE;
+
+    unsigned int cmdtm;
+    if (write) cmdtm = blocks > 1 ? CMD_WRITE_MULTI : CMD_WRITE_SINGLE;
+    else cmdtm = blocks > 1 ? CMD_READ_MULTI : CMD_READ_SINGLE;
+    unsigned int arg = card.sdhc ? lba : lba * SD_BLOCK_SIZE;
+
+    unsigned long start = timer_ticks();
+    int err = sd_transfer(cmdtm, arg, SD_BLOCK_SIZE, segs, count);
+    unsigned long ticks = timer_ticks() - start;
+
+    if (err == SD_OK && write) {
+        stats.write_commands++;
+        stats.write_blocks += blocks;
+        stats.write_ticks += ticks;
+    } else if (err == SD_OK) {
+        stats.read_commands++;
+        stats.read_blocks += blocks;
+        stats.read_ticks += ticks;
+    }
+    return err;
+}
+
+int sd_read(unsigned long lba, const SdSegment* segs, unsigned int count) {
+    return sd_transfer_blocks(false, lba, segs, count);
+}
+
+int sd_write(unsigned long lba, const SdSegment* segs, unsigned int count) {
+    return sd_transfer_blocks(true, lba, segs, count);
+}
+
+// Größter Transfer in einem Befehl für einen zusammenhängenden Puffer
+#define SD_MAX_CHUNK ((ADMA_MAX_DESCRIPTORS * ADMA_MAX_LENGTH) / SD_BLOCK_SIZE)
+
+static int sd_chunked(bool write, unsigned long lba, unsigned long blocks, void* buffer) {
+    unsigned char* p = buffer;
+    while (blocks > 0) {
+        unsigned long n = blocks < SD_MAX_CHUNK ? blocks : SD_MAX_CHUNK;
+        SdSegment seg = { p, n };
+        int err = sd_transfer_blocks(write, lba, &seg, 1);
+        if (err != SD_OK) return err;
+        lba += n;
+        blocks -= n;
+        p += n * SD_BLOCK_SIZE;
+    }
+    return SD_OK;
+}
+
+int sd_read_blocks(unsigned long lba, unsigned long blocks, void* buffer) {
+    return sd_chunked(false, lba, blocks, buffer);
+}
+
+int sd_write_blocks(unsigned long lba, unsigned long blocks, const void* buffer) {
+    return sd_chunked(true, lba, blocks, (void*)buffer);
+}
+
+// ##################################
+// ## Initialisierung
+// ##################################
+
+// Kapazität in Blöcken aus dem CSD (Antwort ohne CRC, d.h. CSD-Bit n = Bit n-8)
+static unsigned long csd_blocks(const unsigned int* r) {
+    unsigned int structure = (r[3] >> 22) & 3;
+    if (structure == 1) {
+        unsigned long c_size = (r[1] >> 8) & 0x3FFFFF;
+        return (c_size + 1) * 1024;
+    }
+    unsigned long c_size = (r[1] >> 22) | (r[2] & 3) << 10;
+    unsigned int mult = (r[1] >> 7) & 7;
+    unsigned int read_bl_len = (r[2] >> 8) & 0xF;
+    return ((c_size + 1) << (mult + 2)) << read_bl_len >> 9;
+}
+
+static void read_response(unsigned int* r) {
+    r[0] = mmio_read(EMMC_RESP0);
+    r[1] = mmio_read(EMMC_RESP1);
+    r[2] = mmio_read(EMMC_RESP2);
+    r[3] = mmio_read(EMMC_RESP3);
+}
+
+// CMD6: auf High Speed (Funktion 1 der Gruppe 1) umschalten, falls unterstützt
+static bool sd_switch_high_speed() {
+    SdSegment seg = { switch_status, 1 };
+    if (sd_transfer(CMD_SWITCH_FUNC, 0x80FFFFF1, sizeof(switch_status), &seg, 1) != SD_OK) return false;
+    // Bits 379-376: eingestellte Funktion der Gruppe 1
+    return (switch_status[16] & 0x0F) == 1;
+}
+
+// Busoffset des EMMC2 aus dem Revisionscode: neues Format (Bit 23), Typ in
+// den Bits 4-11 (0x11 = Pi 4B), Platinenrevision in den Bits 0-3
+static void sd_detect_bus_offset() {
+    mbox[0] = 7*4;
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = MBOX_TAG_GETBOARDREV;
+    mbox[3] = 4;
+    mbox[4] = 0;
+    mbox[5] = 0;
+    mbox[6] = MBOX_TAG_LAST;
+
+    emmc_bus_offset = 0;
+    if (!mbox_call(MBOX_CH_PROP)) return;
+    unsigned int rev = mbox[5];
+    if ((rev & (1u << 23)) && ((rev >> 4) & 0xFF) == 0x11 && (rev & 0xF) < 4) {
+        emmc_bus_offset = 0xC0000000;
+    }
+}
+
+int sd_init() {
+    memset(&card, 0, sizeof(card));
+    sd_detect_bus_offset();
+    sd_set_io_voltage();
+
+    // Controller zurücksetzen, Karte mit 3,3 V versorgen
+    mmio_write(EMMC_CONTROL2, 0);
+    mmio_field_set(EMMC_CONTROL1_SRST_HC, 1);
+    if (!wait_field(EMMC_CONTROL1_SRST_HC, 0, CMD_TIMEOUT_US)) return SD_ERR_TIMEOUT;
+    mmio_field_set(EMMC_CONTROL0_POWER, 0xF);
+    mmio_field_set(EMMC_CONTROL0_DMA_SELECT, 2);
+    mmio_field_set(EMMC_CONTROL1_TIMEOUT, 0xE);
+    if (!sd_set_clock(SD_INIT_CLOCK)) return SD_ERR_TIMEOUT;
+
+    // Alle Ereignisse im Statusregister sehen, aber keine Interrupts auslösen
+    mmio_write(EMMC_IRPT_EN, 0);
+    mmio_write(EMMC_IRPT_MASK, 0xFFFFFFFF);
+    mmio_write(EMMC_INTERRUPT, 0xFFFFFFFF);
+    timer_delay_us(1000);
+
+    sd_command(CMD_GO_IDLE, 0);
+
+    // CMD8 beantworten nur Karten nach Spezifikation 2.0 und neuer
+    bool v2 = sd_command(CMD_SEND_IF_COND, 0x1AA) == SD_OK && (mmio_read(EMMC_RESP0) & 0xFFF) == 0x1AA;
+
+    unsigned long deadline = deadline_after(OP_COND_TIMEOUT_US);
+    unsigned int ocr = 0;
+    do {
+        int err = sd_app_command(ACMD_SD_SEND_OP_COND, OCR_VOLTAGES | (v2 ? OCR_HCS : 0));
+        if (err != SD_OK) return err == SD_ERR_TIMEOUT ? SD_ERR_NO_CARD : err;
+        ocr = mmio_read(EMMC_RESP0);
+        if (ocr & OCR_READY) break;
+        timer_delay_us(10000);
+    } while (!expired(deadline));
+    if (!(ocr & OCR_READY)) return SD_ERR_TIMEOUT;
+    card.sdhc = ocr & OCR_HCS;
+
+    int err = sd_command(CMD_ALL_SEND_CID, 0);
+    if (err != SD_OK) return err;
+    read_response(card.cid);
+
+    if ((err = sd_command(CMD_SEND_RCA, 0)) != SD_OK) return err;
+    card.rca = mmio_read(EMMC_RESP0) >> 16;
+
+    unsigned int csd[4];
+    if ((err = sd_command(CMD_SEND_CSD, card.rca << 16)) != SD_OK) return err;
+    read_response(csd);
+    card.blocks = csd_blocks(csd);
+
+    if ((err = sd_command(CMD_SELECT_CARD, card.rca << 16)) != SD_OK) return err;
+    if ((err = sd_app_command(ACMD_SET_BUS_WIDTH, 2)) != SD_OK) return err;
+    mmio_field_set(EMMC_CONTROL0_BUS_4BIT, 1);
+    if (!card.sdhc && (err = sd_command(CMD_SET_BLOCKLEN, SD_BLOCK_SIZE)) != SD_OK) return err;
+
+    card.high_speed = sd_switch_high_speed();
+    if (card.high_speed) mmio_field_set(EMMC_CONTROL0_HIGH_SPEED, 1);
+    if (!sd_set_clock(card.high_speed ? SD_HIGH_SPEED_CLOCK : SD_DEFAULT_CLOCK)) return SD_ERR_TIMEOUT;
+
+    card.ready = true;
+    return SD_OK;
+}
+
+const SdCard* sd_card() {
+    return &card;
+}
+
+const SdStats* sd_stats() {
+    return &stats;
+}
+
+void sd_reset_stats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const char* sd_error_string(int err) {
+    switch (err) {
+    case SD_OK:          return "ok";
+    case SD_ERR_NO_CARD: return "no card";
+    case SD_ERR_TIMEOUT: return "timeout";
+    case SD_ERR_COMMAND: return "command error";
+    case SD_ERR_DATA:    return "data error";
+    case SD_ERR_ALIGN:   return "buffer not aligned";
+    case SD_ERR_RANGE:   return "block out of range";
+    default:             return "unknown error";
+    }
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+static void print_error(int err) {
+    console_puts("Error: ");
+    console_puts(sd_error_string(err));
+    console_puts(" (interrupt ");
+    console_puthex(last_interrupt);
+    console_puts(")\n");
+}
+
+static void print_hex_byte(unsigned char b) {
+    static const char digits[] = "0123456789abcdef";
+    char s[3] = { digits[b >> 4], digits[b & 15], '\0' };
+    console_puts(s);
+}
+
+/**
+ * "sd": Karteninfo, "sd init": neu initialisieren,
+ * "sd dump <lba>": einen Block als Hexdump ausgeben.
+ */
+static int cmd_sd(int argc, char** argv) {
+    if (argc >= 2 && strcmp_simple(argv[1], "init") == 0) {
+        int err = sd_init();
+        if (err != SD_OK) {
+            print_error(err);
+            return SHELL_ERROR;
+        }
+    } else if (argc == 3 && strcmp_simple(argv[1], "dump") == 0) {
+        static unsigned char block[SD_BLOCK_SIZE] __attribute__((aligned(CACHE_LINE)));
+        int err = sd_read_blocks(simple_atol(argv[2]), 1, block);
+        if (err != SD_OK) {
+            print_error(err);
+            return SHELL_ERROR;
+        }
+        for (int i = 0; i < SD_BLOCK_SIZE; i += 32) {
+            for (int j = 0; j < 32; j++) print_hex_byte(block[i + j]);
+            console_puts("\n");
+        }
+        return SHELL_OK;
+    } else if (argc != 1) {
+        console_puts("Usage: sd [init|dump <lba>]\n");
+        return SHELL_ERROR;
+    }
+
+    if (!card.ready) {
+        console_puts("No SD card\n");
+        return SHELL_ERROR;
+    }
+    console_puts(card.sdhc ? "SDHC/SDXC, " : "SDSC, ");
+    console_putlong(card.blocks / 2048);
+    console_puts(" MB, ");
+    console_putlong(card.clock / 1000);
+    console_puts(card.high_speed ? " kHz (high speed), RCA " : " kHz, RCA ");
+    console_puthex(card.rca);
+    console_puts("\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(sd, cmd_sd, "[init|dump <lba>] - SD card info, re-initialisation or block dump");
@@ -10,6 +10,11 @@
 #include "shell.h"
 #include "string_utils.h"
 #include "console.h"       // NEU: console.h für die vereinheitlichte Ausgabe
+#include "vars.h"
+#include "pvars.h"
+#include "expr.h"
+#include "timer.h"
+#include "mem.h"
 
 // ##################################
 // ## Private Datenstrukturen und globale Variablen
@@ -19,26 +24,33 @@
 static char input_buffer[INPUT_BUFFER_SIZE];
 static unsigned int input_buffer_pos = 0;
 
-#define MAX_VARIABLES 50
-#define MAX_VAR_NAME_LENGTH 16
+// Befehlstabelle: Deskriptoren liegen in der Linker-Section .shell_cmds
+extern const ShellCommand __shell_cmds_start[];
+extern const ShellCommand __shell_cmds_end[];
 
-typedef struct {
-    char name[MAX_VAR_NAME_LENGTH];
-    int value;
-} NamedVariable;
+// Hash-Index für O(1)-Dispatch (Füllgrad <= 50%, NULL = leer) und eine
+// nach Namen sortierte Liste für 'help'
+static const ShellCommand** command_index = NULL;
+static unsigned int command_index_mask = 0;
+static const ShellCommand** commands_sorted = NULL;
+static unsigned int command_count = 0;
 
-static NamedVariable variable_storage[MAX_VARIABLES];
-static unsigned int variable_count = 0;
+// Batch-Modus: eingeleitet durch den Befehl 'batch' oder diese Zeile
+#define BATCH_MAGIC "#!batch"
+#define BATCH_DEFAULT_SUMMARY 100
+static bool batch_active = false;
+
+// Ausführungszeit interaktiver Befehle (Enter bis Prompt) zum Vergleich
+static unsigned long interactive_commands = 0;
+static unsigned long interactive_ticks = 0;
 
 // ##################################
 // ## Private Funktionsprototypen (nur für diese Datei sichtbar)
 // ##################################
-static void process_command(char *buffer);
-static NamedVariable* find_variable(const char* name);
-static void set_variable(const char* name, int value);
-static int get_variable(const char* name, bool* success);
-static int evaluate_term(const char* term, bool* success);
-static int evaluate_expression(const char* expr, bool* success);
+static void build_command_table();
+static const ShellCommand* find_command(const char* name);
+static int tokenize(char* line, char** argv);
+static int cmd_batch(int argc, char** argv);
 
 
 // ##################################
@@ -47,21 +59,27 @@ static int evaluate_expression(const char* expr, bool* success);
 
 void shell_init() {
     input_buffer_pos = 0;
+    build_command_table();
     // Der Prompt wird jetzt hier initialisiert und in shell_update aufgerufen
     // (Oder direkt nach console_init() in kernel_main, wie vorgeschlagen)
 }
 
-void shell_update() {
+bool shell_update() {
     unsigned char byte;
-    // Versuche, ein Byte von der UART zu lesen
-    if (uart_read_byte(&byte)) { // WICHTIG: Hier weiterhin uart_read_byte() nutzen, da es der INPUT ist
+    bool busy = false;
+    // Alle bereits empfangenen Bytes abarbeiten, nicht nur eines pro Aufruf
+    while (uart_read_byte(&byte)) { // WICHTIG: Hier weiterhin uart_read_byte() nutzen, da es der INPUT ist
+        busy = true;
         // Enter wurde gedrückt
         if (byte == '\r') {
             console_puts("\n"); // Ausgabe über die Konsole (geht an UART und FB)
             input_buffer[input_buffer_pos] = '\0';
 
             if (input_buffer_pos > 0) {
-                process_command(input_buffer);
+                unsigned long start = timer_ticks();
+                shell_execute(input_buffer);
+                interactive_ticks += timer_ticks() - start;
+                interactive_commands++;
             }
             input_buffer_pos = 0;
             console_puts("> "); // Ausgabe über die Konsole
@@ -77,134 +95,341 @@ void shell_update() {
             console_putc(byte); // Echo des Zeichens über die Konsole
         }
     }
+    return busy;
+}
+
+int shell_execute(char* line) {
+    char* argv[SHELL_MAX_ARGS];
+    int argc = tokenize(line, argv);
+    if (argc == 0) return SHELL_OK;
+    if (argc < 0) {
+        console_puts("Error: Too many arguments (max ");
+        console_putint(SHELL_MAX_ARGS);
+        console_puts(")\n");
+        return SHELL_ERROR;
+    }
+
+    if (strcmp_simple(argv[0], BATCH_MAGIC) == 0) {
+        return cmd_batch(argc, argv);
+    }
+
+    const ShellCommand* cmd = find_command(argv[0]);
+    if (cmd == NULL) {
+        console_puts("Unknown command: '");
+        console_puts(argv[0]);
+        console_puts("'\n");
+        return SHELL_ERROR;
+    }
+    return cmd->handler(argc, argv);
+}
+
+char* shell_join_args(int argc, char** argv, int first, char* buffer, unsigned int size) {
+    unsigned int pos = 0;
+    for (int i = first; i < argc; i++) {
+        for (const char* p = argv[i]; *p != '\0' && pos + 1 < size; p++) {
+            buffer[pos++] = *p;
+        }
+        if (i + 1 < argc && pos + 1 < size) buffer[pos++] = ' ';
+    }
+    buffer[pos] = '\0';
+    return buffer;
 }
 
 // ##################################
-// ## Implementierung der privaten Funktionen
+// ## Befehlstabelle
 // ##################################
 
-// --- Variablenverwaltung ---
-static NamedVariable* find_variable(const char* name) {
-    for (unsigned int i = 0; i < variable_count; i++) {
-        if (strcmp_simple(name, variable_storage[i].name) == 0) {
-            return &variable_storage[i];
+static void build_command_table() {
+    command_count = __shell_cmds_end - __shell_cmds_start;
+
+    unsigned int size = 4;
+    while (size < 2 * command_count) size *= 2;
+    command_index = mem_alloc(size * sizeof(const ShellCommand*));
+    commands_sorted = mem_alloc(command_count * sizeof(const ShellCommand*));
+    if (command_index == NULL || commands_sorted == NULL) {
+        command_count = 0;
+        return;
+    }
+    memset(command_index, 0, size * sizeof(const ShellCommand*));
+    command_index_mask = size - 1;
+
+    for (unsigned int n = 0; n < command_count; n++) {
+        const ShellCommand* cmd = &__shell_cmds_start[n];
+
+        unsigned int i = hash_string(cmd->name) & command_index_mask;
+        while (command_index[i] != NULL) i = (i + 1) & command_index_mask;
+        command_index[i] = cmd;
+
+        // Insertion Sort - läuft nur einmal beim Start über wenige Einträge
+        unsigned int j = n;
+        while (j > 0 && strcmp_simple(commands_sorted[j - 1]->name, cmd->name) > 0) {
+            commands_sorted[j] = commands_sorted[j - 1];
+            j--;
         }
+        commands_sorted[j] = cmd;
     }
-    return NULL;
 }
 
-static void set_variable(const char* name, int value) {
-    NamedVariable* var = find_variable(name);
-    if (var != NULL) {
-        var->value = value;
-    } else {
-        if (variable_count < MAX_VARIABLES) {
-            strncpy_simple(variable_storage[variable_count].name, name, MAX_VAR_NAME_LENGTH);
-            variable_storage[variable_count].value = value;
-            variable_count++;
-        } else {
-            console_puts("Error: Maximum number of variables reached!\n"); // Ausgabe über die Konsole
+static const ShellCommand* find_command(const char* name) {
+    if (command_index == NULL) return NULL;
+
+    unsigned int i = hash_string(name) & command_index_mask;
+    while (command_index[i] != NULL) {
+        if (strcmp_simple(command_index[i]->name, name) == 0) {
+            return command_index[i];
         }
+        i = (i + 1) & command_index_mask;
     }
+    return NULL;
 }
 
-static int get_variable(const char* name, bool* success) {
-    NamedVariable* var = find_variable(name);
-    if (var != NULL) {
-        if (success) *success = true;
-        return var->value;
+/**
+ * Zerlegt die Zeile an Ort und Stelle in Wörter (Leerzeichen werden zu '\0').
+ * Liefert -1, wenn mehr als SHELL_MAX_ARGS Wörter in der Zeile stehen.
+ */
+static int tokenize(char* line, char** argv) {
+    int argc = 0;
+    char* p = line;
+    while (*p != '\0') {
+        while (*p == ' ') p++;
+        if (*p == '\0') break;
+        if (argc == SHELL_MAX_ARGS) return -1;
+        argv[argc++] = p;
+        while (*p != ' ' && *p != '\0') p++;
+        if (*p == ' ') *p++ = '\0';
     }
-    if (success) *success = false;
-    return 0;
+    return argc;
 }
 
-// --- Expression Evaluator ---
-static int evaluate_term(const char* term, bool* success) {
-    while (*term == ' ') term++;
-    if ((*term >= '0' && *term <= '9') || *term == '-') {
-        *success = true;
-        return simple_atoi(term);
-    } else {
-        return get_variable(term, success);
+// ##################################
+// ## Befehle
+// ##################################
+
+static int cmd_help(int argc, char** argv) {
+    console_puts("Commands:\n");
+    for (unsigned int i = 0; i < command_count; i++) {
+        console_puts(" - ");
+        console_puts(commands_sorted[i]->name);
+        console_puts(" ");
+        console_puts(commands_sorted[i]->help);
+        console_puts("\n");
     }
+    return SHELL_OK;
 }
+SHELL_COMMAND(help, cmd_help, "- list all commands");
 
-static int evaluate_expression(const char* expr, bool* success) {
-    char lhs_str[MAX_VAR_NAME_LENGTH];
-    char rhs_str[MAX_VAR_NAME_LENGTH];
-    const char* plus_operator = NULL;
+static int cmd_version(int argc, char** argv) {
+    console_puts("OhneBS v0.1.0-alpha\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(version, cmd_version, "- show the kernel version");
 
-    for (const char* p = expr; *p != '\0'; p++) {
-        if (*p == '+') {
-            plus_operator = p;
-            break;
+/**
+ * "set <name> <wert> [<name> <wert> ...]".
+ * Bei mehreren Paaren wird die Tabelle vorher einmal passend vergrößert,
+ * damit ein großer Block aus einem Skript nicht mehrfach rehasht.
+ */
+static int cmd_set(int argc, char** argv) {
+    if (argc < 3 || (argc & 1) == 0) {
+        console_puts("Usage: set <name> <value> [<name> <value> ...]\n");
+        return SHELL_ERROR;
+    }
+    vars_reserve((argc - 1) / 2);
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        int err = pvars_set(argv[i], simple_atol(argv[i + 1]));
+        if (err == PVARS_ERR_MEMORY) {
+            console_puts("Error: Out of memory for variables!\n");
+            return SHELL_ERROR;
+        }
+        // Ohne vars.log bleibt die Variable einfach flüchtig
+        if (err != PVARS_OK && err != PVARS_ERR_NOT_MOUNTED) {
+            console_puts("Warning: ");
+            console_puts(argv[i]);
+            console_puts(" not saved: ");
+            console_puts(pvars_error_string(err));
+            console_puts("\n");
         }
     }
+    console_puts("OK.\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(set, cmd_set, "<name> <value> [<name> <value> ...] - set variables");
 
-    if (plus_operator == NULL) {
-        return evaluate_term(expr, success);
+static int cmd_print(int argc, char** argv) {
+    char expr[INPUT_BUFFER_SIZE];
+    long result;
+    int err = expr_eval(shell_join_args(argc, argv, 1, expr, sizeof(expr)), &result);
+    if (err != EXPR_OK) {
+        console_puts("Error: ");
+        console_puts(expr_error_string(err));
+        console_puts("\n");
+        return SHELL_ERROR;
     }
+    console_putlong(result);
+    console_puts("\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(print, cmd_print, "<expr> - evaluate an expression");
 
-    int lhs_len = plus_operator - expr;
-    strncpy_simple(lhs_str, expr, lhs_len + 1);
-    strncpy_simple(rhs_str, plus_operator + 1, MAX_VAR_NAME_LENGTH);
+/**
+ * "exprbench <n> <expr>": misst Auswertungen pro Sekunde, einmal über den
+ * Cache (wie 'print' in Skripten) und einmal mit Parsen bei jedem Aufruf.
+ */
+static int cmd_exprbench(int argc, char** argv) {
+    char expr[INPUT_BUFFER_SIZE];
+    long result;
+    long iterations = argc > 2 ? simple_atol(argv[1]) : 0;
+    shell_join_args(argc, argv, 2, expr, sizeof(expr));
 
-    bool lhs_success, rhs_success;
-    int lhs_value = evaluate_term(lhs_str, &lhs_success);
-    int rhs_value = evaluate_term(rhs_str, &rhs_success);
+    if (iterations <= 0 || expr_eval(expr, &result) != EXPR_OK) {
+        console_puts("Usage: exprbench <n> <expr> (expression must be valid)\n");
+        return SHELL_ERROR;
+    }
 
-    if (lhs_success && rhs_success) {
-        *success = true;
-        return lhs_value + rhs_value;
+    unsigned long start = timer_ticks();
+    for (long i = 0; i < iterations; i++) {
+        expr_eval(expr, &result);
     }
+    unsigned long cached_us = timer_ticks_to_us(timer_ticks() - start);
 
-    *success = false;
-    return 0;
-}
+    ExprProgram prog;
+    start = timer_ticks();
+    for (long i = 0; i < iterations; i++) {
+        expr_compile(expr, &prog);
+        expr_run(&prog, &result);
+    }
+    unsigned long uncached_us = timer_ticks_to_us(timer_ticks() - start);
 
+    if (cached_us == 0) cached_us = 1;
+    if (uncached_us == 0) uncached_us = 1;
+    console_puts("cached:   ");
+    console_putlong(iterations * 1000000 / cached_us);
+    console_puts(" evals/s\nuncached: ");
+    console_putlong(iterations * 1000000 / uncached_us);
+    console_puts(" evals/s\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(exprbench, cmd_exprbench, "<n> <expr> - benchmark expression evaluation");
 
 // ##################################
-// ## Implementierung der privaten Funktionen (früher öffentlich aus shell.h)
+// ## Batch-Modus
 // ##################################
+// Für eingefügte Skripte: kein Echo, keine Ausgabe der einzelnen Befehle,
+// Flusskontrolle zum Sender und nur alle N Zeilen eine Zusammenfassung.
+
+// Liest eine ganze Zeile aus dem Empfangspuffer. -1 bei Ctrl-D (Ende).
+static int batch_read_line(char* buffer, unsigned int size) {
+    unsigned int len = 0;
+    unsigned char byte;
+    while (1) {
+        if (!uart_read_byte(&byte)) continue;
 
-static void process_command(char *buffer) {
-    char command[10];
-    char var_name[MAX_VAR_NAME_LENGTH];
-    // char number_buffer[12]; // Nicht mehr direkt benötigt, da console_putint() das übernimmt
-
-    int i = 0;
-    while(buffer[i] != ' ' && buffer[i] != '\0') {
-        if (i < 9) { command[i] = buffer[i]; }
-        i++;
-    }
-    command[i] = '\0';
-
-    if (strcmp_simple(command, "help") == 0) {
-        console_puts("Commands:\n - set <name> <value>\n - print <expr>\n - version\n"); // Ausgabe über die Konsole
-    } else if (strcmp_simple(command, "version") == 0) {
-        console_puts("OhneBS v0.1.0-alpha\n"); // Ausgabe über die Konsole
-    } else if (strcmp_simple(command, "set") == 0) {
-        char* name_start = buffer + i + 1;
-        int j = 0;
-        while(name_start[j] != ' ' && name_start[j] != '\0') j++;
-        strncpy_simple(var_name, name_start, j + 1);
-        char* value_start = name_start + j + 1;
-        int value = simple_atoi(value_start);
-        set_variable(var_name, value);
-        console_puts("OK.\n"); // Ausgabe über die Konsole
-    } else if (strcmp_simple(command, "print") == 0) {
-        char* expression = buffer + i + 1;
-        bool success;
-        int result = evaluate_expression(expression, &success);
-        if (success) {
-            console_putint(result); // NEU: Nutzt console_putint()
-            console_puts("\n");     // Ausgabe über die Konsole
-        } else {
-            console_puts("Error: Invalid expression or variable not found.\n"); // Ausgabe über die Konsole
+        if (byte == 0x04) return -1;
+        if (byte == '\r' || byte == '\n') {
+            if (len == 0) continue; // Leerzeilen und das \n von \r\n überspringen
+            buffer[len] = '\0';
+            return len;
         }
-    } else {
-        console_puts("Unknown command: '"); // Ausgabe über die Konsole
-        console_puts(buffer);               // Ausgabe über die Konsole
-        console_puts("'\n");               // Ausgabe über die Konsole
+        if (byte == '\t') byte = ' ';
+        if (byte >= ' ' && byte <= '~' && len < size - 1) {
+            buffer[len++] = byte;
+        }
+    }
+}
+
+// Befehle pro Sekunde aus Anzahl und Ticks
+static unsigned long commands_per_second(unsigned long count, unsigned long ticks) {
+    return ticks ? count * timer_freq() / ticks : 0;
+}
+
+static int cmd_batch(int argc, char** argv) {
+    if (batch_active) {
+        console_puts("Error: Already in batch mode\n");
+        return SHELL_ERROR;
+    }
+
+    long summary_every = argc > 1 ? simple_atol(argv[1]) : BATCH_DEFAULT_SUMMARY;
+    int flow = UART_FLOW_XONXOFF;
+    if (argc > 2 && strcmp_simple(argv[2], "rtscts") == 0) flow = UART_FLOW_RTSCTS;
+    if (summary_every <= 0) summary_every = BATCH_DEFAULT_SUMMARY;
+
+    console_puts("Batch mode: send lines, finish with 'end' or Ctrl-D\n");
+    batch_active = true;
+    uart_set_flow_control(flow);
+
+    char line[INPUT_BUFFER_SIZE];
+    unsigned long lines = 0, failed = 0, first_failed = 0;
+    unsigned long window_failed = 0;
+    unsigned long exec_ticks = 0;
+    unsigned long overruns_at_start = uart_rx_overruns();
+    unsigned long start = 0, window_start = 0;
+
+    while (batch_read_line(line, sizeof(line)) >= 0) {
+        if (strcmp_simple(line, "end") == 0) break;
+        if (line[0] == '#') continue; // Kommentar
+
+        unsigned long t0 = timer_ticks();
+        if (lines == 0) start = window_start = t0;
+
+        // Während des Befehls pollt niemand die UART
+        uart_pause_input();
+        console_set_mute(true);
+        int status = shell_execute(line);
+        console_set_mute(false);
+        uart_resume_input();
+
+        exec_ticks += timer_ticks() - t0;
+        lines++;
+        if (status != SHELL_OK) {
+            failed++;
+            window_failed++;
+            if (first_failed == 0) first_failed = lines;
+        }
+
+        if (lines % summary_every == 0) {
+            unsigned long now = timer_ticks();
+            console_puts("batch: lines ");
+            console_putlong(lines - summary_every + 1);
+            console_puts("-");
+            console_putlong(lines);
+            console_puts(": ");
+            console_putlong(summary_every - window_failed);
+            console_puts(" ok, ");
+            console_putlong(window_failed);
+            console_puts(" failed, ");
+            console_putlong(commands_per_second(summary_every, now - window_start));
+            console_puts(" cmds/s\n");
+            window_failed = 0;
+            window_start = now;
+        }
+    }
+    unsigned long wall_ticks = lines ? timer_ticks() - start : 0;
+
+    uart_set_flow_control(UART_FLOW_NONE);
+    batch_active = false;
+
+    console_puts("batch: ");
+    console_putlong(lines);
+    console_puts(" lines, ");
+    console_putlong(lines - failed);
+    console_puts(" ok, ");
+    console_putlong(failed);
+    console_puts(" failed");
+    if (failed) {
+        console_puts(" (first at line ");
+        console_putlong(first_failed);
+        console_puts(")");
     }
+    console_puts("\n  wall: ");
+    console_putlong(commands_per_second(lines, wall_ticks));
+    console_puts(" cmds/s, exec: ");
+    console_putlong(commands_per_second(lines, exec_ticks));
+    console_puts(" cmds/s, interactive exec: ");
+    console_putlong(commands_per_second(interactive_commands, interactive_ticks));
+    console_puts(" cmds/s\n  rx overruns: ");
+    console_putlong(uart_rx_overruns() - overruns_at_start);
+    console_puts("\n");
+    return failed ? SHELL_ERROR : SHELL_OK;
 }
+SHELL_COMMAND(batch, cmd_batch, "[n] [xonxoff|rtscts] - run piped lines silently, summary every n lines");
@@ -0,0 +1,139 @@
+// src/smp.c
+#include "smp.h"
+#include "mmu.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+// Stacks der Cores 1-3, boot.S setzt sp auf das Ende des jeweiligen Bereichs
+unsigned char smp_stacks[SMP_MAX_CORES - 1][SMP_STACK_SIZE] __attribute__((aligned(16)));
+
+extern char _start_secondary[];
+
+// Spin-Table der Firmware: Core n springt an die Adresse in 0xD8 + 8 * n
+#define SPIN_TABLE_BASE 0xD8
+
+/*
+ * Ein Auftrag pro Core, jeweils in einer eigenen Cache-Zeile. Core 0 zählt
+ * 'start' hoch, der Core meldet mit 'done' = start, dass er fertig ist.
+ * Es gibt nur Schreiber auf einer Seite je Feld, daher reichen
+ * Load-Acquire/Store-Release ohne atomare Read-Modify-Write-Befehle.
+ */
+typedef struct {
+    unsigned long start;
+    unsigned long done;
+    smp_work_t fn;
+    void* arg;
+    unsigned int cores;
+    unsigned int online;
+} __attribute__((aligned(CACHE_LINE))) SmpSlot;
+
+static SmpSlot smp_slots[SMP_MAX_CORES];
+static unsigned int smp_online = 1;
+static unsigned long smp_generation = 0;
+
+#define SMP_START_TIMEOUT_US 100000
+
+// ##################################
+// ## Cores 1-3
+// ##################################
+
+static void smp_signal() {
+    asm volatile("dsb ish; sev" ::: "memory");
+}
+
+// Aus boot.S, mit eigenem Stack, aber noch ohne MMU
+void smp_secondary_main(unsigned int core) {
+    // Erst mit eingeschalteter MMU sind Speicherzugriffe kohärent zu Core 0
+    mmu_enable();
+
+    SmpSlot* slot = &smp_slots[core];
+    __atomic_store_n(&slot->online, 1, __ATOMIC_RELEASE);
+    smp_signal();
+
+    unsigned long last = 0;
+    while (1) {
+        unsigned long gen;
+        while ((gen = __atomic_load_n(&slot->start, __ATOMIC_ACQUIRE)) == last) {
+            asm volatile("wfe");
+        }
+        last = gen;
+        slot->fn(core, slot->cores, slot->arg);
+        __atomic_store_n(&slot->done, gen, __ATOMIC_RELEASE);
+        smp_signal();
+    }
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void smp_init() {
+    // Die Cores starten ohne Cache und greifen direkt auf den Speicher zu.
+    // Keine veralteten Kopien ihrer Daten und Stacks im Cache von Core 0 lassen.
+    cache_flush(smp_slots, sizeof(smp_slots));
+    cache_flush(smp_stacks, sizeof(smp_stacks));
+
+    for (unsigned int core = 1; core < SMP_MAX_CORES; core++) {
+        volatile unsigned long* spin = (volatile unsigned long*)(unsigned long)(SPIN_TABLE_BASE + 8 * core);
+        *spin = (unsigned long)_start_secondary;
+        cache_clean(spin, sizeof(*spin));
+    }
+    smp_signal();
+
+    // Auf die Cores warten; fehlende werden einfach nicht benutzt
+    unsigned long start = timer_ticks();
+    unsigned long timeout = timer_freq() / 1000000 * SMP_START_TIMEOUT_US;
+    unsigned int online = 1;
+    while (timer_ticks() - start < timeout) {
+        online = 1;
+        while (online < SMP_MAX_CORES && __atomic_load_n(&smp_slots[online].online, __ATOMIC_ACQUIRE)) {
+            online++;
+        }
+        if (online == SMP_MAX_CORES) break;
+    }
+    smp_online = online;
+}
+
+unsigned int smp_cores() {
+    return smp_online;
+}
+
+void smp_run(smp_work_t fn, void* arg, unsigned int cores) {
+    if (cores < 1) cores = 1;
+    if (cores > smp_online) cores = smp_online;
+
+    unsigned long gen = ++smp_generation;
+    for (unsigned int core = 1; core < cores; core++) {
+        SmpSlot* slot = &smp_slots[core];
+        slot->fn = fn;
+        slot->arg = arg;
+        slot->cores = cores;
+        __atomic_store_n(&slot->start, gen, __ATOMIC_RELEASE);
+    }
+    if (cores > 1) smp_signal();
+
+    fn(0, cores, arg);
+
+    for (unsigned int core = 1; core < cores; core++) {
+        while (__atomic_load_n(&smp_slots[core].done, __ATOMIC_ACQUIRE) != gen) {
+            asm volatile("wfe");
+        }
+    }
+}
+
+// ##################################
+// ## Shell
+// ##################################
+
+static int cmd_cores(int argc, char** argv) {
+    console_puts("Cores online: ");
+    console_putint(smp_online);
+    console_puts("\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND(cores, cmd_cores, "- show how many CPU cores are running");
@@ -28,7 +28,7 @@ static void reverse_string(char *str, int length) {
  * Wandelt einen String in einen int um. Berücksichtigt negative Zahlen.
  */
 int simple_atoi(const char *str) {
-    int res = 0;
+    unsigned int res = 0; // Wie simple_atol: Überlauf modulo 2^32
     bool is_negative = false;
     if (*str == '-') {
         is_negative = true;
@@ -38,7 +38,7 @@ int simple_atoi(const char *str) {
         res = res * 10 + (*str - '0');
         str++;
     }
-    return is_negative ? -res : res;
+    return (int)(is_negative ? 0 - res : res);
 }
 
 /**
@@ -85,6 +85,48 @@ char* simple_itoa(int value, char *buffer) {
     return buffer;
 }
 
+/**
+ * Wandelt einen String in einen long (64 Bit) um. Berücksichtigt negative Zahlen.
+ * Gerechnet wird unsigned, zu lange Zahlen laufen also definiert modulo 2^64
+ * über statt mit undefiniertem Verhalten.
+ */
+long simple_atol(const char *str) {
+    unsigned long res = 0;
+    bool is_negative = false;
+    if (*str == '-') {
+        is_negative = true;
+        str++;
+    }
+    while (*str >= '0' && *str <= '9') {
+        res = res * 10 + (*str - '0');
+        str++;
+    }
+    return (long)(is_negative ? 0 - res : res);
+}
+
+/**
+ * Wandelt einen long (64 Bit) in einen String um.
+ * Rechnet intern mit dem Betrag als unsigned long, damit auch der
+ * minimale long-Wert ohne Sonderfall funktioniert.
+ */
+char* simple_ltoa(long value, char *buffer) {
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    int i = 0;
+
+    do {
+        buffer[i++] = (magnitude % 10) + '0';
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (value < 0) {
+        buffer[i++] = '-';
+    }
+
+    buffer[i] = '\0';
+    reverse_string(buffer, i);
+    return buffer;
+}
+
 /**
  * Vergleicht zwei Strings.
  */
@@ -122,6 +164,100 @@ void strncpy_simple(char *dest, const char *src, unsigned int n) {
     *dest = '\0';
 }
 
+/**
+ * Liefert die Länge eines null-terminierten Strings.
+ */
+unsigned int strlen_simple(const char *s) {
+    const char *p = s;
+    while (*p) p++;
+    return p - s;
+}
+
+/**
+ * FNV-1a (32 Bit). Schnell, gut verteilt und ohne Tabellen.
+ */
+unsigned int hash_string(const char *s) {
+    unsigned int h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Wie hash_string, aber über genau len Zeichen (z.B. einen Pfad ohne "/" am Ende)
+unsigned int hash_string_n(const char *s, unsigned int len) {
+    unsigned int h = 2166136261u;
+    for (unsigned int i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// ##################################
+// ## Speicherfunktionen
+// ##################################
+// Die Schleifen dürfen von GCC nicht selbst wieder zu memcpy/memset-Aufrufen
+// "optimiert" werden, sonst rufen sich die Funktionen endlos selbst auf.
+#define NO_LIBCALL __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+NO_LIBCALL void* memcpy(void *dest, const void *src, unsigned long n) {
+    unsigned char *d = dest;
+    const unsigned char *s = src;
+
+    // Wenn beide Zeiger gleich ausgerichtet sind, in 8-Byte-Schritten kopieren
+    if ((((unsigned long)d | (unsigned long)s) & 7) == 0) {
+        while (n >= 8) {
+            *(unsigned long*)d = *(const unsigned long*)s;
+            d += 8;
+            s += 8;
+            n -= 8;
+        }
+    }
+    while (n--) *d++ = *s++;
+    return dest;
+}
+
+NO_LIBCALL void* memmove(void *dest, const void *src, unsigned long n) {
+    unsigned char *d = dest;
+    const unsigned char *s = src;
+
+    if (d <= s || d >= s + n) {
+        return memcpy(dest, src, n);
+    }
+    // Überlappend mit Ziel hinter der Quelle: rückwärts kopieren
+    while (n--) d[n] = s[n];
+    return dest;
+}
+
+NO_LIBCALL void* memset(void *dest, int c, unsigned long n) {
+    unsigned char *d = dest;
+    while (n && ((unsigned long)d & 7)) {
+        *d++ = (unsigned char)c;
+        n--;
+    }
+    unsigned long pattern = (unsigned char)c * 0x0101010101010101UL;
+    while (n >= 8) {
+        *(unsigned long*)d = pattern;
+        d += 8;
+        n -= 8;
+    }
+    while (n--) *d++ = (unsigned char)c;
+    return dest;
+}
+
+NO_LIBCALL int memcmp(const void *s1, const void *s2, unsigned long n) {
+    const unsigned char *a = s1;
+    const unsigned char *b = s2;
+    while (n--) {
+        if (*a != *b) return *a - *b;
+        a++;
+        b++;
+    }
+    return 0;
+}
+
 // Implementierung für simple_uint_to_hex_string
 char* simple_uint_to_hex_string(unsigned int value, char* buffer) {
     char hex_digits[] = "0123456789ABCDEF";
@@ -0,0 +1,421 @@
+// src/task.c
+#include "task.h"
+#include "smp.h"
+#include "fb.h"
+#include "crc32.h"
+#include "timer.h"
+#include "shell.h"
+#include "console.h"
+
+#define DEQUE_SIZE 256 // Zweierpotenz
+
+// Fehlt fn, ist es ein Teilbereich eines parallel_for (arg zeigt auf ForContext)
+typedef struct {
+    task_fn_t fn;
+    void* arg;
+    TaskGroup* group;
+    unsigned long begin, end;
+} Task;
+
+typedef struct {
+    task_range_fn_t fn;
+    void* arg;
+    unsigned long grain;
+} ForContext;
+
+/*
+ * Chase-Lev-Deque mit festem Ring, in der Fassung für schwache
+ * Speichermodelle (Lê, Pop, Cohen, Zappa Nardelli, PPoPP 2013). Nur der
+ * Besitzer schreibt bottom, Diebe einigen sich per CAS auf top. Ein Dieb
+ * kopiert die Aufgabe vor dem CAS; geht der CAS schief, wird die Kopie
+ * verworfen. Der Besitzer überschreibt einen Platz erst, wenn top daran
+ * vorbei ist (push prüft auf vollen Ring).
+ */
+typedef struct {
+    long top __attribute__((aligned(CACHE_LINE)));
+    long bottom __attribute__((aligned(CACHE_LINE)));
+    Task tasks[DEQUE_SIZE];
+} Deque;
+
+typedef enum { STEAL_OK, STEAL_EMPTY, STEAL_ABORT } StealResult;
+
+// ##################################
+// ## Private Variablen
+// ##################################
+
+// Statistik und Zufallszustand, eine Cache-Zeile pro Core
+typedef struct {
+    TaskStats stats;
+    unsigned int seed;
+} __attribute__((aligned(CACHE_LINE))) CoreState;
+
+static Deque deques[SMP_MAX_CORES];
+static CoreState cores_state[SMP_MAX_CORES];
+
+static bool session_active = false;
+static unsigned int session_cores = 1;
+static bool session_done = false;
+
+// ##################################
+// ## Deque
+// ##################################
+
+static bool deque_push(Deque* d, const Task* t) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    long top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    if (b - top >= DEQUE_SIZE) return false;
+    d->tasks[b & (DEQUE_SIZE - 1)] = *t;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static bool deque_take(Deque* d, Task* t) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long top = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+    if (top > b) {
+        // Leer
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    *t = d->tasks[b & (DEQUE_SIZE - 1)];
+    if (top < b) return true;
+
+    // Letzte Aufgabe: gegen die Diebe um top wetteifern
+    bool won = __atomic_compare_exchange_n(&d->top, &top, top + 1, false,
+                                           __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    return won;
+}
+
+static StealResult deque_steal(Deque* d, Task* t) {
+    long top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (top >= b) return STEAL_EMPTY;
+
+    *t = d->tasks[top & (DEQUE_SIZE - 1)];
+    if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return STEAL_ABORT;
+    }
+    return STEAL_OK;
+}
+
+// ##################################
+// ## Ausführen
+// ##################################
+
+static void task_signal() {
+    asm volatile("dsb ish; sev" ::: "memory");
+}
+
+static void run_range(const ForContext* ctx, unsigned long begin, unsigned long end);
+
+static void execute(unsigned int core, const Task* t) {
+    if (t->fn != NULL) t->fn(t->arg);
+    else run_range(t->arg, t->begin, t->end);
+    cores_state[core].stats.executed++;
+
+    // Der Wartende schläft womöglich in wfe
+    if (__atomic_sub_fetch(&t->group->pending, 1, __ATOMIC_ACQ_REL) == 0) task_signal();
+}
+
+static void spawn(TaskGroup* group, const Task* t) {
+    unsigned int core = smp_core_id();
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+    if (!deque_push(&deques[core], t)) {
+        cores_state[core].stats.overflows++;
+        execute(core, t);
+        return;
+    }
+    task_signal();
+}
+
+// xorshift pro Core, damit nicht alle Diebe beim selben Opfer anfangen
+static unsigned int next_victim(unsigned int core) {
+    unsigned int x = cores_state[core].seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    cores_state[core].seed = x;
+    return x % session_cores;
+}
+
+/**
+ * Führt eine Aufgabe aus: zuerst die eigene jüngste, sonst eine gestohlene.
+ * false, wenn es nirgends Arbeit gab und kein Diebstahl an einem anderen
+ * Dieb gescheitert ist (dann lohnt sich Schlafen).
+ */
+static bool run_one(unsigned int core) {
+    Task t;
+    if (deque_take(&deques[core], &t)) {
+        execute(core, &t);
+        return true;
+    }
+
+    bool contended = false;
+    unsigned int start = next_victim(core);
+    for (unsigned int i = 0; i < session_cores; i++) {
+        unsigned int victim = (start + i) % session_cores;
+        if (victim == core) continue;
+        StealResult r = deque_steal(&deques[victim], &t);
+        if (r == STEAL_OK) {
+            cores_state[core].stats.stolen++;
+            execute(core, &t);
+            return true;
+        }
+        cores_state[core].stats.steal_failed++;
+        if (r == STEAL_ABORT) contended = true;
+    }
+    return contended;
+}
+
+static void run_range(const ForContext* ctx, unsigned long begin, unsigned long end) {
+    TaskGroup group = TASK_GROUP_INIT;
+    // Obere Hälften abspalten, bis der Rest höchstens grain groß ist
+    while (end - begin > ctx->grain) {
+        unsigned long mid = begin + (end - begin) / 2;
+        Task t = { NULL, (void*)ctx, &group, mid, end };
+        spawn(&group, &t);
+        end = mid;
+    }
+    ctx->fn(begin, end, ctx->arg);
+    task_wait(&group);
+}
+
+// ##################################
+// ## Sitzung
+// ##################################
+
+typedef struct {
+    task_fn_t fn;
+    void* arg;
+} Root;
+
+static void session_worker(unsigned int core, unsigned int cores, void* arg) {
+    if (core == 0) {
+        const Root* root = arg;
+        root->fn(root->arg);
+        __atomic_store_n(&session_done, true, __ATOMIC_RELEASE);
+        task_signal();
+        return;
+    }
+    while (!__atomic_load_n(&session_done, __ATOMIC_ACQUIRE)) {
+        if (!run_one(core)) {
+            cores_state[core].stats.sleeps++;
+            asm volatile("wfe");
+        }
+    }
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+void task_run(task_fn_t fn, void* arg, unsigned int cores) {
+    if (session_active) {
+        fn(arg);
+        return;
+    }
+    if (cores < 1) cores = 1;
+    if (cores > smp_cores()) cores = smp_cores();
+
+    for (unsigned int i = 0; i < SMP_MAX_CORES; i++) {
+        deques[i].top = deques[i].bottom = 0;
+        if (cores_state[i].seed == 0) cores_state[i].seed = 2463534242u + i * 7919;
+    }
+    session_cores = cores;
+    session_done = false;
+    session_active = true;
+
+    Root root = { fn, arg };
+    smp_run(session_worker, &root, cores);
+    session_active = false;
+}
+
+void task_spawn(TaskGroup* group, task_fn_t fn, void* arg) {
+    if (!session_active) {
+        fn(arg);
+        return;
+    }
+    Task t = { fn, arg, group, 0, 0 };
+    spawn(group, &t);
+}
+
+void task_wait(TaskGroup* group) {
+    unsigned int core = smp_core_id();
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) != 0) {
+        if (!run_one(core)) {
+            cores_state[core].stats.sleeps++;
+            asm volatile("wfe");
+        }
+    }
+}
+
+typedef struct {
+    ForContext ctx;
+    unsigned long begin, end;
+} ForRoot;
+
+static void parallel_for_root(void* arg) {
+    const ForRoot* root = arg;
+    run_range(&root->ctx, root->begin, root->end);
+}
+
+void parallel_for(unsigned long begin, unsigned long end, unsigned long grain,
+                  task_range_fn_t fn, void* arg) {
+    if (begin >= end) return;
+    ForRoot root = { { fn, arg, grain ? grain : 1 }, begin, end };
+    if (session_active) parallel_for_root(&root);
+    else task_run(parallel_for_root, &root, smp_cores());
+}
+
+const TaskStats* task_stats(unsigned int core) {
+    return core < SMP_MAX_CORES ? &cores_state[core].stats : NULL;
+}
+
+void task_reset_stats() {
+    for (unsigned int i = 0; i < SMP_MAX_CORES; i++) cores_state[i].stats = (TaskStats){ 0 };
+}
+
+// ##################################
+// ## Benchmark
+// ##################################
+
+#define MANDEL_MAX_ITER 256
+
+typedef struct {
+    unsigned int pixel[MANDEL_MAX_ITER + 1]; // Farbe je Iterationszahl im fb-Format
+    double x0, y0, step;
+} Mandel;
+
+// Eine Zeile der Mandelbrot-Menge direkt in den Framebuffer
+static void mandel_row(const Mandel* m, unsigned int y) {
+    unsigned char* row = fb_buffer() + (unsigned long)y * fb_pitch();
+    unsigned int bytes = fb_depth() / 8;
+    double ci = m->y0 + y * m->step;
+    for (unsigned int x = 0; x < fb_width(); x++) {
+        double cr = m->x0 + x * m->step;
+        double zr = 0, zi = 0;
+        unsigned int i = 0;
+        while (i < MANDEL_MAX_ITER && zr * zr + zi * zi <= 4.0) {
+            double t = zr * zr - zi * zi + cr;
+            zi = 2 * zr * zi + ci;
+            zr = t;
+            i++;
+        }
+        unsigned int p = m->pixel[i];
+        if (bytes == 4) ((unsigned int*)row)[x] = p;
+        else if (bytes == 2) ((unsigned short*)row)[x] = p;
+        else row[x] = p;
+    }
+}
+
+static void mandel_rows(unsigned long begin, unsigned long end, void* arg) {
+    for (unsigned long y = begin; y < end; y++) mandel_row(arg, y);
+}
+
+typedef struct {
+    Mandel* m;
+    unsigned long grain;
+} MandelJob;
+
+static void mandel_stolen(void* arg) {
+    const MandelJob* job = arg;
+    parallel_for(0, fb_height(), job->grain, mandel_rows, job->m);
+}
+
+// Zum Vergleich: feste Aufteilung in gleich hohe Streifen
+static void mandel_static(unsigned int core, unsigned int cores, void* arg) {
+    unsigned int h = fb_height();
+    mandel_rows(h * core / cores, h * (core + 1) / cores, arg);
+}
+
+static unsigned int fb_crc() {
+    unsigned int crc = 0;
+    for (unsigned int y = 0; y < fb_height(); y++) {
+        crc = crc32_update(crc, fb_buffer() + y * fb_pitch(), fb_width() * (fb_depth() / 8));
+    }
+    return crc;
+}
+
+static void print_speedup(unsigned long base_us, unsigned long us) {
+    console_puts(" x");
+    console_putlong(base_us * 100 / us / 100);
+    console_puts(".");
+    long frac = base_us * 100 / us % 100;
+    if (frac < 10) console_puts("0");
+    console_putlong(frac);
+}
+
+/**
+ * "mandel [grain]": zeichnet die Mandelbrot-Menge mit 1 bis 4 Cores, einmal
+ * mit parallel_for (grain Zeilen pro Aufgabe) und einmal in festen
+ * Streifen. Die Mitte des Bildes braucht viel mehr Iterationen als der
+ * Rand, feste Streifen sind daher schlecht verteilt. Die CRC muss überall
+ * gleich sein.
+ */
+static int cmd_mandel(int argc, char** argv) {
+    long grain = argc > 1 ? simple_atol(argv[1]) : 2;
+    if (grain <= 0 || fb_buffer() == NULL) {
+        console_puts("Error: Invalid grain or no framebuffer\n");
+        return SHELL_ERROR;
+    }
+
+    static Mandel m;
+    for (unsigned int i = 0; i < MANDEL_MAX_ITER; i++) {
+        unsigned int r = i * 9 & 0xFF, g = i * 3 & 0xFF, b = (128 + i * 5) & 0xFF;
+        m.pixel[i] = fb_map_rgb(r << 16 | g << 8 | b);
+    }
+    m.pixel[MANDEL_MAX_ITER] = fb_map_rgb(0);
+    m.step = 3.0 / fb_width();
+    m.x0 = -2.1;
+    m.y0 = -m.step * fb_height() / 2;
+    MandelJob job = { &m, grain };
+
+    unsigned long base_us = 0;
+    for (unsigned int cores = 1; cores <= smp_cores(); cores++) {
+        task_reset_stats();
+        // mandel_row schreibt direkt in den Framebuffer
+        fb_begin_draw(0, 0, fb_width() - 1, fb_height() - 1);
+        unsigned long start = timer_ticks();
+        task_run(mandel_stolen, &job, cores);
+        unsigned long us = timer_ticks_to_us(timer_ticks() - start);
+        unsigned int crc = fb_crc();
+
+        start = timer_ticks();
+        smp_run(mandel_static, &m, cores);
+        unsigned long static_us = timer_ticks_to_us(timer_ticks() - start);
+        // Vor jeder Ausgabe: die Konsole zeichnet in denselben Framebuffer
+        unsigned int static_crc = fb_crc();
+        if (us == 0) us = 1;
+        if (static_us == 0) static_us = 1;
+        if (cores == 1) base_us = us;
+
+        unsigned long stolen = 0;
+        for (unsigned int c = 0; c < cores; c++) stolen += cores_state[c].stats.stolen;
+
+        console_putint(cores);
+        console_puts(" core(s): ");
+        console_putlong(us / 1000);
+        console_puts(" ms");
+        print_speedup(base_us, us);
+        console_puts(", ");
+        console_putlong(stolen);
+        console_puts(" stolen; static split ");
+        console_putlong(static_us / 1000);
+        console_puts(" ms");
+        print_speedup(base_us, static_us);
+        console_puts(", crc ");
+        console_puthex(crc);
+        console_puts(crc == static_crc ? "\n" : " MISMATCH\n");
+    }
+    fb_mark_dirty(0, 0, fb_width() - 1, fb_height() - 1);
+    fb_flush();
+    return SHELL_OK;
+}
+SHELL_COMMAND(mandel, cmd_mandel, "[grain] - Mandelbrot work-stealing benchmark on 1-4 cores");
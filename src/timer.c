@@ -0,0 +1,41 @@
+// src/timer.c
+#include "timer.h"
+
+unsigned long timer_ticks() {
+    unsigned long ticks;
+    // isb verhindert, dass der Zähler vor vorherigen Befehlen gelesen wird
+    asm volatile("isb; mrs %0, cntpct_el0" : "=r"(ticks) :: "memory");
+    return ticks;
+}
+
+unsigned long timer_cycles() {
+    static int enabled = 0;
+    if (!enabled) {
+        // PMCR: E (Bit 0) an, C (Bit 2) setzt den Zyklenzähler zurück
+        asm volatile("msr pmcr_el0, %0" :: "r"(1ul | (1ul << 2)));
+        // PMCNTENSET: Bit 31 schaltet PMCCNTR ein
+        asm volatile("msr pmcntenset_el0, %0" :: "r"(1ul << 31));
+        enabled = 1;
+    }
+    unsigned long cycles;
+    asm volatile("isb; mrs %0, pmccntr_el0" : "=r"(cycles) :: "memory");
+    return cycles;
+}
+
+unsigned long timer_freq() {
+    unsigned long freq;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq;
+}
+
+unsigned long timer_ticks_to_us(unsigned long ticks) {
+    unsigned long freq = timer_freq();
+    // In zwei Schritten rechnen, damit ticks * 1000000 nicht überläuft
+    return (ticks / freq) * 1000000 + ((ticks % freq) * 1000000) / freq;
+}
+
+void timer_delay_us(unsigned long us) {
+    unsigned long start = timer_ticks();
+    unsigned long wait = (timer_freq() * us) / 1000000;
+    while (timer_ticks() - start < wait);
+}
@@ -1,32 +1,41 @@
 #include "uart.h"
-#include "gpio.h" // Wird für gpio_useAsAlt5 und PERIPHERAL_BASE benötigt
+#include "gpio.h" // Wird für gpio_useAsAlt5 benötigt
+#include "regs.h" // AUX-Register
 
 //==================================================================
 // Private Defines und globale Variablen
 // 'static' macht sie nur in dieser Datei sichtbar.
 //==================================================================
 enum {
-    AUX_BASE        = PERIPHERAL_BASE + 0x215000,
-    AUX_ENABLES     = AUX_BASE + 4,
-    AUX_MU_IO_REG   = AUX_BASE + 64,
-    AUX_MU_IER_REG  = AUX_BASE + 68,
-    AUX_MU_IIR_REG  = AUX_BASE + 72,
-    AUX_MU_LCR_REG  = AUX_BASE + 76,
-    AUX_MU_MCR_REG  = AUX_BASE + 80,
-    AUX_MU_LSR_REG  = AUX_BASE + 84,
-    AUX_MU_CNTL_REG = AUX_BASE + 96,
-    AUX_MU_STAT_REG = AUX_BASE + 100,
-    AUX_MU_BAUD_REG = AUX_BASE + 104,
-    AUX_UART_CLOCK  = 500000000,
-    UART_MAX_QUEUE  = 16 * 1024
+    UART_BAUD       = 115200,
+    UART_MAX_QUEUE  = 16 * 1024,
+    UART_RX_QUEUE   = 4 * 1024
 };
 
-#define AUX_MU_BAUD(baud) ((AUX_UART_CLOCK/(baud*8))-1)
+// Flusskontrolle: XOFF ab 3/4 Füllstand, XON wieder unter 1/4.
+// Der Rest des Puffers fängt Bytes auf, die der Sender nach dem XOFF noch schickt.
+#define UART_RX_HIGH_WATER (UART_RX_QUEUE * 3 / 4)
+#define UART_RX_LOW_WATER  (UART_RX_QUEUE / 4)
+#define XON  0x11
+#define XOFF 0x13
+
+#define AUX_MU_BAUD(clock, baud) (((clock)/((baud)*8))-1)
+
+// Der Mini-UART läuft mit dem VPU-Kerntakt; clock.c meldet Änderungen
+static unsigned int uart_clock = 500000000;
 
 static unsigned char uart_output_queue[UART_MAX_QUEUE];
 static unsigned int uart_output_queue_write = 0;
 static unsigned int uart_output_queue_read = 0;
 
+static unsigned char uart_input_queue[UART_RX_QUEUE];
+static unsigned int uart_input_queue_write = 0;
+static unsigned int uart_input_queue_read = 0;
+static unsigned int uart_input_overruns = 0;
+
+static int uart_flow_mode = UART_FLOW_NONE;
+static bool uart_input_stopped = false; // XOFF wurde gesendet
+
 //==================================================================
 // Private Hilfsfunktionen
 //==================================================================
@@ -36,7 +45,7 @@ static bool uart_isOutputQueueEmpty() {
 }
 
 static bool uart_isWriteByteReady() {
-    return mmio_read(AUX_MU_LSR_REG) & 0x20;
+    return mmio_field_get(AUX_MU_LSR_TX_EMPTY);
 }
 
 static void uart_writeByteBlockingActual(unsigned char ch) {
@@ -44,7 +53,40 @@ static void uart_writeByteBlockingActual(unsigned char ch) {
     mmio_write(AUX_MU_IO_REG, (unsigned int)ch);
 }
 
+static unsigned int uart_inputQueueLevel() {
+    return (uart_input_queue_write - uart_input_queue_read) & (UART_RX_QUEUE - 1);
+}
+
+/**
+ * Holt alle Bytes aus der 8 Byte kleinen Hardware-FIFO in den Empfangspuffer.
+ * Wird bei jedem Lese- und Schreibzugriff aufgerufen, damit auch während
+ * längerer Ausgaben nichts verloren geht.
+ */
+static void uart_pollInput() {
+    unsigned int lsr;
+    while (mmio_field_extract(AUX_MU_LSR_DATA_READY, lsr = mmio_read(AUX_MU_LSR_REG))) {
+        if (mmio_field_extract(AUX_MU_LSR_RX_OVERRUN, lsr)) uart_input_overruns++; // Hardware-FIFO ist übergelaufen
+
+        unsigned char ch = (unsigned char)mmio_read(AUX_MU_IO_REG);
+        unsigned int next = (uart_input_queue_write + 1) & (UART_RX_QUEUE - 1);
+        if (next == uart_input_queue_read) {
+            uart_input_overruns++; // Puffer voll, Byte verwerfen
+            continue;
+        }
+        uart_input_queue[uart_input_queue_write] = ch;
+        uart_input_queue_write = next;
+    }
+
+    // XOFF geht direkt an die Hardware, nicht hinter die Sende-Queue
+    if (uart_flow_mode == UART_FLOW_XONXOFF && !uart_input_stopped
+        && uart_inputQueueLevel() >= UART_RX_HIGH_WATER) {
+        uart_writeByteBlockingActual(XOFF);
+        uart_input_stopped = true;
+    }
+}
+
 static void uart_loadOutputFifo() {
+    uart_pollInput();
     while (!uart_isOutputQueueEmpty() && uart_isWriteByteReady()) {
         uart_writeByteBlockingActual(uart_output_queue[uart_output_queue_read]);
         uart_output_queue_read = (uart_output_queue_read + 1) & (UART_MAX_QUEUE - 1);
@@ -57,16 +99,17 @@ static void uart_loadOutputFifo() {
 //==================================================================
 
 void uart_init() {
+    dmb(); // Vorherige Zugriffe auf andere Peripherie abschließen
     mmio_write(AUX_ENABLES, 1); //enable UART1
     mmio_write(AUX_MU_IER_REG, 0);
     mmio_write(AUX_MU_CNTL_REG, 0);
     mmio_write(AUX_MU_LCR_REG, 3); //8 bits
     mmio_write(AUX_MU_MCR_REG, 0);
     mmio_write(AUX_MU_IIR_REG, 0xC6); //disable interrupts
-    mmio_write(AUX_MU_BAUD_REG, AUX_MU_BAUD(115200));
+    mmio_write(AUX_MU_BAUD_REG, AUX_MU_BAUD(uart_clock, UART_BAUD));
     gpio_useAsAlt5(14);
     gpio_useAsAlt5(15);
-    mmio_write(AUX_MU_CNTL_REG, 3); //enable RX/TX
+    mmio_write_release(AUX_MU_CNTL_REG, 3); //enable RX/TX (nach den GPIO-Zugriffen)
 }
 
 void uart_writeByteBlocking(unsigned char ch) {
@@ -79,6 +122,7 @@ void uart_writeByteBlocking(unsigned char ch) {
 
     uart_output_queue[uart_output_queue_write] = ch;
     uart_output_queue_write = next;
+    uart_pollInput();
 }
 
 void uart_writeText(const char *buffer) {
@@ -93,21 +137,106 @@ void uart_writeText(const char *buffer) {
     uart_loadOutputFifo();
 }
 
+/**
+ * Blockiert, bis die Sende-Queue komplett an die Hardware übergeben ist.
+ */
+void uart_flush() {
+    while (!uart_isOutputQueueEmpty()) {
+        uart_loadOutputFifo();
+    }
+}
+
+/**
+ * Wie uart_flush, wartet aber zusätzlich, bis FIFO und Schieberegister leer
+ * sind. Vor jeder Änderung des Kerntakts nötig: Bytes, die danach noch in
+ * der FIFO stehen, gingen mit dem falschen Teiler hinaus.
+ */
+void uart_drain() {
+    uart_flush();
+    while (!mmio_field_get(AUX_MU_LSR_TX_IDLE));
+}
+
+/**
+ * Rechnet den Baudraten-Teiler für einen neuen Kerntakt neu aus. Vorher
+ * wird alles Gepufferte mit dem alten Teiler gesendet.
+ */
+void uart_set_clock(unsigned int hz) {
+    if (hz == 0 || hz == uart_clock) return;
+    uart_drain();
+    uart_clock = hz;
+    mmio_write(AUX_MU_BAUD_REG, AUX_MU_BAUD(uart_clock, UART_BAUD));
+}
+
 /**
  * Prüft, ob ein Byte zum Lesen bereitsteht.
  * Wenn ja, wird es in den 'byte'-Pointer geschrieben und 'true' zurückgegeben.
  * Diese Funktion blockiert nicht.
  */
 bool uart_read_byte(unsigned char* byte) {
-    // Bearbeite die Sende-Queue, auch wenn wir auf Empfang prüfen
+    // Bearbeite die Sende-Queue, auch wenn wir auf Empfang prüfen.
+    // Dabei wird auch die Hardware-FIFO in den Empfangspuffer geleert.
     uart_loadOutputFifo();
 
-    // Prüfe das "data ready" Bit im Line Status Register
-    if (mmio_read(AUX_MU_LSR_REG) & 0x01) {
-        // Lese das Zeichen aus dem IO-Register
-        *byte = (unsigned char)mmio_read(AUX_MU_IO_REG);
-        return true;
+    if (uart_input_queue_read == uart_input_queue_write) {
+        return false;
+    }
+    *byte = uart_input_queue[uart_input_queue_read];
+    uart_input_queue_read = (uart_input_queue_read + 1) & (UART_RX_QUEUE - 1);
+
+    if (uart_input_stopped && uart_inputQueueLevel() <= UART_RX_LOW_WATER) {
+        uart_writeByteBlockingActual(XON);
+        uart_input_stopped = false;
+    }
+    return true;
+}
+
+/**
+ * Wählt die Flusskontrolle für den Empfang.
+ * UART_FLOW_XONXOFF: Software, funktioniert mit jedem 3-Draht-Adapter.
+ * UART_FLOW_RTSCTS:  Hardware über GPIO 16 (CTS) und 17 (RTS). Die Mini-UART
+ *                    nimmt RTS selbst weg, sobald ihre FIFO fast voll ist -
+ *                    auch wenn die Software gerade nicht pollt.
+ */
+void uart_set_flow_control(int mode) {
+    unsigned int cntl = mmio_field_mask(AUX_MU_CNTL_RX_ENABLE) | mmio_field_mask(AUX_MU_CNTL_TX_ENABLE);
+
+    if (uart_input_stopped) {
+        uart_writeByteBlockingActual(XON);
+        uart_input_stopped = false;
+    }
+    if (mode == UART_FLOW_RTSCTS) {
+        gpio_useAsAlt5(16); // CTS1
+        gpio_useAsAlt5(17); // RTS1
+        // RTS/CTS-Automatik; RTS-Level 0: RTS weg bei 3 freien FIFO-Plätzen
+        cntl |= mmio_field_mask(AUX_MU_CNTL_RTS_AUTO) | mmio_field_mask(AUX_MU_CNTL_CTS_AUTO);
     }
+    uart_loadOutputFifo();
+    mmio_write_release(AUX_MU_CNTL_REG, cntl);
+    uart_flow_mode = mode;
+}
+
+/**
+ * Hält den Sender mit XOFF an, solange niemand die Hardware-FIFO leert, z.B.
+ * während die Batch-Shell einen Befehl ausführt. Sonst läuft die 8 Byte
+ * kleine FIFO über, lange bevor der Empfangspuffer die Hochwassermarke
+ * erreicht. Ohne XON/XOFF tut die Funktion nichts.
+ */
+void uart_pause_input() {
+    uart_pollInput();
+    if (uart_flow_mode != UART_FLOW_XONXOFF || uart_input_stopped) return;
+    uart_writeByteBlockingActual(XOFF);
+    uart_input_stopped = true;
+}
+
+// Gibt den Sender wieder frei, außer der Empfangspuffer ist noch zu voll
+// (dann schickt uart_read_byte das XON, sobald er geleert ist)
+void uart_resume_input() {
+    uart_pollInput();
+    if (!uart_input_stopped || uart_inputQueueLevel() > UART_RX_LOW_WATER) return;
+    uart_writeByteBlockingActual(XON);
+    uart_input_stopped = false;
+}
 
-    return false;
+unsigned int uart_rx_overruns() {
+    return uart_input_overruns;
 }
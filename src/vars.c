@@ -0,0 +1,162 @@
+// src/vars.c
+#include "vars.h"
+#include "mem.h"
+
+// ##################################
+// ## Private Datenstrukturen und globale Variablen
+// ##################################
+
+#define VARS_INITIAL_CAPACITY 64     // Zweierpotenz
+#define NAME_ARENA_CHUNK      4096   // Bytes pro Arena-Block für Namen
+
+// Dichte Arrays, indiziert über den Slot
+long* vars_values = NULL;
+static unsigned int* var_hashes = NULL;
+static const char** var_names = NULL;
+static unsigned int var_count = 0;
+static unsigned int var_capacity = 0;
+
+// Hash-Index: enthält Slot + 1, 0 bedeutet "leer".
+// Er ist immer doppelt so groß wie var_capacity (Füllgrad <= 50%).
+static unsigned int* var_index = NULL;
+static unsigned int var_index_mask = 0;
+
+// Arena für die Namen
+static char* name_arena = NULL;
+static unsigned int name_arena_left = 0;
+
+// ##################################
+// ## Private Hilfsfunktionen
+// ##################################
+
+static const char* intern_name(const char* name, unsigned int len) {
+    if (len + 1 > name_arena_left) {
+        unsigned int chunk = len + 1 > NAME_ARENA_CHUNK ? len + 1 : NAME_ARENA_CHUNK;
+        name_arena = mem_alloc(chunk);
+        if (name_arena == NULL) {
+            name_arena_left = 0;
+            return NULL;
+        }
+        name_arena_left = chunk;
+    }
+    char* copy = name_arena;
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    name_arena += len + 1;
+    name_arena_left -= len + 1;
+    return copy;
+}
+
+static void index_insert(unsigned int slot) {
+    unsigned int i = var_hashes[slot] & var_index_mask;
+    while (var_index[i] != 0) {
+        i = (i + 1) & var_index_mask;
+    }
+    var_index[i] = slot + 1;
+}
+
+// Vergrößert alle Arrays auf 'capacity' (Zweierpotenz) und baut den Index neu auf
+static bool grow(unsigned int capacity) {
+    long* values = mem_alloc(capacity * sizeof(long));
+    unsigned int* hashes = mem_alloc(capacity * sizeof(unsigned int));
+    const char** names = mem_alloc(capacity * sizeof(const char*));
+    unsigned int* index = mem_alloc(2 * capacity * sizeof(unsigned int));
+    if (values == NULL || hashes == NULL || names == NULL || index == NULL) {
+        return false;
+    }
+
+    if (var_count > 0) {
+        memcpy(values, vars_values, var_count * sizeof(long));
+        memcpy(hashes, var_hashes, var_count * sizeof(unsigned int));
+        memcpy(names, var_names, var_count * sizeof(const char*));
+    }
+    memset(index, 0, 2 * capacity * sizeof(unsigned int));
+
+    vars_values = values;
+    var_hashes = hashes;
+    var_names = names;
+    var_index = index;
+    var_index_mask = 2 * capacity - 1;
+    var_capacity = capacity;
+
+    // Die Hashes sind gespeichert, der Rehash muss keinen Namen mehr anfassen
+    for (unsigned int slot = 0; slot < var_count; slot++) {
+        index_insert(slot);
+    }
+    return true;
+}
+
+static int lookup(const char* name, unsigned int hash) {
+    if (var_index == NULL) return -1;
+
+    unsigned int i = hash & var_index_mask;
+    while (var_index[i] != 0) {
+        unsigned int slot = var_index[i] - 1;
+        if (var_hashes[slot] == hash && strcmp_simple(var_names[slot], name) == 0) {
+            return slot;
+        }
+        i = (i + 1) & var_index_mask;
+    }
+    return -1;
+}
+
+static int insert(const char* name, unsigned int hash) {
+    if (var_count == var_capacity && !vars_reserve(1)) {
+        return -1;
+    }
+    const char* interned = intern_name(name, strlen_simple(name));
+    if (interned == NULL) return -1;
+
+    unsigned int slot = var_count++;
+    var_names[slot] = interned;
+    var_hashes[slot] = hash;
+    vars_values[slot] = 0;
+    index_insert(slot);
+    return slot;
+}
+
+// ##################################
+// ## Öffentliche Funktionen
+// ##################################
+
+bool vars_reserve(unsigned int count) {
+    unsigned int needed = var_count + count;
+    if (needed <= var_capacity) return true;
+
+    unsigned int capacity = var_capacity ? var_capacity : VARS_INITIAL_CAPACITY;
+    while (capacity < needed) capacity *= 2;
+    return grow(capacity);
+}
+
+int vars_slot(const char* name) {
+    return lookup(name, hash_string(name));
+}
+
+int vars_intern(const char* name) {
+    unsigned int hash = hash_string(name);
+    int slot = lookup(name, hash);
+    if (slot < 0) slot = insert(name, hash);
+    return slot;
+}
+
+bool vars_set(const char* name, long value) {
+    int slot = vars_intern(name);
+    if (slot < 0) return false;
+    vars_values[slot] = value;
+    return true;
+}
+
+bool vars_get(const char* name, long* value) {
+    int slot = vars_slot(name);
+    if (slot < 0) return false;
+    *value = vars_values[slot];
+    return true;
+}
+
+const char* vars_slot_name(int slot) {
+    return var_names[slot];
+}
+
+unsigned int vars_count() {
+    return var_count;
+}
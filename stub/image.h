@@ -0,0 +1,21 @@
+// stub/image.h
+#ifndef STUB_IMAGE_H
+#define STUB_IMAGE_H
+
+/**
+ * Format des komprimierten Kernels, erzeugt von tools/mklz4 und entpackt
+ * vom Stub (stub/stub.c). Auf den Header folgt der Kernel als ein
+ * einziger LZ4-Block (das Blockformat von lz4, ohne Frame). Alle Zahlen
+ * little-endian.
+ */
+
+#define ZIMAGE_MAGIC 0x5A53424F // "OBSZ"
+
+typedef struct {
+    unsigned int magic;         // ZIMAGE_MAGIC
+    unsigned int raw_size;      // Größe des entpackten Kernels
+    unsigned int packed_size;   // Größe des LZ4-Blocks nach dem Header
+    unsigned int load_addr;     // Ziel- und Startadresse (0x80000)
+} ZimageHeader;
+
+#endif // STUB_IMAGE_H
@@ -0,0 +1,184 @@
+// stub/stub.c
+// Entpack-Stub: liegt mit dem LZ4-komprimierten Kernel (tools/mklz4) in
+// einem Image, entpackt ihn nach 0x80000 und springt hinein. Format siehe
+// image.h.
+#include "string_utils.h" // Für bool
+#include "image.h"
+
+// Nutzlast, von objcopy in die Section .payload gelegt (siehe link.ld)
+extern const unsigned char __payload_start[];
+extern const unsigned char __payload_end[];
+extern char __stub_start[];
+
+extern void stub_jump(unsigned long entry, unsigned long dtb);
+
+// Platz für den Stack unterhalb des Stubs
+#define STUB_STACK_RESERVE 0x10000
+
+// Die Kopierschleifen schreiben bis zu 28 Bytes über das Ende hinaus
+#define WILDCOPY_SLACK 32
+
+// 16 Bytes in einem NEON-Register, ohne Ausrichtung (ldr/str q)
+typedef unsigned char u8x16 __attribute__((vector_size(16), aligned(1)));
+
+// ##################################
+// ## MMU
+// ##################################
+
+/*
+ * Ohne MMU gilt jeder Datenzugriff als Device-Speicher: ungecacht und ohne
+ * ungeausgerichtete Zugriffe. Zum Entpacken reicht eine Identitätsabbildung
+ * der unteren 4 GB mit 1-GB-Blöcken: RAM gecacht, das letzte GB (mit den
+ * Peripherie-Registern) als Device.
+ */
+
+// Indizes in MAIR (wie in src/mmu.c)
+enum {
+    MT_DEVICE = 0,
+    MT_NORMAL = 1
+};
+#define MAIR_VALUE ((0x00ul << (8 * MT_DEVICE)) | (0xFFul << (8 * MT_NORMAL)))
+
+#define PTE_BLOCK      (1ul << 0)
+#define PTE_ATTR(i)    ((unsigned long)(i) << 2)
+#define PTE_AP_RES1    (1ul << 6)  // Im EL2-Regime RES1, in EL1 "EL0-Zugriff"
+#define PTE_INNER_SH   (3ul << 8)
+#define PTE_AF         (1ul << 10)
+
+// 4 KB Granule, 32-Bit-Adressraum (T0SZ = 32, Start auf Level 1),
+// Tabellenzugriffe gecacht und Inner Shareable
+#define TCR_COMMON ((32ul << 0) | (1ul << 8) | (1ul << 10) | (3ul << 12))
+#define TCR_EL1_VALUE (TCR_COMMON | (1ul << 23))               // EPD1: kein TTBR1
+#define TCR_EL2_VALUE (TCR_COMMON | (1ul << 23) | (1ul << 31)) // RES1-Bits
+
+#define SCTLR_M (1ul << 0)
+#define SCTLR_A (1ul << 1)
+#define SCTLR_C (1ul << 2)
+#define SCTLR_I (1ul << 12)
+
+#define GB (1ul << 30)
+
+static unsigned long page_table[512] __attribute__((aligned(4096)));
+
+static unsigned long current_el() {
+    unsigned long el;
+    asm volatile("mrs %0, CurrentEL" : "=r"(el));
+    return (el >> 2) & 3;
+}
+
+static void mmu_enable() {
+    bool el2 = current_el() == 2;
+    for (unsigned long i = 0; i < 4; i++) {
+        unsigned long desc = i * GB | PTE_BLOCK | PTE_AF | PTE_INNER_SH;
+        desc |= PTE_ATTR(i == 3 ? MT_DEVICE : MT_NORMAL);
+        if (el2) desc |= PTE_AP_RES1;
+        page_table[i] = desc;
+    }
+    asm volatile("dsb sy");
+
+    unsigned long sctlr;
+    if (el2) {
+        asm volatile("msr mair_el2, %0" :: "r"(MAIR_VALUE));
+        asm volatile("msr tcr_el2, %0" :: "r"(TCR_EL2_VALUE));
+        asm volatile("msr ttbr0_el2, %0" :: "r"(page_table));
+        asm volatile("isb; tlbi alle2; dsb sy; isb");
+        asm volatile("mrs %0, sctlr_el2" : "=r"(sctlr));
+        sctlr = (sctlr & ~SCTLR_A) | SCTLR_M | SCTLR_C | SCTLR_I;
+        asm volatile("msr sctlr_el2, %0; isb" :: "r"(sctlr) : "memory");
+    } else {
+        asm volatile("msr mair_el1, %0" :: "r"(MAIR_VALUE));
+        asm volatile("msr tcr_el1, %0" :: "r"(TCR_EL1_VALUE));
+        asm volatile("msr ttbr0_el1, %0" :: "r"(page_table));
+        asm volatile("isb; tlbi vmalle1; dsb sy; isb");
+        asm volatile("mrs %0, sctlr_el1" : "=r"(sctlr));
+        sctlr = (sctlr & ~SCTLR_A) | SCTLR_M | SCTLR_C | SCTLR_I;
+        asm volatile("msr sctlr_el1, %0; isb" :: "r"(sctlr) : "memory");
+    }
+}
+
+// ##################################
+// ## LZ4
+// ##################################
+
+static inline void copy16(unsigned char* dst, const unsigned char* src) {
+    *(u8x16*)dst = *(const u8x16*)src;
+}
+
+// Länge mit Fortsetzungsbytes (255 = es folgt noch eines)
+static inline unsigned long read_length(const unsigned char** in, unsigned long len) {
+    if (len == 15) {
+        unsigned int b;
+        do {
+            b = *(*in)++;
+            len += b;
+        } while (b == 255);
+    }
+    return len;
+}
+
+/**
+ * Entpackt einen LZ4-Block. Literale und Matches werden in 16-Byte-
+ * Schritten kopiert und dürfen dabei über ihr Ende hinausschreiben; das
+ * folgende Stück überschreibt den Rest wieder. So kommen die häufigen
+ * kurzen Sequenzen ganz ohne Schleife aus. Liefert das Ende der Ausgabe.
+ */
+static unsigned char* lz4_decode(const unsigned char* in, unsigned long size, unsigned char* out) {
+    const unsigned char* end = in + size;
+    while (in < end) {
+        unsigned int token = *in++;
+
+        unsigned long len = read_length(&in, token >> 4);
+        copy16(out, in); // Meist reicht eine Kopie (bis 14 Literale ohne Längenbyte)
+        for (unsigned long i = 16; i < len; i += 16) copy16(out + i, in + i);
+        out += len;
+        in += len;
+        if (in >= end) break; // Die letzte Sequenz hat keinen Match
+
+        unsigned long offset = in[0] | in[1] << 8;
+        in += 2;
+        len = read_length(&in, token & 15) + 4;
+        const unsigned char* match = out - offset;
+
+        if (offset >= 16) {
+            copy16(out, match); // Bis 18 Bytes ohne Längenbyte
+            copy16(out + 16, match + 16);
+            for (unsigned long i = 32; i < len; i += 16) copy16(out + i, match + i);
+        } else {
+            // Kurzer Abstand (z.B. Nullfolgen): die ersten 16 Bytes einzeln,
+            // danach wiederholt sich das Muster im Abstand eines Vielfachen
+            // von offset, das mindestens 16 ist
+            unsigned long i = 0, n = len < 16 ? len : 16;
+            for (; i < n; i++) out[i] = match[i];
+            unsigned long step = offset * ((16 + offset - 1) / offset);
+            for (; i < len; i += 16) copy16(out + i, out + i - step);
+        }
+        out += len;
+    }
+    return out;
+}
+
+// ##################################
+// ## Einstieg
+// ##################################
+
+static void hang() {
+    while (1) asm volatile("wfe");
+}
+
+void stub_main(unsigned long dtb) {
+    const ZimageHeader* header = (const ZimageHeader*)__payload_start;
+    const unsigned char* packed = __payload_start + sizeof(ZimageHeader);
+    unsigned long limit = (unsigned long)__stub_start - STUB_STACK_RESERVE;
+
+    if (header->magic != ZIMAGE_MAGIC || packed + header->packed_size > __payload_end ||
+        header->load_addr + (unsigned long)header->raw_size + WILDCOPY_SLACK > limit) {
+        hang();
+    }
+
+    mmu_enable();
+    unsigned char* out = (unsigned char*)(unsigned long)header->load_addr;
+    unsigned char* end = lz4_decode(packed, header->packed_size, out);
+    if (end != out + header->raw_size) hang();
+
+    stub_jump(header->load_addr, dtb);
+}
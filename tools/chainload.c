@@ -0,0 +1,267 @@
+// tools/chainload.c
+// Host-Programm für den seriellen Chainloader (loader/). Schickt ein
+// Kernel-Image über eine serielle Schnittstelle und zeigt danach die
+// Ausgabe des Kernels an.
+//
+//     chainload [-b baud] [-n] /dev/ttyUSB0 build/kernel8.img
+//
+//   -b baud  Baudrate für die Übertragung (Standard: 921600)
+//   -n       Nach dem Hochladen beenden statt die Ausgabe anzuzeigen
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crc32.h"
+#include "protocol.h"
+
+#define RESPONSE_TIMEOUT_MS 3000
+#define RETRANSMIT_TIMEOUT_MS 500
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static speed_t baud_constant(unsigned int baud) {
+    switch (baud) {
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+#ifdef B1000000
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 3000000: return B3000000;
+#endif
+        default:      return 0;
+    }
+}
+
+static int set_baud(int fd, unsigned int baud) {
+    struct termios tio;
+    speed_t speed = baud_constant(baud);
+    if (speed == 0 || tcgetattr(fd, &tio) < 0) return -1;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcdrain(fd);
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static void write_all(int fd, const void* data, size_t len) {
+    const unsigned char* p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            perror("write");
+            exit(1);
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+// Liest ein Byte; -1 bei Timeout
+static int read_byte(int fd, int timeout_ms) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    unsigned char b;
+    if (poll(&pfd, 1, timeout_ms) <= 0) return -1;
+    if (read(fd, &b, 1) != 1) return -1;
+    return b;
+}
+
+static void put_le16(unsigned char* p, unsigned int v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_le32(unsigned char* p, unsigned int v) {
+    for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static void wait_for_hello(int fd) {
+    const char* hello = LOADER_HELLO;
+    size_t matched = 0;
+    while (matched < strlen(hello)) {
+        int b = read_byte(fd, 1000);
+        if (b < 0) continue;
+        if (b == hello[matched]) {
+            matched++;
+        } else {
+            matched = (b == hello[0]) ? 1 : 0;
+            if (b != hello[0]) putchar(b); // Banner des Loaders durchreichen
+        }
+    }
+    fflush(stdout);
+}
+
+static void send_frame(int fd, const unsigned char* image, unsigned int size, unsigned int seq) {
+    unsigned char frame[1 + 4 + LOADER_FRAME_SIZE + 4];
+    unsigned int offset = seq * LOADER_FRAME_SIZE;
+    unsigned int len = size - offset < LOADER_FRAME_SIZE ? size - offset : LOADER_FRAME_SIZE;
+
+    frame[0] = LOADER_SOF;
+    put_le16(frame + 1, seq);
+    put_le16(frame + 3, len);
+    memcpy(frame + 5, image + offset, len);
+    put_le32(frame + 5 + len, crc32_update(0, frame + 1, 4 + len));
+    write_all(fd, frame, 5 + len + 4);
+}
+
+/**
+ * Go-Back-N: bis zu LOADER_WINDOW Frames unbestätigt senden. Ein NAK oder
+ * ein Timeout ohne Fortschritt setzt die Übertragung auf den ältesten
+ * unbestätigten Frame zurück.
+ */
+static int send_image(int fd, const unsigned char* image, unsigned int size) {
+    unsigned int frames = (size + LOADER_FRAME_SIZE - 1) / LOADER_FRAME_SIZE;
+    unsigned int base = 0, next = 0, retransmits = 0, shown = ~0u;
+    unsigned char resp[3];
+    int resp_len = 0;
+    double last_progress = now_seconds();
+
+    while (base < frames) {
+        while (next < frames && next - base < LOADER_WINDOW) {
+            send_frame(fd, image, size, next++);
+        }
+
+        int b = read_byte(fd, 10);
+        if (b >= 0) {
+            if (resp_len == 0 && b != LOADER_ACK && b != LOADER_NAK) continue;
+            resp[resp_len++] = b;
+            if (resp_len < 3) continue;
+            resp_len = 0;
+
+            unsigned int seq = resp[1] | (resp[2] << 8);
+            if (resp[0] == LOADER_ACK && seq >= base && seq < next) {
+                base = seq + 1;
+                last_progress = now_seconds();
+            } else if (resp[0] == LOADER_NAK && seq >= base && seq <= next) {
+                base = next = seq;
+                retransmits++;
+                last_progress = now_seconds();
+            }
+        } else if ((now_seconds() - last_progress) * 1000 > RETRANSMIT_TIMEOUT_MS) {
+            next = base;
+            retransmits++;
+            last_progress = now_seconds();
+        }
+
+        if (base != shown) {
+            shown = base;
+            fprintf(stderr, "\r%u / %u frames", base, frames);
+        }
+    }
+    fprintf(stderr, "\n");
+    return retransmits;
+}
+
+int main(int argc, char** argv) {
+    unsigned int baud = 921600;
+    int monitor = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n")) != -1) {
+        if (opt == 'b') baud = strtoul(optarg, NULL, 10);
+        else if (opt == 'n') monitor = 0;
+        else goto usage;
+    }
+    if (argc - optind != 2) goto usage;
+    if (baud_constant(baud) == 0) {
+        fprintf(stderr, "unsupported baud rate %u\n", baud);
+        return 1;
+    }
+
+    FILE* f = fopen(argv[optind + 1], "rb");
+    if (f == NULL) {
+        perror(argv[optind + 1]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* image = malloc(size);
+    if (size <= 0 || image == NULL || fread(image, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "cannot read %s\n", argv[optind + 1]);
+        return 1;
+    }
+    fclose(f);
+
+    int fd = open(argv[optind], O_RDWR | O_NOCTTY);
+    if (fd < 0 || set_baud(fd, LOADER_BOOT_BAUD) < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    fprintf(stderr, "Waiting for loader on %s ...\n", argv[optind]);
+    wait_for_hello(fd);
+
+    unsigned char header[sizeof(LoaderHeader)];
+    put_le32(header + 0, LOADER_MAGIC);
+    put_le32(header + 4, size);
+    put_le32(header + 8, crc32_update(0, image, size));
+    put_le32(header + 12, baud);
+    put_le32(header + 16, crc32_update(0, header, 16));
+    tcflush(fd, TCIFLUSH);
+    write_all(fd, header, sizeof(header));
+
+    int b;
+    while ((b = read_byte(fd, RESPONSE_TIMEOUT_MS)) >= 0 && b != LOADER_ACK && b != LOADER_NAK);
+    if (b != LOADER_ACK) {
+        fprintf(stderr, "loader rejected the image (size or baud rate)\n");
+        return 1;
+    }
+    unsigned int actual = 0;
+    for (int i = 0; i < 4; i++) actual |= (unsigned int)read_byte(fd, RESPONSE_TIMEOUT_MS) << (8 * i);
+    fprintf(stderr, "Loader accepted, %u baud (actual %u)\n", baud, actual);
+
+    set_baud(fd, baud);
+    tcflush(fd, TCIFLUSH); // Beim Umschalten verstümmelte Bytes verwerfen
+    while ((b = read_byte(fd, RESPONSE_TIMEOUT_MS)) >= 0 && b != LOADER_READY);
+    if (b != LOADER_READY) {
+        fprintf(stderr, "no response after switching to %u baud\n", baud);
+        return 1;
+    }
+
+    double start = now_seconds();
+    int retransmits = send_image(fd, image, size);
+    while ((b = read_byte(fd, RESPONSE_TIMEOUT_MS)) >= 0 && b != LOADER_DONE && b != LOADER_NAK);
+    double seconds = now_seconds() - start;
+    if (b != LOADER_DONE) {
+        fprintf(stderr, "image checksum mismatch on the target\n");
+        return 1;
+    }
+
+    double mb = size / (1024.0 * 1024.0);
+    fprintf(stderr, "Uploaded %ld bytes in %.2f s (%.1f KB/s, %.2f s/MB, %d retransmits)\n",
+            size, seconds, size / 1024.0 / seconds, seconds / mb, retransmits);
+
+    set_baud(fd, LOADER_BOOT_BAUD);
+    if (!monitor) return 0;
+
+    // Ausgabe des neuen Kernels anzeigen (Ende mit Ctrl-C)
+    while (1) {
+        unsigned char buf[256];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) fwrite(buf, 1, n, stdout), fflush(stdout);
+        else usleep(10000);
+    }
+
+usage:
+    fprintf(stderr, "usage: %s [-b baud] [-n] <serial device> <kernel image>\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,362 @@
+// tools/fbgrab.c
+// Host-Programm für das Shell-Kommando "screenshot". Liest die serielle
+// Ausgabe des Kernels, reicht normalen Text an stdout durch und speichert
+// jeden empfangenen Frame (include/screenshot.h) als PNG.
+//
+//     fbgrab [-b baud] [-n count] [-o prefix] /dev/ttyUSB0
+//     fbgrab -f capture.bin [-o prefix]
+//
+//   -b baud    Baudrate der Konsole (Standard: 115200)
+//   -n count   Nach count Frames beenden (Standard: beliebig viele)
+//   -o prefix  Dateinamen der PNGs: prefix0000.png, ... (Standard: shot)
+//   -f file    Mitschnitt aus einer Datei statt vom Gerät dekodieren
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crc32.h"
+#include "screenshot.h"
+
+#define READ_TIMEOUT_MS 3000
+
+static int input_fd = -1;
+static FILE* input_file;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static speed_t baud_constant(unsigned int baud) {
+    switch (baud) {
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+#ifdef B1000000
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 3000000: return B3000000;
+#endif
+        default:      return 0;
+    }
+}
+
+static int set_baud(int fd, unsigned int baud) {
+    struct termios tio;
+    speed_t speed = baud_constant(baud);
+    if (speed == 0 || tcgetattr(fd, &tio) < 0) return -1;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+// Liest ein Byte; -1 bei Dateiende bzw. Timeout innerhalb eines Frames
+static int read_byte(int timeout_ms) {
+    if (input_file != NULL) return fgetc(input_file);
+
+    static unsigned char buf[4096];
+    static ssize_t len, pos;
+    while (pos == len) {
+        struct pollfd pfd = { input_fd, POLLIN, 0 };
+        int r = poll(&pfd, 1, timeout_ms);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        len = read(input_fd, buf, sizeof(buf));
+        pos = 0;
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN) len = 0;
+            else return -1;
+        }
+    }
+    return buf[pos++];
+}
+
+// ##################################
+// ## PNG
+// ##################################
+
+static void put_be32(unsigned char* p, unsigned int v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void png_chunk(FILE* f, const char* type, const unsigned char* data, unsigned int len) {
+    unsigned char head[8];
+    put_be32(head, len);
+    memcpy(head + 4, type, 4);
+    unsigned int crc = crc32_update(0, type, 4);
+    crc = crc32_update(crc, data, len);
+    unsigned char tail[4];
+    put_be32(tail, crc);
+    fwrite(head, 1, 8, f);
+    fwrite(data, 1, len, f);
+    fwrite(tail, 1, 4, f);
+}
+
+// RGB-Bild als PNG; die Daten werden unkomprimiert ("stored") in den
+// zlib-Strom gelegt, damit das Werkzeug ohne zlib auskommt.
+static int write_png(const char* path, const unsigned char* rgb, unsigned int w, unsigned int h) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return -1;
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, 8, f);
+
+    unsigned char ihdr[13];
+    put_be32(ihdr, w);
+    put_be32(ihdr + 4, h);
+    ihdr[8] = 8;  // Bits pro Kanal
+    ihdr[9] = 2;  // RGB
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+
+    // Rohdaten: je Zeile Filterbyte 0 und die Pixel
+    size_t row = (size_t)w * 3 + 1, raw_len = row * h;
+    unsigned char* raw = malloc(raw_len);
+    size_t blocks = (raw_len + 65534) / 65535;
+    unsigned char* z = malloc(2 + raw_len + blocks * 5 + 4);
+    if (raw == NULL || z == NULL) {
+        fclose(f);
+        return -1;
+    }
+    for (unsigned int y = 0; y < h; y++) {
+        raw[y * row] = 0;
+        memcpy(raw + y * row + 1, rgb + (size_t)y * w * 3, (size_t)w * 3);
+    }
+
+    size_t n = 0;
+    z[n++] = 0x78;
+    z[n++] = 0x01;
+    unsigned int a = 1, b = 0;
+    for (size_t pos = 0; pos < raw_len;) {
+        size_t len = raw_len - pos > 65535 ? 65535 : raw_len - pos;
+        z[n++] = pos + len == raw_len;
+        z[n++] = len & 0xFF;
+        z[n++] = len >> 8;
+        z[n++] = ~len & 0xFF;
+        z[n++] = (~len >> 8) & 0xFF;
+        memcpy(z + n, raw + pos, len);
+        for (size_t i = 0; i < len; i++) {
+            a = (a + raw[pos + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        n += len;
+        pos += len;
+    }
+    put_be32(z + n, b << 16 | a);
+    n += 4;
+    png_chunk(f, "IDAT", z, n);
+    png_chunk(f, "IEND", NULL, 0);
+
+    free(raw);
+    free(z);
+    return fclose(f);
+}
+
+// ##################################
+// ## Dekodierung
+// ##################################
+
+typedef struct {
+    unsigned int width, height;
+    unsigned char* rgb;             // Letzter Frame, Basis für Delta-Frames
+    unsigned char palette[SHOT_PALETTE_SIZE][3];
+    unsigned int next;
+    unsigned int crc;
+} Decoder;
+
+static int next_byte(Decoder* d) {
+    int b = read_byte(READ_TIMEOUT_MS);
+    if (b >= 0) {
+        unsigned char c = b;
+        d->crc = crc32_update(d->crc, &c, 1);
+    }
+    return b;
+}
+
+static long read_varint(Decoder* d) {
+    unsigned long v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int b = next_byte(d);
+        if (b < 0) return -1;
+        v |= (unsigned long)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    return -1;
+}
+
+// Dekodiert einen Frame nach dem bereits gelesenen "OBSS"; 0 bei Erfolg
+static int decode_frame(Decoder* d) {
+    d->crc = crc32_update(0, SHOT_MAGIC, 4);
+    unsigned char head[SHOT_HEADER_SIZE - 4];
+    for (size_t i = 0; i < sizeof(head); i++) {
+        int b = next_byte(d);
+        if (b < 0) return -1;
+        head[i] = b;
+    }
+    if (head[0] != SHOT_VERSION) {
+        fprintf(stderr, "unsupported frame version %u\n", head[0]);
+        return -1;
+    }
+    int delta = head[1] & SHOT_FLAG_DELTA;
+    unsigned int w = head[2] | head[3] << 8, h = head[4] | head[5] << 8;
+    if (delta && (d->rgb == NULL || w != d->width || h != d->height)) {
+        fprintf(stderr, "delta frame without a matching previous frame\n");
+        return -1;
+    }
+    if (d->rgb == NULL || w != d->width || h != d->height) {
+        free(d->rgb);
+        d->rgb = calloc((size_t)w * h, 3);
+        if (d->rgb == NULL) return -1;
+        d->width = w;
+        d->height = h;
+    }
+    memcpy(d->palette, head + 6, SHOT_FIXED_COLORS * 3);
+    d->next = SHOT_FIXED_COLORS;
+
+    size_t total = (size_t)w * h, pos = 0;
+    while (1) {
+        int t = next_byte(d);
+        if (t < 0) return -1;
+        if (t == SHOT_END) break;
+
+        long len;
+        int idx = -1;
+        if (t < 0x80) {
+            idx = t >> 3;
+            len = (t & 7) + 1;
+        } else if (t < 0xC0) {
+            idx = next_byte(d);
+            len = (t & 0x3F) + 1;
+        } else if (t == SHOT_RUN) {
+            idx = next_byte(d);
+            len = read_varint(d) + 1;
+        } else if (t == SHOT_NEW) {
+            idx = d->next;
+            d->next = d->next == SHOT_PALETTE_SIZE - 1 ? SHOT_FIXED_COLORS : d->next + 1;
+            for (int i = 0; i < 3; i++) {
+                int c = next_byte(d);
+                if (c < 0) return -1;
+                d->palette[idx][i] = c;
+            }
+            len = read_varint(d) + 1;
+        } else if (t == SHOT_SKIP) {
+            len = read_varint(d) + 1;
+        } else {
+            fprintf(stderr, "bad token 0x%02x at pixel %zu\n", t, pos);
+            return -1;
+        }
+        if (len <= 0 || (t != SHOT_SKIP && idx < 0) || pos + len > total) {
+            fprintf(stderr, "corrupt frame at pixel %zu\n", pos);
+            return -1;
+        }
+        if (t != SHOT_SKIP) {
+            for (long i = 0; i < len; i++) memcpy(d->rgb + (pos + i) * 3, d->palette[idx], 3);
+        }
+        pos += len;
+    }
+
+    unsigned int crc = d->crc, got = 0;
+    for (int i = 0; i < 4; i++) {
+        int b = read_byte(READ_TIMEOUT_MS);
+        if (b < 0) return -1;
+        got |= (unsigned int)b << (8 * i);
+    }
+    if (got != crc || pos != total) {
+        fprintf(stderr, "frame checksum mismatch (%zu of %zu pixels)\n", pos, total);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    unsigned int baud = 115200;
+    long count = -1;
+    const char* prefix = "shot";
+    const char* file = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:o:f:")) != -1) {
+        if (opt == 'b') baud = strtoul(optarg, NULL, 10);
+        else if (opt == 'n') count = strtol(optarg, NULL, 10);
+        else if (opt == 'o') prefix = optarg;
+        else if (opt == 'f') file = optarg;
+        else goto usage;
+    }
+    if (file != NULL ? argc != optind : argc - optind != 1) goto usage;
+
+    if (file != NULL) {
+        input_file = fopen(file, "rb");
+        if (input_file == NULL) {
+            perror(file);
+            return 1;
+        }
+    } else {
+        if (baud_constant(baud) == 0) {
+            fprintf(stderr, "unsupported baud rate %u\n", baud);
+            return 1;
+        }
+        input_fd = open(argv[optind], O_RDWR | O_NOCTTY);
+        if (input_fd < 0 || set_baud(input_fd, baud) < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+        fprintf(stderr, "Waiting for frames on %s (run \"screenshot\" on the target) ...\n", argv[optind]);
+    }
+
+    Decoder dec = { 0 };
+    long frames = 0;
+    unsigned int match = 0;
+    while (count < 0 || frames < count) {
+        int b = read_byte(-1);
+        if (b < 0) break;
+
+        // "OBSS" suchen, alles andere ist Konsolenausgabe
+        if (b == SHOT_MAGIC[match]) {
+            if (++match < 4) continue;
+        } else {
+            if (match > 0) fwrite(SHOT_MAGIC, 1, match, stdout);
+            match = b == SHOT_MAGIC[0];
+            if (!match) putchar(b);
+            fflush(stdout);
+            continue;
+        }
+        match = 0;
+
+        double start = now_seconds();
+        if (decode_frame(&dec) != 0) continue;
+        double seconds = now_seconds() - start;
+
+        char path[4096];
+        snprintf(path, sizeof(path), "%s%04ld.png", prefix, frames);
+        if (write_png(path, dec.rgb, dec.width, dec.height) != 0) {
+            perror(path);
+            return 1;
+        }
+        fprintf(stderr, "%s: %ux%u, %.2f s\n", path, dec.width, dec.height, seconds);
+        frames++;
+    }
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-b baud] [-n count] [-o prefix] /dev/ttyUSB0\n"
+                    "       %s -f capture.bin [-o prefix]\n", argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,128 @@
+// tools/mkasset.c
+// Wandelt ein Bild (PPM P6 oder PAM P7) in ein Asset für die Section .assets.
+//
+//   mkasset [-k RRGGBB] [-n name] input.ppm|input.pam output.ast
+//
+// PAM mit Alphakanal (TUPLTYPE RGB_ALPHA) wird zu einem BLIT_ALPHA-Asset,
+// RGB-Bilder zu BLIT_COLORKEY mit Schlüssel Magenta (FF00FF) oder -k.
+// Mit "-k none" entsteht ein deckendes Asset. Der Name ist ohne -n der
+// Dateiname ohne Verzeichnis und Endung.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "blit.h"
+
+#define HEADER_SIZE 64
+
+static void die(const char* msg) {
+    fprintf(stderr, "mkasset: %s\n", msg);
+    exit(1);
+}
+
+// Liest das nächste Wort des Headers und überspringt Kommentare
+static int read_token(FILE* f, char* buf, int size) {
+    int c, n = 0;
+    do {
+        c = fgetc(f);
+        if (c == '#') while (c != '\n' && c != EOF) c = fgetc(f);
+    } while (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+    while (c != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+        if (n < size - 1) buf[n++] = (char)c;
+        c = fgetc(f);
+    }
+    buf[n] = 0;
+    return n;
+}
+
+static void put32(unsigned char* p, unsigned int v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+int main(int argc, char** argv) {
+    const char* name = NULL;
+    int format = BLIT_COLORKEY;
+    unsigned int key = 0xFF00FF;
+    int argi = 1;
+
+    while (argi < argc && argv[argi][0] == '-') {
+        if (strcmp(argv[argi], "-k") == 0 && argi + 1 < argc) {
+            if (strcmp(argv[argi + 1], "none") == 0) format = BLIT_OPAQUE;
+            else key = (unsigned int)strtoul(argv[argi + 1], NULL, 16) & 0xFFFFFF;
+            argi += 2;
+        } else if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc) {
+            name = argv[argi + 1];
+            argi += 2;
+        } else {
+            break;
+        }
+    }
+    if (argc - argi != 2) die("usage: mkasset [-k RRGGBB|none] [-n name] input.ppm|input.pam output.ast");
+
+    FILE* in = fopen(argv[argi], "rb");
+    if (in == NULL) die("cannot open input");
+
+    char tok[64];
+    unsigned int width = 0, height = 0, depth = 3, maxval = 0;
+    read_token(in, tok, sizeof(tok));
+    if (strcmp(tok, "P6") == 0) {
+        read_token(in, tok, sizeof(tok)); width = atoi(tok);
+        read_token(in, tok, sizeof(tok)); height = atoi(tok);
+        read_token(in, tok, sizeof(tok)); maxval = atoi(tok);
+    } else if (strcmp(tok, "P7") == 0) {
+        while (read_token(in, tok, sizeof(tok)) && strcmp(tok, "ENDHDR") != 0) {
+            char val[64];
+            if (strcmp(tok, "TUPLTYPE") == 0) { read_token(in, val, sizeof(val)); continue; }
+            read_token(in, val, sizeof(val));
+            if (strcmp(tok, "WIDTH") == 0) width = atoi(val);
+            else if (strcmp(tok, "HEIGHT") == 0) height = atoi(val);
+            else if (strcmp(tok, "DEPTH") == 0) depth = atoi(val);
+            else if (strcmp(tok, "MAXVAL") == 0) maxval = atoi(val);
+        }
+    } else {
+        die("input must be a binary PPM (P6) or PAM (P7)");
+    }
+    if (width == 0 || height == 0 || maxval != 255 || (depth != 3 && depth != 4)) {
+        die("only 8-bit RGB or RGBA images are supported");
+    }
+    if (depth == 4) format = BLIT_ALPHA;
+
+    unsigned long pixels = (unsigned long)width * height;
+    unsigned long size = (HEADER_SIZE + pixels * 4 + 15) & ~15ul;
+    unsigned char* out = calloc(1, size);
+    unsigned char* raw = malloc(pixels * depth);
+    if (out == NULL || raw == NULL) die("out of memory");
+    if (fread(raw, depth, pixels, in) != pixels) die("truncated image data");
+    fclose(in);
+
+    // Name aus dem Dateinamen ableiten
+    char namebuf[40];
+    if (name == NULL) {
+        const char* base = strrchr(argv[argi], '/');
+        base = base ? base + 1 : argv[argi];
+        snprintf(namebuf, sizeof(namebuf), "%s", base);
+        char* dot = strchr(namebuf, '.');
+        if (dot) *dot = 0;
+        name = namebuf;
+    }
+    if (strlen(name) >= 40) die("name too long (max. 39 characters)");
+
+    put32(out + 0, ASSET_MAGIC);
+    put32(out + 4, (unsigned int)size);
+    put32(out + 8, width);
+    put32(out + 12, height);
+    put32(out + 16, format);
+    put32(out + 20, key);
+    memcpy(out + 24, name, strlen(name));
+
+    for (unsigned long i = 0; i < pixels; i++) {
+        const unsigned char* p = raw + i * depth;
+        unsigned int a = depth == 4 ? p[3] : 0xFF;
+        put32(out + HEADER_SIZE + i * 4, (a << 24) | (p[0] << 16) | (p[1] << 8) | p[2]);
+    }
+
+    FILE* o = fopen(argv[argi + 1], "wb");
+    if (o == NULL || fwrite(out, 1, size, o) != size || fclose(o) != 0) die("cannot write output");
+    free(out);
+    free(raw);
+    return 0;
+}
@@ -0,0 +1,125 @@
+// tools/mkcpio.c
+// Packt ein Verzeichnis als cpio-Archiv (Format "newc") für die Section
+// .initramfs (siehe include/initramfs.h).
+//
+//   mkcpio rootfs build/initramfs.cpio
+//
+// Die Einträge werden nach Pfad sortiert, Besitzer und Zeitstempel auf 0
+// gesetzt, damit das Image bei gleichem Inhalt gleich bleibt. Es werden nur
+// Verzeichnisse und reguläre Dateien übernommen.
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct {
+    char* path;       // Relativ zum Quellverzeichnis
+    unsigned int mode;
+    long size;
+} Entry;
+
+static Entry* entries;
+static size_t entry_count, entry_capacity;
+static unsigned int next_ino = 1;
+
+static void die(const char* msg, const char* arg) {
+    fprintf(stderr, "mkcpio: %s%s%s\n", msg, arg ? ": " : "", arg ? arg : "");
+    exit(1);
+}
+
+static void add_entry(const char* path, unsigned int mode, long size) {
+    if (entry_count == entry_capacity) {
+        entry_capacity = entry_capacity ? entry_capacity * 2 : 64;
+        entries = realloc(entries, entry_capacity * sizeof(Entry));
+        if (entries == NULL) die("out of memory", NULL);
+    }
+    entries[entry_count].path = strdup(path);
+    entries[entry_count].mode = mode;
+    entries[entry_count].size = size;
+    entry_count++;
+}
+
+// Sammelt rekursiv alle Einträge unter root/rel
+static void scan(const char* root, const char* rel) {
+    char dir_path[4096];
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", root, rel);
+    DIR* dir = opendir(dir_path);
+    if (dir == NULL) die("cannot open directory", dir_path);
+
+    struct dirent* d;
+    while ((d = readdir(dir)) != NULL) {
+        if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+
+        char child[2048], full[4096];
+        snprintf(child, sizeof(child), "%s%s%s", rel, rel[0] ? "/" : "", d->d_name);
+        snprintf(full, sizeof(full), "%s/%s", root, child);
+        struct stat st;
+        if (stat(full, &st) < 0) die("cannot stat", full);
+
+        if (S_ISDIR(st.st_mode)) {
+            add_entry(child, st.st_mode, 0);
+            scan(root, child);
+        } else if (S_ISREG(st.st_mode)) {
+            add_entry(child, st.st_mode, st.st_size);
+        }
+    }
+    closedir(dir);
+}
+
+static int compare_entries(const void* a, const void* b) {
+    return strcmp(((const Entry*)a)->path, ((const Entry*)b)->path);
+}
+
+static void pad4(FILE* out, long written) {
+    static const char zeros[4];
+    fwrite(zeros, 1, (4 - (written & 3)) & 3, out);
+}
+
+static void write_header(FILE* out, const char* name, unsigned int mode, long size) {
+    unsigned long namesize = strlen(name) + 1;
+    fprintf(out, "070701%08X%08X%08X%08X%08X%08X%08lX%08X%08X%08X%08X%08lX%08X",
+            next_ino++, mode, 0, 0, 1, 0, (unsigned long)size, 0, 0, 0, 0, namesize, 0);
+    fwrite(name, 1, namesize, out);
+    pad4(out, 110 + namesize);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: mkcpio <directory> <output.cpio>\n");
+        return 1;
+    }
+    scan(argv[1], "");
+    qsort(entries, entry_count, sizeof(Entry), compare_entries);
+
+    FILE* out = fopen(argv[2], "wb");
+    if (out == NULL) die("cannot create", argv[2]);
+
+    long total = 0;
+    for (size_t i = 0; i < entry_count; i++) {
+        Entry* e = &entries[i];
+        write_header(out, e->path, e->mode, e->size);
+        if (e->size > 0) {
+            char full[4096];
+            snprintf(full, sizeof(full), "%s/%s", argv[1], e->path);
+            FILE* in = fopen(full, "rb");
+            if (in == NULL) die("cannot read", full);
+            char buffer[65536];
+            size_t n;
+            long copied = 0;
+            while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+                fwrite(buffer, 1, n, out);
+                copied += n;
+            }
+            fclose(in);
+            if (copied != e->size) die("file changed while packing", full);
+            pad4(out, e->size);
+        }
+        total += e->size;
+    }
+    write_header(out, "TRAILER!!!", 0, 0);
+    if (fclose(out) != 0) die("cannot write", argv[2]);
+
+    fprintf(stderr, "mkcpio: %zu entries, %ld bytes of file data\n", entry_count, total);
+    return 0;
+}
@@ -0,0 +1,160 @@
+// tools/mklz4.c
+// Komprimiert das Kernel-Image mit LZ4 für den Entpack-Stub (stub/).
+//
+//   mklz4 build/kernel8.img build/kernel8.lz4
+//
+// Ausgabe: ZimageHeader (stub/image.h) und ein LZ4-Block, kompatibel zum
+// Blockformat von lz4. Gesucht wird mit Hash-Ketten und einem Schritt
+// "lazy matching"; das kostet beim Packen Zeit, das Entpacken wird dadurch
+// nicht langsamer.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "image.h"
+
+#define LOAD_ADDR     0x80000
+
+#define MIN_MATCH     4
+#define MAX_OFFSET    65535
+#define LAST_LITERALS 5     // Die letzten 5 Bytes sind immer Literale
+#define MF_LIMIT      12    // Der letzte Match beginnt spätestens 12 Bytes vor dem Ende
+#define HASH_BITS     16
+#define MAX_CHAIN     256   // Untersuchte Kandidaten pro Position
+
+static int head[1 << HASH_BITS];
+static int prev[MAX_OFFSET + 1];
+
+static void die(const char* msg, const char* arg) {
+    fprintf(stderr, "mklz4: %s%s%s\n", msg, arg ? ": " : "", arg ? arg : "");
+    exit(1);
+}
+
+static unsigned int read32(const unsigned char* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+static unsigned int hash4(const unsigned char* p) {
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void insert(const unsigned char* in, int pos) {
+    unsigned int h = hash4(in + pos);
+    prev[pos & MAX_OFFSET] = head[h];
+    head[h] = pos;
+}
+
+// Längster Match für pos unter den bisherigen Positionen mit gleichem Hash
+static int find_match(const unsigned char* in, int pos, int limit, int* offset) {
+    int best = 0;
+    int candidate = head[hash4(in + pos)];
+    for (int depth = 0; depth < MAX_CHAIN && candidate >= 0 && pos - candidate <= MAX_OFFSET; depth++) {
+        if (in[candidate + best] == in[pos + best]) {
+            int len = 0;
+            while (pos + len < limit && in[candidate + len] == in[pos + len]) len++;
+            if (len > best) {
+                best = len;
+                *offset = pos - candidate;
+            }
+        }
+        int next = prev[candidate & MAX_OFFSET];
+        if (next >= candidate) break; // Eintrag schon überschrieben
+        candidate = next;
+    }
+    return best >= MIN_MATCH ? best : 0;
+}
+
+static unsigned char* put_length(unsigned char* out, long len) {
+    for (; len >= 255; len -= 255) *out++ = 255;
+    *out++ = (unsigned char)len;
+    return out;
+}
+
+static unsigned char* put_sequence(unsigned char* out, const unsigned char* literals, long literal_len,
+                                   int offset, long match_len) {
+    unsigned char* token = out++;
+    *token = (literal_len < 15 ? literal_len : 15) << 4;
+    if (literal_len >= 15) out = put_length(out, literal_len - 15);
+    memcpy(out, literals, literal_len);
+    out += literal_len;
+    if (match_len == 0) return out;
+
+    *out++ = offset & 0xFF;
+    *out++ = offset >> 8;
+    match_len -= MIN_MATCH;
+    *token |= match_len < 15 ? match_len : 15;
+    if (match_len >= 15) out = put_length(out, match_len - 15);
+    return out;
+}
+
+static long compress(const unsigned char* in, long n, unsigned char* out) {
+    unsigned char* start = out;
+    memset(head, 0xFF, sizeof(head));
+
+    long anchor = 0;
+    long pos = 0;
+    int match_limit = n - LAST_LITERALS;
+    while (pos + MF_LIMIT < n) {
+        int offset = 0;
+        int len = find_match(in, pos, match_limit, &offset);
+        if (len == 0) {
+            insert(in, pos++);
+            continue;
+        }
+
+        // Lazy: beginnt an der nächsten Position ein längerer Match, wird
+        // dieses Byte zum Literal
+        if (pos + 1 + MF_LIMIT < n) {
+            insert(in, pos);
+            int next_offset = 0;
+            int next_len = find_match(in, pos + 1, match_limit, &next_offset);
+            if (next_len > len) {
+                pos++;
+                continue;
+            }
+            pos++;
+        } else {
+            insert(in, pos++);
+        }
+
+        out = put_sequence(out, in + anchor, pos - 1 - anchor, offset, len);
+        long end = pos - 1 + len;
+        for (; pos < end && pos + MF_LIMIT < n; pos++) insert(in, pos);
+        pos = end;
+        anchor = end;
+    }
+    out = put_sequence(out, in + anchor, n - anchor, 0, 0);
+    return out - start;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: mklz4 <kernel.img> <output.lz4>\n");
+        return 1;
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if (f == NULL) die("cannot open", argv[1]);
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    rewind(f);
+    if (n <= 0 || n > 0x7FFFFFFF) die("bad input size", argv[1]);
+    unsigned char* in = malloc(n);
+    // Schlimmster Fall: alles Literale, ein Längenbyte pro 255 Bytes
+    unsigned char* packed = malloc(n + n / 255 + 16);
+    if (in == NULL || packed == NULL) die("out of memory", NULL);
+    if (fread(in, 1, n, f) != (size_t)n) die("read error", argv[1]);
+    fclose(f);
+
+    long packed_size = compress(in, n, packed);
+    ZimageHeader header = { ZIMAGE_MAGIC, (unsigned int)n, (unsigned int)packed_size, LOAD_ADDR };
+
+    FILE* out = fopen(argv[2], "wb");
+    if (out == NULL) die("cannot create", argv[2]);
+    if (fwrite(&header, sizeof(header), 1, out) != 1 ||
+        fwrite(packed, 1, packed_size, out) != (size_t)packed_size || fclose(out) != 0) {
+        die("write error", argv[2]);
+    }
+
+    fprintf(stderr, "mklz4: %ld -> %ld bytes (%ld%%)\n", n, packed_size, packed_size * 100 / n);
+    return 0;
+}
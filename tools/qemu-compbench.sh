@@ -0,0 +1,69 @@
+#!/bin/sh
+# tools/qemu-compbench.sh
+# Skalierungsmessung des Compositors unter QEMU: bootet den Kernel mit vier
+# Cores, führt "compbench" aus und gibt die Tabelle für 1, 2 und 4 Cores aus.
+#
+#     make -f Makefile.gcc compbench-qemu
+#     tools/qemu-compbench.sh [kernel image] [frames]
+#
+# QEMU bildet weder Caches noch Speicherbandbreite nach: die Zahlen zeigen,
+# ob die Arbeit sauber aufgeteilt wird (gleiche CRC, Beschleunigung), nicht
+# die Werte auf echter Hardware.
+
+IMAGE=${1:-build/kernel8.img}
+FRAMES=${2:-20}
+QEMU=${QEMU:-qemu-system-aarch64}
+TIMEOUT=${TIMEOUT:-300}
+
+LOG=$(mktemp)
+OUT=$(mktemp)
+QEMU_PID=
+CAT_PID=
+cleanup() {
+    [ -n "$CAT_PID" ] && kill "$CAT_PID" 2>/dev/null
+    [ -n "$QEMU_PID" ] && kill "$QEMU_PID" 2>/dev/null
+    rm -f "$LOG" "$OUT"
+}
+trap cleanup EXIT INT TERM
+
+# serial0 ist die PL011, serial1 die Mini-UART mit der Shell
+"$QEMU" -M raspi4b -smp 4 -kernel "$IMAGE" -display none -monitor none \
+        -serial null -serial pty >"$LOG" 2>&1 &
+QEMU_PID=$!
+
+PTY=
+i=0
+while [ -z "$PTY" ] && [ $i -lt 100 ]; do
+    PTY=$(sed -n 's|.*redirected to \(/dev/[^ ]*\).*|\1|p' "$LOG" | head -n 1)
+    kill -0 "$QEMU_PID" 2>/dev/null || break
+    sleep 0.1
+    i=$((i + 1))
+done
+if [ -z "$PTY" ]; then
+    echo "FAIL: QEMU did not start" >&2
+    cat "$LOG" >&2
+    exit 1
+fi
+
+stty -F "$PTY" raw -echo
+cat "$PTY" >"$OUT" &
+CAT_PID=$!
+
+# Warten, bis die Shell läuft
+wait_for() {
+    i=0
+    while [ $i -lt $((TIMEOUT * 10)) ]; do
+        grep -q "$1" "$OUT" && return 0
+        sleep 0.1
+        i=$((i + 1))
+    done
+    echo "FAIL: no '$1' within $TIMEOUT s" >&2
+    cat "$OUT" >&2
+    exit 1
+}
+wait_for "Welcome to OhneBS!"
+printf 'compbench %s\r' "$FRAMES" >"$PTY"
+wait_for "commands per frame"
+sleep 0.5
+
+sed -n '/core(s):/,$p' "$OUT" | tr -d '\r' | grep -v '^> *$'
@@ -0,0 +1,70 @@
+#!/bin/sh
+# tools/qemu-loader-test.sh
+# Round-Trip-Test für Chainloader und Sendeprogramm unter QEMU: startet
+# build/loader8.img auf einem emulierten Pi 4, hängt die Mini-UART an ein
+# Pseudo-Terminal, lädt mit build/chainload einen Kernel hoch und wartet
+# auf dessen Begrüßung.
+#
+#     make -f Makefile.gcc loader-test
+#     tools/qemu-loader-test.sh [kernel image] [baud]
+#
+# QEMU ignoriert die Baudrate, geprüft werden Protokoll, Handshake nach dem
+# Umschalten, CRCs und der Sprung in den Kernel.
+
+IMAGE=${1:-build/kernel8.img}
+BAUD=${2:-921600}
+QEMU=${QEMU:-qemu-system-aarch64}
+TIMEOUT=${TIMEOUT:-60}
+WELCOME="Welcome to OhneBS!"
+
+LOG=$(mktemp)
+OUT=$(mktemp)
+QEMU_PID=
+LOAD_PID=
+cleanup() {
+    [ -n "$LOAD_PID" ] && kill "$LOAD_PID" 2>/dev/null
+    [ -n "$QEMU_PID" ] && kill "$QEMU_PID" 2>/dev/null
+    rm -f "$LOG" "$OUT"
+}
+trap cleanup EXIT INT TERM
+
+# serial0 ist die PL011, serial1 die Mini-UART
+"$QEMU" -M raspi4b -kernel build/loader8.img -display none -monitor none \
+        -serial null -serial pty >"$LOG" 2>&1 &
+QEMU_PID=$!
+
+# QEMU meldet: "char device redirected to /dev/pts/N (label serial1)"
+PTY=
+i=0
+while [ -z "$PTY" ] && [ $i -lt 100 ]; do
+    PTY=$(sed -n 's|.*redirected to \(/dev/[^ ]*\).*|\1|p' "$LOG" | head -n 1)
+    kill -0 "$QEMU_PID" 2>/dev/null || break
+    sleep 0.1
+    i=$((i + 1))
+done
+if [ -z "$PTY" ]; then
+    echo "FAIL: QEMU did not start" >&2
+    cat "$LOG" >&2
+    exit 1
+fi
+
+build/chainload -b "$BAUD" "$PTY" "$IMAGE" >"$OUT" &
+LOAD_PID=$!
+
+i=0
+while [ $i -lt $((TIMEOUT * 10)) ]; do
+    if grep -q "$WELCOME" "$OUT"; then
+        echo "PASS: $IMAGE loaded over $PTY"
+        exit 0
+    fi
+    if ! kill -0 "$LOAD_PID" 2>/dev/null; then
+        echo "FAIL: chainload exited" >&2
+        cat "$OUT" >&2
+        exit 1
+    fi
+    sleep 0.1
+    i=$((i + 1))
+done
+echo "FAIL: no welcome line within $TIMEOUT s" >&2
+cat "$OUT" >&2
+exit 1
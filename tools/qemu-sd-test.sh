@@ -0,0 +1,100 @@
+#!/bin/sh
+# tools/qemu-sd-test.sh
+# SD-Karte, Block-Cache und FAT32 unter QEMU: legt ein FAT32-Abbild mit einer
+# Textdatei, einer großen Datei und vars.log an, bootet den Kernel mit dem
+# Abbild als SD-Karte und führt Lese- und Schreibbenchmarks aus. Jede
+# "Error"-Zeile oder ein falscher Dateiinhalt lässt den Test scheitern.
+#
+#     make -f Makefile.gcc sd-test
+#     tools/qemu-sd-test.sh [kernel image]
+#
+# Braucht mkfs.vfat und mcopy (dosfstools, mtools). QEMU misst keine echten
+# Kartenzeiten, geprüft werden ADMA-Deskriptoren, Busadressen, Cache und
+# Dateisystem.
+
+IMAGE=${1:-build/kernel8.img}
+QEMU=${QEMU:-qemu-system-aarch64}
+TIMEOUT=${TIMEOUT:-300}
+HELLO="Hello from the SD card"
+
+DIR=$(mktemp -d)
+QEMU_PID=
+CAT_PID=
+cleanup() {
+    [ -n "$CAT_PID" ] && kill "$CAT_PID" 2>/dev/null
+    [ -n "$QEMU_PID" ] && kill "$QEMU_PID" 2>/dev/null
+    rm -rf "$DIR"
+}
+trap cleanup EXIT INT TERM
+
+# QEMU verlangt eine Zweierpotenz als Kartengröße
+SD="$DIR/sd.img"
+truncate -s 64M "$SD"
+mkfs.vfat -F 32 "$SD" >/dev/null || exit 1
+echo "$HELLO" >"$DIR/hello.txt"
+dd if=/dev/urandom of="$DIR/big.bin" bs=1M count=8 2>/dev/null
+dd if=/dev/zero of="$DIR/vars.log" bs=1k count=256 2>/dev/null
+mcopy -i "$SD" "$DIR/hello.txt" "$DIR/big.bin" "$DIR/vars.log" ::/ || exit 1
+
+LOG="$DIR/qemu.log"
+OUT="$DIR/out.log"
+
+# serial0 ist die PL011, serial1 die Mini-UART mit der Shell
+"$QEMU" -M raspi4b -kernel "$IMAGE" -display none -monitor none \
+        -drive file="$SD",if=sd,format=raw \
+        -serial null -serial pty >"$LOG" 2>&1 &
+QEMU_PID=$!
+
+PTY=
+i=0
+while [ -z "$PTY" ] && [ $i -lt 100 ]; do
+    PTY=$(sed -n 's|.*redirected to \(/dev/[^ ]*\).*|\1|p' "$LOG" | head -n 1)
+    kill -0 "$QEMU_PID" 2>/dev/null || break
+    sleep 0.1
+    i=$((i + 1))
+done
+if [ -z "$PTY" ]; then
+    echo "FAIL: QEMU did not start" >&2
+    cat "$LOG" >&2
+    exit 1
+fi
+
+stty -F "$PTY" raw -echo
+cat "$PTY" >"$OUT" &
+CAT_PID=$!
+
+wait_for() {
+    i=0
+    while [ $i -lt $((TIMEOUT * 10)) ]; do
+        grep -q "$1" "$OUT" && return 0
+        sleep 0.1
+        i=$((i + 1))
+    done
+    echo "FAIL: no '$1' within $TIMEOUT s" >&2
+    cat "$OUT" >&2
+    exit 1
+}
+
+# Nach jedem Befehl rechnet "print" eine Marke aus, erst danach kommt der
+# nächste (das Echo der Eingabe enthält die Summe nicht)
+run() {
+    printf '%s\r' "$1" >"$PTY"
+    printf 'print 7770000+%s\r' "$2" >"$PTY"
+    wait_for "$((7770000 + $2))"
+}
+
+wait_for "Welcome to OhneBS!"
+run "sd" 1
+run "cat /sd/hello.txt" 2
+run "bcache bench 4" 3
+run "fatbench /sd/big.bin /sd/hello.txt" 4
+run "pvars bench 100" 5
+run "bcache sync" 6
+run "bcache" 7
+
+tr -d '\r' <"$OUT" | grep -v '^> *$'
+if grep -q "Error" "$OUT" || ! grep -q "$HELLO" "$OUT"; then
+    echo "FAIL: SD test" >&2
+    exit 1
+fi
+echo "PASS: SD card, block cache and FAT32 under QEMU"